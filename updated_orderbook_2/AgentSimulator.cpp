@@ -0,0 +1,643 @@
+#include "AgentSimulator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <stdexcept>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace hft
+{
+
+    namespace
+    {
+        // Ticket layout: sequence | message bit | 24-bit index
+        constexpr unsigned INDEX_BITS = 24;
+        constexpr uint64_t INDEX_MASK = (uint64_t{ 1 } << INDEX_BITS) - 1;
+        constexpr uint64_t MESSAGE_BIT = uint64_t{ 1 } << INDEX_BITS;
+        constexpr unsigned SEQUENCE_SHIFT = INDEX_BITS + 1;
+        constexpr uint64_t MAX_SEQUENCE = (uint64_t{ 1 } << (64 - SEQUENCE_SHIFT)) - 1;
+
+        // Agent records and coroutine frames are scattered over a
+        // large population; wakes due in the same nanosecond are
+        // known in advance, so their memory is requested early
+        constexpr size_t PREFETCH_RECORD = 8;
+        constexpr size_t PREFETCH_FRAME = 4;
+
+        inline void prefetch(const void* address) noexcept
+        {
+#if defined(_MSC_VER)
+            _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+            __builtin_prefetch(address);
+#endif
+        }
+
+        // Decorrelates the per-agent streams of neighbouring ids
+        [[nodiscard]] uint64_t agentSeed(uint64_t seed, uint32_t agent) noexcept
+        {
+            SimRandom mixer(seed ^ (0xD1B54A32D192ED03ull * (uint64_t{ agent } + 1)));
+            return mixer.next();
+        }
+    }
+
+    // ============================================================
+    // EVENT QUEUE
+    // ============================================================
+
+    SimEventQueue::SimEventQueue()
+        : levels(LEVELS)
+    {
+    }
+
+    void SimEventQueue::push(ScheduledEvent event)
+    {
+        if (event.time < current)
+            throw std::invalid_argument("SimEventQueue: event before the last one popped");
+
+        file(event);
+        ++count;
+    }
+
+    void SimEventQueue::file(ScheduledEvent event)
+    {
+        // Slots fill in ticket order: pushes come in sequence, and a
+        // slot is only cascaded into while every lower one is empty
+        const uint64_t differing = event.time ^ current;
+        const size_t level = differing ? static_cast<size_t>(63 - std::countl_zero(differing)) / 8 : 0;
+        const size_t slot = (event.time >> (8 * level)) & (SLOTS - 1);
+
+        Level& target = levels[level];
+        target.slots[slot].push_back(event);
+        target.occupied[slot / 64] |= uint64_t{ 1 } << (slot % 64);
+    }
+
+    ScheduledEvent SimEventQueue::pop() noexcept
+    {
+        Level& bottom = levels[0];
+
+        for (;;)
+        {
+            const size_t slot = current & (SLOTS - 1);
+            std::vector<ScheduledEvent>& events = bottom.slots[slot];
+
+            if (cursor < events.size())
+            {
+                --count;
+                return events[cursor++];
+            }
+
+            // Done with this nanosecond
+            if (!events.empty())
+            {
+                events.clear();
+                bottom.occupied[slot / 64] &= ~(uint64_t{ 1 } << (slot % 64));
+            }
+            cursor = 0;
+
+            const size_t next = nextSlot(bottom, slot + 1);
+            if (next < SLOTS)
+                current = (current & ~uint64_t{ SLOTS - 1 }) | next;
+            else
+                cascade();
+        }
+    }
+
+    void SimEventQueue::cascade()
+    {
+        for (size_t level = 1; level < LEVELS; ++level)
+        {
+            const size_t shift = 8 * level;
+            const size_t slot = nextSlot(levels[level], ((current >> shift) & (SLOTS - 1)) + 1);
+            if (slot == SLOTS)
+                continue;
+
+            // Start of the slot's range; every event in it is at or after
+            const uint64_t above = (shift + 8 < 64) ? ~((uint64_t{ 1 } << (shift + 8)) - 1) : 0;
+            current = (current & above) | (uint64_t{ slot } << shift);
+
+            Level& source = levels[level];
+            cascading.swap(source.slots[slot]);
+            source.occupied[slot / 64] &= ~(uint64_t{ 1 } << (slot % 64));
+
+            for (const ScheduledEvent& event : cascading)
+                file(event);
+            cascading.clear();
+            return;
+        }
+    }
+
+    size_t SimEventQueue::nextSlot(const Level& level, size_t from) const noexcept
+    {
+        for (size_t word = from / 64; word < level.occupied.size(); ++word)
+        {
+            uint64_t bits = level.occupied[word];
+            if (word == from / 64)
+                bits &= ~uint64_t{ 0 } << (from % 64);
+
+            if (bits)
+                return word * 64 + static_cast<size_t>(std::countr_zero(bits));
+        }
+
+        return SLOTS;
+    }
+
+    SimTime SimEventQueue::nextTime() const noexcept
+    {
+        const Level& bottom = levels[0];
+        const size_t slot = current & (SLOTS - 1);
+
+        if (cursor < bottom.slots[slot].size())
+            return current;
+
+        const size_t next = nextSlot(bottom, slot + 1);
+        if (next < SLOTS)
+            return (current & ~uint64_t{ SLOTS - 1 }) | next;
+
+        // Earliest event of the slot pop() would cascade next
+        for (size_t level = 1; level < LEVELS; ++level)
+        {
+            const size_t higher = nextSlot(levels[level], ((current >> (8 * level)) & (SLOTS - 1)) + 1);
+            if (higher == SLOTS)
+                continue;
+
+            SimTime earliest = std::numeric_limits<SimTime>::max();
+            for (const ScheduledEvent& event : levels[level].slots[higher])
+                earliest = std::min(earliest, event.time);
+
+            return earliest;
+        }
+
+        return std::numeric_limits<SimTime>::max();
+    }
+
+    const ScheduledEvent* SimEventQueue::peek(size_t ahead) const noexcept
+    {
+        const std::vector<ScheduledEvent>& events = levels[0].slots[current & (SLOTS - 1)];
+        return (cursor + ahead < events.size()) ? &events[cursor + ahead] : nullptr;
+    }
+
+    bool SimEventQueue::empty() const noexcept
+    {
+        return count == 0;
+    }
+
+    size_t SimEventQueue::size() const noexcept
+    {
+        return count;
+    }
+
+    void SimEventQueue::clear() noexcept
+    {
+        for (Level& level : levels)
+        {
+            level.occupied.fill(0);
+            for (auto& slot : level.slots)
+                slot.clear();
+        }
+
+        current = 0;
+        cursor = 0;
+        count = 0;
+    }
+
+    // ============================================================
+    // SIMULATOR
+    // ============================================================
+
+    AgentSimulator::AgentSimulator(MatchingEngine& engine_, Options options_)
+        : engine(engine_),
+        options(options_),
+        network(options_.seed),
+        tradesSeen(engine_.getTrades().size())
+    {
+        engine.setSimulatedTime(Timestamp{});
+    }
+
+    AgentSimulator::~AgentSimulator()
+    {
+        for (const Agent& agent : agents)
+        {
+            if (agent.task)
+                agent.task.destroy();
+        }
+    }
+
+    uint32_t AgentSimulator::nextAgentId() const
+    {
+        if (agents.size() >= MAX_AGENTS)
+            throw std::runtime_error("AgentSimulator: too many agents");
+
+        return static_cast<uint32_t>(agents.size());
+    }
+
+    uint32_t AgentSimulator::start(uint32_t agent, SimTask task, LatencyModel latency)
+    {
+        // An agent spawned from inside the factory took this id
+        if (agent != agents.size())
+            throw std::runtime_error("AgentSimulator: spawn() called from an agent factory");
+
+        Agent& state = agents.emplace_back();
+        state.task = task.release();
+        state.random = SimRandom(agentSeed(options.seed, agent));
+        latencies.push_back(latency);
+        ++running;
+
+        waitTimer(agent, clock);
+        return agent;
+    }
+
+    uint64_t AgentSimulator::run()
+    {
+        return runUntil(NEVER);
+    }
+
+    uint64_t AgentSimulator::runUntil(SimTime end)
+    {
+        // Fills from engine calls made between runs (an uncross, say)
+        dispatchFills();
+
+        uint64_t count = 0;
+
+        while (!queue.empty() && (end == NEVER || queue.nextTime() <= end))
+        {
+            const ScheduledEvent event = queue.pop();
+            clock = event.time;
+
+            if (const ScheduledEvent* later = queue.peek(PREFETCH_RECORD); later && !(later->ticket & MESSAGE_BIT))
+                prefetch(&agents[later->ticket & INDEX_MASK]);
+
+            if (const ScheduledEvent* soon = queue.peek(PREFETCH_FRAME); soon && !(soon->ticket & MESSAGE_BIT))
+            {
+                if (const SimTask::Handle task = agents[soon->ticket & INDEX_MASK].task)
+                    prefetch(task.address());
+            }
+            ++count;
+            ++processed;
+
+            const uint32_t index = static_cast<uint32_t>(event.ticket & INDEX_MASK);
+            if (event.ticket & MESSAGE_BIT)
+                deliver(index);
+            else
+                wake(index);
+        }
+
+        if (end != NEVER)
+            clock = std::max(clock, end);
+
+        return count;
+    }
+
+    SimTime AgentSimulator::now() const noexcept
+    {
+        return clock;
+    }
+
+    size_t AgentSimulator::agentCount() const noexcept
+    {
+        return agents.size();
+    }
+
+    size_t AgentSimulator::runningAgents() const noexcept
+    {
+        return running;
+    }
+
+    size_t AgentSimulator::pendingEvents() const noexcept
+    {
+        return queue.size();
+    }
+
+    uint64_t AgentSimulator::eventsProcessed() const noexcept
+    {
+        return processed;
+    }
+
+    MatchingEngine& AgentSimulator::getEngine() noexcept
+    {
+        return engine;
+    }
+
+    const MatchingEngine& AgentSimulator::getEngine() const noexcept
+    {
+        return engine;
+    }
+
+    // ============================================================
+    // SCHEDULING AND MESSAGES
+    // ============================================================
+
+    void AgentSimulator::schedule(SimTime time, bool message, uint32_t index)
+    {
+        if (nextSequence > MAX_SEQUENCE)
+            throw std::runtime_error("AgentSimulator: event sequence exhausted");
+
+        const uint64_t ticket = (nextSequence++ << SEQUENCE_SHIFT) | (message ? MESSAGE_BIT : 0) | index;
+        queue.push({ time, ticket });
+    }
+
+    SimTime AgentSimulator::delay(const LatencyModel& latency) noexcept
+    {
+        return latency.baseNs + (latency.jitterNs ? network.below(latency.jitterNs + 1) : 0);
+    }
+
+    uint32_t AgentSimulator::allocateMessage()
+    {
+        if (!freeMessages.empty())
+        {
+            const uint32_t index = freeMessages.back();
+            freeMessages.pop_back();
+            return index;
+        }
+
+        if (messages.size() > INDEX_MASK)
+            throw std::runtime_error("AgentSimulator: too many messages in flight");
+
+        messages.emplace_back();
+        return static_cast<uint32_t>(messages.size() - 1);
+    }
+
+    void AgentSimulator::sendToEngine(uint32_t message)
+    {
+        const uint32_t agentId = messages[message].agent;
+        Agent& agent = agents[agentId];
+
+        const SimTime arrival = std::max(clock + delay(latencies[agentId]), agent.lastSent);
+        agent.lastSent = arrival;
+        schedule(arrival, true, message);
+    }
+
+    void AgentSimulator::sendToAgent(uint32_t agentId, uint32_t message)
+    {
+        Agent& agent = agents[agentId];
+
+        const SimTime arrival = std::max(clock + delay(latencies[agentId]), agent.lastDelivered);
+        agent.lastDelivered = arrival;
+        schedule(arrival, true, message);
+    }
+
+    // ============================================================
+    // EVENT HANDLERS
+    // ============================================================
+
+    void AgentSimulator::wake(uint32_t agentId)
+    {
+        Agent& agent = agents[agentId];
+
+        // A timer is current only if the agent still waits on it;
+        // one outlived by a fill or a later sleep is skipped
+        if (agent.deadline != clock)
+            return;
+
+        if (agent.wait == Wait::FillOrTimer)
+            static_cast<std::optional<SimFill>*>(agent.result)->reset();
+        else if (agent.wait != Wait::Timer)
+            return;
+
+        resume(agentId);
+    }
+
+    void AgentSimulator::deliver(uint32_t index)
+    {
+        const Message message = messages[index];
+
+        if (message.kind == MessageKind::Submit || message.kind == MessageKind::Cancel)
+        {
+            freeMessages.push_back(index);
+            execute(message);
+            return;
+        }
+
+        Agent& agent = agents[message.agent];
+
+        if (message.kind == MessageKind::Reply)
+        {
+            freeMessages.push_back(index);
+            *static_cast<uint64_t*>(agent.result) = message.orderId;
+            resume(message.agent);
+            return;
+        }
+
+        if (!agent.task)
+        {
+            freeMessages.push_back(index);
+            return;
+        }
+
+        if (agent.wait == Wait::Fill || agent.wait == Wait::FillOrTimer)
+        {
+            freeMessages.push_back(index);
+            *static_cast<std::optional<SimFill>*>(agent.result) = toFill(message);
+            resume(message.agent);
+            return;
+        }
+
+        // Busy: queue it for the next nextFill()
+        messages[index].next = NONE;
+        if (agent.inboxTail == NONE)
+            agent.inboxHead = index;
+        else
+            messages[agent.inboxTail].next = index;
+        agent.inboxTail = index;
+    }
+
+    void AgentSimulator::execute(const Message& request)
+    {
+        engine.setSimulatedTime(Timestamp{} + std::chrono::nanoseconds(clock));
+
+        uint64_t reply = 0;
+
+        if (request.kind == MessageKind::Submit)
+        {
+            // Ownership is tracked here; the book's owner lists would
+            // only add cost
+            reply = engine.submitOrder(request.side, request.type, request.price, request.quantity);
+            if (reply != 0)
+                orders.emplace(reply, LiveOrder{ request.agent, request.quantity });
+        }
+        else
+        {
+            const auto it = orders.find(request.orderId);
+            if (it != orders.end() && it->second.agent == request.agent && engine.cancelOrder(request.orderId))
+            {
+                orders.erase(it);
+                reply = 1;
+            }
+        }
+
+        // The reply leaves first, so it reaches the agent before
+        // the fills of its own order
+        const uint32_t message = allocateMessage();
+        messages[message] = { .kind = MessageKind::Reply, .agent = request.agent, .orderId = reply };
+        sendToAgent(request.agent, message);
+
+        dispatchFills();
+
+        // Outside a call auction an unfilled market remainder is dropped
+        if (request.kind == MessageKind::Submit && request.type == OrderType::Market && reply != 0
+            && engine.getOrderBook().getTradingMode() == TradingMode::Continuous)
+        {
+            orders.erase(reply);
+        }
+    }
+
+    void AgentSimulator::dispatchFills()
+    {
+        const std::vector<Trade>& trades = engine.getTrades();
+
+        for (; tradesSeen < trades.size(); ++tradesSeen)
+        {
+            const Trade& trade = trades[tradesSeen];
+            notifyFill(trade.buyOrderId, Side::Buy, trade);
+            notifyFill(trade.sellOrderId, Side::Sell, trade);
+        }
+    }
+
+    void AgentSimulator::notifyFill(uint64_t orderId, Side side, const Trade& trade)
+    {
+        const auto it = orders.find(orderId);
+        if (it == orders.end())
+            return;
+
+        LiveOrder& order = it->second;
+        order.remaining -= std::min(order.remaining, trade.quantity);
+
+        const uint32_t agent = order.agent;
+        const uint64_t remaining = order.remaining;
+        if (remaining == 0)
+            orders.erase(it);
+
+        if (!agents[agent].task)
+            return;
+
+        const uint32_t message = allocateMessage();
+        messages[message] = {
+            .kind = MessageKind::Fill,
+            .side = side,
+            .agent = agent,
+            .price = trade.price,
+            .quantity = trade.quantity,
+            .orderId = orderId,
+            .remaining = remaining,
+            .tradeTime = clock
+        };
+        sendToAgent(agent, message);
+    }
+
+    void AgentSimulator::resume(uint32_t agentId)
+    {
+        // The agent may spawn others, so `agents` is re-read after
+        const SimTask::Handle task = agents[agentId].task;
+        agents[agentId].wait = Wait::None;
+
+        task.resume();
+
+        if (!task.done())
+            return;
+
+        const std::exception_ptr error = task.promise().error;
+        task.destroy();
+
+        Agent& agent = agents[agentId];
+        agent.task = {};
+        --running;
+
+        // Fills nobody will read
+        for (uint32_t index = agent.inboxHead; index != NONE; index = messages[index].next)
+            freeMessages.push_back(index);
+        agent.inboxHead = agent.inboxTail = NONE;
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    // ============================================================
+    // AWAITER HOOKS
+    // ============================================================
+
+    void AgentSimulator::waitTimer(uint32_t agentId, SimTime until)
+    {
+        until = std::max(until, clock);
+
+        Agent& agent = agents[agentId];
+        agent.wait = Wait::Timer;
+        agent.deadline = until;
+        schedule(until, false, agentId);
+    }
+
+    void AgentSimulator::request(uint32_t agentId,
+        Side side,
+        OrderType type,
+        double price,
+        uint64_t quantity,
+        uint64_t orderId,
+        uint64_t* reply)
+    {
+        const uint32_t message = allocateMessage();
+        messages[message] = {
+            .kind = orderId ? MessageKind::Cancel : MessageKind::Submit,
+            .side = side,
+            .type = type,
+            .agent = agentId,
+            .price = price,
+            .quantity = quantity,
+            .orderId = orderId
+        };
+
+        Agent& agent = agents[agentId];
+        agent.wait = Wait::Reply;
+        agent.result = reply;
+        sendToEngine(message);
+    }
+
+    bool AgentSimulator::takeFill(uint32_t agentId, std::optional<SimFill>& fill) noexcept
+    {
+        Agent& agent = agents[agentId];
+
+        const uint32_t index = agent.inboxHead;
+        if (index == NONE)
+            return false;
+
+        fill = toFill(messages[index]);
+
+        agent.inboxHead = messages[index].next;
+        if (agent.inboxHead == NONE)
+            agent.inboxTail = NONE;
+
+        freeMessages.push_back(index);
+        return true;
+    }
+
+    void AgentSimulator::waitFill(uint32_t agentId, SimTime deadline, std::optional<SimFill>* fill)
+    {
+        Agent& agent = agents[agentId];
+        agent.result = fill;
+
+        if (deadline == NEVER)
+        {
+            agent.wait = Wait::Fill;
+            return;
+        }
+
+        deadline = std::max(deadline, clock);
+        agent.wait = Wait::FillOrTimer;
+        agent.deadline = deadline;
+        schedule(deadline, false, agentId);
+    }
+
+    SimFill AgentSimulator::toFill(const Message& message) noexcept
+    {
+        return {
+            .orderId = message.orderId,
+            .side = message.side,
+            .price = message.price,
+            .quantity = message.quantity,
+            .remaining = message.remaining,
+            .tradeTime = message.tradeTime
+        };
+    }
+
+} // namespace hft
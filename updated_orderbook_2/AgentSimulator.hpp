@@ -0,0 +1,580 @@
+#pragma once
+
+#include "HFTUtils.hpp"
+#include "MatchingEngine.hpp"
+
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+
+    Discrete-event, agent-based market simulation.
+
+    Agents are C++20 coroutines trading against one
+    MatchingEngine in simulated time:
+
+        SimTask maker(AgentContext ctx)
+        {
+            const uint64_t id = co_await ctx.submit(Side::Sell, OrderType::Limit, 100.0, 10);
+            const SimFill fill = co_await ctx.nextFill();
+            co_await ctx.sleep(5'000);
+            ...
+        }
+
+        simulator.spawn(maker);
+        simulator.run();
+
+    A coroutine suspends on every co_await and is resumed by an
+    event: a timer, the reply to a request, or a fill. Requests
+    travel to the engine and replies and fills travel back
+    through each agent's LatencyModel, in order per direction.
+    The engine's clock is set to the event time before every
+    request it processes, so trades carry simulated time.
+
+    Events sit in SimEventQueue, a hierarchical timing wheel of
+    16-byte entries (time, ticket). Slots are plain arrays,
+    appended to and read in order, found through occupancy
+    bitmaps; an event is filed once and moves down a level at
+    most a few times, so pushes and pops are O(1) with no
+    pointer chasing or comparisons. Events at the same time run
+    in ticket order, and the ticket packs an insertion sequence
+    above the target index: equal times run in scheduling order.
+
+    With a large population the cost is memory, not logic: each
+    agent's state is one cache line, and the records and frames
+    of wakes due later in the same nanosecond are prefetched.
+
+    Everything is single-threaded and random numbers come from
+    seeded SimRandom streams (one per agent, one for latency
+    jitter), so a run depends only on the seed and the agents.
+
+    spawn() calls its factory once with the agent's context.
+    Coroutine parameters are copied into the frame but lambda
+    captures are not, so a capturing lambda must forward to a
+    coroutine function rather than be the coroutine itself.
+*/
+
+namespace hft
+{
+
+    // Nanoseconds since the start of the simulation
+    using SimTime = uint64_t;
+
+    // One-way delay: base plus uniform jitter in [0, jitterNs]
+    struct LatencyModel
+    {
+        uint64_t baseNs = 0;
+        uint64_t jitterNs = 0;
+    };
+
+    // A fill as the agent receives it
+    struct SimFill
+    {
+        uint64_t orderId = 0;
+        Side side = Side::Buy;
+        double price = 0.0;
+        uint64_t quantity = 0;
+        uint64_t remaining = 0;   // left on the order after this fill
+        SimTime tradeTime = 0;    // when it traded at the engine
+    };
+
+    // ============================================================
+    // EVENT QUEUE
+    // ============================================================
+
+    struct ScheduledEvent
+    {
+        SimTime time;
+        uint64_t ticket;   // unique; breaks ties between equal times
+    };
+
+    static_assert(sizeof(ScheduledEvent) == 16);
+
+    // Hierarchical timing wheel, exact to the nanosecond: 8 levels
+    // of 256 slots, level L holding events whose time first
+    // differs from the current one in byte L. Pushes may not go
+    // back before the last event popped, which always holds in
+    // simulated time.
+    class SimEventQueue
+    {
+    public:
+
+        SimEventQueue();
+
+        // Throws std::invalid_argument for an event in the past
+        void push(ScheduledEvent event);
+
+        // Earliest (time, ticket); the queue must not be empty
+        ScheduledEvent pop() noexcept;
+
+        // Time of the event pop() would return, without moving
+        // anything; the queue must not be empty
+        [[nodiscard]] SimTime nextTime() const noexcept;
+
+        // The event `ahead` places after the next one, if it is due
+        // at the same nanosecond; null otherwise (for prefetching)
+        [[nodiscard]] const ScheduledEvent* peek(size_t ahead) const noexcept;
+
+        [[nodiscard]] bool empty() const noexcept;
+        [[nodiscard]] size_t size() const noexcept;
+
+        void clear() noexcept;
+
+    private:
+
+        static constexpr size_t LEVELS = 8;
+        static constexpr size_t SLOTS = 256;
+
+        struct Level
+        {
+            std::array<uint64_t, SLOTS / 64> occupied{};   // bit per non-empty slot
+            std::array<std::vector<ScheduledEvent>, SLOTS> slots;
+        };
+
+        std::vector<Level> levels;
+        SimTime current = 0;   // time of the last event popped
+        size_t cursor = 0;     // next event in current's level-0 slot
+        size_t count = 0;
+        std::vector<ScheduledEvent> cascading;
+
+        void file(ScheduledEvent event);
+
+        // First occupied slot at or after `from` in a level, or SLOTS
+        [[nodiscard]] size_t nextSlot(const Level& level, size_t from) const noexcept;
+
+        // Moves the first occupied slot above `current` in the
+        // lowest level that has one down the wheel
+        void cascade();
+    };
+
+    // ============================================================
+    // AGENT COROUTINES
+    // ============================================================
+
+    // Return type of an agent coroutine. It starts suspended; the
+    // simulator runs it from spawn()'s time and destroys it when
+    // it returns. An exception escaping the agent is rethrown from
+    // AgentSimulator::run().
+    class SimTask
+    {
+    public:
+
+        struct promise_type
+        {
+            std::exception_ptr error;
+
+            SimTask get_return_object() noexcept
+            {
+                return SimTask(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            std::suspend_always final_suspend() const noexcept { return {}; }
+
+            void return_void() const noexcept {}
+
+            void unhandled_exception() noexcept
+            {
+                error = std::current_exception();
+            }
+        };
+
+        using Handle = std::coroutine_handle<promise_type>;
+
+        SimTask(SimTask&& other) noexcept
+            : handle(std::exchange(other.handle, {}))
+        {
+        }
+
+        SimTask& operator=(SimTask&& other) noexcept
+        {
+            if (this != &other)
+            {
+                if (handle)
+                    handle.destroy();
+
+                handle = std::exchange(other.handle, {});
+            }
+
+            return *this;
+        }
+
+        SimTask(const SimTask&) = delete;
+        SimTask& operator=(const SimTask&) = delete;
+
+        ~SimTask()
+        {
+            if (handle)
+                handle.destroy();
+        }
+
+        // Hands the frame over to the caller
+        [[nodiscard]] Handle release() noexcept
+        {
+            return std::exchange(handle, {});
+        }
+
+    private:
+
+        explicit SimTask(Handle handle_) noexcept
+            : handle(handle_)
+        {
+        }
+
+        Handle handle;
+    };
+
+    class AgentContext;
+
+    struct AgentSimulatorOptions
+    {
+        uint64_t seed = 1;
+        LatencyModel latency{};   // default for spawn()
+    };
+
+    // ============================================================
+    // SIMULATOR
+    // ============================================================
+
+    class AgentSimulator
+    {
+    public:
+
+        using Options = AgentSimulatorOptions;
+
+        static constexpr SimTime NEVER = std::numeric_limits<SimTime>::max();
+
+        // Agents (and requests or fills in flight) are limited to
+        // 2^24 each, and one simulator to 2^39 scheduled events
+        static constexpr size_t MAX_AGENTS = size_t{ 1 } << 24;
+
+        // The engine must outlive the simulator; it is driven in
+        // simulated time from here on
+        explicit AgentSimulator(MatchingEngine& engine, Options options = {});
+        ~AgentSimulator();
+
+        AgentSimulator(const AgentSimulator&) = delete;
+        AgentSimulator& operator=(const AgentSimulator&) = delete;
+
+        // Calls factory(AgentContext) and starts the agent at now();
+        // also callable from inside an agent. Returns the agent id.
+        // Throws std::runtime_error past MAX_AGENTS.
+        template <typename Factory>
+        uint32_t spawn(Factory&& factory);
+
+        template <typename Factory>
+        uint32_t spawn(Factory&& factory, LatencyModel latency);
+
+        // Processes events in time order until none are left, or up
+        // to and including `end` (now() then advances to `end`).
+        // Returns the number processed.
+        uint64_t run();
+        uint64_t runUntil(SimTime end);
+
+        [[nodiscard]] SimTime now() const noexcept;
+
+        [[nodiscard]] size_t agentCount() const noexcept;
+        [[nodiscard]] size_t runningAgents() const noexcept;   // not yet returned
+        [[nodiscard]] size_t pendingEvents() const noexcept;
+        [[nodiscard]] uint64_t eventsProcessed() const noexcept;
+
+        [[nodiscard]] MatchingEngine& getEngine() noexcept;
+        [[nodiscard]] const MatchingEngine& getEngine() const noexcept;
+
+        // ========================================================
+        // AWAITABLES (returned by AgentContext)
+        // ========================================================
+
+        class SleepAwaiter
+        {
+        public:
+
+            SleepAwaiter(AgentSimulator& simulator_, uint32_t agent_, SimTime until_) noexcept
+                : simulator(simulator_), agent(agent_), until(until_)
+            {
+            }
+
+            // Even a zero sleep lets other agents due now run first
+            [[nodiscard]] bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<>) { simulator.waitTimer(agent, until); }
+            void await_resume() const noexcept {}
+
+        private:
+            AgentSimulator& simulator;
+            uint32_t agent;
+            SimTime until;
+        };
+
+        // Round trip to the engine; resumes with the reply
+        template <typename Result>
+        class RequestAwaiter
+        {
+        public:
+
+            RequestAwaiter(AgentSimulator& simulator_, uint32_t agent_,
+                Side side_, OrderType type_, double price_, uint64_t quantity_, uint64_t orderId_) noexcept
+                : simulator(simulator_), agent(agent_),
+                side(side_), type(type_), price(price_), quantity(quantity_), orderId(orderId_)
+            {
+            }
+
+            [[nodiscard]] bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<>)
+            {
+                simulator.request(agent, side, type, price, quantity, orderId, &reply);
+            }
+
+            [[nodiscard]] Result await_resume() const noexcept
+            {
+                return static_cast<Result>(reply);
+            }
+
+        private:
+            AgentSimulator& simulator;
+            uint32_t agent;
+            Side side;
+            OrderType type;
+            double price;
+            uint64_t quantity;
+            uint64_t orderId;   // 0 submits, otherwise cancels
+            uint64_t reply = 0;
+        };
+
+        // Next fill of any of the agent's orders; with a deadline,
+        // std::nullopt if none arrives by then
+        template <bool Timed>
+        class FillAwaiter
+        {
+        public:
+
+            FillAwaiter(AgentSimulator& simulator_, uint32_t agent_, SimTime deadline_) noexcept
+                : simulator(simulator_), agent(agent_), deadline(deadline_)
+            {
+            }
+
+            [[nodiscard]] bool await_ready() noexcept { return simulator.takeFill(agent, fill); }
+            void await_suspend(std::coroutine_handle<>) { simulator.waitFill(agent, deadline, &fill); }
+
+            [[nodiscard]] std::conditional_t<Timed, std::optional<SimFill>, SimFill> await_resume() const noexcept
+            {
+                if constexpr (Timed)
+                    return fill;
+                else
+                    return *fill;
+            }
+
+        private:
+            AgentSimulator& simulator;
+            uint32_t agent;
+            SimTime deadline;
+            std::optional<SimFill> fill;
+        };
+
+    private:
+
+        friend class AgentContext;
+
+        enum class Wait : uint8_t
+        {
+            None,
+            Timer,
+            Reply,
+            Fill,
+            FillOrTimer
+        };
+
+        static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+        // Everything a wake touches, in one cache line
+        struct alignas(CACHE_LINE_SIZE) Agent
+        {
+            SimTask::Handle task;     // null once returned
+            SimTime deadline = 0;     // timer, while waiting on one
+            SimRandom random;
+            void* result = nullptr;   // awaiter's reply or fill slot
+
+            // Arrival of the last message each way, keeping each
+            // direction in order whatever the jitter
+            SimTime lastSent = 0;
+            SimTime lastDelivered = 0;
+
+            // Fills delivered while the agent was busy
+            uint32_t inboxHead = NONE;
+            uint32_t inboxTail = NONE;
+
+            Wait wait = Wait::None;
+        };
+
+        enum class MessageKind : uint8_t
+        {
+            Submit,   // agent -> engine
+            Cancel,
+            Reply,    // engine -> agent
+            Fill
+        };
+
+        // Pooled; indices are recycled through freeMessages
+        struct Message
+        {
+            MessageKind kind = MessageKind::Submit;
+            Side side = Side::Buy;
+            OrderType type = OrderType::Limit;
+            uint32_t agent = 0;
+            uint32_t next = NONE;     // inbox link
+            double price = 0.0;
+            uint64_t quantity = 0;
+            uint64_t orderId = 0;     // or the reply value
+            uint64_t remaining = 0;
+            SimTime tradeTime = 0;
+        };
+
+        // Agent orders resting or in flight at the engine
+        struct LiveOrder
+        {
+            uint32_t agent;
+            uint64_t remaining;
+        };
+
+        MatchingEngine& engine;
+        Options options;
+        SimRandom network;   // latency jitter
+
+        SimEventQueue queue;
+        SimTime clock = 0;
+        uint64_t nextSequence = 0;
+        uint64_t processed = 0;
+
+        std::vector<Agent> agents;
+        std::vector<LatencyModel> latencies;   // per agent, read only when sending
+        size_t running = 0;
+
+        std::vector<Message> messages;
+        std::vector<uint32_t> freeMessages;
+
+        std::unordered_map<uint64_t, LiveOrder> orders;
+        size_t tradesSeen = 0;
+
+        [[nodiscard]] uint32_t nextAgentId() const;
+        uint32_t start(uint32_t agent, SimTask task, LatencyModel latency);
+
+        void schedule(SimTime time, bool message, uint32_t index);
+        [[nodiscard]] SimTime delay(const LatencyModel& latency) noexcept;
+
+        [[nodiscard]] uint32_t allocateMessage();
+        void sendToEngine(uint32_t message);
+        void sendToAgent(uint32_t agent, uint32_t message);
+
+        // Event handlers
+        void wake(uint32_t agent);
+        void deliver(uint32_t message);
+        void execute(const Message& request);
+        void dispatchFills();
+        void notifyFill(uint64_t orderId, Side side, const Trade& trade);
+        void resume(uint32_t agent);
+
+        // Awaiter hooks
+        void waitTimer(uint32_t agent, SimTime until);
+        void request(uint32_t agent, Side side, OrderType type, double price,
+            uint64_t quantity, uint64_t orderId, uint64_t* reply);
+        [[nodiscard]] bool takeFill(uint32_t agent, std::optional<SimFill>& fill) noexcept;
+        void waitFill(uint32_t agent, SimTime deadline, std::optional<SimFill>* fill);
+
+        [[nodiscard]] static SimFill toFill(const Message& message) noexcept;
+    };
+
+    // ============================================================
+    // AGENT CONTEXT
+    // ============================================================
+
+    // An agent's handle on the simulation, passed to its coroutine
+    class AgentContext
+    {
+    public:
+
+        AgentContext(AgentSimulator& simulator_, uint32_t agent_) noexcept
+            : simulator(&simulator_), agent(agent_)
+        {
+        }
+
+        [[nodiscard]] uint32_t id() const noexcept { return agent; }
+        [[nodiscard]] SimTime now() const noexcept { return simulator->clock; }
+
+        // The agent's own stream; the reference is valid until the
+        // next spawn()
+        [[nodiscard]] SimRandom& random() const noexcept { return simulator->agents[agent].random; }
+
+        // The engine as it stands now, without market-data latency
+        [[nodiscard]] const MatchingEngine& engine() const noexcept { return simulator->engine; }
+
+        [[nodiscard]] AgentSimulator& getSimulator() const noexcept { return *simulator; }
+
+        [[nodiscard]] AgentSimulator::SleepAwaiter sleep(SimTime duration) const noexcept
+        {
+            return { *simulator, agent, simulator->clock + duration };
+        }
+
+        [[nodiscard]] AgentSimulator::SleepAwaiter sleepUntil(SimTime time) const noexcept
+        {
+            return { *simulator, agent, time };
+        }
+
+        // Resumes with the order id, or 0 if the engine rejected it
+        [[nodiscard]] AgentSimulator::RequestAwaiter<uint64_t> submit(Side side,
+            OrderType type,
+            double price,
+            uint64_t quantity) const noexcept
+        {
+            return { *simulator, agent, side, type, price, quantity, 0 };
+        }
+
+        // Resumes with false if the order is not this agent's, or
+        // already filled or cancelled when the request arrives
+        [[nodiscard]] AgentSimulator::RequestAwaiter<bool> cancel(uint64_t orderId) const noexcept
+        {
+            return { *simulator, agent, Side::Buy, OrderType::Limit, 0.0, 0, orderId };
+        }
+
+        [[nodiscard]] AgentSimulator::FillAwaiter<false> nextFill() const noexcept
+        {
+            return { *simulator, agent, AgentSimulator::NEVER };
+        }
+
+        [[nodiscard]] AgentSimulator::FillAwaiter<true> nextFill(SimTime timeout) const noexcept
+        {
+            return { *simulator, agent, simulator->clock + timeout };
+        }
+
+    private:
+        AgentSimulator* simulator;
+        uint32_t agent;
+    };
+
+    // ============================================================
+    // SPAWN
+    // ============================================================
+
+    template <typename Factory>
+    uint32_t AgentSimulator::spawn(Factory&& factory)
+    {
+        return spawn(std::forward<Factory>(factory), options.latency);
+    }
+
+    template <typename Factory>
+    uint32_t AgentSimulator::spawn(Factory&& factory, LatencyModel latency)
+    {
+        const uint32_t agent = nextAgentId();
+        SimTask task = std::forward<Factory>(factory)(AgentContext(*this, agent));
+        return start(agent, std::move(task), latency);
+    }
+
+} // namespace hft
@@ -0,0 +1,298 @@
+#include "AsyncLogger.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <stdexcept>
+#include <utility>
+
+namespace hft
+{
+
+    namespace
+    {
+        constexpr size_t MIN_BUFFER_BYTES = 4096;
+    }
+
+    AsyncLogger::AsyncLogger(std::ostream& out_, Options options_)
+        : out(out_),
+        options(options_),
+        loggerId(ThreadSlotRegistry<Channel>::nextOwnerId())
+    {
+    }
+
+    AsyncLogger::AsyncLogger(const std::filesystem::path& file, Options options_)
+        : ownedFile(std::make_unique<std::ofstream>(file, std::ios::binary | std::ios::trunc)),
+        out(*ownedFile),
+        options(options_),
+        loggerId(ThreadSlotRegistry<Channel>::nextOwnerId())
+    {
+        if (!*ownedFile)
+            throw std::runtime_error("AsyncLogger: cannot open " + file.string());
+    }
+
+    AsyncLogger::~AsyncLogger()
+    {
+        stop();
+        ThreadSlotRegistry<Channel>::release(loggerId);
+    }
+
+    // ============================================================
+    // PER-THREAD RINGS
+    // ============================================================
+
+    AsyncLogger::Channel::Channel(size_t capacity_)
+        : capacity(std::bit_ceil(std::max(capacity_, MIN_BUFFER_BYTES))),
+        buffer(std::make_unique<std::byte[]>(capacity))
+    {
+    }
+
+    std::byte* AsyncLogger::Channel::reserve(uint32_t size) noexcept
+    {
+        uint64_t position = head.load(std::memory_order_relaxed);
+        size_t offset = static_cast<size_t>(position & (capacity - 1));
+        const size_t toEnd = capacity - offset;
+
+        // Records never straddle the end; the gap is skipped
+        const uint64_t needed = size + (toEnd < size ? toEnd : 0);
+
+        if (position + needed - cachedTail > capacity)
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+
+            if (position + needed - cachedTail > capacity)
+            {
+                // Only this thread writes the counter
+                dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+        }
+
+        if (toEnd < size)
+        {
+            // Gaps too small for a header are skipped by the reader implicitly
+            if (toEnd >= sizeof(RecordHeader))
+            {
+                const RecordHeader padding{ nullptr, nullptr, static_cast<uint32_t>(toEnd), 0 };
+                std::memcpy(buffer.get() + offset, &padding, sizeof(padding));
+            }
+
+            position += toEnd;
+            offset = 0;
+        }
+
+        reservedHead = position + size;
+        return buffer.get() + offset;
+    }
+
+    void AsyncLogger::Channel::commit() noexcept
+    {
+        head.store(reservedHead, std::memory_order_release);
+    }
+
+    AsyncLogger::Channel* AsyncLogger::registerThread()
+    {
+        std::lock_guard lock(channelMutex);
+        channels.push_back(std::make_unique<Channel>(options.bufferBytes));
+        channelCount.store(channels.size(), std::memory_order_release);
+        return channels.back().get();
+    }
+
+    uint64_t AsyncLogger::droppedCount() const noexcept
+    {
+        std::lock_guard lock(channelMutex);
+
+        uint64_t total = 0;
+        for (const auto& channel : channels)
+            total += channel->dropped.load(std::memory_order_relaxed);
+
+        return total;
+    }
+
+    // ============================================================
+    // WRITER THREAD
+    // ============================================================
+
+    void AsyncLogger::start()
+    {
+        if (worker.joinable())
+            return;
+
+        worker = std::jthread([this](std::stop_token stop)
+            {
+                run(stop);
+            });
+    }
+
+    void AsyncLogger::stop()
+    {
+        if (worker.joinable())
+        {
+            // The writer drains once more after seeing the request
+            worker.request_stop();
+            worker.join();
+            return;
+        }
+
+        // Never started: the caller is the only consumer
+        std::vector<Channel*> seen;
+        std::string batch;
+        drain(seen, batch);
+    }
+
+    void AsyncLogger::flush()
+    {
+        if (!worker.joinable())
+            return;
+
+        const uint64_t ticket = flushRequested.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+        std::unique_lock lock(flushMutex);
+        flushed.wait(lock, [&] { return flushCompleted >= ticket; });
+    }
+
+    void AsyncLogger::run(std::stop_token stop)
+    {
+        std::vector<Channel*> seen;
+        std::string batch;
+
+        while (true)
+        {
+            // Read both before draining: whatever preceded them is written below
+            const uint64_t ticket = flushRequested.load(std::memory_order_acquire);
+            const bool stopping = stop.stop_requested();
+
+            const bool wrote = drain(seen, batch);
+
+            if (ticket != flushCompleted)
+            {
+                {
+                    std::lock_guard lock(flushMutex);
+                    flushCompleted = ticket;
+                }
+
+                flushed.notify_all();
+            }
+
+            if (stopping)
+                break;
+
+            if (!wrote)
+                std::this_thread::sleep_for(options.idleSleep);
+        }
+    }
+
+    bool AsyncLogger::drain(std::vector<Channel*>& seen, std::string& batch)
+    {
+        if (seen.size() != channelCount.load(std::memory_order_acquire))
+        {
+            std::lock_guard lock(channelMutex);
+
+            seen.clear();
+            for (const auto& channel : channels)
+                seen.push_back(channel.get());
+        }
+
+        batch.clear();
+        for (Channel* channel : seen)
+            drainChannel(*channel, batch);
+
+        if (batch.empty())
+            return false;
+
+        // One write per pass, however many records it holds
+        out.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+        out.flush();
+        return true;
+    }
+
+    void AsyncLogger::drainChannel(Channel& channel, std::string& batch)
+    {
+        const uint64_t end = channel.head.load(std::memory_order_acquire);
+        uint64_t position = channel.tail.load(std::memory_order_relaxed);
+
+        while (position != end)
+        {
+            const size_t offset = static_cast<size_t>(position & (channel.capacity - 1));
+            const size_t toEnd = channel.capacity - offset;
+
+            if (toEnd < sizeof(RecordHeader))
+            {
+                position += toEnd;
+                continue;
+            }
+
+            RecordHeader header;
+            std::memcpy(&header, channel.buffer.get() + offset, sizeof(header));
+
+            if (header.decode != nullptr)
+                header.decode(batch, header.format, channel.buffer.get() + offset + sizeof(header));
+
+            position += header.size;
+        }
+
+        channel.tail.store(position, std::memory_order_release);
+
+        const uint64_t dropped = channel.dropped.load(std::memory_order_relaxed);
+        if (dropped != channel.droppedReported)
+        {
+            batch += "AsyncLogger: ";
+            appendUnsigned(batch, dropped - channel.droppedReported);
+            batch += " records dropped (ring full)\n";
+            channel.droppedReported = dropped;
+        }
+    }
+
+    // ============================================================
+    // FORMATTING
+    // ============================================================
+
+    const char* AsyncLogger::appendUntilPlaceholder(std::string& out, const char* format)
+    {
+        const char* cursor = format;
+
+        while (*cursor != '\0')
+        {
+            if (cursor[0] == '{' && cursor[1] == '}')
+            {
+                out.append(format, cursor);
+                return cursor + 2;
+            }
+
+            ++cursor;
+        }
+
+        // More arguments than placeholders: append them after the text
+        out.append(format, cursor);
+        out.push_back(' ');
+        return cursor;
+    }
+
+    void AsyncLogger::appendSigned(std::string& out, int64_t value)
+    {
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    void AsyncLogger::appendUnsigned(std::string& out, uint64_t value)
+    {
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    void AsyncLogger::appendDouble(std::string& out, double value)
+    {
+        // Shortest representation that round-trips
+        char digits[32];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    void AsyncLogger::appendText(std::string& out, const char* text)
+    {
+        out.append(text != nullptr ? text : "(null)");
+    }
+
+} // namespace hft
@@ -0,0 +1,245 @@
+#pragma once
+
+#include "HFTUtils.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+
+    Asynchronous binary logger.
+
+    log(format, args...) copies a 24-byte header (decoder and
+    format pointers, record size) plus the raw argument bytes
+    into the calling thread's own ring buffer and returns. No
+    formatting, no allocation, no lock: each producer thread
+    owns a single-producer/single-consumer ring, registered on
+    its first call.
+
+    A background thread drains every ring, expands "{}"
+    placeholders and writes the text to the sink in one batch
+    per pass. A full ring drops the record and counts it; the
+    producer never waits on the disk.
+
+    Arguments must be trivially copyable: integers, floating
+    point, enums (written as their value), bool, and const
+    char* pointing at storage that outlives the logger (string
+    literals). Format strings must be literals too. Records from
+    one thread keep their order; records from different threads
+    are interleaved per drain pass.
+*/
+
+namespace hft
+{
+
+    struct AsyncLoggerOptions
+    {
+        size_t bufferBytes = 1 << 20;   // per producer thread, rounded up to a power of two
+        std::chrono::microseconds idleSleep{ 500 };
+    };
+
+    class AsyncLogger
+    {
+    public:
+
+        using Options = AsyncLoggerOptions;
+
+        explicit AsyncLogger(std::ostream& out, Options options = {});
+        explicit AsyncLogger(const std::filesystem::path& file, Options options = {});
+
+        ~AsyncLogger();
+
+        AsyncLogger(const AsyncLogger&) = delete;
+        AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+        // Producer side (any thread)
+        template <typename... Args>
+        void log(const char* format, const Args&... args) noexcept;
+
+        // Background writer. Records logged before start() wait in
+        // their ring; stop() drains everything still queued.
+        void start();
+        void stop();
+
+        // Blocks until everything logged before the call is written
+        // (returns at once if the writer is not running)
+        void flush();
+
+        [[nodiscard]] uint64_t droppedCount() const noexcept;
+
+    private:
+
+        using Decoder = void (*)(std::string&, const char*, const std::byte*);
+
+        struct RecordHeader
+        {
+            Decoder decode;         // null marks wrap-around padding
+            const char* format;
+            uint32_t size;          // header + payload, multiple of 8
+            uint32_t reserved;
+        };
+
+        static_assert(sizeof(RecordHeader) == 24);
+
+        // One per producer thread; the writer is the only consumer
+        struct Channel
+        {
+            explicit Channel(size_t capacity_);
+
+            [[nodiscard]] std::byte* reserve(uint32_t size) noexcept;
+            void commit() noexcept;
+
+            // Producer
+            alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head{ 0 };
+            uint64_t reservedHead = 0;
+            uint64_t cachedTail = 0;
+
+            // Consumer
+            alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail{ 0 };
+
+            alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> dropped{ 0 };
+            uint64_t droppedReported = 0;
+
+            size_t capacity;
+            std::unique_ptr<std::byte[]> buffer;
+        };
+
+        std::unique_ptr<std::ofstream> ownedFile;
+        std::ostream& out;
+        Options options;
+        const uint64_t loggerId;
+
+        mutable std::mutex channelMutex;
+        std::vector<std::unique_ptr<Channel>> channels;
+        std::atomic<size_t> channelCount{ 0 };
+
+        // flush() handshake with the writer
+        std::mutex flushMutex;
+        std::condition_variable flushed;
+        std::atomic<uint64_t> flushRequested{ 0 };
+        uint64_t flushCompleted = 0;
+
+        std::jthread worker;
+
+        [[nodiscard]] Channel& localChannel();
+
+        // A new channel for the calling thread
+        [[nodiscard]] Channel* registerThread();
+
+        // Formats everything queued; returns false if nothing was
+        bool drain(std::vector<Channel*>& seen, std::string& batch);
+        void drainChannel(Channel& channel, std::string& batch);
+        void run(std::stop_token stop);
+
+        template <typename... Args>
+        static void decodeRecord(std::string& out, const char* format, const std::byte* payload);
+
+        template <typename T>
+        static void appendValue(std::string& out, T value);
+
+        // Copies literal text up to the next "{}" and returns what follows it
+        static const char* appendUntilPlaceholder(std::string& out, const char* format);
+
+        static void appendSigned(std::string& out, int64_t value);
+        static void appendUnsigned(std::string& out, uint64_t value);
+        static void appendDouble(std::string& out, double value);
+        static void appendText(std::string& out, const char* text);
+    };
+
+    // ============================================================
+    // PRODUCER PATH
+    // ============================================================
+
+    template <typename... Args>
+    void AsyncLogger::log(const char* format, const Args&... args) noexcept
+    {
+        static_assert((std::is_trivially_copyable_v<std::decay_t<const Args>> && ...),
+            "AsyncLogger arguments are copied as raw bytes");
+
+        // String literals decay to const char*; everything else is copied as is
+        constexpr size_t payloadSize = (sizeof(std::decay_t<const Args>) + ... + 0);
+        constexpr uint32_t recordSize =
+            static_cast<uint32_t>((sizeof(RecordHeader) + payloadSize + 7) & ~size_t{ 7 });
+
+        Channel& channel = localChannel();
+        std::byte* record = channel.reserve(recordSize);
+        if (record == nullptr)
+            return;
+
+        const RecordHeader header{ &decodeRecord<std::decay_t<const Args>...>, format, recordSize, 0 };
+        std::memcpy(record, &header, sizeof(header));
+
+        std::byte* cursor = record + sizeof(header);
+        auto write = [&cursor](const auto value)
+            {
+                std::memcpy(cursor, &value, sizeof(value));
+                cursor += sizeof(value);
+            };
+
+        (write(static_cast<std::decay_t<const Args>>(args)), ...);
+
+        channel.commit();
+    }
+
+    inline AsyncLogger::Channel& AsyncLogger::localChannel()
+    {
+        return ThreadSlotRegistry<Channel>::local(loggerId, [this] { return registerThread(); });
+    }
+
+    // ============================================================
+    // WRITER-SIDE DECODING
+    // ============================================================
+
+    template <typename... Args>
+    void AsyncLogger::decodeRecord(std::string& out, const char* format, const std::byte* payload)
+    {
+        const char* cursor = format;
+
+        auto next = [&](auto value)
+            {
+                std::memcpy(&value, payload, sizeof(value));
+                payload += sizeof(value);
+
+                cursor = appendUntilPlaceholder(out, cursor);
+                appendValue(out, value);
+            };
+
+        (next(std::remove_cv_t<Args>{}), ...);
+
+        appendText(out, cursor);
+        out.push_back('\n');
+    }
+
+    template <typename T>
+    void AsyncLogger::appendValue(std::string& out, T value)
+    {
+        if constexpr (std::is_same_v<T, bool>)
+            appendText(out, value ? "true" : "false");
+        else if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*>)
+            appendText(out, value);
+        else if constexpr (std::is_enum_v<T>)
+            appendValue(out, static_cast<std::underlying_type_t<T>>(value));
+        else if constexpr (std::is_floating_point_v<T>)
+            appendDouble(out, static_cast<double>(value));
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+            appendSigned(out, static_cast<int64_t>(value));
+        else if constexpr (std::is_integral_v<T>)
+            appendUnsigned(out, static_cast<uint64_t>(value));
+        else
+            static_assert(sizeof(T) == 0, "AsyncLogger cannot format this argument type");
+    }
+
+} // namespace hft
@@ -0,0 +1,220 @@
+#include "Backtest.hpp"
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace hft
+{
+
+    namespace
+    {
+        constexpr char REPLAY_MAGIC[8] = { 'H', 'F', 'T', 'R', 'P', 'L', 'Y', '1' };
+
+        constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+        constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+        void mix(uint64_t& hash, uint64_t value) noexcept
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                hash ^= (value >> (i * 8)) & 0xFF;
+                hash *= FNV_PRIME;
+            }
+        }
+    }
+
+    // ============================================================
+    // REPLAY FILES
+    // ============================================================
+
+    void writeReplayFile(const std::string& path, std::span<const ReplayEvent> events)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("writeReplayFile: cannot open " + path);
+
+        ReplayFileHeader header{};
+        std::memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+        header.eventCount = events.size();
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(events.data()),
+            static_cast<std::streamsize>(events.size_bytes()));
+
+        if (!out)
+            throw std::runtime_error("writeReplayFile: write failed for " + path);
+    }
+
+    void ReplayDataset::addDay(const std::string& path)
+    {
+        MappedFile file(path);
+
+        if (file.size() < sizeof(ReplayFileHeader))
+            throw std::runtime_error("ReplayDataset: truncated header in " + path);
+
+        const auto* header = reinterpret_cast<const ReplayFileHeader*>(file.data());
+
+        if (std::memcmp(header->magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0)
+            throw std::runtime_error("ReplayDataset: bad magic in " + path);
+
+        if (!fitsIn(header->eventCount, sizeof(ReplayEvent), file.size() - sizeof(ReplayFileHeader)))
+            throw std::runtime_error("ReplayDataset: size mismatch in " + path);
+
+        const auto* first = reinterpret_cast<const ReplayEvent*>(
+            file.data() + sizeof(ReplayFileHeader));
+
+        days.emplace_back(first, header->eventCount);
+        files.push_back(std::move(file));
+    }
+
+    size_t ReplayDataset::dayCount() const noexcept
+    {
+        return days.size();
+    }
+
+    std::span<const ReplayEvent> ReplayDataset::day(size_t index) const noexcept
+    {
+        return days[index];
+    }
+
+    // ============================================================
+    // RUNNER
+    // ============================================================
+
+    BacktestRunner::BacktestRunner(const ReplayDataset& dataset_,
+        std::vector<BacktestConfig> configs_)
+        : dataset(dataset_),
+        configs(std::move(configs_))
+    {
+    }
+
+    std::vector<BacktestResult> BacktestRunner::run(ThreadPool& pool) const
+    {
+        const size_t days = dataset.dayCount();
+        std::vector<BacktestResult> results(configs.size() * days);
+
+        pool.parallelFor(results.size(), [&](size_t job)
+            {
+                results[job] = runOne(job / days, job % days);
+            });
+
+        return results;
+    }
+
+    BacktestResult BacktestRunner::runOne(size_t configIndex, size_t dayIndex) const
+    {
+        const BacktestConfig& config = configs[configIndex];
+        const std::span<const ReplayEvent> events = dataset.day(dayIndex);
+
+        MatchingEngine engine;
+        engine.setRiskLimits(config.riskLimits);
+
+        BacktestStrategy strategy;
+        if (config.strategyFactory)
+            strategy = config.strategyFactory();
+
+        ShadowFillSimulator shadows(engine.getOrderBook());
+        ShadowStrategy shadowStrategy;
+        if (config.shadowStrategyFactory)
+        {
+            shadowStrategy = config.shadowStrategyFactory();
+            engine.attachShadowFills(&shadows);
+        }
+
+        for (const ReplayEvent& event : events)
+        {
+            engine.setSimulatedTime(Timestamp{} + std::chrono::nanoseconds(event.timestampNs));
+
+            switch (event.action)
+            {
+            case ReplayAction::Submit:
+                (void)engine.submitOrder(event.side, event.type, event.price, event.quantity);
+                break;
+            }
+
+            if (strategy)
+                strategy(engine, event);
+
+            if (shadowStrategy)
+                shadowStrategy(shadows, engine, event);
+        }
+
+        BacktestResult result;
+        result.configIndex = configIndex;
+        result.dayIndex = dayIndex;
+        result.events = events.size();
+
+        const MetricsRegistry& metrics = engine.getMetrics();
+        result.ordersAccepted = metrics.get(Metric::OrdersAccepted);
+        result.ordersRejected = metrics.get(Metric::OrdersRejectedPrice)
+            + metrics.get(Metric::OrdersRejectedQuantity)
+            + metrics.get(Metric::OrdersRejectedMarketDisabled)
+            + metrics.get(Metric::OrdersRejectedOrderId);
+
+        const OrderBook& book = engine.getOrderBook();
+        result.vwap = book.calculateVWAP();
+        result.finalBid = book.getBestBid();
+        result.finalAsk = book.getBestAsk();
+
+        uint64_t checksum = FNV_OFFSET;
+        for (const Trade& trade : engine.getTrades())
+        {
+            ++result.tradeCount;
+            result.tradedVolume += trade.quantity;
+
+            mix(checksum, trade.buyOrderId);
+            mix(checksum, trade.sellOrderId);
+            mix(checksum, std::bit_cast<uint64_t>(trade.price));
+            mix(checksum, trade.quantity);
+            mix(checksum, static_cast<uint64_t>(trade.timestamp.time_since_epoch().count()));
+        }
+        result.tradeChecksum = checksum;
+
+        for (const ShadowFill& fill : shadows.getFills())
+        {
+            ++result.shadowFills;
+            result.shadowVolume += fill.quantity;
+        }
+
+        return result;
+    }
+
+    // ============================================================
+    // SUMMARY TABLE
+    // ============================================================
+
+    void BacktestRunner::printSummary(std::ostream& out,
+        const std::vector<BacktestResult>& results) const
+    {
+        out << "\n====== BACKTEST SUMMARY ======\n";
+        out << std::left << std::setw(16) << "Config"
+            << std::right << std::setw(5) << "Day"
+            << std::setw(10) << "Events"
+            << std::setw(10) << "Accepted"
+            << std::setw(10) << "Rejected"
+            << std::setw(10) << "Trades"
+            << std::setw(12) << "Volume"
+            << std::setw(12) << "VWAP"
+            << std::setw(12) << "ShadowVol"
+            << std::setw(18) << "Checksum" << "\n";
+
+        for (const BacktestResult& r : results)
+        {
+            out << std::left << std::setw(16) << configs[r.configIndex].name
+                << std::right << std::setw(5) << r.dayIndex
+                << std::setw(10) << r.events
+                << std::setw(10) << r.ordersAccepted
+                << std::setw(10) << r.ordersRejected
+                << std::setw(10) << r.tradeCount
+                << std::setw(12) << r.tradedVolume
+                << std::setw(12) << std::fixed << std::setprecision(4) << r.vwap
+                << std::setw(12) << r.shadowVolume
+                << std::setw(18) << std::hex << r.tradeChecksum << std::dec
+                << std::defaultfloat << "\n";
+        }
+    }
+
+} // namespace hft
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "MatchingEngine.hpp"
+#include "MappedFile.hpp"
+#include "ShadowFillSimulator.hpp"
+#include "ThreadPool.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*
+
+    Parallel deterministic backtest driver.
+
+    A ReplayDataset maps one binary file per trading day
+    read-only; every job reads the same pages without copying.
+
+    BacktestRunner fans (config x day) jobs out over a
+    work-stealing ThreadPool. Each job owns an independent
+    MatchingEngine driven by simulated time taken from the
+    events, so a job's result depends only on its inputs.
+    Results land in fixed slots, making the summary table
+    bit-for-bit identical for any thread count.
+
+    A shadow strategy backtests orders without inserting them:
+    it places them on a ShadowFillSimulator overlaying the
+    job's book, so the recorded flow replays unchanged and
+    fills come from queue position.
+*/
+
+namespace hft
+{
+
+    // ============================================================
+    // REPLAY FORMAT
+    // ============================================================
+
+    enum class ReplayAction : uint8_t
+    {
+        Submit
+    };
+
+    // Fixed 32-byte record, little-endian, read in place from the map
+    struct ReplayEvent
+    {
+        uint64_t timestampNs;   // nanoseconds since session start
+        double price;
+        uint64_t quantity;
+        Side side;
+        OrderType type;
+        ReplayAction action;
+        uint8_t reserved[5];
+    };
+
+    static_assert(sizeof(ReplayEvent) == 32);
+    static_assert(std::is_trivially_copyable_v<ReplayEvent>);
+
+    struct ReplayFileHeader
+    {
+        char magic[8];
+        uint64_t eventCount;
+    };
+
+    static_assert(sizeof(ReplayFileHeader) == 16);
+
+    // Throws std::runtime_error on I/O failure
+    void writeReplayFile(const std::string& path, std::span<const ReplayEvent> events);
+
+    class ReplayDataset
+    {
+    public:
+
+        // Maps one day's file; throws std::runtime_error if invalid
+        void addDay(const std::string& path);
+
+        [[nodiscard]] size_t dayCount() const noexcept;
+        [[nodiscard]] std::span<const ReplayEvent> day(size_t index) const noexcept;
+
+    private:
+        std::vector<MappedFile> files;
+        std::vector<std::span<const ReplayEvent>> days;
+    };
+
+    // ============================================================
+    // CONFIGURATION AND RESULTS
+    // ============================================================
+
+    // Called after every replayed event; may submit its own orders.
+    // Must be deterministic (no wall clock, no shared mutable state).
+    using BacktestStrategy = std::function<void(MatchingEngine&, const ReplayEvent&)>;
+
+    // Creates fresh per-job strategy state
+    using BacktestStrategyFactory = std::function<BacktestStrategy()>;
+
+    // Called after every replayed event with the job's shadow
+    // overlay; sees the engine read-only. Same determinism rules.
+    using ShadowStrategy = std::function<void(ShadowFillSimulator&, const MatchingEngine&, const ReplayEvent&)>;
+
+    using ShadowStrategyFactory = std::function<ShadowStrategy()>;
+
+    struct BacktestConfig
+    {
+        std::string name;
+        MatchingEngine::RiskLimits riskLimits;
+        BacktestStrategyFactory strategyFactory;
+        ShadowStrategyFactory shadowStrategyFactory{};
+    };
+
+    struct BacktestResult
+    {
+        size_t configIndex = 0;
+        size_t dayIndex = 0;
+        uint64_t events = 0;
+        uint64_t ordersAccepted = 0;
+        uint64_t ordersRejected = 0;
+        uint64_t tradeCount = 0;
+        uint64_t tradedVolume = 0;
+        double vwap = 0.0;
+        double finalBid = 0.0;
+        double finalAsk = 0.0;
+        uint64_t tradeChecksum = 0;
+        uint64_t shadowFills = 0;
+        uint64_t shadowVolume = 0;
+
+        bool operator==(const BacktestResult&) const = default;
+    };
+
+    // ============================================================
+    // RUNNER
+    // ============================================================
+
+    class BacktestRunner
+    {
+    public:
+
+        BacktestRunner(const ReplayDataset& dataset, std::vector<BacktestConfig> configs);
+
+        // Results ordered by (config, day)
+        [[nodiscard]] std::vector<BacktestResult> run(ThreadPool& pool) const;
+
+        [[nodiscard]] BacktestResult runOne(size_t configIndex, size_t dayIndex) const;
+
+        void printSummary(std::ostream& out, const std::vector<BacktestResult>& results) const;
+
+    private:
+        const ReplayDataset& dataset;
+        std::vector<BacktestConfig> configs;
+    };
+
+} // namespace hft
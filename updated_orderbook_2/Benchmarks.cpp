@@ -0,0 +1,1376 @@
+#include "AgentSimulator.hpp"
+#include "AsyncLogger.hpp"
+#include "Backtest.hpp"
+#include "ConsolidatedBook.hpp"
+#include "CrossSectionalAnalytics.hpp"
+#include "DepthIndex.hpp"
+#include "EventArchive.hpp"
+#include "FeedHandler.hpp"
+#include "HFTAlgorithms.hpp"
+#include "MatchingEngine.hpp"
+#include "HFTUtils.hpp"
+#include "OrderIdAllocator.hpp"
+#include "OrderTracer.hpp"
+#include "Replication.hpp"
+#include "ShadowFillSimulator.hpp"
+#include "VectorOrderBook.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <queue>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace hft;
+
+/*
+    Microbenchmarks for the matching core.
+
+    Build in Release before trusting numbers:
+        cmake -S . -B build-release -DCMAKE_BUILD_TYPE=Release
+        cmake --build build-release --target updated_orderbook_bench
+*/
+
+namespace
+{
+    void report(const std::string& name, uint64_t micros, size_t operations)
+    {
+        const double nsPerOp = operations == 0
+            ? 0.0
+            : static_cast<double>(micros) * 1'000.0 / static_cast<double>(operations);
+
+        std::cout << std::left << std::setw(40) << name
+            << std::right << std::setw(12) << std::fixed << std::setprecision(1)
+            << nsPerOp << " ns/op\n";
+    }
+
+    // ============================================================
+    // MATCHING LOOP
+    // ============================================================
+
+    // Aggressive limit orders that each sweep several resting levels
+    void benchLimitCross()
+    {
+        constexpr size_t rounds = 2'000;
+        constexpr size_t levels = 8;
+
+        MatchingEngine engine;
+        size_t operations = 0;
+
+        const uint64_t micros = runBenchmark([&]()
+            {
+                for (size_t i = 0; i < levels; ++i)
+                {
+                    (void)engine.submitOrder(Side::Sell, OrderType::Limit, 100.0 + i, 10);
+                    (void)engine.submitOrder(Side::Buy, OrderType::Limit, 90.0 - i, 10);
+                }
+
+                (void)engine.submitOrder(Side::Buy, OrderType::Limit, 100.0 + levels, 10 * levels);
+                (void)engine.submitOrder(Side::Sell, OrderType::Limit, 90.0 - levels, 10 * levels);
+                operations += 2 * levels + 2;
+            }, rounds);
+
+        report("limit cross (8-level sweep)", micros, operations);
+    }
+
+    // Market orders alternating sides against deep single levels
+    void benchMarketSweep()
+    {
+        constexpr size_t rounds = 2'000;
+        constexpr size_t depth = 32;
+
+        MatchingEngine engine;
+        size_t operations = 0;
+
+        const uint64_t micros = runBenchmark([&]()
+            {
+                for (size_t i = 0; i < depth; ++i)
+                {
+                    (void)engine.submitOrder(Side::Sell, OrderType::Limit, 101.0, 5);
+                    (void)engine.submitOrder(Side::Buy, OrderType::Limit, 99.0, 5);
+                }
+
+                (void)engine.submitOrder(Side::Buy, OrderType::Market, 0.0, 5 * depth);
+                (void)engine.submitOrder(Side::Sell, OrderType::Market, 0.0, 5 * depth);
+                operations += 2 * depth + 2;
+            }, rounds);
+
+        report("market sweep (32-deep level)", micros, operations);
+    }
+
+    // One level holding thousands of small orders, swept in one go
+    void benchDeepQueueSweep()
+    {
+        constexpr size_t rounds = 20;
+        constexpr size_t depth = 200'000;
+
+        MatchingEngine engine;
+        uint64_t sweepMicros = 0;
+
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            // Keep trade history from dominating the measurement
+            engine.reset();
+
+            for (size_t i = 0; i < depth; ++i)
+                (void)engine.submitOrder(Side::Sell, OrderType::Limit, 101.0, 1);
+
+            sweepMicros += runBenchmark([&]()
+                {
+                    (void)engine.submitOrder(Side::Buy, OrderType::Market, 0.0, depth);
+                }, 1);
+        }
+
+        report("deep queue sweep (per fill)", sweepMicros, rounds * depth);
+    }
+
+    // A parent order worked in 100-lot tranches, each taken by one
+    // market order: native iceberg refills vs the client resubmitting
+    // every child (a second message, a new record and level)
+    void benchIcebergRefill()
+    {
+        constexpr size_t tranches = 200'000;
+        constexpr uint64_t display = 100;
+
+        MatchingEngine native;
+        (void)native.submitIceberg(Side::Buy, 100.0, tranches * display, display);
+
+        const uint64_t nativeMicros = runBenchmark([&]()
+            {
+                (void)native.submitOrder(Side::Sell, OrderType::Market, 0.0, display);
+            }, tranches);
+
+        MatchingEngine client;
+        (void)client.submitOrder(Side::Buy, OrderType::Limit, 100.0, display);
+
+        const uint64_t clientMicros = runBenchmark([&]()
+            {
+                (void)client.submitOrder(Side::Sell, OrderType::Market, 0.0, display);
+                (void)client.submitOrder(Side::Buy, OrderType::Limit, 100.0, display);
+            }, tranches);
+
+        report("iceberg tranche, in-place refill", nativeMicros, tranches);
+        report("iceberg tranche, child resubmit", clientMicros, tranches);
+
+        if (native.getOrderBook().getTotalBidVolume() != 0)
+            std::cout << "  (iceberg not exhausted)\n";
+    }
+
+    // Lit quote moves with and without resting pegs: pegs store
+    // offsets, so a move never touches them
+    void benchPeggedQuoteMove()
+    {
+        constexpr size_t moves = 200'000;
+
+        for (const size_t pegs : { size_t{ 0 }, size_t{ 10'000 } })
+        {
+            MatchingEngine engine;
+            (void)engine.submitOrder(Side::Buy, OrderType::Limit, 100.0, 10);
+            (void)engine.submitOrder(Side::Sell, OrderType::Limit, 101.0, 10);
+
+            for (size_t i = 0; i < pegs; ++i)
+            {
+                const double offset = static_cast<double>(i % 100) * 0.25;
+                (void)engine.submitPegged(Side::Buy, PegType::Primary, offset, 10);
+                (void)engine.submitPegged(Side::Sell, PegType::Mid, offset + 0.25, 10);
+            }
+
+            const uint64_t micros = runBenchmark([&]()
+                {
+                    const uint64_t id = engine.submitOrder(Side::Buy, OrderType::Limit, 100.25, 10);
+                    (void)engine.cancelOrder(id);
+                }, moves);
+
+            report("quote move, " + std::to_string(pegs * 2) + " pegs resting", micros, moves * 2);
+        }
+    }
+
+    // Passive inserts that never cross
+    void benchPassiveInsert()
+    {
+        constexpr size_t rounds = 200'000;
+
+        MatchingEngine engine;
+        size_t i = 0;
+
+        const uint64_t micros = runBenchmark([&]()
+            {
+                const double offset = static_cast<double>(i++ % 64) * 0.25;
+                (void)engine.submitOrder(Side::Buy, OrderType::Limit, 90.0 - offset, 10);
+                (void)engine.submitOrder(Side::Sell, OrderType::Limit, 110.0 + offset, 10);
+            }, rounds);
+
+        report("passive insert", micros, rounds * 2);
+    }
+
+    // ============================================================
+    // BACKTEST
+    // ============================================================
+
+    // One fixed config x day grid on pools of 1, 2, 4, ... threads.
+    // Jobs share nothing, so wall time should fall with the thread
+    // count until the pool outgrows the host's cores.
+    void benchBacktestScaling()
+    {
+        constexpr size_t days = 4;
+        constexpr size_t configCount = 8;
+        constexpr size_t eventsPerDay = 50'000;
+
+        const auto dir = std::filesystem::temp_directory_path();
+        std::vector<std::string> paths;
+
+        for (size_t d = 0; d < days; ++d)
+        {
+            SimRandom random(100 + d);
+            std::vector<ReplayEvent> events(eventsPerDay);
+
+            for (size_t i = 0; i < eventsPerDay; ++i)
+            {
+                const uint64_t r = random.next();
+
+                ReplayEvent& event = events[i];
+                event.timestampNs = i * 1'000;
+                event.side = (r & 1) ? Side::Buy : Side::Sell;
+                event.type = (r % 17 == 0) ? OrderType::Market : OrderType::Limit;
+                event.price = 100.0 + static_cast<double>((r >> 4) % 20) * 0.5;
+                event.quantity = 1 + (r >> 12) % 200;
+                event.action = ReplayAction::Submit;
+            }
+
+            paths.push_back((dir / ("hft_bench_replay_day" + std::to_string(d) + ".bin")).string());
+            writeReplayFile(paths.back(), events);
+        }
+
+        {
+            ReplayDataset dataset;
+            for (const std::string& path : paths)
+                dataset.addDay(path);
+
+            // Each config leans on the bid at its own cadence
+            std::vector<BacktestConfig> configs;
+            for (size_t c = 0; c < configCount; ++c)
+            {
+                const int cadence = 20 + static_cast<int>(c) * 10;
+                configs.push_back({ "quoter-" + std::to_string(cadence), {}, [cadence]() -> BacktestStrategy
+                    {
+                        return [cadence, n = 0](MatchingEngine& engine, const ReplayEvent&) mutable
+                            {
+                                if (++n % cadence == 0 && engine.getOrderBook().getBestBid() > 0.0)
+                                    (void)engine.submitOrder(Side::Buy, OrderType::Limit, engine.getOrderBook().getBestBid(), 10);
+                            };
+                    } });
+            }
+
+            const BacktestRunner runner(dataset, configs);
+            const size_t cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+            std::vector<BacktestResult> baseline;
+            uint64_t serialMicros = 0;
+
+            for (size_t threads = 1; threads <= std::max<size_t>(cores, 4); threads *= 2)
+            {
+                ThreadPool pool(threads);
+                std::vector<BacktestResult> results;
+                const uint64_t micros = runBenchmark([&]() { results = runner.run(pool); }, 1);
+
+                if (threads == 1)
+                {
+                    baseline = results;
+                    serialMicros = micros;
+                }
+
+                report("backtest grid, " + std::to_string(threads) + " threads", micros, configCount * days * eventsPerDay);
+                std::cout << "  (" << configCount << "x" << days << " jobs: "
+                    << std::fixed << std::setprecision(2)
+                    << static_cast<double>(serialMicros) / static_cast<double>(std::max<uint64_t>(micros, 1))
+                    << "x vs 1 thread)\n";
+
+                if (results != baseline)
+                    std::cout << "  (results differ from the 1-thread run)\n";
+            }
+
+            if (cores == 1)
+                std::cout << "  (single-core host: no speedup to show)\n";
+        }
+
+        for (const std::string& path : paths)
+            std::filesystem::remove(path);
+    }
+
+    // ============================================================
+    // BACKENDS
+    // ============================================================
+
+    // Mixed submit / cancel / market flow near the touch,
+    // identical for every OrderBookLike backend
+    template <OrderBookLike Book>
+    void benchBackendFlow(const std::string& name)
+    {
+        constexpr size_t rounds = 200'000;
+
+        BasicMatchingEngine<Book> engine;
+        std::vector<uint64_t> live;
+        SimRandom random(12345);
+
+        const uint64_t micros = runBenchmark([&]()
+            {
+                const uint64_t r = random.next();
+                const uint64_t action = r % 10;
+
+                if (action < 4 && !live.empty())
+                {
+                    const size_t pick = (r >> 8) % live.size();
+                    (void)engine.cancelOrder(live[pick]);
+                    live[pick] = live.back();
+                    live.pop_back();
+                    return;
+                }
+
+                const Side side = (r & 0x10) ? Side::Buy : Side::Sell;
+                const OrderType type = (action == 9) ? OrderType::Market : OrderType::Limit;
+                const double offset = static_cast<double>((r >> 12) % 32) * 0.25;
+                const double price = (side == Side::Buy) ? 100.0 - offset : 100.0 + offset;
+
+                const uint64_t id = engine.submitOrder(side, type, price, 1 + (r >> 20) % 100);
+
+                if (type == OrderType::Limit)
+                    live.push_back(id);
+            }, rounds);
+
+        report(name, micros, rounds);
+    }
+
+    // ============================================================
+    // SHADOW ORDERS
+    // ============================================================
+
+    // The mixed flow replayed bare, then under ~2k shadow orders
+    // kept topped up across 32 levels a side
+    uint64_t replayWithShadows(size_t shadowTarget, size_t rounds)
+    {
+        MatchingEngine engine;
+        ShadowFillSimulator shadows(engine.getOrderBook());
+
+        if (shadowTarget > 0)
+            engine.attachShadowFills(&shadows);
+
+        std::vector<uint64_t> live;
+        SimRandom random(12345);
+
+        return runBenchmark([&]()
+            {
+                const uint64_t r = random.next();
+                const uint64_t action = r % 10;
+
+                const Side side = (r & 0x10) ? Side::Buy : Side::Sell;
+                const double offset = static_cast<double>((r >> 12) % 32) * 0.25;
+                const double price = (side == Side::Buy) ? 100.0 - offset : 100.0 + offset;
+
+                if (shadows.openOrders() < shadowTarget)
+                    (void)shadows.place(side, price, 1 + (r >> 24) % 50);
+
+                if (action < 4 && !live.empty())
+                {
+                    const size_t pick = (r >> 8) % live.size();
+                    (void)engine.cancelOrder(live[pick]);
+                    live[pick] = live.back();
+                    live.pop_back();
+                    return;
+                }
+
+                const OrderType type = (action == 9) ? OrderType::Market : OrderType::Limit;
+                const uint64_t id = engine.submitOrder(side, type, price, 1 + (r >> 20) % 100);
+
+                if (type == OrderType::Limit)
+                    live.push_back(id);
+            }, rounds);
+    }
+
+    void benchShadowReplay()
+    {
+        constexpr size_t rounds = 200'000;
+
+        const uint64_t bareMicros = replayWithShadows(0, rounds);
+        const uint64_t shadowMicros = replayWithShadows(2'000, rounds);
+
+        report("replay, no shadow orders", bareMicros, rounds);
+        report("replay, 2k shadow orders", shadowMicros, rounds);
+    }
+
+    // ============================================================
+    // CONSOLIDATED BOOK
+    // ============================================================
+
+    // 10 venues updating 16 levels a side near the touch. Updates
+    // keep merged depth and venue attribution as well as the NBBO;
+    // reads compare the cached NBBO with scanning every venue's best.
+    void benchConsolidatedBook()
+    {
+        constexpr size_t venueCount = 10;
+        constexpr size_t updates = 500'000;
+        constexpr size_t reads = 1'000'000;
+
+        struct Update
+        {
+            VenueId venue;
+            LevelUpdate level;
+        };
+
+        std::vector<Update> flow;
+        flow.reserve(updates);
+
+        SimRandom random(2718);
+        for (size_t i = 0; i < updates; ++i)
+        {
+            const uint64_t r = random.next();
+
+            const Side side = (r & 0x100) ? Side::Buy : Side::Sell;
+            const double offset = static_cast<double>((r >> 9) % 16) * 0.01;
+            const double price = (side == Side::Buy) ? 99.99 - offset : 100.01 + offset;
+            const uint64_t volume = ((r >> 14) % 4 == 0) ? 0 : 1 + (r >> 16) % 1'000;
+
+            flow.push_back({ static_cast<VenueId>(r % venueCount), { side, price, volume, volume == 0 ? 0u : 1u } });
+        }
+
+        ConsolidatedBook book(venueCount);
+        size_t next = 0;
+
+        const uint64_t updateMicros = runBenchmark([&]()
+            {
+                const Update& update = flow[next++];
+                (void)book.apply(update.venue, update.level);
+            }, updates);
+
+        double sink = 0.0;
+
+        const uint64_t cachedMicros = runBenchmark([&]()
+            {
+                const Nbbo& nbbo = book.nbbo();
+                sink += nbbo.ask - nbbo.bid;
+            }, reads);
+
+        // Baseline: the same flow in plain per-venue maps (not timed)
+        std::vector<std::map<double, uint64_t, std::greater<double>>> venueBids(venueCount);
+        std::vector<std::map<double, uint64_t, std::less<double>>> venueAsks(venueCount);
+
+        for (const Update& update : flow)
+        {
+            const LevelUpdate& level = update.level;
+
+            if (level.side == Side::Buy && level.volume == 0)
+                venueBids[update.venue].erase(level.price);
+            else if (level.side == Side::Buy)
+                venueBids[update.venue][level.price] = level.volume;
+            else if (level.volume == 0)
+                venueAsks[update.venue].erase(level.price);
+            else
+                venueAsks[update.venue][level.price] = level.volume;
+        }
+
+        const uint64_t scanMicros = runBenchmark([&]()
+            {
+                double bid = 0.0;
+                double ask = 0.0;
+
+                for (size_t v = 0; v < venueCount; ++v)
+                {
+                    if (!venueBids[v].empty())
+                        bid = std::max(bid, venueBids[v].begin()->first);
+                    if (!venueAsks[v].empty() && (ask == 0.0 || venueAsks[v].begin()->first < ask))
+                        ask = venueAsks[v].begin()->first;
+                }
+
+                sink += ask - bid;
+            }, reads);
+
+        report("consolidated update (10 venues)", updateMicros, updates);
+        report("NBBO read, cached", cachedMicros, reads);
+        report("NBBO read, scan of 10 venues", scanMicros, reads);
+
+        if (sink < 0.0)
+            std::cout << sink;
+    }
+
+    // ============================================================
+    // CALL AUCTION
+    // ============================================================
+
+    // Collect a crossed 100k-order book, then price and uncross it
+    void benchAuctionUncross()
+    {
+        constexpr size_t rounds = 10;
+        constexpr size_t orders = 100'000;
+
+        MatchingEngine engine;
+        uint64_t pricingMicros = 0;
+        uint64_t uncrossMicros = 0;
+        SimRandom random(777);
+
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            engine.reset();
+            engine.setTradingMode(TradingMode::Auction);
+
+            for (size_t i = 0; i < orders; ++i)
+            {
+                const uint64_t r = random.next();
+
+                const Side side = (r & 1) ? Side::Buy : Side::Sell;
+                const double price = 90.0 + static_cast<double>((r >> 4) % 2'000) * 0.01;
+                (void)engine.submitOrder(side, OrderType::Limit, price, 1 + (r >> 20) % 100);
+            }
+
+            pricingMicros += runBenchmark([&]()
+                {
+                    (void)engine.getOrderBook().indicativeUncross();
+                }, 1);
+
+            uncrossMicros += runBenchmark([&]()
+                {
+                    (void)engine.uncross();
+                }, 1);
+
+            engine.setTradingMode(TradingMode::Continuous);
+        }
+
+        // Reported per auction, not per order
+        report("auction price discovery (100k orders)", pricingMicros, rounds);
+        report("auction uncross (100k orders)", uncrossMicros, rounds);
+    }
+
+    // ============================================================
+    // DEPTH QUERIES
+    // ============================================================
+
+    // Sweep-cost queries on a 5000-level book: index vs level walk
+    void benchDepthQueries()
+    {
+        constexpr size_t levels = 5'000;
+        constexpr size_t queries = 100'000;
+
+        MatchingEngine engine;
+        engine.enableDepthIndex(0.01);
+
+        for (size_t i = 0; i < levels; ++i)
+        {
+            (void)engine.submitOrder(Side::Sell, OrderType::Limit, 100.0 + i * 0.01, 10);
+            (void)engine.submitOrder(Side::Buy, OrderType::Limit, 99.99 - i * 0.01, 10);
+        }
+
+        const DepthIndex& index = *engine.getOrderBook().getDepthIndex();
+        const auto depth = engine.getOrderBook().getDepth(Side::Sell);
+        double sink = 0.0;
+        size_t i = 0;
+
+        const uint64_t indexMicros = runBenchmark([&]()
+            {
+                const uint64_t quantity = 1 + (i++ * 7'919) % (levels * 10);
+                sink += index.sweepCost(Side::Sell, quantity).notional;
+            }, queries);
+
+        i = 0;
+        const uint64_t walkMicros = runBenchmark([&]()
+            {
+                uint64_t remaining = 1 + (i++ * 7'919) % (levels * 10);
+                double notional = 0.0;
+
+                for (const DepthLevel& level : depth)
+                {
+                    const uint64_t take = std::min(remaining, level.volume);
+                    notional += take * level.price;
+                    remaining -= take;
+                    if (remaining == 0)
+                        break;
+                }
+
+                sink += notional;
+            }, queries);
+
+        report("sweep cost, depth index (5k levels)", indexMicros, queries);
+        report("sweep cost, level walk (5k levels)", walkMicros, queries);
+
+        if (sink < 0.0)
+            std::cout << sink;
+    }
+    // ============================================================
+    // MASS CANCEL
+    // ============================================================
+
+    // 64 levels x 64 orders per side, round-robin across 8 owners
+    std::vector<uint64_t> fillForMassCancel(MatchingEngine& engine, uint32_t trackedOwner)
+    {
+        std::vector<uint64_t> tracked;
+
+        for (size_t level = 0; level < 64; ++level)
+        {
+            for (size_t i = 0; i < 64; ++i)
+            {
+                const uint32_t owner = static_cast<uint32_t>(1 + i % 8);
+                const auto bid = engine.submitOrder(Side::Buy, OrderType::Limit, 99.0 - level * 0.01, 10, owner);
+                const auto ask = engine.submitOrder(Side::Sell, OrderType::Limit, 101.0 + level * 0.01, 10, owner);
+
+                if (owner == trackedOwner)
+                {
+                    tracked.push_back(bid);
+                    tracked.push_back(ask);
+                }
+            }
+        }
+
+        return tracked;
+    }
+
+    // Setup is excluded; only the cancels are timed
+    void benchMassCancel()
+    {
+        constexpr size_t rounds = 50;
+        constexpr size_t ordersPerSide = 64 * 64;
+
+        uint64_t sideMicros = 0;
+        uint64_t sideLoopMicros = 0;
+        uint64_t ownerMicros = 0;
+        uint64_t ownerLoopMicros = 0;
+        size_t ownerOrders = 0;
+
+        MatchingEngine engine;
+
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            engine.reset();
+            (void)fillForMassCancel(engine, 0);
+            sideMicros += runBenchmark([&]() { (void)engine.cancelSide(Side::Buy); }, 1);
+
+            engine.reset();
+            (void)fillForMassCancel(engine, 0);
+            sideLoopMicros += runBenchmark([&]()
+                {
+                    for (uint64_t id = 1; id <= 2 * ordersPerSide; id += 2)
+                        engine.cancelOrder(id);
+                }, 1);
+
+            engine.reset();
+            ownerOrders = fillForMassCancel(engine, 3).size();
+            ownerMicros += runBenchmark([&]() { (void)engine.cancelOwner(3); }, 1);
+
+            engine.reset();
+            const std::vector<uint64_t> ids = fillForMassCancel(engine, 3);
+            ownerLoopMicros += runBenchmark([&]()
+                {
+                    for (const uint64_t id : ids)
+                        engine.cancelOrder(id);
+                }, 1);
+        }
+
+        report("cancel side (4k orders, bulk)", sideMicros, rounds * ordersPerSide);
+        report("cancel side (4k orders, one by one)", sideLoopMicros, rounds * ordersPerSide);
+        report("cancel owner (1k orders, bulk)", ownerMicros, rounds * ownerOrders);
+        report("cancel owner (1k orders, one by one)", ownerLoopMicros, rounds * ownerOrders);
+    }
+
+    // ============================================================
+    // COMPACTION
+    // ============================================================
+
+    // A 200k-order burst over 500 levels, mostly swept and cancelled,
+    // then compacted in 50us slices and once with a quiet-period
+    // budget; reports slice times and what each pass gave back
+    void benchCompaction()
+    {
+        constexpr size_t orders = 200'000;
+        constexpr auto budget = std::chrono::microseconds(50);
+
+        MatchingEngine engine;
+        std::vector<uint64_t> ids;
+        ids.reserve(orders);
+
+        for (size_t i = 0; i < orders; ++i)
+            ids.push_back(engine.submitOrder(Side::Buy, OrderType::Limit, 100.0 - static_cast<double>(i % 500) * 0.01, 10));
+
+        // Drains the front of every level, then thins what is left
+        (void)engine.submitOrder(Side::Sell, OrderType::Market, 0.0, orders * 10 / 2);
+        for (size_t i = 0; i < ids.size(); i += 2)
+            (void)engine.cancelOrder(ids[i]);
+
+        const size_t before = engine.memoryStats().total();
+
+        size_t slices = 0;
+        size_t released = 0;
+        size_t deferred = 0;
+        uint64_t totalMicros = 0;
+        uint64_t worstMicros = 0;
+        CompactionResult result;
+
+        do
+        {
+            const uint64_t micros = runBenchmark([&]() { result = engine.compact(budget); }, 1);
+
+            ++slices;
+            released += result.bytesReleased;
+            deferred += result.deferredSteps;
+            totalMicros += micros;
+            worstMicros = std::max(worstMicros, micros);
+        } while (!result.passComplete);
+
+        report("compact slice (50us budget)", totalMicros, slices);
+
+        std::cout << "  (" << slices << " slices, worst " << worstMicros << " us, "
+            << released / 1024 << " KiB of " << before / 1024 << " KiB released, "
+            << deferred << " steps deferred)\n";
+
+        // Steps too large for any slice run in a quiet period
+        const uint64_t quietMicros = runBenchmark([&]() { result = engine.compact(std::chrono::milliseconds(20)); }, 1);
+
+        report("compact quiet pass (20ms budget)", quietMicros, 1);
+
+        std::cout << "  (" << result.bytesReleased / 1024 << " KiB released, "
+            << result.deferredSteps << " steps deferred)\n";
+    }
+
+    // ============================================================
+    // LOGGING
+    // ============================================================
+
+    // Formats like a real sink, then discards the bytes
+    struct DiscardBuffer : std::streambuf
+    {
+        int overflow(int c) override
+        {
+            return c;
+        }
+
+        std::streamsize xsputn(const char*, std::streamsize count) override
+        {
+            return count;
+        }
+    };
+
+    // Caller-side cost of one fill line: formatted in place vs queued raw
+    void benchFillLogging()
+    {
+        constexpr size_t fills = 200'000;
+
+        DiscardBuffer discard;
+        std::ostream sink(&discard);
+
+        const Trade trade{ 1'234'567, 7'654'321, 101.25, 300, {}, 42 };
+        uint64_t i = 0;
+
+        const uint64_t syncMicros = runBenchmark([&]()
+            {
+                sink << "FILL seq=" << trade.sequence + i++
+                    << " buy=" << trade.buyOrderId
+                    << " sell=" << trade.sellOrderId
+                    << " qty=" << trade.quantity
+                    << " px=" << trade.price << '\n';
+            }, fills);
+
+        AsyncLogger logger(sink, { 1 << 24, std::chrono::microseconds(500) });
+        logger.start();
+
+        // Steady state: channel registered, writer batch buffer grown
+        for (size_t warm = 0; warm < fills; ++warm)
+            logger.log("FILL seq={} buy={} sell={} qty={} px={}", warm, trade.buyOrderId, trade.sellOrderId, trade.quantity, trade.price);
+        logger.flush();
+
+        i = 0;
+        const uint64_t asyncMicros = runBenchmark([&]()
+            {
+                logger.log("FILL seq={} buy={} sell={} qty={} px={}",
+                    trade.sequence + i++,
+                    trade.buyOrderId,
+                    trade.sellOrderId,
+                    trade.quantity,
+                    trade.price);
+            }, fills);
+
+        logger.stop();
+
+        report("fill log, ostream on caller", syncMicros, fills);
+        report("fill log, async (caller side)", asyncMicros, fills);
+
+        if (logger.droppedCount() > 0)
+            std::cout << "  (" << logger.droppedCount() << " records dropped)\n";
+    }
+
+    // ============================================================
+    // ORDER-ID ALLOCATION
+    // ============================================================
+
+    // Wall time for `producers` threads to draw `perProducer` IDs each
+    template <typename Draw>
+    uint64_t timeProducers(size_t producers, Draw draw)
+    {
+        std::vector<std::thread> threads;
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t p = 0; p < producers; ++p)
+            threads.emplace_back(draw);
+
+        for (auto& thread : threads)
+            thread.join();
+
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+
+    // One shared fetch_add per order vs one per 4096-ID block
+    void benchIdAllocation()
+    {
+        constexpr size_t perProducer = 1'000'000;
+
+        for (size_t producers : { 1, 2, 4, 8, 16 })
+        {
+            alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> shared{ 0 };
+            std::atomic<uint64_t> sink{ 0 };
+
+            const uint64_t sharedMicros = timeProducers(producers, [&]()
+                {
+                    uint64_t last = 0;
+                    for (size_t i = 0; i < perProducer; ++i)
+                        last = shared.fetch_add(1, std::memory_order_relaxed);
+                    sink.fetch_add(last, std::memory_order_relaxed);
+                });
+
+            OrderIdAllocator allocator;
+            const uint64_t blockMicros = timeProducers(producers, [&]()
+                {
+                    OrderIdBlock block(allocator);
+                    uint64_t last = 0;
+                    for (size_t i = 0; i < perProducer; ++i)
+                        last = block.next();
+                    sink.fetch_add(last, std::memory_order_relaxed);
+                });
+
+            const std::string suffix = " (" + std::to_string(producers) + " threads)";
+            report("order id, shared atomic" + suffix, sharedMicros, producers * perProducer);
+            report("order id, id block" + suffix, blockMicros, producers * perProducer);
+
+            const uint64_t drawn = sink.load();
+            if (drawn == 0)
+                std::cout << drawn;
+        }
+    }
+
+    // ============================================================
+    // ARCHIVE
+    // ============================================================
+
+    // One simulated session's trades: archive size against raw
+    // structs, write cost, and decode speed serial vs pooled
+    void benchArchive()
+    {
+        constexpr size_t submits = 400'000;
+
+        MatchingEngine engine;
+        SimRandom random(99);
+        for (size_t i = 0; i < submits; ++i)
+        {
+            const uint64_t r = random.next();
+
+            engine.setSimulatedTime(Timestamp{} + std::chrono::nanoseconds(i * 900 + r % 500));
+            (void)engine.submitOrder((r & 1) ? Side::Buy : Side::Sell,
+                (r % 11 == 0) ? OrderType::Market : OrderType::Limit,
+                100.0 + static_cast<double>((r >> 3) % 60) * 0.01,
+                1 + (r >> 10) % 500);
+        }
+
+        const std::vector<Trade>& trades = engine.getTrades();
+        const std::string path = (std::filesystem::temp_directory_path() / "hft_bench_archive.bin").string();
+
+        uint64_t archiveBytes = 0;
+        const uint64_t writeMicros = runBenchmark([&]()
+            {
+                ArchiveWriter writer(path);
+                writer.append(trades);
+                writer.close();
+                archiveBytes = writer.bytesWritten();
+            }, 1);
+
+        ArchiveReader reader(path);
+        size_t decoded = 0;
+
+        const uint64_t serialMicros = runBenchmark([&]()
+            {
+                for (size_t block = 0; block < reader.blockCount(); ++block)
+                    decoded += reader.decodeBlock(block).trades.size();
+            }, 1);
+
+        ThreadPool pool;
+        const uint64_t parallelMicros = runBenchmark([&]()
+            {
+                for (const ArchiveBlock& block : reader.decodeBlocks(0, reader.blockCount(), pool))
+                    decoded += block.trades.size();
+            }, 1);
+
+        const uint64_t rawBytes = trades.size() * sizeof(Trade);
+
+        report("archive write", writeMicros, trades.size());
+        report("archive decode, serial", serialMicros, trades.size());
+        report("archive decode, " + std::to_string(pool.size()) + " threads", parallelMicros, trades.size());
+
+        std::cout << "  (" << trades.size() << " trades, " << rawBytes / 1024 << " KiB raw, "
+            << archiveBytes / 1024 << " KiB archived, " << std::fixed << std::setprecision(1)
+            << static_cast<double>(rawBytes) / static_cast<double>(std::max<uint64_t>(archiveBytes, 1)) << "x; decode "
+            << static_cast<double>(rawBytes) / static_cast<double>(std::max<uint64_t>(serialMicros, 1)) << " MB/s raw-equivalent)\n"
+            << std::defaultfloat;
+
+        if (decoded != 2 * trades.size())
+            std::cout << decoded;
+
+        std::filesystem::remove(path);
+    }
+    // ============================================================
+    // FEED HANDLER
+    // ============================================================
+
+    // Recorded L3 capture over 500 symbols, mapped and applied
+    // sequentially and sharded over the pool
+    void benchFeedHandler()
+    {
+        constexpr size_t messages = 2'000'000;
+        constexpr uint32_t symbols = 500;
+
+        struct Live { uint64_t id; Side side; double price; uint64_t quantity; };
+
+        std::vector<FeedMessage> capture;
+        capture.reserve(messages);
+        std::vector<std::vector<Live>> books(symbols);
+        std::vector<uint64_t> sequences(symbols, 0);
+        uint64_t nextId = 1;
+        SimRandom random(3);
+
+        while (capture.size() < messages)
+        {
+            const uint64_t r = random.next();
+
+            const uint32_t symbol = static_cast<uint32_t>(r % symbols);
+            std::vector<Live>& live = books[symbol];
+
+            FeedMessage message{};
+            message.timestampNs = capture.size() * 200;
+            message.sequence = ++sequences[symbol];
+            message.symbol = symbol;
+
+            // Adds keep about 100 orders per symbol; the rest is
+            // executes, size cuts and deletes, as on a real feed
+            if (live.size() < 100 || (r >> 8) % 3 == 0)
+            {
+                const Side side = ((r >> 10) & 1) ? Side::Buy : Side::Sell;
+                const double price = 100.0 + ((side == Side::Buy) ? -1.0 : 1.0) * static_cast<double>(1 + (r >> 11) % 30) * 0.01;
+                live.push_back({ nextId++, side, price, 1 + (r >> 16) % 500 });
+
+                message.action = FeedAction::Add;
+                message.orderId = live.back().id;
+                message.side = side;
+                message.price = price;
+                message.quantity = live.back().quantity;
+            }
+            else
+            {
+                const size_t pick = (r >> 16) % live.size();
+                Live& order = live[pick];
+                message.orderId = order.id;
+
+                if ((r >> 8) % 3 == 1 && order.quantity > 1)
+                {
+                    message.action = FeedAction::Modify;
+                    message.price = order.price;
+                    message.quantity = order.quantity / 2;
+                    order.quantity = message.quantity;
+                }
+                else
+                {
+                    message.action = ((r >> 9) & 1) ? FeedAction::Execute : FeedAction::Delete;
+                    message.quantity = order.quantity;
+                    order = live.back();
+                    live.pop_back();
+                }
+            }
+
+            capture.push_back(message);
+        }
+
+        const std::string path = (std::filesystem::temp_directory_path() / "hft_bench_feed.bin").string();
+        writeFeedCapture(path, capture);
+
+        {
+            const FeedCapture mapped(path);
+
+            FeedHandler sequential;
+            const uint64_t serialMicros = runBenchmark([&]()
+                {
+                    sequential.process(mapped.messages());
+                }, 1);
+
+            ThreadPool pool;
+            FeedHandler sharded;
+            const uint64_t parallelMicros = runBenchmark([&]()
+                {
+                    sharded.process(mapped.messages(), pool);
+                }, 1);
+
+            report("L3 feed apply, serial", serialMicros, messages);
+            report("L3 feed apply, " + std::to_string(pool.size()) + " threads", parallelMicros, messages);
+
+            std::cout << "  (" << std::fixed << std::setprecision(1)
+                << static_cast<double>(messages) / static_cast<double>(std::max<uint64_t>(parallelMicros, 1))
+                << "M msgs/s sharded)\n" << std::defaultfloat;
+
+            if (!(sequential.stats() == sharded.stats()) || sharded.stats().rejected != 0)
+                std::cout << "  (sharded replay diverged)\n";
+        }
+
+        std::filesystem::remove(path);
+    }
+
+    // ============================================================
+    // REPLICATION
+    // ============================================================
+
+    // Primary-side cost per order with a standby following on
+    // another thread, and the standby's drain-and-take-over time
+    void benchReplication()
+    {
+        constexpr size_t orders = 200'000;
+        const auto path = (std::filesystem::temp_directory_path() / "hft_bench_replication.bin").string();
+
+        const auto flow = [](MatchingEngine& engine, size_t i)
+            {
+                const Side side = (i & 1) ? Side::Buy : Side::Sell;
+                const double price = 100.0 + static_cast<double>(i % 7) * 0.25 - ((i & 1) ? 0.75 : 0.0);
+                (void)engine.submitOrder(side, OrderType::Limit, price, 100);
+            };
+
+        MatchingEngine plain;
+        size_t i = 0;
+        const uint64_t plainMicros = runBenchmark([&]() { flow(plain, i++); }, orders);
+
+        MatchingEngine primary;
+        MatchingEngine standby;
+        ReplicationPublisher publisher(path, ReplicationPublisher::DEFAULT_CAPACITY, std::chrono::seconds(5));
+        ReplicationSubscriber subscriber(path);
+        primary.attachReplication(&publisher);
+
+        std::atomic<bool> stop{ false };
+        std::atomic<uint64_t> takeoverNs{ 0 };
+
+        std::thread follower([&]()
+            {
+                while (!stop.load(std::memory_order_acquire))
+                {
+                    if (standby.followReplication(subscriber) == 0)
+                        std::this_thread::yield();
+                }
+
+                const auto start = std::chrono::steady_clock::now();
+                while (standby.followReplication(subscriber) > 0)
+                {
+                }
+                standby.takeOver();
+
+                takeoverNs.store(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count()));
+            });
+
+        i = 0;
+        const uint64_t replicatedMicros = runBenchmark([&]() { flow(primary, i++); }, orders);
+
+        publisher.close();
+        stop.store(true, std::memory_order_release);
+        follower.join();
+
+        report("submit, no replication", plainMicros, orders);
+        report("submit, replicated to standby", replicatedMicros, orders);
+
+        std::cout << "  (standby drain + take over: " << takeoverNs.load() / 1'000
+            << " us, ring full " << publisher.fullWaits() << " times)\n";
+
+        if (standby.getSequence() != primary.getSequence())
+            std::cout << "  (standby diverged)\n";
+
+        std::filesystem::remove(path);
+    }
+
+    // ============================================================
+    // TRACING
+    // ============================================================
+
+    // Submit cost with no tracer, with tracing off, sampled, and on every order
+    void benchOrderTracing()
+    {
+        constexpr size_t orders = 200'000;
+
+        const auto run = [](OrderTracer* tracer)
+            {
+                MatchingEngine engine;
+                engine.attachTracer(tracer);
+
+                size_t i = 0;
+                return runBenchmark([&]()
+                    {
+                        const Side side = (i & 1) ? Side::Buy : Side::Sell;
+                        const double price = 100.0 + static_cast<double>(i % 7) * 0.25 - ((i & 1) ? 0.75 : 0.0);
+                        (void)engine.submitOrder(side, OrderType::Limit, price, 100);
+                        ++i;
+                    }, orders);
+            };
+
+        OrderTracer tracer({ .tracesPerThread = orders });
+
+        report("submit, no tracer", run(nullptr), orders);
+        report("submit, tracer off", run(&tracer), orders);
+
+        tracer.setSampleEvery(1024);
+        report("submit, traced 1 in 1024", run(&tracer), orders);
+
+        tracer.setSampleEvery(1);
+        report("submit, every order traced", run(&tracer), orders);
+
+        std::ostringstream json;
+        const auto start = Clock::now();
+        tracer.writeChromeTrace(json);
+        const auto exportMicros = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+
+        std::cout << "  (" << tracer.traces().size() << " traces exported in "
+            << exportMicros / 1'000 << " ms, " << json.str().size() / 1024 << " KiB)\n";
+    }
+
+    // ============================================================
+    // CROSS-SECTIONAL ANALYTICS
+    // ============================================================
+
+    // One refresh of a 5,000-symbol universe: per-book calls and a
+    // sort, vs SoA kernels serial and on the pool
+    void benchCrossSection()
+    {
+        constexpr size_t symbols = 5'000;
+        constexpr size_t refreshes = 200;
+
+        std::vector<OrderBook> books(symbols);
+        std::vector<const OrderBook*> universe;
+        uint64_t id = 1;
+
+        for (size_t s = 0; s < symbols; ++s)
+        {
+            // O(1) side totals; without the index each refresh walks every level
+            books[s].enableDepthIndex(0.01);
+
+            const double base = 20.0 + static_cast<double>(s % 400);
+            for (size_t level = 1; level <= 10; ++level)
+            {
+                const double offset = 0.01 * static_cast<double>(level);
+                books[s].addOrder(Order(id++, Side::Buy, OrderType::Limit, base - offset, 100 + (s * level) % 400));
+                books[s].addOrder(Order(id++, Side::Sell, OrderType::Limit, base + offset, 100 + (s + level * 7) % 400));
+            }
+
+            universe.push_back(&books[s]);
+        }
+
+        std::vector<double> imbalance(symbols), spread(symbols), micro(symbols);
+        std::vector<uint32_t> ranked(symbols);
+
+        const uint64_t perBookMicros = runBenchmark([&]()
+            {
+                for (size_t s = 0; s < symbols; ++s)
+                {
+                    imbalance[s] = HFTAlgorithms::computeOrderImbalance(books[s]);
+                    spread[s] = HFTAlgorithms::computeSpreadPercentage(books[s]);
+                    micro[s] = HFTAlgorithms::computeMicroprice(books[s]);
+                    ranked[s] = static_cast<uint32_t>(s);
+                }
+
+                std::sort(ranked.begin(), ranked.end(), [&](uint32_t a, uint32_t b)
+                    {
+                        return imbalance[a] > imbalance[b] || (imbalance[a] == imbalance[b] && a < b);
+                    });
+            }, refreshes);
+
+        CrossSectionalAnalytics analytics;
+        analytics.refresh(universe);
+        const uint64_t serialMicros = runBenchmark([&]() { analytics.refresh(universe); }, refreshes);
+
+        ThreadPool pool;
+        analytics.refresh(universe, pool);
+        const uint64_t parallelMicros = runBenchmark([&]() { analytics.refresh(universe, pool); }, refreshes);
+
+        report("universe refresh, per-book calls", perBookMicros, refreshes * symbols);
+        report("universe refresh, SoA serial", serialMicros, refreshes * symbols);
+        report("universe refresh, SoA " + std::to_string(pool.size()) + " threads", parallelMicros, refreshes * symbols);
+
+        std::cout << "  (" << symbols << " symbols: " << perBookMicros / refreshes << " / "
+            << serialMicros / refreshes << " / " << parallelMicros / refreshes << " us per refresh)\n";
+
+        if (!std::ranges::equal(ranked, analytics.rankedByImbalance()))
+            std::cout << "  (rankings differ)\n";
+    }
+    // ============================================================
+    // AGENT SIMULATION
+    // ============================================================
+
+    SimTask ticker(AgentContext ctx, int wakes)
+    {
+        for (int i = 0; i < wakes; ++i)
+            co_await ctx.sleep(1'000 + ctx.random().below(1'000));
+    }
+
+    // Quotes both sides around 100, requoting when filled or stale
+    SimTask quotingMaker(AgentContext ctx, SimTime end)
+    {
+        while (ctx.now() < end)
+        {
+            const double edge = 0.01 * static_cast<double>(1 + ctx.random().below(5));
+            const uint64_t bid = co_await ctx.submit(Side::Buy, OrderType::Limit, 100.0 - edge, 100);
+            const uint64_t ask = co_await ctx.submit(Side::Sell, OrderType::Limit, 100.0 + edge, 100);
+
+            (void)co_await ctx.nextFill(20'000);
+            (void)co_await ctx.cancel(bid);
+            (void)co_await ctx.cancel(ask);
+        }
+    }
+
+    SimTask randomTaker(AgentContext ctx, SimTime end)
+    {
+        while (ctx.now() < end)
+        {
+            co_await ctx.sleep(ctx.random().below(50'000));
+            const Side side = ctx.random().chance(0.5) ? Side::Buy : Side::Sell;
+            (void)co_await ctx.submit(side, OrderType::Market, 0.0, 1 + ctx.random().below(30));
+        }
+    }
+
+    // Limit orders either side of 100, some crossing
+    SimTask noiseTrader(AgentContext ctx, SimTime end)
+    {
+        while (ctx.now() < end)
+        {
+            co_await ctx.sleep(ctx.random().below(200'000));
+            const Side side = ctx.random().chance(0.5) ? Side::Buy : Side::Sell;
+            const double price = 100.0 + 0.01 * (static_cast<double>(ctx.random().below(21)) - 10.0);
+            const uint64_t id = co_await ctx.submit(side, OrderType::Limit, price, 1 + ctx.random().below(50));
+
+            if (id != 0 && !co_await ctx.nextFill(100'000))
+                (void)co_await ctx.cancel(id);
+        }
+    }
+
+    void benchAgentSimulation()
+    {
+        // Queue alone: hold model with a million pending events
+        {
+            constexpr size_t pending = 1'000'000;
+            constexpr size_t operations = 5'000'000;
+
+            SimRandom random(3);
+            SimEventQueue queue;
+            std::priority_queue<ScheduledEvent, std::vector<ScheduledEvent>, bool(*)(const ScheduledEvent&, const ScheduledEvent&)> binary(
+                [](const ScheduledEvent& a, const ScheduledEvent& b) { return a.time > b.time || (a.time == b.time && a.ticket > b.ticket); });
+
+            for (uint64_t i = 0; i < pending; ++i)
+            {
+                const ScheduledEvent event{ random.below(1'000'000), i };
+                queue.push(event);
+                binary.push(event);
+            }
+
+            uint64_t ticket = pending;
+            const uint64_t quaternaryMicros = runBenchmark([&]()
+                {
+                    const ScheduledEvent event = queue.pop();
+                    queue.push({ event.time + random.below(1'000'000), ticket++ });
+                }, operations);
+
+            const uint64_t binaryMicros = runBenchmark([&]()
+                {
+                    const ScheduledEvent event = binary.top();
+                    binary.pop();
+                    binary.push({ event.time + random.below(1'000'000), ticket++ });
+                }, operations);
+
+            report("event queue hold, timing wheel", quaternaryMicros, operations);
+            report("event queue hold, std::priority_queue", binaryMicros, operations);
+        }
+
+        // A million agents waking on timers
+        {
+            constexpr size_t agents = 1'000'000;
+            constexpr int wakes = 10;
+
+            MatchingEngine engine;
+            AgentSimulator simulator(engine, { .seed = 5 });
+
+            for (size_t i = 0; i < agents; ++i)
+                simulator.spawn([](AgentContext ctx) { return ticker(ctx, wakes); });
+
+            uint64_t events = 0;
+            const uint64_t micros = runBenchmark([&]() { events = simulator.run(); }, 1);
+
+            report("simulator, 1M timer agents", micros, events);
+            std::cout << "  (" << events << " events, " << events * 1'000'000 / std::max<uint64_t>(micros, 1)
+                << " events/s)\n";
+        }
+
+        // Makers, takers and noise traders over 1us +- 0.5us links
+        {
+            constexpr SimTime end = 20'000'000;   // 20 ms
+
+            MatchingEngine engine;
+            AgentSimulator simulator(engine, { .seed = 9, .latency = { .baseNs = 500, .jitterNs = 1'000 } });
+
+            for (int i = 0; i < 100; ++i)
+                simulator.spawn([](AgentContext ctx) { return quotingMaker(ctx, end); });
+            for (int i = 0; i < 400; ++i)
+                simulator.spawn([](AgentContext ctx) { return randomTaker(ctx, end); });
+            for (int i = 0; i < 9'500; ++i)
+                simulator.spawn([](AgentContext ctx) { return noiseTrader(ctx, end); });
+
+            uint64_t events = 0;
+            const uint64_t micros = runBenchmark([&]() { events = simulator.run(); }, 1);
+
+            report("simulator, 10k trading agents", micros, events);
+            std::cout << "  (" << events << " events, " << engine.getTrades().size() << " trades, "
+                << events * 1'000'000 / std::max<uint64_t>(micros, 1) << " events/s)\n";
+        }
+    }
+
+}
+
+int main()
+{
+    std::cout << "====================================\n";
+    std::cout << "      MATCHING CORE BENCHMARKS\n";
+    std::cout << "====================================\n";
+
+    benchLimitCross();
+    benchMarketSweep();
+    benchDeepQueueSweep();
+    benchIcebergRefill();
+    benchPeggedQuoteMove();
+    benchPassiveInsert();
+    benchBacktestScaling();
+    benchBackendFlow<OrderBook>("mixed flow (map backend)");
+    benchBackendFlow<VectorOrderBook>("mixed flow (vector backend)");
+    benchShadowReplay();
+    benchConsolidatedBook();
+    benchAuctionUncross();
+    benchDepthQueries();
+    benchIdAllocation();
+    benchMassCancel();
+    benchCompaction();
+    benchFillLogging();
+    benchArchive();
+    benchFeedHandler();
+    benchReplication();
+    benchOrderTracing();
+    benchCrossSection();
+    benchAgentSimulation();
+
+    return 0;
+}
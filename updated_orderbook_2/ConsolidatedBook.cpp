@@ -0,0 +1,286 @@
+#include "ConsolidatedBook.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+namespace hft
+{
+
+    ConsolidatedBook::ConsolidatedBook(size_t venueCount)
+    {
+        if (venueCount == 0 || venueCount >= NO_VENUE)
+            throw std::invalid_argument("ConsolidatedBook: venue count out of range");
+
+        venues.resize(venueCount);
+
+        for (VenueTree* side : { &bidTree, &askTree })
+        {
+            side->leaves = std::bit_ceil(venueCount);
+            side->nodes.assign(side->leaves * 2, NO_VENUE);
+            side->bestPrice.assign(venueCount, 0.0);
+        }
+    }
+
+    // ============================================================
+    // UPDATES
+    // ============================================================
+
+    bool ConsolidatedBook::apply(VenueId venue, const LevelUpdate& update)
+    {
+        // A NaN key breaks the map ordering for every later lookup
+        if (venue >= venues.size() || !std::isfinite(update.price) || update.price <= 0.0)
+            return false;
+
+        if (update.side == Side::Buy)
+            apply<Side::Buy>(venue, update.price, update.volume, update.orderCount);
+        else
+            apply<Side::Sell>(venue, update.price, update.volume, update.orderCount);
+
+        return true;
+    }
+
+    template <Side S>
+    void ConsolidatedBook::apply(VenueId venue, double price, uint64_t volume, size_t orderCount)
+    {
+        auto& own = venueSide<S>(venue);
+        const bool wasQuoted = !own.empty();
+        const double bestBefore = wasQuoted ? own.begin()->first : 0.0;
+
+        if (volume == 0)
+        {
+            // Removing a level the venue never had is a no-op
+            if (own.erase(price) == 0)
+                return;
+        }
+        else
+        {
+            own.insert_or_assign(price, VenueLevel{ volume, orderCount });
+        }
+
+        updateMerged<S>(venue, price, volume, orderCount);
+
+        // The tree is keyed by price: size changes at the top skip it
+        if (own.empty() != !wasQuoted || (!own.empty() && own.begin()->first != bestBefore))
+            replay<S>(venue);
+
+        refreshBest<S>();
+    }
+
+    template <Side S>
+    void ConsolidatedBook::updateMerged(VenueId venue, double price, uint64_t volume, size_t orderCount)
+    {
+        auto& side = merged<S>();
+
+        if (volume == 0)
+        {
+            const auto levelIt = side.find(price);
+            MergedLevel& level = levelIt->second;
+
+            const auto quote = std::find_if(level.venues.begin(), level.venues.end(),
+                [venue](const VenueQuote& q) { return q.venue == venue; });
+
+            level.volume -= quote->volume;
+            level.orderCount -= quote->orderCount;
+            level.venues.erase(quote);
+
+            if (level.venues.empty())
+                side.erase(levelIt);
+
+            return;
+        }
+
+        MergedLevel& level = side[price];
+
+        const auto quote = std::find_if(level.venues.begin(), level.venues.end(),
+            [venue](const VenueQuote& q) { return q.venue == venue; });
+
+        if (quote == level.venues.end())
+        {
+            level.venues.push_back({ venue, volume, orderCount });
+        }
+        else
+        {
+            level.volume -= quote->volume;
+            level.orderCount -= quote->orderCount;
+            quote->volume = volume;
+            quote->orderCount = orderCount;
+        }
+
+        level.volume += volume;
+        level.orderCount += orderCount;
+    }
+
+    void ConsolidatedBook::clearVenue(VenueId venue)
+    {
+        if (venue >= venues.size())
+            return;
+
+        clearVenue<Side::Buy>(venue);
+        clearVenue<Side::Sell>(venue);
+    }
+
+    template <Side S>
+    void ConsolidatedBook::clearVenue(VenueId venue)
+    {
+        auto& own = venueSide<S>(venue);
+        if (own.empty())
+            return;
+
+        for (const auto& [price, level] : own)
+            updateMerged<S>(venue, price, 0, 0);
+
+        own.clear();
+        replay<S>(venue);
+        refreshBest<S>();
+    }
+
+    void ConsolidatedBook::clear()
+    {
+        for (Venue& venue : venues)
+        {
+            venue.bids.clear();
+            venue.asks.clear();
+        }
+
+        bids.clear();
+        asks.clear();
+
+        std::fill(bidTree.nodes.begin(), bidTree.nodes.end(), NO_VENUE);
+        std::fill(askTree.nodes.begin(), askTree.nodes.end(), NO_VENUE);
+        best = {};
+    }
+
+    // ============================================================
+    // NBBO
+    // ============================================================
+
+    template <Side S>
+    VenueId ConsolidatedBook::better(VenueId left, VenueId right) const noexcept
+    {
+        if (left == NO_VENUE)
+            return right;
+        if (right == NO_VENUE)
+            return left;
+
+        const VenueTree& side = tree<S>();
+        const typename SideTraits<S>::Compare before;
+
+        if (before(side.bestPrice[right], side.bestPrice[left]))
+            return right;
+
+        // Left wins ties, and left subtrees hold the lower indices
+        return left;
+    }
+
+    template <Side S>
+    void ConsolidatedBook::replay(VenueId venue) noexcept
+    {
+        VenueTree& side = tree<S>();
+        const auto& own = venueSide<S>(venue);
+
+        size_t node = side.leaves + venue;
+
+        if (own.empty())
+        {
+            side.nodes[node] = NO_VENUE;
+        }
+        else
+        {
+            side.nodes[node] = venue;
+            side.bestPrice[venue] = own.begin()->first;
+        }
+
+        for (node /= 2; node > 0; node /= 2)
+            side.nodes[node] = better<S>(side.nodes[node * 2], side.nodes[node * 2 + 1]);
+    }
+
+    template <Side S>
+    void ConsolidatedBook::refreshBest() noexcept
+    {
+        const VenueTree& side = tree<S>();
+        const VenueId winner = side.nodes[1];
+
+        // The merged top level is at the winner's price
+        const double price = (winner == NO_VENUE) ? 0.0 : side.bestPrice[winner];
+        const uint64_t size = (winner == NO_VENUE) ? 0 : merged<S>().begin()->second.volume;
+
+        if constexpr (S == Side::Buy)
+        {
+            best.bid = price;
+            best.bidSize = size;
+            best.bidVenue = winner;
+        }
+        else
+        {
+            best.ask = price;
+            best.askSize = size;
+            best.askVenue = winner;
+        }
+    }
+
+    // ============================================================
+    // DEPTH
+    // ============================================================
+
+    std::vector<ConsolidatedLevel> ConsolidatedBook::getDepth(Side side, size_t maxLevels) const
+    {
+        std::vector<ConsolidatedLevel> depth;
+
+        if (side == Side::Buy)
+            appendDepth<Side::Buy>(depth, maxLevels);
+        else
+            appendDepth<Side::Sell>(depth, maxLevels);
+
+        return depth;
+    }
+
+    template <Side S>
+    void ConsolidatedBook::appendDepth(std::vector<ConsolidatedLevel>& out, size_t maxLevels) const
+    {
+        const auto& side = merged<S>();
+        const size_t count = (maxLevels == 0) ? side.size() : std::min(maxLevels, side.size());
+        out.reserve(count);
+
+        for (const auto& [price, level] : side)
+        {
+            if (out.size() == count)
+                break;
+
+            out.push_back({ price, level.volume, level.orderCount, level.venues });
+        }
+    }
+
+    std::vector<DepthLevel> ConsolidatedBook::getVenueDepth(VenueId venue, Side side, size_t maxLevels) const
+    {
+        std::vector<DepthLevel> depth;
+
+        if (venue >= venues.size())
+            return depth;
+
+        if (side == Side::Buy)
+            appendVenueDepth<Side::Buy>(depth, venue, maxLevels);
+        else
+            appendVenueDepth<Side::Sell>(depth, venue, maxLevels);
+
+        return depth;
+    }
+
+    template <Side S>
+    void ConsolidatedBook::appendVenueDepth(std::vector<DepthLevel>& out, VenueId venue, size_t maxLevels) const
+    {
+        const auto& side = venueSide<S>(venue);
+        const size_t count = (maxLevels == 0) ? side.size() : std::min(maxLevels, side.size());
+        out.reserve(count);
+
+        for (const auto& [price, level] : side)
+        {
+            if (out.size() == count)
+                break;
+
+            out.push_back({ price, level.volume, level.orderCount });
+        }
+    }
+
+} // namespace hft
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "OrderBook.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/*
+
+    Consolidated book across venues.
+
+    Each venue publishes aggregated level updates (LevelUpdate:
+    the new volume and order count at one price, 0 meaning the
+    level is gone). The consolidated book keeps:
+
+        - every venue's own levels, so its best price is known
+          after any update
+        - the merged depth per price, with the share of each
+          venue quoting there
+        - the national best bid and offer
+
+    The NBBO is a tournament tree over venues per side, keyed
+    by each venue's best price (ties go to the lower venue
+    index). An update that moves a venue's best replays one
+    leaf-to-root path, O(log venues); the cached NBBO is then
+    refreshed from the root and the merged top level, so
+    reading it is O(1).
+
+    Venues are dense indices fixed at construction. Crossed
+    and locked markets between venues are kept as published.
+*/
+
+namespace hft
+{
+
+    using VenueId = uint16_t;
+
+    inline constexpr VenueId NO_VENUE = UINT16_MAX;
+
+    struct VenueQuote
+    {
+        VenueId venue;
+        uint64_t volume;
+        size_t orderCount;
+
+        bool operator==(const VenueQuote&) const = default;
+    };
+
+    // One merged price level; venues in first-quoted order
+    struct ConsolidatedLevel
+    {
+        double price = 0.0;
+        uint64_t volume = 0;
+        size_t orderCount = 0;
+        std::vector<VenueQuote> venues;
+
+        bool operator==(const ConsolidatedLevel&) const = default;
+    };
+
+    // Size is the merged volume at the best price, from every venue there
+    struct Nbbo
+    {
+        double bid = 0.0;
+        uint64_t bidSize = 0;
+        VenueId bidVenue = NO_VENUE;
+        double ask = 0.0;
+        uint64_t askSize = 0;
+        VenueId askVenue = NO_VENUE;
+
+        bool operator==(const Nbbo&) const = default;
+    };
+
+    class ConsolidatedBook
+    {
+    public:
+
+        // Throws std::invalid_argument unless 0 < venueCount < NO_VENUE
+        explicit ConsolidatedBook(size_t venueCount);
+
+        // Replaces one venue level; false for an unknown venue or a bad price
+        bool apply(VenueId venue, const LevelUpdate& update);
+
+        // Drops everything a venue quotes (disconnect, halt)
+        void clearVenue(VenueId venue);
+
+        [[nodiscard]] const Nbbo& nbbo() const noexcept
+        {
+            return best;
+        }
+
+        // Best-first merged levels (maxLevels == 0 means all)
+        [[nodiscard]] std::vector<ConsolidatedLevel> getDepth(Side side, size_t maxLevels = 0) const;
+
+        // One venue's own levels, best first
+        [[nodiscard]] std::vector<DepthLevel> getVenueDepth(VenueId venue, Side side, size_t maxLevels = 0) const;
+
+        [[nodiscard]] size_t venueCount() const noexcept
+        {
+            return venues.size();
+        }
+
+        void clear();
+
+    private:
+
+        struct VenueLevel
+        {
+            uint64_t volume;
+            size_t orderCount;
+        };
+
+        template <Side S>
+        using VenueSide = std::map<double, VenueLevel, typename SideTraits<S>::Compare>;
+
+        // Merged level keyed by price; the price lives in the key
+        struct MergedLevel
+        {
+            uint64_t volume = 0;
+            size_t orderCount = 0;
+            std::vector<VenueQuote> venues;
+        };
+
+        template <Side S>
+        using MergedSide = std::map<double, MergedLevel, typename SideTraits<S>::Compare>;
+
+        struct Venue
+        {
+            VenueSide<Side::Buy> bids;
+            VenueSide<Side::Sell> asks;
+        };
+
+        /*
+            Winner tree over venue indices: node i holds the better
+            of nodes 2i and 2i+1, leaves start at `leaves`. Empty
+            venues (and padding) hold NO_VENUE, which always loses.
+        */
+        struct VenueTree
+        {
+            size_t leaves = 0;
+            std::vector<VenueId> nodes;
+            std::vector<double> bestPrice;   // per venue, valid while quoted
+        };
+
+        std::vector<Venue> venues;
+
+        MergedSide<Side::Buy> bids;
+        MergedSide<Side::Sell> asks;
+
+        VenueTree bidTree;
+        VenueTree askTree;
+
+        Nbbo best;
+
+        template <Side S>
+        [[nodiscard]] VenueSide<S>& venueSide(VenueId venue) noexcept
+        {
+            if constexpr (S == Side::Buy)
+                return venues[venue].bids;
+            else
+                return venues[venue].asks;
+        }
+
+        template <Side S>
+        [[nodiscard]] const VenueSide<S>& venueSide(VenueId venue) const noexcept
+        {
+            if constexpr (S == Side::Buy)
+                return venues[venue].bids;
+            else
+                return venues[venue].asks;
+        }
+
+        template <Side S>
+        [[nodiscard]] MergedSide<S>& merged() noexcept
+        {
+            if constexpr (S == Side::Buy)
+                return bids;
+            else
+                return asks;
+        }
+
+        template <Side S>
+        [[nodiscard]] const MergedSide<S>& merged() const noexcept
+        {
+            if constexpr (S == Side::Buy)
+                return bids;
+            else
+                return asks;
+        }
+
+        template <Side S>
+        [[nodiscard]] VenueTree& tree() noexcept
+        {
+            if constexpr (S == Side::Buy)
+                return bidTree;
+            else
+                return askTree;
+        }
+
+        template <Side S>
+        [[nodiscard]] const VenueTree& tree() const noexcept
+        {
+            if constexpr (S == Side::Buy)
+                return bidTree;
+            else
+                return askTree;
+        }
+
+        template <Side S>
+        void apply(VenueId venue, double price, uint64_t volume, size_t orderCount);
+
+        template <Side S>
+        void clearVenue(VenueId venue);
+
+        template <Side S>
+        void updateMerged(VenueId venue, double price, uint64_t volume, size_t orderCount);
+
+        // Better of two venues by their best price on side S
+        template <Side S>
+        [[nodiscard]] VenueId better(VenueId left, VenueId right) const noexcept;
+
+        // Replays the path from a venue's leaf to the root
+        template <Side S>
+        void replay(VenueId venue) noexcept;
+
+        template <Side S>
+        void refreshBest() noexcept;
+
+        template <Side S>
+        void appendDepth(std::vector<ConsolidatedLevel>& out, size_t maxLevels) const;
+
+        template <Side S>
+        void appendVenueDepth(std::vector<DepthLevel>& out, VenueId venue, size_t maxLevels) const;
+    };
+
+} // namespace hft
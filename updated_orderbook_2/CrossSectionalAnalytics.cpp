@@ -0,0 +1,292 @@
+#include "CrossSectionalAnalytics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace hft
+{
+
+    namespace
+    {
+        // ============================================================
+        // KERNELS
+        // ============================================================
+
+        // Inputs are loaded up front and a missing side becomes a
+        // 0/1 mask folded into the arithmetic (divisor 1, value 0).
+        // With no conditional work left, the loops vectorize even
+        // under strict floating-point flags.
+
+        void imbalanceKernel(const double* bid, const double* ask, double* out, size_t count) noexcept
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                const double b = bid[i];
+                const double a = ask[i];
+
+                const double total = b + a;
+                const double denominator = (total > 0.0) ? total : 1.0;
+                out[i] = (b - a) / denominator;
+            }
+        }
+
+        void spreadKernel(const double* bid, const double* ask, double* out, size_t count) noexcept
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                const double b = bid[i];
+                const double a = ask[i];
+
+                const double lower = (b < a) ? b : a;
+                const double quoted = (lower > 0.0) ? 1.0 : 0.0;
+
+                const double spread = a - b;
+                const double mid = (a + b) / 2.0;
+                out[i] = ((spread * quoted) / (mid * quoted + (1.0 - quoted))) * 100.0;
+            }
+        }
+
+        void micropriceKernel(const double* bidPx,
+            const double* askPx,
+            const double* bidQty,
+            const double* askQty,
+            double* out,
+            size_t count) noexcept
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                const double bp = bidPx[i];
+                const double ap = askPx[i];
+                const double bq = bidQty[i];
+                const double aq = askQty[i];
+
+                const double smaller = (bq < aq) ? bq : aq;
+                const double quoted = (smaller > 0.0) ? 1.0 : 0.0;
+
+                const double weighted = bp * aq + ap * bq;
+                const double size = bq + aq;
+                out[i] = (weighted * quoted) / (size * quoted + (1.0 - quoted));
+            }
+        }
+
+        // Unsigned key that sorts ascending as the value descends
+        uint64_t descendingKey(double value) noexcept
+        {
+            // +0.0 and -0.0 must tie
+            const uint64_t bits = std::bit_cast<uint64_t>(value + 0.0);
+            const uint64_t ascending = (bits >> 63) ? ~bits : bits | (1ull << 63);
+            return ~ascending;
+        }
+    }
+
+    CrossSectionalAnalytics::CrossSectionalAnalytics(Options options_)
+        : options(options_)
+    {
+        if (options.chunkSymbols == 0)
+            throw std::invalid_argument("CrossSectionalAnalytics: chunkSymbols must be positive");
+    }
+
+    // ============================================================
+    // REFRESH
+    // ============================================================
+
+    void CrossSectionalAnalytics::refresh(std::span<const OrderBook* const> books)
+    {
+        resize(books.size());
+
+        for (size_t chunk = 0; chunk < chunkCount(); ++chunk)
+        {
+            const size_t begin = chunk * options.chunkSymbols;
+            refreshChunk(books, begin, std::min(begin + options.chunkSymbols, symbols));
+        }
+
+        mergeChunks();
+    }
+
+    void CrossSectionalAnalytics::refresh(std::span<const OrderBook* const> books, ThreadPool& pool)
+    {
+        resize(books.size());
+
+        pool.parallelFor(chunkCount(), [&](size_t chunk)
+            {
+                const size_t begin = chunk * options.chunkSymbols;
+                refreshChunk(books, begin, std::min(begin + options.chunkSymbols, symbols));
+            });
+
+        mergeChunks();
+    }
+
+    void CrossSectionalAnalytics::resize(size_t count)
+    {
+        if (count > std::numeric_limits<uint32_t>::max())
+            throw std::invalid_argument("CrossSectionalAnalytics: too many symbols");
+
+        symbols = count;
+
+        for (auto* column : { &bidPrice, &askPrice, &bidTop, &askTop, &bidVolume, &askVolume,
+            &imbalance, &spreadPct, &microprice })
+        {
+            column->resize(count);
+        }
+
+        entries.resize(count);
+        entryScratch.resize(count);
+        ranked.resize(count);
+    }
+
+    size_t CrossSectionalAnalytics::chunkCount() const noexcept
+    {
+        return (symbols + options.chunkSymbols - 1) / options.chunkSymbols;
+    }
+
+    void CrossSectionalAnalytics::refreshChunk(std::span<const OrderBook* const> books, size_t begin, size_t end) noexcept
+    {
+        // Gather: the only pass that touches the books
+        for (size_t i = begin; i < end; ++i)
+        {
+            const BookSummary summary = books[i] ? books[i]->getSummary() : BookSummary{};
+
+            bidPrice[i] = summary.bidPrice;
+            askPrice[i] = summary.askPrice;
+            bidTop[i] = static_cast<double>(summary.bidTop);
+            askTop[i] = static_cast<double>(summary.askTop);
+            bidVolume[i] = static_cast<double>(summary.bidVolume);
+            askVolume[i] = static_cast<double>(summary.askVolume);
+        }
+
+        const size_t count = end - begin;
+
+        imbalanceKernel(&bidVolume[begin], &askVolume[begin], &imbalance[begin], count);
+        spreadKernel(&bidPrice[begin], &askPrice[begin], &spreadPct[begin], count);
+        micropriceKernel(&bidPrice[begin], &askPrice[begin], &bidTop[begin], &askTop[begin], &microprice[begin], count);
+
+        // Chunk-local ranking; mergeChunks() joins the runs
+        for (size_t i = begin; i < end; ++i)
+            entries[i] = { descendingKey(imbalance[i]), static_cast<uint32_t>(i) };
+
+        radixSort(begin, end);
+    }
+
+    void CrossSectionalAnalytics::radixSort(size_t begin, size_t end) noexcept
+    {
+        /*
+            LSD radix sort, a byte per pass. One read builds every
+            pass's histogram; passes are stable, so equal keys keep
+            symbol order, and bytes every key shares (most of the
+            exponent) are skipped.
+        */
+
+        RankEntry* from = entries.data() + begin;
+        RankEntry* to = entryScratch.data() + begin;
+        const size_t count = end - begin;
+
+        std::array<std::array<uint32_t, 256>, 8> histograms{};
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint64_t key = from[i].key;
+            for (size_t pass = 0; pass < 8; ++pass)
+                ++histograms[pass][(key >> (8 * pass)) & 0xFF];
+        }
+
+        for (size_t pass = 0; pass < 8; ++pass)
+        {
+            auto& offsets = histograms[pass];
+            const unsigned shift = static_cast<unsigned>(8 * pass);
+
+            if (offsets[(from[0].key >> shift) & 0xFF] == count)
+                continue;
+
+            uint32_t position = 0;
+            for (uint32_t& offset : offsets)
+                position += std::exchange(offset, position);
+
+            for (size_t i = 0; i < count; ++i)
+                to[offsets[(from[i].key >> shift) & 0xFF]++] = from[i];
+
+            std::swap(from, to);
+        }
+
+        if (from != entries.data() + begin)
+            std::copy(from, from + count, entries.data() + begin);
+    }
+
+    void CrossSectionalAnalytics::mergeChunks()
+    {
+        // std::merge is stable and left runs hold lower symbols,
+        // so comparing keys alone keeps ties in symbol order
+        const auto byKey = [](const RankEntry& a, const RankEntry& b) { return a.key < b.key; };
+
+        // Bottom-up: runs of width chunkSymbols, doubling each pass
+        for (size_t width = options.chunkSymbols; width < symbols; width *= 2)
+        {
+            for (size_t begin = 0; begin < symbols; begin += 2 * width)
+            {
+                const size_t middle = std::min(begin + width, symbols);
+                const size_t end = std::min(begin + 2 * width, symbols);
+
+                std::merge(entries.data() + begin, entries.data() + middle,
+                    entries.data() + middle, entries.data() + end,
+                    entryScratch.data() + begin, byKey);
+            }
+
+            entries.swap(entryScratch);
+        }
+
+        for (size_t i = 0; i < symbols; ++i)
+            ranked[i] = entries[i].symbol;
+    }
+
+    // ============================================================
+    // QUERIES
+    // ============================================================
+
+    size_t CrossSectionalAnalytics::size() const noexcept
+    {
+        return symbols;
+    }
+
+    std::span<const double> CrossSectionalAnalytics::bidPrices() const noexcept
+    {
+        return bidPrice;
+    }
+
+    std::span<const double> CrossSectionalAnalytics::askPrices() const noexcept
+    {
+        return askPrice;
+    }
+
+    std::span<const double> CrossSectionalAnalytics::bidVolumes() const noexcept
+    {
+        return bidVolume;
+    }
+
+    std::span<const double> CrossSectionalAnalytics::askVolumes() const noexcept
+    {
+        return askVolume;
+    }
+
+    std::span<const double> CrossSectionalAnalytics::imbalances() const noexcept
+    {
+        return imbalance;
+    }
+
+    std::span<const double> CrossSectionalAnalytics::spreadPercentages() const noexcept
+    {
+        return spreadPct;
+    }
+
+    std::span<const double> CrossSectionalAnalytics::microprices() const noexcept
+    {
+        return microprice;
+    }
+
+    std::span<const uint32_t> CrossSectionalAnalytics::rankedByImbalance() const noexcept
+    {
+        return ranked;
+    }
+
+} // namespace hft
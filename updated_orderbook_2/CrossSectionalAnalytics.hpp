@@ -0,0 +1,117 @@
+#pragma once
+
+#include "OrderBook.hpp"
+#include "ThreadPool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/*
+
+    Cross-sectional analytics over a whole symbol universe.
+
+    HFTAlgorithms answers one question about one book. Here a
+    refresh() snapshots every book once (top of book and side
+    totals, via OrderBook::getSummary) into contiguous columns,
+    one array per field, then computes each signal for all
+    symbols in a flat loop over those columns:
+
+        imbalance      (bid - ask) / (bid + ask) total volume
+        spread %       spread over mid, x100
+        microprice     mid weighted by opposite top-level size
+
+    and ranks the universe by imbalance. Values match the
+    per-book HFTAlgorithms results exactly.
+
+    Side totals come from the book's depth index when it has
+    one (OrderBook::enableDepthIndex); otherwise every refresh
+    walks every level, which dominates the cost.
+
+    The kernels are branch-free loops over doubles, which the
+    compiler turns into packed SIMD in Release builds (-O3);
+    no intrinsics or target flags are needed. With a pool, the
+    universe is split into fixed chunks that each collect,
+    compute and radix-sort their own symbols; the sorted
+    chunks are then merged. Results do not depend on the
+    thread count.
+*/
+
+namespace hft
+{
+
+    struct CrossSectionOptions
+    {
+        size_t chunkSymbols = 512;   // per pool task
+    };
+
+    class CrossSectionalAnalytics
+    {
+    public:
+
+        using Options = CrossSectionOptions;
+
+        // Throws std::invalid_argument for a zero chunk size
+        explicit CrossSectionalAnalytics(Options options = {});
+
+        // books[i] is symbol i; a null book reads as empty.
+        // The books must not change during the call.
+        void refresh(std::span<const OrderBook* const> books);
+        void refresh(std::span<const OrderBook* const> books, ThreadPool& pool);
+
+        [[nodiscard]] size_t size() const noexcept;
+
+        // Snapshot columns, indexed by symbol
+        [[nodiscard]] std::span<const double> bidPrices() const noexcept;
+        [[nodiscard]] std::span<const double> askPrices() const noexcept;
+        [[nodiscard]] std::span<const double> bidVolumes() const noexcept;
+        [[nodiscard]] std::span<const double> askVolumes() const noexcept;
+
+        // Signals, indexed by symbol; 0 where a side is missing
+        [[nodiscard]] std::span<const double> imbalances() const noexcept;
+        [[nodiscard]] std::span<const double> spreadPercentages() const noexcept;
+        [[nodiscard]] std::span<const double> microprices() const noexcept;
+
+        // Symbols by imbalance, highest first; ties by symbol
+        [[nodiscard]] std::span<const uint32_t> rankedByImbalance() const noexcept;
+
+    private:
+
+        Options options;
+        size_t symbols = 0;
+
+        std::vector<double> bidPrice;
+        std::vector<double> askPrice;
+        std::vector<double> bidTop;
+        std::vector<double> askTop;
+        std::vector<double> bidVolume;
+        std::vector<double> askVolume;
+
+        std::vector<double> imbalance;
+        std::vector<double> spreadPct;
+        std::vector<double> microprice;
+
+        // Sort key: imbalance bits mapped so that higher sorts first
+        struct RankEntry
+        {
+            uint64_t key;
+            uint32_t symbol;
+        };
+
+        std::vector<RankEntry> entries;
+        std::vector<RankEntry> entryScratch;
+        std::vector<uint32_t> ranked;
+
+        void resize(size_t count);
+        [[nodiscard]] size_t chunkCount() const noexcept;
+
+        // Collects, computes and sorts symbols [begin, end)
+        void refreshChunk(std::span<const OrderBook* const> books, size_t begin, size_t end) noexcept;
+        void radixSort(size_t begin, size_t end) noexcept;
+
+        // Merges the sorted chunks into one ranking
+        void mergeChunks();
+    };
+
+} // namespace hft
@@ -0,0 +1,474 @@
+#include "DepthIndex.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+
+namespace hft
+{
+
+    DepthIndex::DepthIndex(double tickSize)
+        : tick(tickSize)
+    {
+        if (!(tickSize > 0.0) || !std::isfinite(tickSize))
+            throw std::invalid_argument("DepthIndex: tick size must be positive");
+    }
+
+    int64_t DepthIndex::toTick(double price) const noexcept
+    {
+        return std::llround(price / tick);
+    }
+
+    int64_t DepthIndex::tickAt(Side side, size_t position) const noexcept
+    {
+        const size_t offset = (side == Side::Buy) ? capacity - position : position - 1;
+        return lowTick + static_cast<int64_t>(offset);
+    }
+
+    // ============================================================
+    // UPDATES
+    // ============================================================
+
+    void DepthIndex::add(Side side, double price, uint64_t quantity)
+    {
+        if (quantity == 0)
+            return;
+
+        const int64_t tickNumber = toTick(price);
+        ensureCovers(side, tickNumber);
+        update(side, tickNumber, quantity, true);
+    }
+
+    void DepthIndex::remove(Side side, double price, uint64_t quantity)
+    {
+        if (quantity == 0 || capacity == 0)
+            return;
+
+        update(side, toTick(price), quantity, false);
+    }
+
+    void DepthIndex::update(Side side, int64_t tickNumber, uint64_t quantity, bool adding)
+    {
+        Ladder& target = ladder(side);
+        const int64_t offset = tickNumber - lowTick;
+
+        if (offset < 0 || static_cast<size_t>(offset) >= capacity)
+        {
+            // Beyond the band: a plain sorted level
+            if (adding)
+            {
+                target.outside[tickNumber] += quantity;
+                target.total += quantity;
+                return;
+            }
+
+            const auto it = target.outside.find(tickNumber);
+            if (it == target.outside.end())
+                return;
+
+            const uint64_t removed = std::min(quantity, it->second);
+            target.total -= removed;
+            if ((it->second -= removed) == 0)
+                target.outside.erase(it);
+            return;
+        }
+
+        const uint64_t notional = quantity * static_cast<uint64_t>(offset);
+
+        // Unsigned wrap-around makes removal a plain add
+        const uint64_t quantityDelta = adding ? quantity : 0 - quantity;
+        const uint64_t notionalDelta = adding ? notional : 0 - notional;
+
+        target.quantityAt[static_cast<size_t>(offset)] += quantityDelta;
+        target.gridTotal += quantityDelta;
+        target.total += quantityDelta;
+
+        for (size_t i = position(side, static_cast<size_t>(offset)); i <= capacity; i += i & (0 - i))
+        {
+            target.quantityTree[i] += quantityDelta;
+            target.notionalTree[i] += notionalDelta;
+        }
+    }
+
+    size_t DepthIndex::memoryBytes() const noexcept
+    {
+        size_t bytes = 0;
+
+        for (const Ladder* side : { &bids, &asks })
+        {
+            bytes += (side->quantityAt.capacity()
+                + side->quantityTree.capacity()
+                + side->notionalTree.capacity()) * sizeof(uint64_t);
+
+            // Red-black tree node: three links and a colour word ahead of the value
+            bytes += side->outside.size() * (sizeof(std::pair<const int64_t, uint64_t>) + 4 * sizeof(void*));
+        }
+
+        return bytes;
+    }
+
+    void DepthIndex::clear() noexcept
+    {
+        for (Ladder* side : { &bids, &asks })
+        {
+            side->quantityAt.clear();
+            side->quantityTree.clear();
+            side->notionalTree.clear();
+            side->outside.clear();
+            side->gridTotal = 0;
+            side->total = 0;
+        }
+
+        lowTick = 0;
+        capacity = 0;
+    }
+
+    // ============================================================
+    // GRID GROWTH
+    // ============================================================
+
+    void DepthIndex::ensureCovers(Side side, int64_t tickNumber)
+    {
+        if (capacity == 0)
+        {
+            capacity = INITIAL_CAPACITY;
+            lowTick = tickNumber - static_cast<int64_t>(capacity / 2);
+
+            for (Ladder* target : { &bids, &asks })
+            {
+                target->quantityAt.assign(capacity, 0);
+                target->quantityTree.assign(capacity + 1, 0);
+                target->notionalTree.assign(capacity + 1, 0);
+            }
+
+            return;
+        }
+
+        const int64_t highTick = lowTick + static_cast<int64_t>(capacity);
+        if (tickNumber >= lowTick && tickNumber < highTick)
+            return;
+
+        const int64_t newLow = std::min(lowTick, tickNumber);
+        const int64_t newHigh = std::max(highTick, tickNumber + 1);
+        const uint64_t span = static_cast<uint64_t>(newHigh) - static_cast<uint64_t>(newLow);
+
+        if (span <= MAX_CAPACITY)
+        {
+            const size_t newCapacity = std::min(MAX_CAPACITY,
+                std::bit_ceil(std::max(capacity * 2, static_cast<size_t>(span))));
+
+            // Grow away from the side the new tick fell outside of
+            relocate((tickNumber < lowTick) ? newHigh - static_cast<int64_t>(newCapacity) : lowTick, newCapacity);
+            return;
+        }
+
+        // Past the band only a new touch moves the grid; anything
+        // else stays a level beyond it
+        const Ladder& target = ladder(side);
+        const bool newTouch = target.total == 0
+            || (side == Side::Buy ? tickNumber > bestTick(side) : tickNumber < bestTick(side));
+
+        if (newTouch)
+            relocate(tickNumber - static_cast<int64_t>(capacity / 2), capacity);
+    }
+
+    void DepthIndex::relocate(int64_t newLowTick, size_t newCapacity)
+    {
+        const int64_t newHighTick = newLowTick + static_cast<int64_t>(newCapacity);
+        const auto inside = [&](int64_t tickNumber)
+            {
+                return tickNumber >= newLowTick && tickNumber < newHighTick;
+            };
+
+        for (Ladder* target : { &bids, &asks })
+        {
+            std::vector<uint64_t> moved(newCapacity, 0);
+            std::map<int64_t, uint64_t> beyond;
+
+            for (size_t offset = 0; offset < capacity; ++offset)
+            {
+                const uint64_t quantity = target->quantityAt[offset];
+                const int64_t tickNumber = lowTick + static_cast<int64_t>(offset);
+
+                if (quantity == 0)
+                    continue;
+
+                if (inside(tickNumber))
+                    moved[static_cast<size_t>(tickNumber - newLowTick)] = quantity;
+                else
+                    beyond.emplace_hint(beyond.end(), tickNumber, quantity);
+            }
+
+            for (auto it = target->outside.begin(); it != target->outside.end();)
+            {
+                auto node = target->outside.extract(it++);
+
+                if (inside(node.key()))
+                    moved[static_cast<size_t>(node.key() - newLowTick)] = node.mapped();
+                else
+                    beyond.insert(std::move(node));
+            }
+
+            target->quantityAt = std::move(moved);
+            target->outside = std::move(beyond);
+        }
+
+        lowTick = newLowTick;
+        capacity = newCapacity;
+
+        rebuild(Side::Buy);
+        rebuild(Side::Sell);
+    }
+
+    void DepthIndex::rebuild(Side side)
+    {
+        Ladder& target = ladder(side);
+
+        target.quantityTree.assign(capacity + 1, 0);
+        target.notionalTree.assign(capacity + 1, 0);
+        target.gridTotal = 0;
+
+        for (size_t offset = 0; offset < capacity; ++offset)
+        {
+            const size_t i = position(side, offset);
+            target.gridTotal += target.quantityAt[offset];
+            target.quantityTree[i] = target.quantityAt[offset];
+            target.notionalTree[i] = target.quantityAt[offset] * static_cast<uint64_t>(offset);
+        }
+
+        // Linear-time Fenwick construction
+        for (size_t i = 1; i <= capacity; ++i)
+        {
+            const size_t parent = i + (i & (0 - i));
+            if (parent <= capacity)
+            {
+                target.quantityTree[parent] += target.quantityTree[i];
+                target.notionalTree[parent] += target.notionalTree[i];
+            }
+        }
+    }
+
+    // ============================================================
+    // QUERIES
+    // ============================================================
+
+    uint64_t DepthIndex::prefixQuantity(const Ladder& side, size_t position) const noexcept
+    {
+        uint64_t sum = 0;
+        for (size_t i = std::min(position, capacity); i > 0; i -= i & (0 - i))
+            sum += side.quantityTree[i];
+
+        return sum;
+    }
+
+    DepthIndex::Descent DepthIndex::descend(const Ladder& side, uint64_t target) const noexcept
+    {
+        // Largest prefix strictly below target; the next position reaches it
+        Descent result{ 0, 0, 0 };
+        uint64_t remaining = target;
+
+        for (size_t step = std::bit_floor(capacity); step > 0; step >>= 1)
+        {
+            const size_t next = result.position + step;
+            if (next <= capacity && side.quantityTree[next] < remaining)
+            {
+                result.position = next;
+                remaining -= side.quantityTree[next];
+                result.quantityBefore += side.quantityTree[next];
+                result.notionalBefore += side.notionalTree[next];
+            }
+        }
+
+        ++result.position;
+        return result;
+    }
+
+    template <typename Visit>
+    void DepthIndex::walkOutside(Side side, bool better, Visit&& visit) const
+    {
+        const auto& levels = ladder(side).outside;
+        const int64_t highTick = lowTick + static_cast<int64_t>(capacity);
+
+        // Asks run up the ticks, bids down
+        if (side == Side::Sell)
+        {
+            auto it = better ? levels.begin() : levels.lower_bound(highTick);
+            const auto last = better ? levels.lower_bound(lowTick) : levels.end();
+
+            for (; it != last; ++it)
+            {
+                if (!visit(it->first, it->second))
+                    return;
+            }
+        }
+        else
+        {
+            auto it = better ? levels.rbegin() : std::make_reverse_iterator(levels.lower_bound(lowTick));
+            const auto last = better ? std::make_reverse_iterator(levels.lower_bound(highTick)) : levels.rend();
+
+            for (; it != last; ++it)
+            {
+                if (!visit(it->first, it->second))
+                    return;
+            }
+        }
+    }
+
+    int64_t DepthIndex::bestTick(Side side) const noexcept
+    {
+        const Ladder& source = ladder(side);
+        int64_t best = 0;
+        bool found = false;
+
+        const auto first = [&](int64_t tickNumber, uint64_t)
+            {
+                best = tickNumber;
+                found = true;
+                return false;
+            };
+
+        walkOutside(side, true, first);
+        if (found)
+            return best;
+
+        if (source.gridTotal > 0)
+            return tickAt(side, descend(source, 1).position);
+
+        walkOutside(side, false, first);
+        return best;
+    }
+
+    SweepCost DepthIndex::sweepCost(Side side, uint64_t quantity) const
+    {
+        const Ladder& source = ladder(side);
+        const uint64_t wanted = std::min(quantity, source.total);
+
+        if (wanted == 0)
+            return {};
+
+        // Notional in ticks: levels beyond the band, then the grid
+        uint64_t remaining = wanted;
+        double notionalTicks = 0.0;
+        int64_t lastTick = 0;
+
+        const auto take = [&](int64_t tickNumber, uint64_t available)
+            {
+                const uint64_t used = std::min(available, remaining);
+                notionalTicks += static_cast<double>(used) * static_cast<double>(tickNumber);
+                remaining -= used;
+                lastTick = tickNumber;
+                return remaining > 0;
+            };
+
+        walkOutside(side, true, take);
+
+        if (remaining > 0 && source.gridTotal > 0)
+        {
+            const uint64_t fromGrid = std::min(remaining, source.gridTotal);
+            const Descent descent = descend(source, fromGrid);
+            lastTick = tickAt(side, descent.position);
+
+            // Grid notional is stored relative to lowTick
+            notionalTicks += static_cast<double>(descent.notionalBefore)
+                + static_cast<double>(fromGrid - descent.quantityBefore) * static_cast<double>(lastTick - lowTick)
+                + static_cast<double>(lowTick) * static_cast<double>(fromGrid);
+            remaining -= fromGrid;
+        }
+
+        if (remaining > 0)
+            walkOutside(side, false, take);
+
+        SweepCost cost;
+        cost.quantity = wanted;
+        cost.worstPrice = static_cast<double>(lastTick) * tick;
+        cost.notional = notionalTicks * tick;
+        return cost;
+    }
+
+    double DepthIndex::priceForQty(Side side, uint64_t quantity) const
+    {
+        if (quantity == 0 || quantity > ladder(side).total)
+            return 0.0;
+
+        return sweepCost(side, quantity).worstPrice;
+    }
+
+    double DepthIndex::bestPrice(Side side) const
+    {
+        if (ladder(side).total == 0)
+            return 0.0;
+
+        return static_cast<double>(bestTick(side)) * tick;
+    }
+
+    uint64_t DepthIndex::depthWithin(Side side, uint64_t ticks) const
+    {
+        if (ladder(side).total == 0)
+            return 0;
+
+        const int64_t ownBest = bestTick(side);
+
+        // Twice the reference tick, so a half-tick mid stays exact
+        int64_t doubledReference = 2 * ownBest;
+        const Side otherSide = (side == Side::Buy) ? Side::Sell : Side::Buy;
+        if (ladder(otherSide).total > 0)
+            doubledReference = ownBest + bestTick(otherSide);
+
+        const int64_t span = 2 * static_cast<int64_t>(ticks);
+
+        if (side == Side::Sell)
+        {
+            // Asks priced <= reference + ticks (floor)
+            const int64_t doubled = doubledReference + span;
+            return quantityThrough(side, (doubled >= 0) ? doubled / 2 : -((-doubled + 1) / 2));
+        }
+
+        // Bids priced >= reference - ticks (ceil)
+        const int64_t doubled = doubledReference - span;
+        return quantityThrough(side, (doubled >= 0) ? (doubled + 1) / 2 : -((-doubled) / 2));
+    }
+
+    uint64_t DepthIndex::quantityThrough(Side side, int64_t limitTick) const noexcept
+    {
+        const Ladder& source = ladder(side);
+        uint64_t sum = 0;
+
+        // Best first, so the walks stop at the first level past the limit
+        const auto count = [&](int64_t tickNumber, uint64_t quantity)
+            {
+                if (side == Side::Sell ? tickNumber > limitTick : tickNumber < limitTick)
+                    return false;
+
+                sum += quantity;
+                return true;
+            };
+
+        walkOutside(side, true, count);
+
+        const int64_t offset = limitTick - lowTick;
+        if (side == Side::Sell)
+        {
+            if (offset >= 0)
+                sum += prefixQuantity(source, static_cast<size_t>(offset) + 1);
+        }
+        else if (offset < 0)
+        {
+            sum += source.gridTotal;
+        }
+        else if (offset < static_cast<int64_t>(capacity))
+        {
+            sum += prefixQuantity(source, capacity - static_cast<size_t>(offset));
+        }
+
+        walkOutside(side, false, count);
+        return sum;
+    }
+
+    uint64_t DepthIndex::totalQuantity(Side side) const noexcept
+    {
+        return ladder(side).total;
+    }
+
+} // namespace hft
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "OrderBook.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/*
+
+    Cumulative-depth index over a tick grid.
+
+    Each side keeps two Fenwick trees indexed by distance from
+    the best possible price on that side (ascending ticks for
+    asks, descending for bids): resting quantity, and notional
+    in ticks x quantity. Any "from the touch outwards" prefix
+    is then one O(log ticks) descent:
+
+        sweepCost(side, qty)   notional to take qty from `side`
+        priceForQty(side, qty) worst price reached doing so
+        depthWithin(side, n)   size on `side` within n ticks of mid
+
+    `side` is always the resting side consulted, so the cost
+    of buying N lots is sweepCost(Side::Sell, N).
+
+    Prices are bucketed to the nearest tick. The grid grows
+    (amortized doubling, O(ticks) rebuild) when a price falls
+    outside it, up to MAX_CAPACITY ticks. Past that, prices
+    outside the band do not grow it: they are kept as sorted
+    per-tick levels and queries walk them. A new touch beyond
+    the band re-centres the grid on it, so the band follows
+    the top of the book while stray far orders stay cheap.
+    Notional is held in ticks relative to the grid origin, so
+    band x total volume must stay below 2^64.
+*/
+
+namespace hft
+{
+
+    struct SweepCost
+    {
+        double notional = 0.0;
+        uint64_t quantity = 0;      // < requested when depth runs out
+        double worstPrice = 0.0;    // 0 when nothing is available
+    };
+
+    class DepthIndex
+    {
+    public:
+
+        explicit DepthIndex(double tickSize);
+
+        void add(Side side, double price, uint64_t quantity);
+        void remove(Side side, double price, uint64_t quantity);
+        void clear() noexcept;
+
+        [[nodiscard]] SweepCost sweepCost(Side side, uint64_t quantity) const;
+
+        // 0.0 if the side cannot fill `quantity`
+        [[nodiscard]] double priceForQty(Side side, uint64_t quantity) const;
+
+        // Mid when both sides are present, else this side's best
+        [[nodiscard]] uint64_t depthWithin(Side side, uint64_t ticks) const;
+
+        [[nodiscard]] double bestPrice(Side side) const;
+        [[nodiscard]] uint64_t totalQuantity(Side side) const noexcept;
+
+        // Heap bytes held by both ladders
+        [[nodiscard]] size_t memoryBytes() const noexcept;
+
+        [[nodiscard]] double tickSize() const noexcept
+        {
+            return tick;
+        }
+
+    private:
+
+        static constexpr size_t INITIAL_CAPACITY = 1024;
+        static constexpr size_t MAX_CAPACITY = 1 << 16;
+
+        // One side: plain per-tick quantities plus both trees.
+        // Trees are 1-based and ordered best price first.
+        struct Ladder
+        {
+            std::vector<uint64_t> quantityAt;   // by tick - lowTick
+            std::vector<uint64_t> quantityTree;
+            std::vector<uint64_t> notionalTree;
+            std::map<int64_t, uint64_t> outside;   // by tick, beyond the grid
+            uint64_t gridTotal = 0;
+            uint64_t total = 0;
+        };
+
+        double tick;
+        int64_t lowTick = 0;
+        size_t capacity = 0;
+
+        Ladder bids;
+        Ladder asks;
+
+        [[nodiscard]] int64_t toTick(double price) const noexcept;
+
+        [[nodiscard]] const Ladder& ladder(Side side) const noexcept
+        {
+            return side == Side::Buy ? bids : asks;
+        }
+
+        [[nodiscard]] Ladder& ladder(Side side) noexcept
+        {
+            return side == Side::Buy ? bids : asks;
+        }
+
+        // Tree position (1-based) of a tick offset on `side`
+        [[nodiscard]] size_t position(Side side, size_t offset) const noexcept
+        {
+            return side == Side::Buy ? capacity - offset : offset + 1;
+        }
+
+        [[nodiscard]] int64_t tickAt(Side side, size_t position) const noexcept;
+
+        void ensureCovers(Side side, int64_t tickNumber);
+        void relocate(int64_t newLowTick, size_t newCapacity);
+        void rebuild(Side side);
+        void update(Side side, int64_t tickNumber, uint64_t quantity, bool adding);
+
+        // Levels beyond the grid, best first: the ones better than
+        // every grid tick, or the ones worse. visit(tick, quantity)
+        // returns false to stop.
+        template <typename Visit>
+        void walkOutside(Side side, bool better, Visit&& visit) const;
+
+        // Requires a non-empty side
+        [[nodiscard]] int64_t bestTick(Side side) const noexcept;
+
+        // Quantity priced at limitTick or better
+        [[nodiscard]] uint64_t quantityThrough(Side side, int64_t limitTick) const noexcept;
+
+        [[nodiscard]] uint64_t prefixQuantity(const Ladder& ladder, size_t position) const noexcept;
+
+        struct Descent
+        {
+            size_t position;            // first position reaching the target
+            uint64_t quantityBefore;    // prefix quantity before it
+            uint64_t notionalBefore;
+        };
+
+        [[nodiscard]] Descent descend(const Ladder& ladder, uint64_t target) const noexcept;
+    };
+
+} // namespace hft
@@ -0,0 +1,174 @@
+#include "EngineMetrics.hpp"
+
+namespace hft
+{
+
+    namespace
+    {
+        constexpr std::array<MetricInfo, METRIC_COUNT> METRIC_TABLE{ {
+            { "orders_accepted", MetricKind::Counter },
+            { "orders_rejected_price", MetricKind::Counter },
+            { "orders_rejected_quantity", MetricKind::Counter },
+            { "orders_rejected_market_disabled", MetricKind::Counter },
+            { "orders_rejected_order_id", MetricKind::Counter },
+            { "orders_cancelled", MetricKind::Counter },
+            { "fills", MetricKind::Counter },
+            { "filled_quantity", MetricKind::Counter },
+            { "levels_created", MetricKind::Counter },
+            { "levels_destroyed", MetricKind::Counter },
+            { "iceberg_refills", MetricKind::Counter },
+            { "last_sweep_depth", MetricKind::Gauge },
+            { "max_sweep_depth", MetricKind::Gauge },
+            { "max_queue_length", MetricKind::Gauge },
+            { "order_pool_occupancy", MetricKind::Gauge },
+        } };
+    }
+
+    const MetricInfo& metricInfo(Metric metric) noexcept
+    {
+        return METRIC_TABLE[static_cast<size_t>(metric)];
+    }
+
+    // ============================================================
+    // SNAPSHOT OUTPUT
+    // ============================================================
+
+    void MetricsSnapshot::writeText(std::ostream& out) const
+    {
+        out << "# metrics seq=" << sequence << "\n";
+
+        for (size_t i = 0; i < METRIC_COUNT; ++i)
+            out << METRIC_TABLE[i].name << " " << values[i] << "\n";
+    }
+
+    void MetricsSnapshot::writeJson(std::ostream& out) const
+    {
+        out << "{\"seq\":" << sequence;
+
+        for (size_t i = 0; i < METRIC_COUNT; ++i)
+            out << ",\"" << METRIC_TABLE[i].name << "\":" << values[i];
+
+        out << "}\n";
+    }
+
+    // ============================================================
+    // SEQUENCE LOCK
+    // ============================================================
+
+    void MetricsRegistry::beginUpdate() noexcept
+    {
+        // Odd sequence marks a write in progress
+        sequence.increment();
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void MetricsRegistry::endUpdate() noexcept
+    {
+        std::atomic_thread_fence(std::memory_order_release);
+        sequence.increment();
+    }
+
+    MetricsSnapshot MetricsRegistry::snapshot() const noexcept
+    {
+        MetricsSnapshot snap;
+
+        for (;;)
+        {
+            const uint64_t before = sequence.load();
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (before & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            for (size_t i = 0; i < METRIC_COUNT; ++i)
+                snap.values[i] = counters[i].load();
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (sequence.load() == before)
+            {
+                snap.sequence = before / 2;
+                return snap;
+            }
+        }
+    }
+
+    void MetricsRegistry::reset() noexcept
+    {
+        MetricsUpdateScope scope(*this);
+
+        for (auto& counter : counters)
+            counter.reset();
+    }
+
+    // ============================================================
+    // REPORTER
+    // ============================================================
+
+    MetricsReporter::MetricsReporter(const MetricsRegistry& registry_,
+        std::ostream& out_,
+        Format format_,
+        std::chrono::milliseconds interval_)
+        : registry(registry_),
+        out(out_),
+        format(format_),
+        interval(interval_)
+    {
+    }
+
+    MetricsReporter::~MetricsReporter()
+    {
+        stop();
+    }
+
+    void MetricsReporter::start()
+    {
+        if (worker.joinable())
+            return;
+
+        worker = std::jthread([this](std::stop_token stop)
+            {
+                std::unique_lock lock(mutex);
+
+                while (!stop.stop_requested())
+                {
+                    wakeup.wait_for(lock, stop, interval, [] { return false; });
+
+                    if (stop.stop_requested())
+                        break;
+
+                    lock.unlock();
+                    dumpNow();
+                    lock.lock();
+                }
+            });
+    }
+
+    void MetricsReporter::stop()
+    {
+        if (!worker.joinable())
+            return;
+
+        worker.request_stop();
+        worker.join();
+
+        // Final dump so the last interval is never lost
+        dumpNow();
+    }
+
+    void MetricsReporter::dumpNow()
+    {
+        const MetricsSnapshot snap = registry.snapshot();
+
+        if (format == Format::Json)
+            snap.writeJson(out);
+        else
+            snap.writeText(out);
+
+        out.flush();
+    }
+
+} // namespace hft
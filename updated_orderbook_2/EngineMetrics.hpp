@@ -0,0 +1,196 @@
+#pragma once
+
+#include "HFTUtils.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+/*
+
+    Hot-path counter registry.
+
+    Every metric lives in its own cache line (PerformanceCounter),
+    so the engine thread updates them with plain stores and no
+    false sharing.
+
+    Readers on another thread take a snapshot() through a
+    sequence lock: the writer brackets each logical event with
+    beginUpdate() / endUpdate(), and the reader retries until it
+    copies the whole set between two equal, even sequence values.
+
+    MetricsReporter dumps snapshots as text or JSON on a timer.
+*/
+
+namespace hft
+{
+
+    enum class Metric : uint8_t
+    {
+        OrdersAccepted,
+        OrdersRejectedPrice,
+        OrdersRejectedQuantity,
+        OrdersRejectedMarketDisabled,
+        OrdersRejectedOrderId,
+        OrdersCancelled,
+        Fills,
+        FilledQuantity,
+        LevelsCreated,
+        LevelsDestroyed,
+        IcebergRefills,
+        LastSweepDepth,
+        MaxSweepDepth,
+        MaxQueueLength,
+        OrderPoolOccupancy,
+        Count
+    };
+
+    enum class MetricKind : uint8_t
+    {
+        Counter,
+        Gauge
+    };
+
+    constexpr size_t METRIC_COUNT = static_cast<size_t>(Metric::Count);
+
+    struct MetricInfo
+    {
+        const char* name;
+        MetricKind kind;
+    };
+
+    [[nodiscard]] const MetricInfo& metricInfo(Metric metric) noexcept;
+
+    // ============================================================
+    // SNAPSHOT
+    // ============================================================
+
+    struct MetricsSnapshot
+    {
+        std::array<uint64_t, METRIC_COUNT> values{};
+        uint64_t sequence = 0;
+
+        [[nodiscard]] uint64_t operator[](Metric metric) const noexcept
+        {
+            return values[static_cast<size_t>(metric)];
+        }
+
+        void writeText(std::ostream& out) const;
+        void writeJson(std::ostream& out) const;
+    };
+
+    // ============================================================
+    // REGISTRY
+    // ============================================================
+
+    class MetricsRegistry
+    {
+    public:
+
+        // Writer (engine thread) interface
+        void increment(Metric metric, uint64_t delta = 1) noexcept
+        {
+            counters[static_cast<size_t>(metric)].add(delta);
+        }
+
+        void set(Metric metric, uint64_t value) noexcept
+        {
+            counters[static_cast<size_t>(metric)].set(value);
+        }
+
+        void setMax(Metric metric, uint64_t value) noexcept
+        {
+            counters[static_cast<size_t>(metric)].setMax(value);
+        }
+
+        [[nodiscard]] uint64_t get(Metric metric) const noexcept
+        {
+            return counters[static_cast<size_t>(metric)].get();
+        }
+
+        void beginUpdate() noexcept;
+        void endUpdate() noexcept;
+
+        // Reader (any thread) interface
+        [[nodiscard]] MetricsSnapshot snapshot() const noexcept;
+
+        // Writer thread only, while no reader depends on continuity
+        void reset() noexcept;
+
+    private:
+
+        std::array<PerformanceCounter, METRIC_COUNT> counters;
+        PerformanceCounter sequence;
+    };
+
+    // RAII bracket for one logical engine event
+    class MetricsUpdateScope
+    {
+    public:
+
+        explicit MetricsUpdateScope(MetricsRegistry& registry_) noexcept
+            : registry(registry_)
+        {
+            registry.beginUpdate();
+        }
+
+        ~MetricsUpdateScope()
+        {
+            registry.endUpdate();
+        }
+
+        MetricsUpdateScope(const MetricsUpdateScope&) = delete;
+        MetricsUpdateScope& operator=(const MetricsUpdateScope&) = delete;
+
+    private:
+        MetricsRegistry& registry;
+    };
+
+    // ============================================================
+    // PERIODIC DUMP
+    // ============================================================
+
+    class MetricsReporter
+    {
+    public:
+
+        enum class Format
+        {
+            Text,
+            Json
+        };
+
+        MetricsReporter(const MetricsRegistry& registry,
+            std::ostream& out,
+            Format format,
+            std::chrono::milliseconds interval);
+
+        ~MetricsReporter();
+
+        MetricsReporter(const MetricsReporter&) = delete;
+        MetricsReporter& operator=(const MetricsReporter&) = delete;
+
+        void start();
+        void stop();
+
+        // Write one snapshot immediately (monitoring thread or caller)
+        void dumpNow();
+
+    private:
+
+        const MetricsRegistry& registry;
+        std::ostream& out;
+        Format format;
+        std::chrono::milliseconds interval;
+
+        std::mutex mutex;
+        std::condition_variable_any wakeup;
+        std::jthread worker;
+    };
+
+} // namespace hft
@@ -0,0 +1,503 @@
+#include "EventArchive.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace hft
+{
+
+    namespace
+    {
+        constexpr char ARCHIVE_MAGIC[8] = { 'H', 'F', 'T', 'A', 'R', 'C', 'H', '1' };
+
+        // Record tag bits
+        constexpr uint8_t TAG_BOOK_EVENT = 0x01;
+        constexpr uint8_t TAG_SELL = 0x02;
+        constexpr uint8_t TAG_RAW_PRICE = 0x04;
+
+        // Tag, time, sequence, price and two varints: a book event at its smallest
+        constexpr size_t MIN_RECORD_BYTES = 6;
+
+        struct ArchiveHeader
+        {
+            char magic[8];
+            double tickSize;
+        };
+
+        struct ArchiveTrailer
+        {
+            uint64_t indexOffset;
+            uint64_t blockCount;
+            char magic[8];
+        };
+
+        static_assert(sizeof(ArchiveHeader) == 16);
+        static_assert(sizeof(ArchiveTrailer) == 24);
+
+        // Beyond 2^53 ticks the tick grid is no longer exact
+        constexpr double MAX_TICKS = 9007199254740992.0;
+
+        [[nodiscard]] int64_t toNanoseconds(Timestamp time) noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        }
+
+        [[nodiscard]] Timestamp fromNanoseconds(int64_t ns) noexcept
+        {
+            return Timestamp{} + std::chrono::duration_cast<Timestamp::duration>(std::chrono::nanoseconds(ns));
+        }
+
+        [[nodiscard]] uint64_t zigzag(int64_t value) noexcept
+        {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+
+        [[nodiscard]] int64_t unzigzag(uint64_t value) noexcept
+        {
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        void putVarint(std::vector<uint8_t>& out, uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<uint8_t>(value) | 0x80);
+                value >>= 7;
+            }
+
+            out.push_back(static_cast<uint8_t>(value));
+        }
+
+        void putDelta(std::vector<uint8_t>& out, uint64_t value, uint64_t& base)
+        {
+            putVarint(out, zigzag(static_cast<int64_t>(value - base)));
+            base = value;
+        }
+
+        // Price in ticks when it sits exactly on the grid
+        [[nodiscard]] bool toTicks(double price, double tickSize, int64_t& ticks) noexcept
+        {
+            const double scaled = std::round(price / tickSize);
+            if (!(std::fabs(scaled) < MAX_TICKS))
+                return false;
+
+            ticks = static_cast<int64_t>(scaled);
+            return static_cast<double>(ticks) * tickSize == price;
+        }
+
+        // Bounds-checked cursor over one block
+        class BlockCursor
+        {
+        public:
+
+            BlockCursor(const uint8_t* begin, const uint8_t* end_, const std::string& path_)
+                : at(begin),
+                end(end_),
+                path(path_)
+            {
+            }
+
+            [[nodiscard]] uint8_t byte()
+            {
+                if (at == end)
+                    corrupt();
+
+                return *at++;
+            }
+
+            [[nodiscard]] uint64_t varint()
+            {
+                uint64_t value = 0;
+
+                for (int shift = 0; shift < 64; shift += 7)
+                {
+                    const uint8_t next = byte();
+                    value |= static_cast<uint64_t>(next & 0x7F) << shift;
+
+                    if ((next & 0x80) == 0)
+                        return value;
+                }
+
+                corrupt();
+            }
+
+            [[nodiscard]] uint64_t delta(uint64_t& base)
+            {
+                base += static_cast<uint64_t>(unzigzag(varint()));
+                return base;
+            }
+
+            [[nodiscard]] double price(uint8_t tag, double tickSize, int64_t& ticks)
+            {
+                if (tag & TAG_RAW_PRICE)
+                {
+                    if (end - at < 8)
+                        corrupt();
+
+                    uint64_t bits;
+                    std::memcpy(&bits, at, sizeof(bits));
+                    at += sizeof(bits);
+                    return std::bit_cast<double>(bits);
+                }
+
+                ticks += unzigzag(varint());
+                return static_cast<double>(ticks) * tickSize;
+            }
+
+            [[nodiscard]] bool done() const noexcept
+            {
+                return at == end;
+            }
+
+            [[noreturn]] void corrupt() const
+            {
+                throw std::runtime_error("ArchiveReader: corrupt block in " + path);
+            }
+
+        private:
+            const uint8_t* at;
+            const uint8_t* end;
+            const std::string& path;
+        };
+    }
+
+    // ============================================================
+    // WRITER
+    // ============================================================
+
+    ArchiveWriter::ArchiveWriter(const std::string& path_, Options options_)
+        : path(path_),
+        options(options_)
+    {
+        if (!(options.tickSize > 0.0) || !std::isfinite(options.tickSize))
+            throw std::invalid_argument("ArchiveWriter: tick size must be positive");
+
+        if (options.blockRecords == 0)
+            throw std::invalid_argument("ArchiveWriter: block size must be positive");
+
+        out.open(path, std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("ArchiveWriter: cannot open " + path);
+
+        ArchiveHeader header{};
+        std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+        header.tickSize = options.tickSize;
+
+        write(&header, sizeof(header));
+    }
+
+    ArchiveWriter::~ArchiveWriter()
+    {
+        try
+        {
+            close();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    void ArchiveWriter::append(const Trade& trade)
+    {
+        int64_t ticks = 0;
+        const bool onGrid = toTicks(trade.price, options.tickSize, ticks);
+
+        beginRecord(onGrid ? 0 : TAG_RAW_PRICE, trade.timestamp, trade.sequence);
+
+        putDelta(block, trade.buyOrderId, bases.buyId);
+        putDelta(block, trade.sellOrderId, bases.sellId);
+
+        if (onGrid)
+        {
+            putVarint(block, zigzag(ticks - bases.tradeTicks));
+            bases.tradeTicks = ticks;
+        }
+        else
+        {
+            const uint64_t bits = std::bit_cast<uint64_t>(trade.price);
+            const auto* raw = reinterpret_cast<const uint8_t*>(&bits);
+            block.insert(block.end(), raw, raw + sizeof(bits));
+        }
+
+        putVarint(block, trade.quantity);
+
+        if (current.records == options.blockRecords)
+            flushBlock();
+    }
+
+    void ArchiveWriter::append(const BookEvent& event)
+    {
+        int64_t ticks = 0;
+        const bool onGrid = toTicks(event.level.price, options.tickSize, ticks);
+
+        uint8_t tag = TAG_BOOK_EVENT;
+        if (event.level.side == Side::Sell)
+            tag |= TAG_SELL;
+        if (!onGrid)
+            tag |= TAG_RAW_PRICE;
+
+        beginRecord(tag, event.timestamp, event.sequence);
+
+        if (onGrid)
+        {
+            putVarint(block, zigzag(ticks - bases.levelTicks));
+            bases.levelTicks = ticks;
+        }
+        else
+        {
+            const uint64_t bits = std::bit_cast<uint64_t>(event.level.price);
+            const auto* raw = reinterpret_cast<const uint8_t*>(&bits);
+            block.insert(block.end(), raw, raw + sizeof(bits));
+        }
+
+        putVarint(block, event.level.volume);
+        putVarint(block, event.level.orderCount);
+
+        if (current.records == options.blockRecords)
+            flushBlock();
+    }
+
+    void ArchiveWriter::append(std::span<const Trade> trades)
+    {
+        for (const Trade& trade : trades)
+            append(trade);
+    }
+
+    void ArchiveWriter::beginRecord(uint8_t tag, Timestamp timestamp, uint64_t sequence)
+    {
+        if (closed)
+            throw std::runtime_error("ArchiveWriter: append after close for " + path);
+
+        const int64_t timeNs = toNanoseconds(timestamp);
+
+        if (current.records == 0)
+        {
+            current.minTimeNs = current.maxTimeNs = timeNs;
+            current.minSequence = current.maxSequence = sequence;
+        }
+        else
+        {
+            current.minTimeNs = std::min(current.minTimeNs, timeNs);
+            current.maxTimeNs = std::max(current.maxTimeNs, timeNs);
+            current.minSequence = std::min(current.minSequence, sequence);
+            current.maxSequence = std::max(current.maxSequence, sequence);
+        }
+
+        ++current.records;
+        ++records;
+
+        block.push_back(tag);
+        putVarint(block, zigzag(timeNs - bases.timeNs));
+        bases.timeNs = timeNs;
+        putDelta(block, sequence, bases.sequence);
+    }
+
+    void ArchiveWriter::flushBlock()
+    {
+        if (current.records == 0)
+            return;
+
+        current.offset = offset;
+        current.bytes = static_cast<uint32_t>(block.size());
+
+        write(block.data(), block.size());
+        index.push_back(current);
+
+        block.clear();
+        current = {};
+        bases = {};
+    }
+
+    void ArchiveWriter::close()
+    {
+        if (closed)
+            return;
+
+        flushBlock();
+        closed = true;
+
+        ArchiveTrailer trailer{};
+        trailer.indexOffset = offset;
+        trailer.blockCount = index.size();
+        std::memcpy(trailer.magic, ARCHIVE_MAGIC, sizeof(trailer.magic));
+
+        write(index.data(), index.size() * sizeof(ArchiveBlockInfo));
+        write(&trailer, sizeof(trailer));
+
+        out.close();
+        if (!out)
+            throw std::runtime_error("ArchiveWriter: close failed for " + path);
+    }
+
+    void ArchiveWriter::write(const void* data, size_t bytes)
+    {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        if (!out)
+            throw std::runtime_error("ArchiveWriter: write failed for " + path);
+
+        offset += bytes;
+    }
+
+    uint64_t ArchiveWriter::recordCount() const noexcept
+    {
+        return records;
+    }
+
+    uint64_t ArchiveWriter::bytesWritten() const noexcept
+    {
+        return offset;
+    }
+
+    // ============================================================
+    // READER
+    // ============================================================
+
+    ArchiveReader::ArchiveReader(const std::string& path_)
+        : file(path_),
+        path(path_)
+    {
+        const std::byte* data = file.data();
+        const size_t size = file.size();
+
+        if (size < sizeof(ArchiveHeader) + sizeof(ArchiveTrailer))
+            throw std::runtime_error("ArchiveReader: truncated file " + path);
+
+        ArchiveHeader header;
+        ArchiveTrailer trailer;
+        std::memcpy(&header, data, sizeof(header));
+        std::memcpy(&trailer, data + size - sizeof(trailer), sizeof(trailer));
+
+        if (std::memcmp(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0
+            || std::memcmp(trailer.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0)
+            throw std::runtime_error("ArchiveReader: bad magic in " + path);
+
+        const size_t indexEnd = size - sizeof(trailer);
+
+        if (trailer.indexOffset < sizeof(header) || trailer.indexOffset > indexEnd
+            || !fitsIn(trailer.blockCount, sizeof(ArchiveBlockInfo), indexEnd - trailer.indexOffset))
+            throw std::runtime_error("ArchiveReader: bad index in " + path);
+
+        tick = header.tickSize;
+
+        // Copied out: the index follows variable-length blocks, unaligned
+        index.resize(trailer.blockCount);
+        if (!index.empty())
+            std::memcpy(index.data(), data + trailer.indexOffset, index.size() * sizeof(ArchiveBlockInfo));
+
+        for (const ArchiveBlockInfo& info : index)
+        {
+            // Subtract on the checked side: a garbled offset must not wrap
+            if (info.offset < sizeof(header) || info.offset > trailer.indexOffset
+                || info.bytes > trailer.indexOffset - info.offset)
+                throw std::runtime_error("ArchiveReader: block out of range in " + path);
+
+            // Checked here so decodeBlock() never reserves for a garbled count
+            if (info.records > info.bytes / MIN_RECORD_BYTES)
+                throw std::runtime_error("ArchiveReader: bad record count in " + path);
+        }
+    }
+
+    double ArchiveReader::tickSize() const noexcept
+    {
+        return tick;
+    }
+
+    size_t ArchiveReader::blockCount() const noexcept
+    {
+        return index.size();
+    }
+
+    const ArchiveBlockInfo& ArchiveReader::blockInfo(size_t block) const noexcept
+    {
+        return index[block];
+    }
+
+    size_t ArchiveReader::findBlockByTime(Timestamp time) const noexcept
+    {
+        const int64_t timeNs = toNanoseconds(time);
+
+        const auto it = std::partition_point(index.begin(), index.end(),
+            [timeNs](const ArchiveBlockInfo& info) { return info.maxTimeNs < timeNs; });
+
+        return static_cast<size_t>(it - index.begin());
+    }
+
+    size_t ArchiveReader::findBlockBySequence(uint64_t sequence) const noexcept
+    {
+        const auto it = std::partition_point(index.begin(), index.end(),
+            [sequence](const ArchiveBlockInfo& info) { return info.maxSequence < sequence; });
+
+        return static_cast<size_t>(it - index.begin());
+    }
+
+    ArchiveBlock ArchiveReader::decodeBlock(size_t block) const
+    {
+        const ArchiveBlockInfo& info = index[block];
+        const auto* begin = reinterpret_cast<const uint8_t*>(file.data() + info.offset);
+
+        BlockCursor cursor(begin, begin + info.bytes, path);
+        ArchiveBlock decoded;
+        decoded.trades.reserve(info.records);   // trade-only archives are the common case
+
+        uint64_t timeNs = 0;
+        uint64_t sequence = 0;
+        uint64_t buyId = 0;
+        uint64_t sellId = 0;
+        int64_t tradeTicks = 0;
+        int64_t levelTicks = 0;
+
+        for (uint32_t i = 0; i < info.records; ++i)
+        {
+            const uint8_t tag = cursor.byte();
+            const Timestamp timestamp = fromNanoseconds(static_cast<int64_t>(cursor.delta(timeNs)));
+            const uint64_t recordSequence = cursor.delta(sequence);
+
+            if (tag & TAG_BOOK_EVENT)
+            {
+                BookEvent& event = decoded.bookEvents.emplace_back();
+                event.timestamp = timestamp;
+                event.sequence = recordSequence;
+                event.level.side = (tag & TAG_SELL) ? Side::Sell : Side::Buy;
+                event.level.price = cursor.price(tag, tick, levelTicks);
+                event.level.volume = cursor.varint();
+                event.level.orderCount = static_cast<size_t>(cursor.varint());
+            }
+            else
+            {
+                Trade& trade = decoded.trades.emplace_back();
+                trade.timestamp = timestamp;
+                trade.sequence = recordSequence;
+                trade.buyOrderId = cursor.delta(buyId);
+                trade.sellOrderId = cursor.delta(sellId);
+                trade.price = cursor.price(tag, tick, tradeTicks);
+                trade.quantity = cursor.varint();
+            }
+        }
+
+        if (!cursor.done())
+            cursor.corrupt();
+
+        return decoded;
+    }
+
+    std::vector<ArchiveBlock> ArchiveReader::decodeBlocks(size_t first, size_t last, ThreadPool& pool) const
+    {
+        last = std::min(last, index.size());
+        if (first >= last)
+            return {};
+
+        std::vector<ArchiveBlock> blocks(last - first);
+
+        pool.parallelFor(blocks.size(), [&](size_t job)
+            {
+                blocks[job] = decodeBlock(first + job);
+            });
+
+        return blocks;
+    }
+
+} // namespace hft
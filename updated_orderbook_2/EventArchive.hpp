@@ -0,0 +1,179 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "OrderBook.hpp"
+#include "ThreadPool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*
+
+    Compressed archive of trades and book events.
+
+    ArchiveWriter streams records into blocks of up to
+    blockRecords entries. Inside a block every field is coded
+    against the previous record:
+
+        - timestamps and sequences as zigzag varint deltas
+        - order IDs as zigzag varint deltas from the last buy
+          and last sell ID
+        - prices as zigzag varint deltas in ticks; a price off
+          the tick grid is stored raw, so decoding is exact
+        - quantities, volumes and order counts as varints
+
+    Bases reset at every block boundary, so any block decodes
+    on its own. close() appends the block index (offset, size,
+    record count, time and sequence range) and a trailer.
+
+    ArchiveReader maps the file, binary-searches the index to
+    seek by time or sequence, and decodes a block range on a
+    ThreadPool into fixed slots: the output never depends on
+    the thread count. Records are expected in time and
+    sequence order, as the engine produces them.
+*/
+
+namespace hft
+{
+
+    // One aggregated level change (see LevelUpdate) with its time and engine sequence
+    struct BookEvent
+    {
+        Timestamp timestamp;
+        uint64_t sequence = 0;
+        LevelUpdate level;
+    };
+
+    // Index entry, stored as is at the end of the file
+    struct ArchiveBlockInfo
+    {
+        uint64_t offset;
+        uint32_t bytes;
+        uint32_t records;
+        int64_t minTimeNs;
+        int64_t maxTimeNs;
+        uint64_t minSequence;
+        uint64_t maxSequence;
+    };
+
+    static_assert(sizeof(ArchiveBlockInfo) == 48);
+    static_assert(std::is_trivially_copyable_v<ArchiveBlockInfo>);
+
+    // Records of one block, each kind in archive order
+    struct ArchiveBlock
+    {
+        std::vector<Trade> trades;
+        std::vector<BookEvent> bookEvents;
+    };
+
+    struct ArchiveOptions
+    {
+        double tickSize = 0.01;
+        uint32_t blockRecords = 4096;
+    };
+
+    // ============================================================
+    // WRITER
+    // ============================================================
+
+    class ArchiveWriter
+    {
+    public:
+
+        using Options = ArchiveOptions;
+
+        // Throws std::runtime_error if the file cannot be created,
+        // std::invalid_argument for a bad tick size or block size
+        explicit ArchiveWriter(const std::string& path, Options options = {});
+
+        // Closes; I/O errors are lost here, call close() to see them
+        ~ArchiveWriter();
+
+        ArchiveWriter(const ArchiveWriter&) = delete;
+        ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+        // Throw std::runtime_error if a full block cannot be written
+        void append(const Trade& trade);
+        void append(const BookEvent& event);
+        void append(std::span<const Trade> trades);
+
+        // Writes the open block, the index and the trailer.
+        // Throws std::runtime_error on I/O failure.
+        void close();
+
+        [[nodiscard]] uint64_t recordCount() const noexcept;
+
+        // File bytes so far, excluding the open block
+        [[nodiscard]] uint64_t bytesWritten() const noexcept;
+
+    private:
+
+        // Previous values each field is coded against
+        struct Bases
+        {
+            int64_t timeNs = 0;
+            uint64_t sequence = 0;
+            uint64_t buyId = 0;
+            uint64_t sellId = 0;
+            int64_t tradeTicks = 0;
+            int64_t levelTicks = 0;
+        };
+
+        std::ofstream out;
+        std::string path;
+        Options options;
+
+        std::vector<uint8_t> block;
+        ArchiveBlockInfo current{};
+        Bases bases;
+
+        std::vector<ArchiveBlockInfo> index;
+        uint64_t offset = 0;
+        uint64_t records = 0;
+        bool closed = false;
+
+        void beginRecord(uint8_t tag, Timestamp timestamp, uint64_t sequence);
+        void flushBlock();
+        void write(const void* data, size_t bytes);
+    };
+
+    // ============================================================
+    // READER
+    // ============================================================
+
+    class ArchiveReader
+    {
+    public:
+
+        // Maps and validates the file; throws std::runtime_error
+        explicit ArchiveReader(const std::string& path);
+
+        [[nodiscard]] double tickSize() const noexcept;
+        [[nodiscard]] size_t blockCount() const noexcept;
+        [[nodiscard]] const ArchiveBlockInfo& blockInfo(size_t block) const noexcept;
+
+        // First block holding records at or after the given time or
+        // sequence; blockCount() if there is none
+        [[nodiscard]] size_t findBlockByTime(Timestamp time) const noexcept;
+        [[nodiscard]] size_t findBlockBySequence(uint64_t sequence) const noexcept;
+
+        // Throws std::runtime_error if the block is corrupt
+        [[nodiscard]] ArchiveBlock decodeBlock(size_t block) const;
+
+        // Blocks [first, last), one pool job each, in block order
+        [[nodiscard]] std::vector<ArchiveBlock> decodeBlocks(size_t first, size_t last, ThreadPool& pool) const;
+
+    private:
+
+        MappedFile file;
+        std::string path;
+        double tick = 0.0;
+        std::vector<ArchiveBlockInfo> index;
+    };
+
+} // namespace hft
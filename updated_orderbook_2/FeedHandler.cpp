@@ -0,0 +1,402 @@
+#include "FeedHandler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace hft
+{
+
+    namespace
+    {
+        constexpr char CAPTURE_MAGIC[8] = { 'H', 'F', 'T', 'L', '3', 'F', 'D', '1' };
+
+        Timestamp feedTime(const FeedMessage& message) noexcept
+        {
+            return Timestamp{} + std::chrono::nanoseconds(message.timestampNs);
+        }
+    }
+
+    // ============================================================
+    // CAPTURE FILES
+    // ============================================================
+
+    void writeFeedCapture(const std::string& path, std::span<const FeedMessage> messages)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("writeFeedCapture: cannot open " + path);
+
+        FeedCaptureHeader header{};
+        std::memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+        header.messageCount = messages.size();
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(messages.data()),
+            static_cast<std::streamsize>(messages.size_bytes()));
+
+        if (!out)
+            throw std::runtime_error("writeFeedCapture: write failed for " + path);
+    }
+
+    FeedCapture::FeedCapture(const std::string& path)
+        : file(path)
+    {
+        if (file.size() < sizeof(FeedCaptureHeader))
+            throw std::runtime_error("FeedCapture: truncated header in " + path);
+
+        const auto* header = reinterpret_cast<const FeedCaptureHeader*>(file.data());
+
+        if (std::memcmp(header->magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0)
+            throw std::runtime_error("FeedCapture: bad magic in " + path);
+
+        if (!fitsIn(header->messageCount, sizeof(FeedMessage), file.size() - sizeof(FeedCaptureHeader)))
+            throw std::runtime_error("FeedCapture: size mismatch in " + path);
+
+        records = { reinterpret_cast<const FeedMessage*>(file.data() + sizeof(FeedCaptureHeader)),
+            header->messageCount };
+    }
+
+    std::span<const FeedMessage> FeedCapture::messages() const noexcept
+    {
+        return records;
+    }
+
+    // ============================================================
+    // STATS
+    // ============================================================
+
+    FeedStats& FeedStats::operator+=(const FeedStats& other) noexcept
+    {
+        messages += other.messages;
+        applied += other.applied;
+        dropped += other.dropped;
+        rejected += other.rejected;
+        gaps += other.gaps;
+        snapshots += other.snapshots;
+        return *this;
+    }
+
+    // ============================================================
+    // HANDLER
+    // ============================================================
+
+    FeedHandler::FeedHandler(Options options_)
+        : options(options_)
+    {
+        if (options.shards == 0 || options.batchMessages == 0 || options.sliceMessages == 0)
+            throw std::invalid_argument("FeedHandler: shard, batch and slice sizes must be positive");
+
+        // Routed indices are 32-bit offsets into one batch
+        if (options.batchMessages > std::numeric_limits<uint32_t>::max())
+            throw std::invalid_argument("FeedHandler: batch too large");
+
+        shards.reserve(options.shards);
+        for (size_t i = 0; i < options.shards; ++i)
+            shards.push_back(std::make_unique<Shard>());
+    }
+
+    FeedHandler::~FeedHandler() = default;
+
+    void FeedHandler::setGapHandler(GapHandler handler)
+    {
+        gapHandler = std::move(handler);
+    }
+
+    void FeedHandler::apply(const FeedMessage& message)
+    {
+        Shard& shard = shardFor(message.symbol);
+        receive(shard, message.symbol, shard.symbols[message.symbol], message, options);
+
+        if (!shard.gaps.empty())
+            reportGaps();
+    }
+
+    void FeedHandler::process(std::span<const FeedMessage> messages)
+    {
+        for (const FeedMessage& message : messages)
+            apply(message);
+    }
+
+    void FeedHandler::process(std::span<const FeedMessage> messages, ThreadPool& pool)
+    {
+        for (size_t begin = 0; begin < messages.size(); begin += options.batchMessages)
+        {
+            const size_t count = std::min(options.batchMessages, messages.size() - begin);
+            applyBatch(messages.subspan(begin, count), pool);
+            reportGaps();
+        }
+    }
+
+    void FeedHandler::applyBatch(std::span<const FeedMessage> batch, ThreadPool& pool)
+    {
+        /*
+            Routing is a counting sort per slice: count messages per
+            shard, turn counts into offsets, then scatter indices.
+            Slices are routed in parallel into disjoint ranges of
+            `routed`; shards then read their ranges slice by slice,
+            which keeps every symbol in capture order.
+        */
+
+        const size_t shardCount = shards.size();
+        const size_t slices = (batch.size() + options.sliceMessages - 1) / options.sliceMessages;
+
+        routed.resize(batch.size());
+        routeOffsets.assign(slices * (shardCount + 1), 0);
+
+        pool.parallelFor(slices, [&](size_t slice)
+            {
+                const size_t begin = slice * options.sliceMessages;
+                const size_t end = std::min(begin + options.sliceMessages, batch.size());
+                size_t* offsets = routeOffsets.data() + slice * (shardCount + 1);
+
+                for (size_t i = begin; i < end; ++i)
+                    ++offsets[batch[i].symbol % shardCount + 1];
+
+                offsets[0] = begin;
+                for (size_t s = 0; s < shardCount; ++s)
+                    offsets[s + 1] += offsets[s];
+
+                std::vector<size_t> cursor(offsets, offsets + shardCount);
+
+                for (size_t i = begin; i < end; ++i)
+                    routed[cursor[batch[i].symbol % shardCount]++] = static_cast<uint32_t>(i);
+            });
+
+        pool.parallelFor(shardCount, [&](size_t s)
+            {
+                Shard& shard = *shards[s];
+
+                // Feeds cluster by symbol; element references survive rehashing
+                uint32_t lastSymbol = 0;
+                SymbolBook* last = nullptr;
+
+                for (size_t slice = 0; slice < slices; ++slice)
+                {
+                    const size_t* offsets = routeOffsets.data() + slice * (shardCount + 1);
+
+                    for (size_t k = offsets[s]; k < offsets[s + 1]; ++k)
+                    {
+                        const FeedMessage& message = batch[routed[k]];
+
+                        if (!last || message.symbol != lastSymbol)
+                        {
+                            lastSymbol = message.symbol;
+                            last = &shard.symbols[message.symbol];
+                        }
+
+                        receive(shard, message.symbol, *last, message, options);
+                    }
+                }
+            });
+    }
+
+    void FeedHandler::applySnapshot(uint32_t symbol, uint64_t sequence, std::span<const FeedMessage> orders)
+    {
+        Shard& shard = shardFor(symbol);
+        SymbolBook& state = shard.symbols[symbol];
+
+        beginSnapshot(state, sequence);
+
+        for (const FeedMessage& order : orders)
+            update(shard, state, order);
+
+        endSnapshot(shard, symbol, state, options);
+
+        if (!shard.gaps.empty())
+            reportGaps();
+    }
+
+    void FeedHandler::reportGaps()
+    {
+        for (const auto& shard : shards)
+        {
+            for (const FeedGap& gap : shard->gaps)
+            {
+                if (gapHandler)
+                    gapHandler(gap);
+            }
+
+            shard->gaps.clear();
+        }
+    }
+
+    // ============================================================
+    // PER-SYMBOL STATE MACHINE
+    // ============================================================
+
+    void FeedHandler::receive(Shard& shard, uint32_t symbol, SymbolBook& state, const FeedMessage& message, const Options& options)
+    {
+        ++shard.stats.messages;
+
+        switch (message.action)
+        {
+        case FeedAction::SnapshotBegin:
+            // Live books ignore snapshots; new and gapped ones take them
+            if (state.recovering || state.nextSequence == 1)
+                beginSnapshot(state, message.sequence);
+            else
+                ++shard.stats.dropped;
+            return;
+
+        case FeedAction::SnapshotOrder:
+            if (state.snapshotting)
+                update(shard, state, message);
+            else
+                ++shard.stats.dropped;
+            return;
+
+        case FeedAction::SnapshotEnd:
+            if (state.snapshotting)
+                endSnapshot(shard, symbol, state, options);
+            else
+                ++shard.stats.dropped;
+            return;
+
+        default:
+            sequenced(shard, symbol, state, message, options);
+            return;
+        }
+    }
+
+    void FeedHandler::sequenced(Shard& shard, uint32_t symbol, SymbolBook& state, const FeedMessage& message, const Options& options)
+    {
+        if (state.recovering)
+        {
+            if (state.held.size() < options.maxHeldMessages)
+                state.held.push_back(message);
+            else
+                ++shard.stats.dropped;
+
+            return;
+        }
+
+        if (message.sequence < state.nextSequence)
+        {
+            ++shard.stats.dropped;
+            return;
+        }
+
+        if (message.sequence > state.nextSequence)
+        {
+            // The book can no longer be trusted: drop it and wait for a snapshot
+            ++shard.stats.gaps;
+            shard.gaps.push_back({ symbol, state.nextSequence, message.sequence });
+
+            state.book.clear();
+            state.recovering = true;
+            state.held.assign(1, message);
+            return;
+        }
+
+        ++state.nextSequence;
+        update(shard, state, message);
+    }
+
+    void FeedHandler::update(Shard& shard, SymbolBook& state, const FeedMessage& message)
+    {
+        OrderBook& book = state.book;
+        book.setSimulatedTime(feedTime(message));
+
+        bool applied = false;
+
+        switch (message.action)
+        {
+        case FeedAction::Add:
+        case FeedAction::SnapshotOrder:
+            applied = book.restOrder(Order(message.orderId, message.side, OrderType::Limit,
+                message.price, message.quantity, feedTime(message)));
+            break;
+        case FeedAction::Modify:
+            applied = book.modifyOrder(message.orderId, message.price, message.quantity);
+            break;
+        case FeedAction::Delete:
+            applied = book.cancelOrder(message.orderId);
+            break;
+        case FeedAction::Execute:
+            applied = book.executeOrder(message.orderId, message.quantity);
+            break;
+        default:
+            break;
+        }
+
+        if (applied)
+            ++shard.stats.applied;
+        else
+            ++shard.stats.rejected;
+    }
+
+    void FeedHandler::beginSnapshot(SymbolBook& state, uint64_t sequence)
+    {
+        // Held messages stay: the ones newer than the snapshot replay after it
+        state.book.clear();
+        state.recovering = true;
+        state.snapshotting = true;
+        state.snapshotSequence = sequence;
+    }
+
+    void FeedHandler::endSnapshot(Shard& shard, uint32_t symbol, SymbolBook& state, const Options& options)
+    {
+        state.snapshotting = false;
+        state.recovering = false;
+        state.nextSequence = state.snapshotSequence + 1;
+        ++shard.stats.snapshots;
+
+        // Replay may gap again, refilling `held`
+        std::vector<FeedMessage> held;
+        held.swap(state.held);
+
+        for (const FeedMessage& message : held)
+            sequenced(shard, symbol, state, message, options);
+    }
+
+    // ============================================================
+    // QUERIES
+    // ============================================================
+
+    FeedHandler::Shard& FeedHandler::shardFor(uint32_t symbol) noexcept
+    {
+        return *shards[symbol % shards.size()];
+    }
+
+    const FeedHandler::Shard& FeedHandler::shardFor(uint32_t symbol) const noexcept
+    {
+        return *shards[symbol % shards.size()];
+    }
+
+    const OrderBook* FeedHandler::book(uint32_t symbol) const noexcept
+    {
+        const Shard& shard = shardFor(symbol);
+        const auto it = shard.symbols.find(symbol);
+        return (it == shard.symbols.end()) ? nullptr : &it->second.book;
+    }
+
+    bool FeedHandler::recovering(uint32_t symbol) const noexcept
+    {
+        const Shard& shard = shardFor(symbol);
+        const auto it = shard.symbols.find(symbol);
+        return it != shard.symbols.end() && it->second.recovering;
+    }
+
+    FeedStats FeedHandler::stats() const noexcept
+    {
+        FeedStats total;
+        for (const auto& shard : shards)
+            total += shard->stats;
+
+        return total;
+    }
+
+    size_t FeedHandler::symbolCount() const noexcept
+    {
+        size_t count = 0;
+        for (const auto& shard : shards)
+            count += shard->symbols.size();
+
+        return count;
+    }
+
+} // namespace hft
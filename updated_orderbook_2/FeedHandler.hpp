@@ -0,0 +1,213 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "OrderBook.hpp"
+#include "ThreadPool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/*
+
+    Market-by-order (L3) feed handler.
+
+    Mirrors another venue's books from its order-level feed:
+    every add, modify, delete and execute is applied to a
+    per-symbol OrderBook through its feed-mirror calls, so
+    nothing is matched locally and queue positions follow the
+    venue's.
+
+    Each symbol carries its own sequence. A message past the
+    expected one is a gap: the book is cleared, the gap is
+    reported, and later messages are held until a snapshot
+    (in the stream, or passed to applySnapshot()) rebuilds the
+    book. Held messages newer than the snapshot are then
+    replayed; older ones and duplicates are dropped.
+
+    process() decodes a capture in batches. One pass over the
+    batch routes message indices to shards (symbol % shards)
+    in parallel slices; then every shard applies its own
+    messages, slice by slice, on a ThreadPool. A shard owns its
+    symbols outright, so per-symbol order is the capture's
+    order and no locks are taken. Results do not depend on the
+    thread count.
+*/
+
+namespace hft
+{
+
+    // ============================================================
+    // CAPTURE FORMAT
+    // ============================================================
+
+    enum class FeedAction : uint8_t
+    {
+        Add,
+        Modify,          // new price and remaining quantity
+        Delete,
+        Execute,         // quantity filled
+        SnapshotBegin,   // sequence: last message the snapshot includes
+        SnapshotOrder,   // one resting order, in queue order
+        SnapshotEnd
+    };
+
+    // Fixed 48-byte record, little-endian, read in place from the map
+    struct FeedMessage
+    {
+        uint64_t timestampNs;   // nanoseconds since session start
+        uint64_t sequence;      // per symbol, from 1
+        uint64_t orderId;
+        double price;
+        uint64_t quantity;
+        uint32_t symbol;
+        FeedAction action;
+        Side side;
+        uint8_t reserved[2];
+    };
+
+    static_assert(sizeof(FeedMessage) == 48);
+    static_assert(std::is_trivially_copyable_v<FeedMessage>);
+
+    struct FeedCaptureHeader
+    {
+        char magic[8];
+        uint64_t messageCount;
+    };
+
+    static_assert(sizeof(FeedCaptureHeader) == 16);
+
+    // Throws std::runtime_error on I/O failure
+    void writeFeedCapture(const std::string& path, std::span<const FeedMessage> messages);
+
+    class FeedCapture
+    {
+    public:
+
+        // Maps and validates the file; throws std::runtime_error
+        explicit FeedCapture(const std::string& path);
+
+        [[nodiscard]] std::span<const FeedMessage> messages() const noexcept;
+
+    private:
+        MappedFile file;
+        std::span<const FeedMessage> records;
+    };
+
+    // ============================================================
+    // HANDLER
+    // ============================================================
+
+    struct FeedGap
+    {
+        uint32_t symbol;
+        uint64_t expected;
+        uint64_t received;
+    };
+
+    struct FeedStats
+    {
+        uint64_t messages = 0;
+        uint64_t applied = 0;
+        uint64_t dropped = 0;    // duplicates, pre-snapshot or overflowed holds
+        uint64_t rejected = 0;   // unknown or duplicate order ids, bad prices
+        uint64_t gaps = 0;
+        uint64_t snapshots = 0;
+
+        FeedStats& operator+=(const FeedStats& other) noexcept;
+        bool operator==(const FeedStats&) const = default;
+    };
+
+    struct FeedHandlerOptions
+    {
+        size_t shards = 256;
+        size_t batchMessages = 1 << 18;
+        size_t sliceMessages = 1 << 14;
+        size_t maxHeldMessages = 1 << 16;   // per symbol while recovering
+    };
+
+    class FeedHandler
+    {
+    public:
+
+        using Options = FeedHandlerOptions;
+
+        // Called on the calling thread, once per gap, to request a snapshot
+        using GapHandler = std::function<void(const FeedGap&)>;
+
+        // Throws std::invalid_argument for zero shard, batch or slice sizes
+        explicit FeedHandler(Options options = {});
+        ~FeedHandler();
+
+        FeedHandler(const FeedHandler&) = delete;
+        FeedHandler& operator=(const FeedHandler&) = delete;
+
+        void setGapHandler(GapHandler handler);
+
+        // One message, in arrival order
+        void apply(const FeedMessage& message);
+
+        // A whole capture; sequential, or sharded over the pool
+        void process(std::span<const FeedMessage> messages);
+        void process(std::span<const FeedMessage> messages, ThreadPool& pool);
+
+        // Out-of-band snapshot as of `sequence`: SnapshotOrder records
+        // only, in queue order. Replaces the book and ends recovery.
+        void applySnapshot(uint32_t symbol, uint64_t sequence, std::span<const FeedMessage> orders);
+
+        // Null for a symbol never seen
+        [[nodiscard]] const OrderBook* book(uint32_t symbol) const noexcept;
+
+        // Waiting for a snapshot; unknown symbols are not
+        [[nodiscard]] bool recovering(uint32_t symbol) const noexcept;
+
+        [[nodiscard]] FeedStats stats() const noexcept;
+        [[nodiscard]] size_t symbolCount() const noexcept;
+
+    private:
+
+        struct SymbolBook
+        {
+            OrderBook book;
+            uint64_t nextSequence = 1;
+            bool recovering = false;
+            bool snapshotting = false;
+            uint64_t snapshotSequence = 0;
+            std::vector<FeedMessage> held;
+        };
+
+        struct Shard
+        {
+            std::unordered_map<uint32_t, SymbolBook> symbols;
+            std::vector<FeedGap> gaps;
+            FeedStats stats;
+        };
+
+        Options options;
+        std::vector<std::unique_ptr<Shard>> shards;
+        GapHandler gapHandler;
+
+        // Routing scratch: per slice, message indices grouped by shard
+        std::vector<uint32_t> routed;
+        std::vector<size_t> routeOffsets;
+
+        [[nodiscard]] Shard& shardFor(uint32_t symbol) noexcept;
+        [[nodiscard]] const Shard& shardFor(uint32_t symbol) const noexcept;
+
+        void applyBatch(std::span<const FeedMessage> batch, ThreadPool& pool);
+        void reportGaps();
+
+        static void receive(Shard& shard, uint32_t symbol, SymbolBook& state, const FeedMessage& message, const Options& options);
+        static void sequenced(Shard& shard, uint32_t symbol, SymbolBook& state, const FeedMessage& message, const Options& options);
+        static void update(Shard& shard, SymbolBook& state, const FeedMessage& message);
+        static void beginSnapshot(SymbolBook& state, uint64_t sequence);
+        static void endSnapshot(Shard& shard, uint32_t symbol, SymbolBook& state, const Options& options);
+    };
+
+} // namespace hft
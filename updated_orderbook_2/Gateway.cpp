@@ -0,0 +1,610 @@
+#include "Gateway.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace hft
+{
+
+    namespace
+    {
+        // epoll tokens; connection ids start at 1
+        constexpr uint64_t LISTEN_TOKEN = 0;
+        constexpr uint64_t WAKE_TOKEN = UINT64_MAX;
+
+        constexpr int MAX_EVENTS = 64;
+
+        [[noreturn]] void throwSystemError(const char* what)
+        {
+            throw std::runtime_error(std::string("Gateway: ") + what + ": " + std::strerror(errno));
+        }
+
+        void watch(int epollFd, int op, int fd, uint32_t events, uint64_t token)
+        {
+            epoll_event event{};
+            event.events = events;
+            event.data.u64 = token;
+
+            if (epoll_ctl(epollFd, op, fd, &event) != 0)
+                throwSystemError("epoll_ctl");
+        }
+
+        [[nodiscard]] bool validSide(Side side) noexcept
+        {
+            return side == Side::Buy || side == Side::Sell;
+        }
+
+        [[nodiscard]] bool validType(OrderType type) noexcept
+        {
+            return type == OrderType::Market || type == OrderType::Limit;
+        }
+    }
+
+    // ============================================================
+    // SETUP
+    // ============================================================
+
+    Gateway::Gateway(MatchingEngine& engine_, uint16_t port)
+        : engine(engine_),
+        tradeCursor(engine_.getTrades().size())
+    {
+        listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0)
+            throwSystemError("socket");
+
+        const int enable = 1;
+        ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+
+        if (::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+            throwSystemError("bind");
+
+        if (::listen(listenFd, SOMAXCONN) != 0)
+            throwSystemError("listen");
+
+        socklen_t length = sizeof(address);
+        ::getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+        boundPort = ntohs(address.sin_port);
+
+        epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0)
+            throwSystemError("epoll_create1");
+
+        wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeFd < 0)
+            throwSystemError("eventfd");
+
+        watch(epollFd, EPOLL_CTL_ADD, listenFd, EPOLLIN, LISTEN_TOKEN);
+        watch(epollFd, EPOLL_CTL_ADD, wakeFd, EPOLLIN, WAKE_TOKEN);
+    }
+
+    Gateway::~Gateway()
+    {
+        for (auto& [id, connection] : connections)
+            ::close(connection.fd);
+
+        if (wakeFd >= 0)
+            ::close(wakeFd);
+        if (epollFd >= 0)
+            ::close(epollFd);
+        if (listenFd >= 0)
+            ::close(listenFd);
+    }
+
+    uint16_t Gateway::port() const noexcept
+    {
+        return boundPort;
+    }
+
+    size_t Gateway::connectionCount() const noexcept
+    {
+        return connections.size();
+    }
+
+    size_t Gateway::pausedConnections() const noexcept
+    {
+        return pausedCount.load(std::memory_order_relaxed);
+    }
+
+    // ============================================================
+    // EVENT LOOP
+    // ============================================================
+
+    void Gateway::run()
+    {
+        while (pollOnce(-1))
+        {
+        }
+    }
+
+    void Gateway::stop() noexcept
+    {
+        stopping.store(true, std::memory_order_release);
+
+        const uint64_t one = 1;
+        (void)!::write(wakeFd, &one, sizeof(one));
+    }
+
+    bool Gateway::pollOnce(int timeoutMs)
+    {
+        epoll_event events[MAX_EVENTS];
+        const int count = ::epoll_wait(epollFd, events, MAX_EVENTS, timeoutMs);
+
+        if (count < 0 && errno != EINTR)
+            throwSystemError("epoll_wait");
+
+        for (int i = 0; i < count; ++i)
+        {
+            const uint64_t token = events[i].data.u64;
+            const uint32_t flags = events[i].events;
+
+            if (token == LISTEN_TOKEN)
+            {
+                acceptConnections();
+                continue;
+            }
+
+            if (token == WAKE_TOKEN)
+            {
+                uint64_t drained = 0;
+                (void)!::read(wakeFd, &drained, sizeof(drained));
+                continue;
+            }
+
+            auto it = connections.find(token);
+            if (it == connections.end())
+                continue;
+
+            // A paused connection is not read, so errors end it here
+            if (it->second.readPaused && (flags & (EPOLLHUP | EPOLLERR)))
+            {
+                closeConnection(token);
+                continue;
+            }
+
+            if ((flags & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !it->second.readPaused)
+            {
+                onReadable(token, it->second);
+
+                it = connections.find(token);
+                if (it == connections.end())
+                    continue;
+            }
+
+            if (flags & EPOLLOUT)
+                (void)flush(token, it->second);
+        }
+
+        // One send() per connection per round
+        for (const uint64_t connectionId : flushList)
+        {
+            const auto it = connections.find(connectionId);
+            if (it != connections.end() && it->second.pendingFlush && !it->second.wantsWrite)
+                (void)flush(connectionId, it->second);
+        }
+
+        flushList.clear();
+
+        return !stopping.load(std::memory_order_acquire);
+    }
+
+    void Gateway::acceptConnections()
+    {
+        for (;;)
+        {
+            const int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                // EAGAIN: backlog drained; anything else: try next round
+                return;
+            }
+
+            const int enable = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+            // Owner 0 is the engine's "no owner"
+            if (++nextOwner == 0)
+                ++nextOwner;
+
+            const uint64_t connectionId = nextConnectionId++;
+            Connection& connection = connections[connectionId];
+            connection.fd = fd;
+            connection.owner = nextOwner;
+            connection.input.resize(RECEIVE_BUFFER_SIZE);
+
+            watch(epollFd, EPOLL_CTL_ADD, fd, EPOLLIN, connectionId);
+        }
+    }
+
+    void Gateway::closeConnection(uint64_t connectionId)
+    {
+        const auto it = connections.find(connectionId);
+        if (it == connections.end())
+            return;
+
+        const uint32_t owner = it->second.owner;
+        if (it->second.readPaused)
+            pausedCount.fetch_sub(1, std::memory_order_relaxed);
+
+        ::epoll_ctl(epollFd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+        ::close(it->second.fd);
+        connections.erase(it);
+
+        // Cancel-on-disconnect: nobody is left to cancel these
+        (void)engine.cancelOwner(owner);
+        std::erase_if(owners, [connectionId](const auto& entry) { return entry.second.connectionId == connectionId; });
+    }
+
+    void Gateway::updateInterest(uint64_t connectionId, const Connection& connection)
+    {
+        const uint32_t events = (connection.readPaused ? 0u : uint32_t{ EPOLLIN })
+            | (connection.wantsWrite ? uint32_t{ EPOLLOUT } : 0u);
+
+        watch(epollFd, EPOLL_CTL_MOD, connection.fd, events, connectionId);
+    }
+
+    void Gateway::pauseReads(uint64_t connectionId, Connection& connection)
+    {
+        connection.readPaused = true;
+        pausedCount.fetch_add(1, std::memory_order_relaxed);
+
+        // Flushed here so EPOLLOUT is armed for the backlog
+        if (!connection.wantsWrite)
+            (void)flush(connectionId, connection);
+        else
+            updateInterest(connectionId, connection);
+    }
+
+    // ============================================================
+    // RECEIVE AND DECODE
+    // ============================================================
+
+    void Gateway::onReadable(uint64_t connectionId, Connection& connection)
+    {
+        // Level-triggered: what is left over is read next round
+        for (size_t readThisRound = 0; readThisRound < MAX_READ_PER_ROUND;)
+        {
+            if (connection.pendingOutput() >= MAX_PENDING_OUTPUT)
+            {
+                pauseReads(connectionId, connection);
+                return;
+            }
+
+            std::byte* writeAt = connection.input.data() + connection.inputUsed;
+            const size_t space = connection.input.size() - connection.inputUsed;
+
+            const ssize_t received = ::recv(connection.fd, writeAt, space, 0);
+
+            if (received == 0)
+            {
+                closeConnection(connectionId);
+                return;
+            }
+
+            if (received < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    closeConnection(connectionId);
+                return;
+            }
+
+            connection.inputUsed += static_cast<size_t>(received);
+            readThisRound += static_cast<size_t>(received);
+
+            bool ok = true;
+            const size_t consumed = decode(connectionId, connection, ok);
+
+            if (!ok)
+            {
+                closeConnection(connectionId);
+                return;
+            }
+
+            // Keep only the partial tail (< one message)
+            const size_t tail = connection.inputUsed - consumed;
+            if (tail > 0 && consumed > 0)
+                std::memmove(connection.input.data(), connection.input.data() + consumed, tail);
+
+            connection.inputUsed = tail;
+        }
+    }
+
+    size_t Gateway::decode(uint64_t connectionId, Connection& connection, bool& ok)
+    {
+        const std::byte* data = connection.input.data();
+        const size_t available = connection.inputUsed;
+        size_t offset = 0;
+
+        while (available - offset >= sizeof(wire::MessageHeader))
+        {
+            const auto& header = wire::messageAt<wire::MessageHeader>(data + offset);
+            const size_t expected = wire::messageSize(header.type);
+
+            if (expected == 0 || header.length != expected)
+            {
+                ok = false;
+                return offset;
+            }
+
+            if (available - offset < expected)
+                break;
+
+            const std::byte* message = data + offset;
+
+            switch (header.type)
+            {
+            case wire::MessageType::NewOrder:
+            {
+                const auto& newOrder = wire::messageAt<wire::NewOrder>(message);
+                if (!validSide(newOrder.side) || !validType(newOrder.orderType))
+                {
+                    ok = false;
+                    return offset;
+                }
+
+                onNewOrder(connectionId, connection, newOrder);
+                break;
+            }
+            case wire::MessageType::CancelOrder:
+                onCancel(connectionId, connection, wire::messageAt<wire::CancelOrder>(message));
+                break;
+            case wire::MessageType::ReplaceOrder:
+                onReplace(connectionId, connection, wire::messageAt<wire::ReplaceOrder>(message));
+                break;
+            default:
+                // Gateway-to-client types are not valid input
+                ok = false;
+                return offset;
+            }
+
+            offset += expected;
+        }
+
+        return offset;
+    }
+
+    // ============================================================
+    // ORDER HANDLING
+    // ============================================================
+
+    void Gateway::onNewOrder(uint64_t connectionId, Connection& connection, const wire::NewOrder& message)
+    {
+        const uint64_t orderId = engine.submitOrder(message.side,
+            message.orderType,
+            message.price,
+            message.quantity,
+            connection.owner);
+
+        if (orderId == 0)
+        {
+            send(connectionId, connection, wire::OrderReject{
+                wire::headerFor<wire::OrderReject>(wire::MessageType::OrderReject),
+                message.clientOrderId,
+                engine.getLastRejectReason(),
+                {} });
+            return;
+        }
+
+        owners.emplace(orderId, OrderOwner{ connectionId, message.clientOrderId, message.quantity, message.side });
+
+        send(connectionId, connection, wire::OrderAck{
+            wire::headerFor<wire::OrderAck>(wire::MessageType::OrderAck),
+            message.clientOrderId,
+            orderId });
+
+        routeFills();
+
+        // Unfilled market quantity never rests
+        if (message.orderType == OrderType::Market)
+            owners.erase(orderId);
+    }
+
+    void Gateway::onCancel(uint64_t connectionId, Connection& connection, const wire::CancelOrder& message)
+    {
+        // Packed wire field; copy before binding it to a reference
+        const uint64_t orderId = message.orderId;
+
+        const auto it = owners.find(orderId);
+        const bool owned = it != owners.end() && it->second.connectionId == connectionId;
+
+        if (!owned || !engine.cancelOrder(orderId))
+        {
+            send(connectionId, connection, wire::CancelReject{
+                wire::headerFor<wire::CancelReject>(wire::MessageType::CancelReject),
+                message.clientOrderId,
+                message.orderId });
+            return;
+        }
+
+        owners.erase(it);
+
+        send(connectionId, connection, wire::CancelAck{
+            wire::headerFor<wire::CancelAck>(wire::MessageType::CancelAck),
+            message.clientOrderId,
+            message.orderId });
+    }
+
+    void Gateway::onReplace(uint64_t connectionId, Connection& connection, const wire::ReplaceOrder& message)
+    {
+        // Packed wire field; copy before binding it to a reference
+        const uint64_t originalId = message.orderId;
+
+        const auto it = owners.find(originalId);
+        const bool owned = it != owners.end() && it->second.connectionId == connectionId;
+
+        if (!owned || !engine.cancelOrder(originalId))
+        {
+            send(connectionId, connection, wire::CancelReject{
+                wire::headerFor<wire::CancelReject>(wire::MessageType::CancelReject),
+                message.clientOrderId,
+                message.orderId });
+            return;
+        }
+
+        const Side side = it->second.side;
+        owners.erase(it);
+
+        const uint64_t orderId = engine.submitOrder(side, OrderType::Limit, message.price, message.quantity, connection.owner);
+
+        // The original is already cancelled at this point
+        if (orderId == 0)
+        {
+            send(connectionId, connection, wire::OrderReject{
+                wire::headerFor<wire::OrderReject>(wire::MessageType::OrderReject),
+                message.clientOrderId,
+                engine.getLastRejectReason(),
+                {} });
+            return;
+        }
+
+        owners.emplace(orderId, OrderOwner{ connectionId, message.clientOrderId, message.quantity, side });
+
+        send(connectionId, connection, wire::ReplaceAck{
+            wire::headerFor<wire::ReplaceAck>(wire::MessageType::ReplaceAck),
+            message.clientOrderId,
+            message.orderId,
+            orderId });
+
+        routeFills();
+    }
+
+    void Gateway::routeFills()
+    {
+        const auto& trades = engine.getTrades();
+
+        // Engine was reset underneath us
+        if (tradeCursor > trades.size())
+            tradeCursor = trades.size();
+
+        for (; tradeCursor < trades.size(); ++tradeCursor)
+        {
+            const Trade& trade = trades[tradeCursor];
+
+            for (const uint64_t orderId : { trade.buyOrderId, trade.sellOrderId })
+            {
+                const auto ownerIt = owners.find(orderId);
+                if (ownerIt == owners.end())
+                    continue;
+
+                OrderOwner& owner = ownerIt->second;
+
+                const auto connectionIt = connections.find(owner.connectionId);
+                if (connectionIt != connections.end())
+                {
+                    send(owner.connectionId, connectionIt->second, wire::Fill{
+                        wire::headerFor<wire::Fill>(wire::MessageType::Fill),
+                        owner.clientOrderId,
+                        orderId,
+                        trade.price,
+                        trade.quantity });
+                }
+
+                owner.remaining -= std::min(owner.remaining, trade.quantity);
+                if (owner.remaining == 0)
+                    owners.erase(ownerIt);
+            }
+        }
+    }
+
+    // ============================================================
+    // SEND
+    // ============================================================
+
+    template <typename T>
+    void Gateway::send(uint64_t connectionId, Connection& connection, const T& message)
+    {
+        const auto* bytes = reinterpret_cast<const std::byte*>(&message);
+        connection.output.insert(connection.output.end(), bytes, bytes + sizeof(T));
+
+        if (!connection.pendingFlush)
+        {
+            connection.pendingFlush = true;
+            flushList.push_back(connectionId);
+        }
+    }
+
+    bool Gateway::flush(uint64_t connectionId, Connection& connection)
+    {
+        while (connection.outputSent < connection.output.size())
+        {
+            const ssize_t sent = ::send(connection.fd,
+                connection.output.data() + connection.outputSent,
+                connection.output.size() - connection.outputSent,
+                MSG_NOSIGNAL);
+
+            if (sent < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    // Drop the sent prefix once it outweighs the backlog
+                    if (connection.outputSent >= connection.pendingOutput())
+                    {
+                        connection.output.erase(connection.output.begin(),
+                            connection.output.begin() + static_cast<std::ptrdiff_t>(connection.outputSent));
+                        connection.outputSent = 0;
+                    }
+
+                    // Socket full: finish on EPOLLOUT
+                    bool changed = !connection.wantsWrite;
+                    connection.wantsWrite = true;
+
+                    if (connection.readPaused && connection.pendingOutput() < RESUME_PENDING_OUTPUT)
+                    {
+                        connection.readPaused = false;
+                        pausedCount.fetch_sub(1, std::memory_order_relaxed);
+                        changed = true;
+                    }
+
+                    if (changed)
+                        updateInterest(connectionId, connection);
+                    return true;
+                }
+
+                closeConnection(connectionId);
+                return false;
+            }
+
+            connection.outputSent += static_cast<size_t>(sent);
+        }
+
+        connection.output.clear();
+        connection.outputSent = 0;
+        connection.pendingFlush = false;
+
+        if (connection.wantsWrite || connection.readPaused)
+        {
+            if (connection.readPaused)
+                pausedCount.fetch_sub(1, std::memory_order_relaxed);
+
+            connection.wantsWrite = false;
+            connection.readPaused = false;
+            updateInterest(connectionId, connection);
+        }
+
+        return true;
+    }
+
+} // namespace hft
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "MatchingEngine.hpp"
+#include "Protocol.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*
+
+    Binary order-entry gateway (Linux, epoll).
+
+    One thread owns the engine and the event loop:
+        - each readable connection is drained into its own
+          receive buffer and every complete message is decoded
+          in place and applied to the engine back-to-back
+        - acks and fills are appended to per-connection send
+          buffers and flushed once per loop iteration, so one
+          read's worth of responses leaves in one send()
+
+    A connection reads at most MAX_READ_PER_ROUND bytes per
+    round, so one busy client cannot starve the others. A
+    client that stops reading its replies is paused once
+    MAX_PENDING_OUTPUT bytes wait for it: its socket is not
+    read again until the backlog drains below
+    RESUME_PENDING_OUTPUT.
+
+    Fills are routed to the owning connection through an
+    engine-id -> owner map kept until the order is done.
+    Each connection submits under its own engine owner id,
+    and closing it cancels every order it still has resting.
+    The engine's other owners must not collide with these.
+
+    Listens on 127.0.0.1; port 0 picks an ephemeral port.
+    Errors during setup throw std::runtime_error.
+*/
+
+namespace hft
+{
+
+    class Gateway
+    {
+    public:
+
+        explicit Gateway(MatchingEngine& engine, uint16_t port = 0);
+        ~Gateway();
+
+        Gateway(const Gateway&) = delete;
+        Gateway& operator=(const Gateway&) = delete;
+
+        [[nodiscard]] uint16_t port() const noexcept;
+
+        // Event loop; returns after stop()
+        void run();
+
+        // One epoll round; false once stop() has been requested
+        bool pollOnce(int timeoutMs);
+
+        // Safe from any thread
+        void stop() noexcept;
+
+        [[nodiscard]] size_t connectionCount() const noexcept;
+
+        // Connections paused for unread replies; safe from any thread
+        [[nodiscard]] size_t pausedConnections() const noexcept;
+
+    private:
+
+        static constexpr size_t RECEIVE_BUFFER_SIZE = 64 * 1024;
+        static constexpr size_t MAX_READ_PER_ROUND = 4 * RECEIVE_BUFFER_SIZE;
+
+        // Unsent reply bytes that pause a connection's reads, and
+        // the level they must drain below to resume them
+        static constexpr size_t MAX_PENDING_OUTPUT = 1024 * 1024;
+        static constexpr size_t RESUME_PENDING_OUTPUT = MAX_PENDING_OUTPUT / 4;
+
+        struct Connection
+        {
+            int fd = -1;
+            uint32_t owner = 0;
+            std::vector<std::byte> input;
+            size_t inputUsed = 0;
+            std::vector<std::byte> output;
+            size_t outputSent = 0;
+            bool pendingFlush = false;
+            bool wantsWrite = false;
+            bool readPaused = false;
+
+            [[nodiscard]] size_t pendingOutput() const noexcept
+            {
+                return output.size() - outputSent;
+            }
+        };
+
+        struct OrderOwner
+        {
+            uint64_t connectionId;
+            uint64_t clientOrderId;
+            uint64_t remaining;
+            Side side;
+        };
+
+        MatchingEngine& engine;
+
+        int listenFd = -1;
+        int epollFd = -1;
+        int wakeFd = -1;
+        uint16_t boundPort = 0;
+        std::atomic<bool> stopping{ false };
+
+        uint64_t nextConnectionId = 1;
+        uint32_t nextOwner = 0;
+        std::unordered_map<uint64_t, Connection> connections;
+        std::vector<uint64_t> flushList;
+        std::atomic<size_t> pausedCount{ 0 };
+
+        std::unordered_map<uint64_t, OrderOwner> owners;
+        size_t tradeCursor = 0;
+
+        void acceptConnections();
+        void onReadable(uint64_t connectionId, Connection& connection);
+        bool flush(uint64_t connectionId, Connection& connection);
+        void closeConnection(uint64_t connectionId);
+
+        // Re-arms epoll for the connection's paused and write state
+        void updateInterest(uint64_t connectionId, const Connection& connection);
+        void pauseReads(uint64_t connectionId, Connection& connection);
+
+        // Returns bytes consumed; false in `ok` on a protocol error
+        size_t decode(uint64_t connectionId, Connection& connection, bool& ok);
+
+        void onNewOrder(uint64_t connectionId, Connection& connection, const wire::NewOrder& message);
+        void onCancel(uint64_t connectionId, Connection& connection, const wire::CancelOrder& message);
+        void onReplace(uint64_t connectionId, Connection& connection, const wire::ReplaceOrder& message);
+
+        void routeFills();
+
+        template <typename T>
+        void send(uint64_t connectionId, Connection& connection, const T& message);
+    };
+
+} // namespace hft
@@ -0,0 +1,163 @@
+#include "GatewayClient.hpp"
+
+#include <cerrno>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace hft
+{
+
+    GatewayClient::~GatewayClient()
+    {
+        close();
+    }
+
+    void GatewayClient::connect(const std::string& host, uint16_t port)
+    {
+        close();
+
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            throw std::runtime_error("GatewayClient: socket failed");
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+
+        if (::inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+        {
+            close();
+            throw std::runtime_error("GatewayClient: bad address " + host);
+        }
+
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            close();
+            throw std::runtime_error("GatewayClient: cannot connect to " + host);
+        }
+
+        const int enable = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    }
+
+    void GatewayClient::close() noexcept
+    {
+        if (fd >= 0)
+            ::close(fd);
+
+        fd = -1;
+        output.clear();
+        inputUsed = 0;
+    }
+
+    // ============================================================
+    // REQUESTS
+    // ============================================================
+
+    template <typename T>
+    void GatewayClient::append(const T& message)
+    {
+        const auto* bytes = reinterpret_cast<const std::byte*>(&message);
+        output.insert(output.end(), bytes, bytes + sizeof(T));
+    }
+
+    void GatewayClient::newOrder(uint64_t clientOrderId, Side side, OrderType type, double price, uint64_t quantity)
+    {
+        append(wire::NewOrder{
+            wire::headerFor<wire::NewOrder>(wire::MessageType::NewOrder),
+            clientOrderId,
+            price,
+            quantity,
+            side,
+            type,
+            {} });
+    }
+
+    void GatewayClient::cancelOrder(uint64_t clientOrderId, uint64_t orderId)
+    {
+        append(wire::CancelOrder{
+            wire::headerFor<wire::CancelOrder>(wire::MessageType::CancelOrder),
+            clientOrderId,
+            orderId });
+    }
+
+    void GatewayClient::replaceOrder(uint64_t clientOrderId, uint64_t orderId, double price, uint64_t quantity)
+    {
+        append(wire::ReplaceOrder{
+            wire::headerFor<wire::ReplaceOrder>(wire::MessageType::ReplaceOrder),
+            clientOrderId,
+            orderId,
+            price,
+            quantity });
+    }
+
+    void GatewayClient::sendRaw(const void* data, size_t size)
+    {
+        const auto* bytes = static_cast<const std::byte*>(data);
+        output.insert(output.end(), bytes, bytes + size);
+    }
+
+    bool GatewayClient::flush()
+    {
+        size_t sent = 0;
+
+        while (sent < output.size())
+        {
+            const ssize_t result = ::send(fd, output.data() + sent, output.size() - sent, MSG_NOSIGNAL);
+
+            if (result < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                close();
+                return false;
+            }
+
+            sent += static_cast<size_t>(result);
+        }
+
+        output.clear();
+        return true;
+    }
+
+    // ============================================================
+    // RECEIVE
+    // ============================================================
+
+    long GatewayClient::readSome(int timeoutMs)
+    {
+        if (fd < 0)
+            return -1;
+
+        pollfd request{ fd, POLLIN, 0 };
+        const int ready = ::poll(&request, 1, timeoutMs);
+
+        if (ready == 0 || (ready < 0 && errno == EINTR))
+            return 0;
+
+        if (inputUsed == input.size())
+            input.resize(input.size() * 2);
+
+        const ssize_t received = ::recv(fd, input.data() + inputUsed, input.size() - inputUsed, 0);
+
+        if (received <= 0)
+        {
+            if (received < 0 && errno == EINTR)
+                return 0;
+
+            close();
+            return -1;
+        }
+
+        inputUsed += static_cast<size_t>(received);
+        return received;
+    }
+
+} // namespace hft
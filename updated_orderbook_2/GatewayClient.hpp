@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Protocol.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+
+    Order-entry client for Gateway (Linux).
+
+    Requests are appended to a send buffer and leave on
+    flush(), so a caller can batch several per syscall.
+    receive() reads what is available and hands each
+    complete message to the handler in place, as a header
+    plus a pointer to its bytes (see wire::messageAt).
+*/
+
+namespace hft
+{
+
+    class GatewayClient
+    {
+    public:
+
+        GatewayClient() = default;
+        ~GatewayClient();
+
+        GatewayClient(const GatewayClient&) = delete;
+        GatewayClient& operator=(const GatewayClient&) = delete;
+
+        // Throws std::runtime_error on failure
+        void connect(const std::string& host, uint16_t port);
+        void close() noexcept;
+
+        // Buffered requests
+        void newOrder(uint64_t clientOrderId, Side side, OrderType type, double price, uint64_t quantity);
+        void cancelOrder(uint64_t clientOrderId, uint64_t orderId);
+        void replaceOrder(uint64_t clientOrderId, uint64_t orderId, double price, uint64_t quantity);
+
+        // Raw bytes, for tests that exercise framing
+        void sendRaw(const void* data, size_t size);
+
+        // Sends everything buffered; false if the connection failed
+        bool flush();
+
+        // Waits up to timeoutMs for data, then dispatches every
+        // complete message. Returns messages handled, or -1 once
+        // the gateway has closed the connection.
+        template <typename Handler>
+        int receive(Handler&& handler, int timeoutMs);
+
+        [[nodiscard]] bool isConnected() const noexcept
+        {
+            return fd >= 0;
+        }
+
+    private:
+
+        int fd = -1;
+        std::vector<std::byte> output;
+        std::vector<std::byte> input = std::vector<std::byte>(64 * 1024);
+        size_t inputUsed = 0;
+
+        // Reads once; returns bytes read, 0 on timeout, -1 on close/error
+        long readSome(int timeoutMs);
+
+        template <typename T>
+        void append(const T& message);
+    };
+
+    template <typename Handler>
+    int GatewayClient::receive(Handler&& handler, int timeoutMs)
+    {
+        if (readSome(timeoutMs) < 0)
+            return -1;
+
+        int handled = 0;
+        size_t offset = 0;
+
+        while (inputUsed - offset >= sizeof(wire::MessageHeader))
+        {
+            const std::byte* message = input.data() + offset;
+            const auto& header = wire::messageAt<wire::MessageHeader>(message);
+
+            if (header.length < sizeof(wire::MessageHeader))
+            {
+                close();
+                return -1;
+            }
+
+            if (inputUsed - offset < header.length)
+                break;
+
+            handler(header, message);
+            offset += header.length;
+            ++handled;
+        }
+
+        const size_t tail = inputUsed - offset;
+        if (tail > 0 && offset > 0)
+            std::memmove(input.data(), input.data() + offset, tail);
+
+        inputUsed = tail;
+        return handled;
+    }
+
+} // namespace hft
@@ -35,6 +35,23 @@ namespace hft
         return (spread / mid) * 100.0;
     }
 
+    // ============================================================
+    // MICROPRICE
+    // ============================================================
+
+    double HFTAlgorithms::computeMicroprice(const OrderBook& book)
+    {
+        const BookSummary top = book.getSummary();
+
+        if (top.bidTop == 0 || top.askTop == 0)
+            return 0.0;
+
+        const double bidQty = static_cast<double>(top.bidTop);
+        const double askQty = static_cast<double>(top.askTop);
+
+        return (top.bidPrice * askQty + top.askPrice * bidQty) / (bidQty + askQty);
+    }
+
     // ============================================================
     // MOMENTUM (Recent Trade Bias)
     // ============================================================
@@ -102,4 +119,15 @@ namespace hft
         std::cout << "Momentum:        " << momentum << "\n";
         std::cout << "Rolling Avg:     " << rollingAvg << "\n";
     }
+
+    void HFTAlgorithms::logAnalytics(AsyncLogger& logger,
+        const OrderBook& book,
+        const std::vector<Trade>& trades)
+    {
+        logger.log("ANALYTICS imbalance={} spreadPct={} momentum={} rollingAvg={}",
+            computeOrderImbalance(book),
+            computeSpreadPercentage(book),
+            computeMomentum(trades, 10),
+            computeRollingAverage(trades, 10));
+    }
 }
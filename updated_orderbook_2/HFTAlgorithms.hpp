@@ -1,5 +1,6 @@
 #pragma once
 
+#include "AsyncLogger.hpp"
 #include "OrderBook.hpp"
 #include <vector>
 
@@ -31,6 +32,10 @@ namespace hft
         // Spread as percentage of mid
         [[nodiscard]] static double computeSpreadPercentage(const OrderBook& book);
 
+        // Mid weighted by the opposite side's top-level size;
+        // 0 unless both sides quote
+        [[nodiscard]] static double computeMicroprice(const OrderBook& book);
+
         // Simple momentum from recent trades
         [[nodiscard]] static double computeMomentum(const std::vector<Trade>& trades,
             size_t lookback);
@@ -42,6 +47,11 @@ namespace hft
         // Print analytics summary
         static void printAnalytics(const OrderBook& book,
             const std::vector<Trade>& trades);
+
+        // Same summary, formatted and written on the logger's thread
+        static void logAnalytics(AsyncLogger& logger,
+            const OrderBook& book,
+            const std::vector<Trade>& trades);
     };
 
 } // namespace hft
@@ -1,12 +1,18 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <cmath>
 #include <iostream>
 #include <iomanip>
+#include <limits>
+#include <mutex>
 #include <string>
 #include <ctime>
+#include <utility>
+#include <vector>
 
 /*
 
@@ -169,33 +175,241 @@ namespace hft
     }
 
 
+    // ============================================================
+    // DETERMINISTIC RANDOM
+    // ============================================================
+
+    // splitmix64: fast, seedable, identical on every platform
+    class SimRandom
+    {
+    public:
+
+        explicit SimRandom(uint64_t seed = 0) noexcept
+            : state(seed)
+        {
+        }
+
+        [[nodiscard]] uint64_t next() noexcept
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // [0, 1)
+        [[nodiscard]] double unit() noexcept
+        {
+            return static_cast<double>(next() >> 11) * 0x1.0p-53;
+        }
+
+        // [0, bound); 0 for bound 0. Below 2^32 a multiply-shift
+        // stands in for the division (bias under bound / 2^32).
+        [[nodiscard]] uint64_t below(uint64_t bound) noexcept
+        {
+            if (bound <= std::numeric_limits<uint32_t>::max())
+                return ((next() >> 32) * bound) >> 32;
+
+            return next() % bound;
+        }
+
+        [[nodiscard]] double uniform(double low, double high) noexcept
+        {
+            return low + (high - low) * unit();
+        }
+
+        [[nodiscard]] bool chance(double probability) noexcept
+        {
+            return unit() < probability;
+        }
+
+    private:
+        uint64_t state;
+    };
+
+
     struct alignas(CACHE_LINE_SIZE) AlignedCounter
     {
         uint64_t value = 0;
     };
 
+    /*
+        Single-writer counter on its own cache line.
 
+        The owning thread updates it with plain (relaxed) stores,
+        never a locked read-modify-write. Any other thread may
+        call load() concurrently and sees a torn-free value.
+    */
     class PerformanceCounter
     {
     public:
 
-        void increment()
+        void increment() noexcept
         {
-            ++counter.value;
+            add(1);
         }
 
-        [[nodiscard]] uint64_t get() const
+        void add(uint64_t delta) noexcept
+        {
+            ref().store(counter.value + delta, std::memory_order_relaxed);
+        }
+
+        void set(uint64_t value) noexcept
+        {
+            ref().store(value, std::memory_order_relaxed);
+        }
+
+        void setMax(uint64_t value) noexcept
+        {
+            if (value > counter.value)
+                set(value);
+        }
+
+        [[nodiscard]] uint64_t get() const noexcept
         {
             return counter.value;
         }
 
-        void reset()
+        // Safe to call from a thread other than the writer
+        [[nodiscard]] uint64_t load() const noexcept
+        {
+            return std::atomic_ref<uint64_t>(
+                const_cast<uint64_t&>(counter.value)).load(std::memory_order_relaxed);
+        }
+
+        void reset() noexcept
         {
-            counter.value = 0;
+            set(0);
         }
 
     private:
         AlignedCounter counter;
+
+        std::atomic_ref<uint64_t> ref() noexcept
+        {
+            return std::atomic_ref<uint64_t>(counter.value);
+        }
+    };
+
+    /*
+        Per-thread slots of many owners (loggers, tracers).
+
+        Each owner takes an id from nextOwnerId(). Ids are never
+        reused, so a stale one-entry cache can never match a new
+        owner. local() is a thread_local cache in front of the
+        thread's full binding list; only the thread's first call
+        for an owner runs create(), which returns a Slot* the
+        owner keeps alive. An owner calls release() on
+        destruction to drop its binding from every thread.
+    */
+    template <typename Slot>
+    class ThreadSlotRegistry
+    {
+    public:
+
+        [[nodiscard]] static uint64_t nextOwnerId() noexcept
+        {
+            return nextId.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        template <typename Create>
+        [[nodiscard]] static Slot& local(uint64_t owner, Create&& create)
+        {
+            if (cachedOwner == owner)
+                return *cachedSlot;
+
+            Slot& slot = bind(owner, create);
+            cachedOwner = owner;
+            cachedSlot = &slot;
+            return slot;
+        }
+
+        // The calling thread's slot, or null before its first local()
+        [[nodiscard]] static Slot* find(uint64_t owner) noexcept
+        {
+            if (cachedOwner == owner)
+                return cachedSlot;
+
+            std::lock_guard lock(liveMutex);
+            for (const auto& [id, slot] : bindings.entries)
+            {
+                if (id == owner)
+                    return slot;
+            }
+
+            return nullptr;
+        }
+
+        // Owners bound on the calling thread
+        [[nodiscard]] static size_t boundCount() noexcept
+        {
+            std::lock_guard lock(liveMutex);
+            return bindings.entries.size();
+        }
+
+        static void release(uint64_t owner) noexcept
+        {
+            std::lock_guard lock(liveMutex);
+            for (Bindings* thread : live)
+            {
+                std::erase_if(thread->entries,
+                    [owner](const std::pair<uint64_t, Slot*>& entry) { return entry.first == owner; });
+            }
+        }
+
+    private:
+
+        // Every live owner this thread has used; listed in live
+        // from its first binding until the thread exits
+        struct Bindings
+        {
+            std::vector<std::pair<uint64_t, Slot*>> entries;
+            bool listed = false;
+
+            ~Bindings()
+            {
+                if (!listed)
+                    return;
+
+                std::lock_guard lock(liveMutex);
+                std::erase(live, this);
+            }
+        };
+
+        inline static std::atomic<uint64_t> nextId{ 1 };
+
+        inline static std::mutex liveMutex;
+        inline static std::vector<Bindings*> live;
+
+        inline static thread_local uint64_t cachedOwner = 0;
+        inline static thread_local Slot* cachedSlot = nullptr;
+        inline static thread_local Bindings bindings;
+
+        template <typename Create>
+        static Slot& bind(uint64_t owner, Create& create)
+        {
+            {
+                std::lock_guard lock(liveMutex);
+                for (const auto& [id, slot] : bindings.entries)
+                {
+                    if (id == owner)
+                        return *slot;
+                }
+            }
+
+            // Outside the lock: create() takes the owner's own
+            Slot* slot = create();
+
+            std::lock_guard lock(liveMutex);
+            if (!bindings.listed)
+            {
+                live.push_back(&bindings);
+                bindings.listed = true;
+            }
+
+            bindings.entries.emplace_back(owner, slot);
+            return *slot;
+        }
     };
 
 
@@ -212,9 +426,13 @@ namespace hft
         // Convert to time_t
         std::time_t time = std::chrono::system_clock::to_time_t(now);
 
-        // Thread-safe localtime (MSVC safe)
+        // Thread-safe localtime (MSVC and POSIX)
         std::tm tmStruct{};
+#ifdef _WIN32
         localtime_s(&tmStruct, &time);
+#else
+        localtime_r(&time, &tmStruct);
+#endif
 
         std::cout << std::put_time(&tmStruct, "%H:%M:%S");
     }
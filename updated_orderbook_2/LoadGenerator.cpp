@@ -0,0 +1,201 @@
+#include "Gateway.hpp"
+#include "GatewayClient.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace hft;
+
+/*
+    Gateway load generator.
+
+    Keeps `window` requests in flight against a gateway and
+    records the round trip from send to the matching response
+    (ack, reject, cancel ack/reject, replace ack) per request.
+
+    Usage:
+        updated_orderbook_loadgen [requests] [window] [port]
+
+    Without a port an in-process gateway is started on an
+    ephemeral loopback port.
+*/
+
+namespace
+{
+    [[nodiscard]] uint64_t nowNs()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    [[nodiscard]] double percentile(const std::vector<uint64_t>& sorted, double p)
+    {
+        if (sorted.empty())
+            return 0.0;
+
+        const size_t index = std::min(sorted.size() - 1,
+            static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size())));
+
+        return static_cast<double>(sorted[index]) / 1'000.0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t requests = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 200'000;
+    const size_t window = (argc > 2) ? std::max<size_t>(1, std::strtoull(argv[2], nullptr, 10)) : 32;
+    uint16_t port = (argc > 3) ? static_cast<uint16_t>(std::strtoul(argv[3], nullptr, 10)) : 0;
+
+    std::unique_ptr<MatchingEngine> engine;
+    std::unique_ptr<Gateway> gateway;
+    std::thread gatewayThread;
+
+    if (port == 0)
+    {
+        engine = std::make_unique<MatchingEngine>();
+        gateway = std::make_unique<Gateway>(*engine);
+        port = gateway->port();
+        gatewayThread = std::thread([&]() { gateway->run(); });
+    }
+
+    GatewayClient client;
+    client.connect("127.0.0.1", port);
+
+    // Index = clientOrderId; 0 means no request outstanding
+    std::vector<uint64_t> sentAt(requests + 1, 0);
+    std::vector<uint64_t> latencies;
+    latencies.reserve(requests);
+
+    std::vector<uint64_t> restingIds;
+    size_t sent = 0;
+    size_t outstanding = 0;
+    size_t fills = 0;
+    size_t rejects = 0;
+    bool connectionLost = false;
+
+    const uint64_t start = nowNs();
+
+    while (latencies.size() < requests)
+    {
+        // Top the window up in one flush
+        while (outstanding < window && sent < requests)
+        {
+            const uint64_t clientOrderId = ++sent;
+            const uint64_t r = clientOrderId * 2654435761u;
+
+            if (clientOrderId % 4 == 0 && !restingIds.empty())
+            {
+                client.cancelOrder(clientOrderId, restingIds.back());
+                restingIds.pop_back();
+            }
+            else
+            {
+                const Side side = (r & 1) ? Side::Buy : Side::Sell;
+                const double offset = static_cast<double>((r >> 8) % 8) * 0.25;
+                const double price = (side == Side::Buy) ? 100.5 - offset : 99.5 + offset;
+                client.newOrder(clientOrderId, side, OrderType::Limit, price, 1 + (r >> 16) % 100);
+            }
+
+            sentAt[clientOrderId] = nowNs();
+            ++outstanding;
+        }
+
+        if (!client.flush())
+        {
+            connectionLost = true;
+            break;
+        }
+
+        const int handled = client.receive([&](const wire::MessageHeader& header, const std::byte* message)
+            {
+                uint64_t clientOrderId = 0;
+
+                switch (header.type)
+                {
+                case wire::MessageType::OrderAck:
+                {
+                    const auto& ack = wire::messageAt<wire::OrderAck>(message);
+                    clientOrderId = ack.clientOrderId;
+                    restingIds.push_back(uint64_t{ ack.orderId });
+                    break;
+                }
+                case wire::MessageType::OrderReject:
+                    clientOrderId = wire::messageAt<wire::OrderReject>(message).clientOrderId;
+                    ++rejects;
+                    break;
+                case wire::MessageType::CancelAck:
+                    clientOrderId = wire::messageAt<wire::CancelAck>(message).clientOrderId;
+                    break;
+                case wire::MessageType::CancelReject:
+                    clientOrderId = wire::messageAt<wire::CancelReject>(message).clientOrderId;
+                    break;
+                case wire::MessageType::ReplaceAck:
+                    clientOrderId = wire::messageAt<wire::ReplaceAck>(message).clientOrderId;
+                    break;
+                case wire::MessageType::Fill:
+                    ++fills;
+                    return;
+                default:
+                    return;
+                }
+
+                if (clientOrderId == 0 || clientOrderId > requests || sentAt[clientOrderId] == 0)
+                    return;
+
+                latencies.push_back(nowNs() - sentAt[clientOrderId]);
+                sentAt[clientOrderId] = 0;
+                --outstanding;
+            }, 1'000);
+
+        if (handled < 0)
+        {
+            connectionLost = true;
+            break;
+        }
+    }
+
+    const double seconds = static_cast<double>(nowNs() - start) / 1e9;
+
+    client.close();
+
+    if (gateway)
+    {
+        gateway->stop();
+        gatewayThread.join();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << "====================================\n";
+    std::cout << "        GATEWAY ROUND TRIPS\n";
+    std::cout << "====================================\n";
+    std::cout << "requests:   " << latencies.size() << " (window " << window << ")\n";
+    std::cout << "fills:      " << fills << "\n";
+    std::cout << "rejects:    " << rejects << "\n";
+
+    // A partial run's rates and percentiles would mislead
+    if (connectionLost)
+    {
+        std::cout << "status:     gateway closed the connection after "
+            << latencies.size() << " of " << requests << " requests\n";
+        return 1;
+    }
+
+    std::cout << "throughput: " << std::fixed << std::setprecision(0)
+        << static_cast<double>(latencies.size()) / seconds << " req/s\n";
+
+    std::cout << std::setprecision(1);
+    std::cout << "p50:        " << percentile(latencies, 50.0) << " us\n";
+    std::cout << "p90:        " << percentile(latencies, 90.0) << " us\n";
+    std::cout << "p99:        " << percentile(latencies, 99.0) << " us\n";
+    std::cout << "p99.9:      " << percentile(latencies, 99.9) << " us\n";
+    std::cout << "max:        " << (latencies.empty() ? 0.0 : static_cast<double>(latencies.back()) / 1'000.0) << " us\n";
+
+    return latencies.size() == requests ? 0 : 1;
+}
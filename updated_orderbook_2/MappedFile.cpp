@@ -0,0 +1,422 @@
+#include "MappedFile.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace hft
+{
+
+    MappedFile::MappedFile(const std::string& path)
+    {
+        open(path);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this == &other)
+            return *this;
+
+        close();
+
+        mappedData = std::exchange(other.mappedData, nullptr);
+        mappedSize = std::exchange(other.mappedSize, 0);
+#ifdef _WIN32
+        fileHandle = std::exchange(other.fileHandle, nullptr);
+        mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#else
+        fileDescriptor = std::exchange(other.fileDescriptor, -1);
+#endif
+        return *this;
+    }
+
+#ifdef _WIN32
+
+    void MappedFile::open(const std::string& path)
+    {
+        close();
+
+        HANDLE file = CreateFileA(path.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+
+        if (file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("MappedFile: cannot open " + path);
+
+        LARGE_INTEGER fileSize{};
+        if (!GetFileSizeEx(file, &fileSize))
+        {
+            CloseHandle(file);
+            throw std::runtime_error("MappedFile: cannot stat " + path);
+        }
+
+        fileHandle = file;
+        mappedSize = static_cast<size_t>(fileSize.QuadPart);
+
+        // Zero-length files cannot be mapped; expose an empty view
+        if (mappedSize == 0)
+            return;
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping)
+        {
+            close();
+            throw std::runtime_error("MappedFile: cannot map " + path);
+        }
+
+        mappingHandle = mapping;
+        mappedData = static_cast<const std::byte*>(
+            MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+        if (!mappedData)
+        {
+            close();
+            throw std::runtime_error("MappedFile: cannot view " + path);
+        }
+    }
+
+    void MappedFile::close() noexcept
+    {
+        if (mappedData)
+            UnmapViewOfFile(mappedData);
+
+        if (mappingHandle)
+            CloseHandle(static_cast<HANDLE>(mappingHandle));
+
+        if (fileHandle)
+            CloseHandle(static_cast<HANDLE>(fileHandle));
+
+        mappedData = nullptr;
+        mappedSize = 0;
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+    }
+
+    bool MappedFile::isOpen() const noexcept
+    {
+        return fileHandle != nullptr;
+    }
+
+#else
+
+    void MappedFile::open(const std::string& path)
+    {
+        close();
+
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("MappedFile: cannot open " + path);
+
+        struct stat info {};
+        if (::fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("MappedFile: cannot stat " + path);
+        }
+
+        fileDescriptor = fd;
+        mappedSize = static_cast<size_t>(info.st_size);
+
+        // Zero-length files cannot be mapped; expose an empty view
+        if (mappedSize == 0)
+            return;
+
+        void* address = ::mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED)
+        {
+            close();
+            throw std::runtime_error("MappedFile: cannot map " + path);
+        }
+
+        mappedData = static_cast<const std::byte*>(address);
+    }
+
+    void MappedFile::close() noexcept
+    {
+        if (mappedData)
+            ::munmap(const_cast<std::byte*>(mappedData), mappedSize);
+
+        if (fileDescriptor >= 0)
+            ::close(fileDescriptor);
+
+        mappedData = nullptr;
+        mappedSize = 0;
+        fileDescriptor = -1;
+    }
+
+    bool MappedFile::isOpen() const noexcept
+    {
+        return fileDescriptor >= 0;
+    }
+
+#endif
+
+    const std::byte* MappedFile::data() const noexcept
+    {
+        return mappedData;
+    }
+
+    size_t MappedFile::size() const noexcept
+    {
+        return mappedSize;
+    }
+
+    // ============================================================
+    // SHARED MAPPING
+    // ============================================================
+
+    SharedMapping::~SharedMapping()
+    {
+        close();
+    }
+
+    SharedMapping::SharedMapping(SharedMapping&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    SharedMapping& SharedMapping::operator=(SharedMapping&& other) noexcept
+    {
+        if (this == &other)
+            return *this;
+
+        close();
+
+        mappedData = std::exchange(other.mappedData, nullptr);
+        mappedSize = std::exchange(other.mappedSize, 0);
+#ifdef _WIN32
+        fileHandle = std::exchange(other.fileHandle, nullptr);
+        mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#else
+        fileDescriptor = std::exchange(other.fileDescriptor, -1);
+#endif
+        return *this;
+    }
+
+#ifdef _WIN32
+
+    void SharedMapping::create(const std::string& path, size_t size)
+    {
+        close();
+
+        HANDLE file = CreateFileA(path.c_str(),
+            GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_WRITE,
+            nullptr,
+            CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+
+        if (file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("SharedMapping: cannot create " + path);
+
+        fileHandle = file;
+
+        LARGE_INTEGER length{};
+        length.QuadPart = static_cast<LONGLONG>(size);
+
+        if (!SetFilePointerEx(file, length, nullptr, FILE_BEGIN) || !SetEndOfFile(file))
+        {
+            close();
+            throw std::runtime_error("SharedMapping: cannot size " + path);
+        }
+
+        mappedSize = size;
+        map(path);
+    }
+
+    void SharedMapping::open(const std::string& path)
+    {
+        close();
+
+        HANDLE file = CreateFileA(path.c_str(),
+            GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_WRITE,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+
+        if (file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("SharedMapping: cannot open " + path);
+
+        fileHandle = file;
+
+        LARGE_INTEGER fileSize{};
+        if (!GetFileSizeEx(file, &fileSize))
+        {
+            close();
+            throw std::runtime_error("SharedMapping: cannot stat " + path);
+        }
+
+        mappedSize = static_cast<size_t>(fileSize.QuadPart);
+        map(path);
+    }
+
+    void SharedMapping::map(const std::string& path)
+    {
+        if (mappedSize == 0)
+        {
+            close();
+            throw std::runtime_error("SharedMapping: empty file " + path);
+        }
+
+        HANDLE mapping = CreateFileMappingA(static_cast<HANDLE>(fileHandle), nullptr, PAGE_READWRITE, 0, 0, nullptr);
+        if (!mapping)
+        {
+            close();
+            throw std::runtime_error("SharedMapping: cannot map " + path);
+        }
+
+        mappingHandle = mapping;
+        mappedData = static_cast<std::byte*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+
+        if (!mappedData)
+        {
+            close();
+            throw std::runtime_error("SharedMapping: cannot view " + path);
+        }
+    }
+
+    void SharedMapping::close() noexcept
+    {
+        if (mappedData)
+            UnmapViewOfFile(mappedData);
+
+        if (mappingHandle)
+            CloseHandle(static_cast<HANDLE>(mappingHandle));
+
+        if (fileHandle)
+            CloseHandle(static_cast<HANDLE>(fileHandle));
+
+        mappedData = nullptr;
+        mappedSize = 0;
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+    }
+
+    bool SharedMapping::isOpen() const noexcept
+    {
+        return fileHandle != nullptr;
+    }
+
+#else
+
+    void SharedMapping::create(const std::string& path, size_t size)
+    {
+        close();
+
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0)
+            throw std::runtime_error("SharedMapping: cannot create " + path);
+
+        fileDescriptor = fd;
+
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            close();
+            throw std::runtime_error("SharedMapping: cannot size " + path);
+        }
+
+        mappedSize = size;
+        map(path);
+    }
+
+    void SharedMapping::open(const std::string& path)
+    {
+        close();
+
+        const int fd = ::open(path.c_str(), O_RDWR);
+        if (fd < 0)
+            throw std::runtime_error("SharedMapping: cannot open " + path);
+
+        fileDescriptor = fd;
+
+        struct stat info {};
+        if (::fstat(fd, &info) != 0)
+        {
+            close();
+            throw std::runtime_error("SharedMapping: cannot stat " + path);
+        }
+
+        mappedSize = static_cast<size_t>(info.st_size);
+        map(path);
+    }
+
+    void SharedMapping::map(const std::string& path)
+    {
+        if (mappedSize == 0)
+        {
+            close();
+            throw std::runtime_error("SharedMapping: empty file " + path);
+        }
+
+        void* address = ::mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+        if (address == MAP_FAILED)
+        {
+            close();
+            throw std::runtime_error("SharedMapping: cannot map " + path);
+        }
+
+        mappedData = static_cast<std::byte*>(address);
+    }
+
+    void SharedMapping::close() noexcept
+    {
+        if (mappedData)
+            ::munmap(mappedData, mappedSize);
+
+        if (fileDescriptor >= 0)
+            ::close(fileDescriptor);
+
+        mappedData = nullptr;
+        mappedSize = 0;
+        fileDescriptor = -1;
+    }
+
+    bool SharedMapping::isOpen() const noexcept
+    {
+        return fileDescriptor >= 0;
+    }
+
+#endif
+
+    std::byte* SharedMapping::data() const noexcept
+    {
+        return mappedData;
+    }
+
+    size_t SharedMapping::size() const noexcept
+    {
+        return mappedSize;
+    }
+
+} // namespace hft
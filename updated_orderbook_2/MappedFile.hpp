@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+/*
+
+    Read-only memory-mapped file.
+
+    Replay datasets and archives are mapped once and shared
+    by every worker thread without copying. The mapping is
+    released when the object is destroyed.
+*/
+
+namespace hft
+{
+
+    class MappedFile
+    {
+    public:
+
+        MappedFile() = default;
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Throws std::runtime_error if the file cannot be mapped
+        void open(const std::string& path);
+        void close() noexcept;
+
+        [[nodiscard]] bool isOpen() const noexcept;
+        [[nodiscard]] const std::byte* data() const noexcept;
+        [[nodiscard]] size_t size() const noexcept;
+
+        [[nodiscard]] std::span<const std::byte> bytes() const noexcept
+        {
+            return { mappedData, mappedSize };
+        }
+
+    private:
+
+        const std::byte* mappedData = nullptr;
+        size_t mappedSize = 0;
+
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#else
+        int fileDescriptor = -1;
+#endif
+    };
+
+    /*
+        Read-write shared mapping. Every process mapping the same
+        file sees the others' writes, so it doubles as shared
+        memory between processes (see ReplicationPublisher).
+    */
+    class SharedMapping
+    {
+    public:
+
+        SharedMapping() = default;
+        ~SharedMapping();
+
+        SharedMapping(SharedMapping&& other) noexcept;
+        SharedMapping& operator=(SharedMapping&& other) noexcept;
+
+        SharedMapping(const SharedMapping&) = delete;
+        SharedMapping& operator=(const SharedMapping&) = delete;
+
+        // Creates or truncates the file to `size` zero bytes and maps
+        // it; throws std::runtime_error
+        void create(const std::string& path, size_t size);
+
+        // Maps an existing file whole; throws std::runtime_error
+        void open(const std::string& path);
+        void close() noexcept;
+
+        [[nodiscard]] bool isOpen() const noexcept;
+        [[nodiscard]] std::byte* data() const noexcept;
+        [[nodiscard]] size_t size() const noexcept;
+
+    private:
+
+        std::byte* mappedData = nullptr;
+        size_t mappedSize = 0;
+
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#else
+        int fileDescriptor = -1;
+#endif
+
+        void map(const std::string& path);
+    };
+
+    // True when `bytes` holds exactly `count` records of `recordSize`.
+    // Divides rather than multiplies: a garbled count read from a
+    // file header must not wrap into a plausible size
+    [[nodiscard]] constexpr bool fitsIn(uint64_t count, size_t recordSize, size_t bytes) noexcept
+    {
+        return bytes % recordSize == 0 && bytes / recordSize == count;
+    }
+
+} // namespace hft
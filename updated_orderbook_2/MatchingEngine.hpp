@@ -1,7 +1,17 @@
 #pragma once
 
+#include "AsyncLogger.hpp"
 #include "OrderBook.hpp"
-#include <atomic>
+#include "OrderBookLike.hpp"
+#include "OrderIdAllocator.hpp"
+#include "EngineMetrics.hpp"
+#include "HFTUtils.hpp"
+#include "OrderTracer.hpp"
+#include "Replication.hpp"
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 /*
@@ -21,29 +31,118 @@
         - Network Gateway
         - Logging system
         - Market Data Feed
+
+    The book type is a template parameter constrained by
+    OrderBookLike; MatchingEngine is the default map-based
+    instantiation, compiled once in MatchingEngine.cpp.
 */
 
 namespace hft
 {
 
-    class MatchingEngine
+    struct RiskLimits
+    {
+        double maxPrice{ 1'000'000.0 };
+        uint64_t maxQuantity{ 1'000'000 };
+        bool allowMarketOrders{ true };
+    };
+
+    enum class RejectReason : uint8_t
+    {
+        None,
+        InvalidPrice,
+        InvalidQuantity,
+        MarketOrdersDisabled,
+        InvalidOrderId
+    };
+
+    template <OrderBookLike Book = OrderBook>
+    class BasicMatchingEngine
     {
     public:
 
-        struct RiskLimits
-        {
-            double maxPrice{ 1'000'000.0 };
-            uint64_t maxQuantity{ 1'000'000 };
-            bool allowMarketOrders{ true };
-        };
+        using BookType = Book;
+        using RiskLimits = hft::RiskLimits;
+        using RejectReason = hft::RejectReason;
 
-        MatchingEngine();
+        BasicMatchingEngine();
 
-        // Submit order (auto ID generation)
+        // Submit order (auto ID generation). `owner` tags the order
+        // for cancelOwner(); 0 means no owner.
         [[nodiscard]] uint64_t submitOrder(Side side,
             OrderType type,
             double price,
-            uint64_t quantity);
+            uint64_t quantity,
+            uint32_t owner = 0);
+
+        // Submit with an ID drawn by the producer from getIdAllocator()
+        // (or read back from a journal); returns orderId or 0
+        [[nodiscard]] uint64_t submitOrderWithId(uint64_t orderId,
+            Side side,
+            OrderType type,
+            double price,
+            uint64_t quantity,
+            uint32_t owner = 0);
+
+        // Limit order showing displayQty at a time, refilled in place
+        // from its reserve (see OrderBook::addIceberg). Risk limits
+        // apply to the full quantity; displayQty 0 is rejected.
+        [[nodiscard]] uint64_t submitIceberg(Side side,
+            double price,
+            uint64_t quantity,
+            uint64_t displayQty,
+            uint32_t owner = 0) requires IcebergBookLike<Book>;
+
+        // Undisplayed limit order priced at offset behind its
+        // reference (see OrderBook::addPegged). A negative,
+        // non-finite or out-of-band offset, a buy offset that would
+        // price at or below zero, or PegType::None, is rejected as
+        // InvalidPrice.
+        [[nodiscard]] uint64_t submitPegged(Side side,
+            PegType peg,
+            double offset,
+            uint64_t quantity,
+            uint32_t owner = 0) requires PeggedBookLike<Book>;
+
+        // Shared block dispenser for producer threads (OrderIdBlock)
+        [[nodiscard]] OrderIdAllocator& getIdAllocator() noexcept;
+
+        // Dense sequence of accepted events (submits, cancels,
+        // mode changes, uncrosses); 0 before the first one.
+        // Trades carry the sequence of the event that caused them.
+        [[nodiscard]] uint64_t getSequence() const noexcept;
+
+        // Cancel a resting order; false if unknown or already done
+        bool cancelOrder(uint64_t orderId);
+
+        // Bulk cancels (backends satisfying MassCancelBookLike only).
+        // A call that removes anything is one sequenced event.
+        MassCancelResult cancelSide(Side side) requires MassCancelBookLike<Book>;
+        MassCancelResult cancelPriceRange(Side side, double low, double high) requires MassCancelBookLike<Book>;
+        MassCancelResult cancelOwner(uint32_t owner) requires MassCancelBookLike<Book>;
+
+        // Why the most recent submitOrder() returned 0
+        [[nodiscard]] RejectReason getLastRejectReason() const noexcept;
+
+        // Call auction (backends satisfying AuctionBookLike only)
+        void setTradingMode(TradingMode mode) requires AuctionBookLike<Book>;
+        AuctionResult uncross(double referencePrice = 0.0) requires AuctionBookLike<Book>;
+
+        // Cumulative-depth index, read through getOrderBook().getDepthIndex()
+        void enableDepthIndex(double tickSize)
+            requires requires(Book& book) { book.enableDepthIndex(tickSize); };
+
+        // Shadow orders overlaid on the book (see ShadowFillSimulator);
+        // null detaches
+        void attachShadowFills(ShadowFillSimulator* simulator)
+            requires requires(Book& book) { book.attachShadowFills(simulator); };
+
+        // Heap footprint, and bounded compaction slices for quiet
+        // periods (see OrderBook::compact); neither is an event
+        [[nodiscard]] MemoryStats memoryStats() const
+            requires requires(const Book& book) { book.memoryStats(); };
+        CompactionResult compact(std::chrono::microseconds budget)
+            requires requires(Book& book) { book.compact(budget); };
 
         void setRiskLimits(RiskLimits limits) noexcept;
 
@@ -55,22 +154,838 @@ namespace hft
         // Market data access
         void printTopOfBook() const;
         void printFullDepth() const;
-        [[nodiscard]] const OrderBook& getOrderBook() const noexcept;
+
+        // Same reports through an AsyncLogger: formatting and the
+        // write happen on the logger's thread
+        void logTopOfBook(AsyncLogger& logger) const;
+        void logFullDepth(AsyncLogger& logger) const;
+
+        // Logs every fill as it happens (null detaches); the logger
+        // must outlive the attachment
+        void attachTradeLog(AsyncLogger* logger) noexcept;
+
+        // Primary side: streams every accepted event to a standby
+        // (see ReplicationPublisher; null detaches). The publisher
+        // must outlive the attachment. While attached, each event
+        // reads the clock once and stamps its fills with that time.
+        void attachReplication(ReplicationPublisher* publisher) noexcept;
+
+        // Samples submitOrder()/submitOrderWithId() lifecycles into the
+        // tracer (null detaches); the tracer must outlive the attachment
+        void attachTracer(OrderTracer* orderTracer) noexcept;
+
+        // Standby side: applies one primary event with the primary's
+        // order id and clock, skipping risk checks. Throws
+        // std::runtime_error unless it carries the next sequence, or
+        // if applying it does not reproduce that sequence. Trades
+        // are stamped with the event time.
+        void applyReplicated(const ReplicationRecord& event);
+
+        // Applies one batch of waiting records and acknowledges the
+        // sequence reached; returns the number applied. Throws
+        // std::runtime_error once the primary has detached the
+        // standby and nothing is left to apply: the replica is
+        // incomplete and must not take over.
+        size_t followReplication(ReplicationSubscriber& subscriber);
+
+        // Failover: back on the wall clock, with new engine ids
+        // above every id the primary used
+        void takeOver() noexcept;
+
+        [[nodiscard]] const Book& getOrderBook() const noexcept;
+
+        // Deterministic clock for backtests (wall clock by default)
+        void setSimulatedTime(Timestamp time) noexcept;
+        void useWallClock() noexcept;
+
+        // Hot-path counters; snapshot() is safe from a monitoring thread
+        [[nodiscard]] const MetricsRegistry& getMetrics() const noexcept;
 
         void reset();
 
     private:
 
-        OrderBook orderBook;
+        Book orderBook;
+
+        // IDs for submitOrder() come from the engine's own block
+        OrderIdAllocator idAllocator;
+        OrderIdBlock engineIds{ idAllocator };
+        uint64_t sequence = 0;
 
-        // Thread-safe ID generator
-        std::atomic<uint64_t> nextOrderId;
         RiskLimits riskLimits;
+        RejectReason lastRejectReason = RejectReason::None;
+        MetricsRegistry metrics;
+
+        AsyncLogger* tradeLog = nullptr;
+        size_t tradesReported = 0;
+
+        ReplicationPublisher* replication = nullptr;
+        uint64_t highestReplicatedId = 0;
+
+        OrderTracer* tracer = nullptr;
+        OrderTrace trace;
+        bool tracing = false;   // the submit in progress is sampled
+
+        bool simulatedClock = false;   // mirrors the book's clock
+
+        // Holds a wall-clock book at one instant for a whole event
+        // while a standby is attached, so every fill carries the
+        // time the event is replicated with
+        class EventTimeScope
+        {
+        public:
+
+            explicit EventTimeScope(BasicMatchingEngine& engine_) noexcept
+                : engine(engine_),
+                held(engine_.replication != nullptr && !engine_.simulatedClock),
+                eventTime(engine_.orderBook.currentTime())
+            {
+                if (held)
+                    engine.orderBook.setSimulatedTime(eventTime);
+            }
+
+            ~EventTimeScope()
+            {
+                if (held)
+                    engine.orderBook.useWallClock();
+            }
 
-        bool validateSubmission(OrderType type,
+            EventTimeScope(const EventTimeScope&) = delete;
+            EventTimeScope& operator=(const EventTimeScope&) = delete;
+
+            [[nodiscard]] Timestamp time() const noexcept
+            {
+                return eventTime;
+            }
+
+        private:
+            BasicMatchingEngine& engine;
+            const bool held;
+            const Timestamp eventTime;
+        };
+
+        RejectReason validateSubmission(OrderType type,
             double price,
             uint64_t quantity) const noexcept;
 
+        // Risk check plus accept/reject counters
+        bool admit(OrderType type, double price, uint64_t quantity) noexcept;
+
+        // Stores the verdict and bumps its counter; true if accepted
+        bool record(RejectReason reason) noexcept;
+
+        void enter(uint64_t orderId, Side side, OrderType type, double price, uint64_t quantity, uint32_t owner);
+
+        void enterIceberg(uint64_t orderId, Side side, double price, uint64_t quantity, uint64_t displayQty, uint32_t owner)
+            requires IcebergBookLike<Book>;
+
+        void enterPegged(uint64_t orderId, Side side, PegType peg, double offset, uint64_t quantity, uint32_t owner)
+            requires PeggedBookLike<Book>;
+
+        // Sampled-trace stamps; no-ops unless the submit was sampled
+        void beginTrace(OrderType type) noexcept;
+        void markTrace(TracePoint point) noexcept;
+        void endTrace(uint64_t orderId) noexcept;
+
+        // Publishes an accepted event under the current sequence
+        void replicate(ReplicationRecord event, Timestamp time) noexcept;
+
+        // Sequences (and replicates) a bulk cancel that removed anything
+        MassCancelResult recordMassCancel(MassCancelResult result, const ReplicationRecord& event, Timestamp time);
+
+        void reportTrades() noexcept;
+
     };
 
+    using MatchingEngine = BasicMatchingEngine<OrderBook>;
+
+    // ============================================================
+    // CONSTRUCTOR
+
+    template <OrderBookLike Book>
+    BasicMatchingEngine<Book>::BasicMatchingEngine()
+    {
+        orderBook.attachMetrics(&metrics);
+    }
+
+    
+
+    template <OrderBookLike Book>
+    uint64_t BasicMatchingEngine<Book>::submitOrder(Side side,
+        OrderType type,
+        double price,
+        uint64_t quantity,
+        uint32_t owner)
+    {
+        /*
+            This function acts as the public API
+            for submitting new orders into the system.
+
+            In a real exchange this would:
+                - Validate risk
+                - Check margin
+                - Validate price bands
+                - Timestamp at gateway
+                - Pass to matching engine thread
+        */
+
+        MetricsUpdateScope metricsScope(metrics);
+        beginTrace(type);
+
+        if (!admit(type, price, quantity))
+        {
+            endTrace(0);
+            return 0;
+        }
+
+        // Rejected orders do not consume IDs
+        const uint64_t orderId = engineIds.next();
+        enter(orderId, side, type, price, quantity, owner);
+
+        return orderId;
+    }
+
+    template <OrderBookLike Book>
+    uint64_t BasicMatchingEngine<Book>::submitOrderWithId(uint64_t orderId,
+        Side side,
+        OrderType type,
+        double price,
+        uint64_t quantity,
+        uint32_t owner)
+    {
+        MetricsUpdateScope metricsScope(metrics);
+
+        // A live duplicate would shadow the resting order's index entry
+        if (orderId == 0 || orderBook.contains(orderId))
+        {
+            record(RejectReason::InvalidOrderId);
+            return 0;
+        }
+
+        beginTrace(type);
+
+        if (!admit(type, price, quantity))
+        {
+            endTrace(0);
+            return 0;
+        }
+
+        enter(orderId, side, type, price, quantity, owner);
+        return orderId;
+    }
+
+    template <OrderBookLike Book>
+    uint64_t BasicMatchingEngine<Book>::submitIceberg(Side side,
+        double price,
+        uint64_t quantity,
+        uint64_t displayQty,
+        uint32_t owner) requires IcebergBookLike<Book>
+    {
+        MetricsUpdateScope metricsScope(metrics);
+
+        if (displayQty == 0)
+        {
+            record(RejectReason::InvalidQuantity);
+            return 0;
+        }
+
+        if (!admit(OrderType::Limit, price, quantity))
+            return 0;
+
+        const uint64_t orderId = engineIds.next();
+        enterIceberg(orderId, side, price, quantity, displayQty, owner);
+
+        return orderId;
+    }
+
+    template <OrderBookLike Book>
+    uint64_t BasicMatchingEngine<Book>::submitPegged(Side side,
+        PegType peg,
+        double offset,
+        uint64_t quantity,
+        uint32_t owner) requires PeggedBookLike<Book>
+    {
+        MetricsUpdateScope metricsScope(metrics);
+
+        // No price of its own to check: the offset stands in for it
+        RejectReason reason = RejectReason::None;
+
+        if (quantity == 0 || quantity > riskLimits.maxQuantity)
+            reason = RejectReason::InvalidQuantity;
+        else if (peg == PegType::None || !std::isfinite(offset) || offset < 0.0 || offset >= riskLimits.maxPrice)
+            reason = RejectReason::InvalidPrice;
+        else if (side == Side::Buy)
+        {
+            // A buy offset past its current reference would price at or below zero
+            const double bid = orderBook.getBestBid();
+            const double ask = orderBook.getBestAsk();
+            const double reference = (peg == PegType::Primary) ? bid
+                : (bid > 0.0 && ask > 0.0) ? (bid + ask) / 2.0 : 0.0;
+
+            if (reference > 0.0 && reference - offset <= 0.0)
+                reason = RejectReason::InvalidPrice;
+        }
+
+        if (!record(reason))
+            return 0;
+
+        const uint64_t orderId = engineIds.next();
+        enterPegged(orderId, side, peg, offset, quantity, owner);
+
+        return orderId;
+    }
+
+    template <OrderBookLike Book>
+    bool BasicMatchingEngine<Book>::admit(OrderType type, double price, uint64_t quantity) noexcept
+    {
+        return record(validateSubmission(type, price, quantity));
+    }
+
+    template <OrderBookLike Book>
+    bool BasicMatchingEngine<Book>::record(RejectReason reason) noexcept
+    {
+        lastRejectReason = reason;
+
+        switch (lastRejectReason)
+        {
+        case RejectReason::None:
+            break;
+        case RejectReason::InvalidPrice:
+            metrics.increment(Metric::OrdersRejectedPrice);
+            return false;
+        case RejectReason::InvalidQuantity:
+            metrics.increment(Metric::OrdersRejectedQuantity);
+            return false;
+        case RejectReason::MarketOrdersDisabled:
+            metrics.increment(Metric::OrdersRejectedMarketDisabled);
+            return false;
+        case RejectReason::InvalidOrderId:
+            metrics.increment(Metric::OrdersRejectedOrderId);
+            return false;
+        }
+
+        metrics.increment(Metric::OrdersAccepted);
+        return true;
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::enter(uint64_t orderId,
+        Side side,
+        OrderType type,
+        double price,
+        uint64_t quantity,
+        uint32_t owner)
+    {
+        const EventTimeScope eventTime(*this);
+        const Timestamp now = eventTime.time();
+
+        Order order(orderId, side, type, price, quantity, now);
+        order.owner = owner;
+
+        markTrace(TracePoint::Validated);
+
+        orderBook.setEventSequence(++sequence);
+        orderBook.addOrder(std::move(order));
+        markTrace(TracePoint::Booked);
+
+        reportTrades();
+        replicate({ .orderId = orderId, .price = price, .quantity = quantity, .owner = owner,
+            .action = ReplicatedAction::Submit, .side = side, .type = type }, now);
+        endTrace(orderId);
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::enterIceberg(uint64_t orderId,
+        Side side,
+        double price,
+        uint64_t quantity,
+        uint64_t displayQty,
+        uint32_t owner) requires IcebergBookLike<Book>
+    {
+        const EventTimeScope eventTime(*this);
+        const Timestamp now = eventTime.time();
+
+        Order order(orderId, side, OrderType::Limit, price, quantity, now);
+        order.owner = owner;
+
+        orderBook.setEventSequence(++sequence);
+        orderBook.addIceberg(std::move(order), displayQty);
+        reportTrades();
+
+        replicate({ .orderId = orderId, .price = price, .quantity = quantity, .displayQty = displayQty,
+            .owner = owner, .action = ReplicatedAction::Iceberg, .side = side, .type = OrderType::Limit }, now);
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::enterPegged(uint64_t orderId,
+        Side side,
+        PegType peg,
+        double offset,
+        uint64_t quantity,
+        uint32_t owner) requires PeggedBookLike<Book>
+    {
+        const EventTimeScope eventTime(*this);
+        const Timestamp now = eventTime.time();
+
+        Order order(orderId, side, OrderType::Limit, 0.0, quantity, now);
+        order.owner = owner;
+
+        orderBook.setEventSequence(++sequence);
+        orderBook.addPegged(std::move(order), peg, offset);
+        reportTrades();
+
+        replicate({ .orderId = orderId, .price = offset, .quantity = quantity, .owner = owner,
+            .action = ReplicatedAction::Pegged, .side = side, .type = OrderType::Limit,
+            .mode = static_cast<uint8_t>(peg) }, now);
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::replicate(ReplicationRecord event, Timestamp time) noexcept
+    {
+        if (!replication)
+            return;
+
+        event.sequence = sequence;
+        event.timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        replication->publish(event);
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::attachReplication(ReplicationPublisher* publisher) noexcept
+    {
+        replication = publisher;
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::attachTracer(OrderTracer* orderTracer) noexcept
+    {
+        tracer = orderTracer;
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::beginTrace(OrderType type) noexcept
+    {
+        tracing = tracer && tracer->sample();
+        if (!tracing)
+            return;
+
+        trace = OrderTrace{};
+        trace.market = (type == OrderType::Market);
+        trace.mark(TracePoint::Received);
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::markTrace(TracePoint point) noexcept
+    {
+        if (tracing)
+            trace.mark(point);
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::endTrace(uint64_t orderId) noexcept
+    {
+        if (!tracing)
+            return;
+
+        // A rejected order ends where validation did
+        trace.mark(orderId ? TracePoint::Published : TracePoint::Validated);
+        trace.orderId = orderId;
+        tracer->record(trace);
+        tracing = false;
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::applyReplicated(const ReplicationRecord& event)
+    {
+        if (event.sequence != sequence + 1)
+        {
+            throw std::runtime_error("MatchingEngine: replicated sequence " + std::to_string(event.sequence)
+                + " does not follow " + std::to_string(sequence));
+        }
+
+        simulatedClock = true;
+        orderBook.setSimulatedTime(Timestamp{} + std::chrono::nanoseconds(event.timestampNs));
+
+        // Public calls open their own metrics scope; entries need one here
+        switch (event.action)
+        {
+        case ReplicatedAction::Submit:
+        {
+            MetricsUpdateScope metricsScope(metrics);
+            record(RejectReason::None);
+            enter(event.orderId, event.side, event.type, event.price, event.quantity, event.owner);
+            break;
+        }
+        case ReplicatedAction::Iceberg:
+            if constexpr (IcebergBookLike<Book>)
+            {
+                MetricsUpdateScope metricsScope(metrics);
+                record(RejectReason::None);
+                enterIceberg(event.orderId, event.side, event.price, event.quantity, event.displayQty, event.owner);
+            }
+            break;
+        case ReplicatedAction::Pegged:
+            if constexpr (PeggedBookLike<Book>)
+            {
+                MetricsUpdateScope metricsScope(metrics);
+                record(RejectReason::None);
+                enterPegged(event.orderId, event.side, static_cast<PegType>(event.mode), event.price, event.quantity, event.owner);
+            }
+            break;
+        case ReplicatedAction::Cancel:
+            (void)cancelOrder(event.orderId);
+            break;
+        case ReplicatedAction::CancelSide:
+            if constexpr (MassCancelBookLike<Book>)
+                (void)cancelSide(event.side);
+            break;
+        case ReplicatedAction::CancelPriceRange:
+            if constexpr (MassCancelBookLike<Book>)
+                (void)cancelPriceRange(event.side, event.price, event.high);
+            break;
+        case ReplicatedAction::CancelOwner:
+            if constexpr (MassCancelBookLike<Book>)
+                (void)cancelOwner(event.owner);
+            break;
+        case ReplicatedAction::SetTradingMode:
+            if constexpr (AuctionBookLike<Book>)
+                setTradingMode(static_cast<TradingMode>(event.mode));
+            break;
+        case ReplicatedAction::Uncross:
+            if constexpr (AuctionBookLike<Book>)
+                (void)uncross(event.price);
+            break;
+        }
+
+        // Unsupported actions and diverged books both land here
+        if (sequence != event.sequence)
+            throw std::runtime_error("MatchingEngine: replica diverged at sequence " + std::to_string(event.sequence));
+
+        highestReplicatedId = std::max(highestReplicatedId, event.orderId);
+    }
+
+    template <OrderBookLike Book>
+    size_t BasicMatchingEngine<Book>::followReplication(ReplicationSubscriber& subscriber)
+    {
+        std::array<ReplicationRecord, 256> batch;
+        const size_t count = subscriber.poll(batch);
+
+        for (size_t i = 0; i < count; ++i)
+            applyReplicated(batch[i]);
+
+        if (count > 0)
+            subscriber.acknowledge(sequence);
+        else if (subscriber.detached() && !subscriber.pending())
+            throw std::runtime_error("MatchingEngine: standby detached by the primary");
+
+        return count;
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::takeOver() noexcept
+    {
+        simulatedClock = false;
+        orderBook.useWallClock();
+        idAllocator.skipPast(highestReplicatedId);
+        engineIds.reset();
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::reportTrades() noexcept
+    {
+        if (tradeLog == nullptr)
+            return;
+
+        const std::vector<Trade>& trades = orderBook.getTrades();
+
+        for (; tradesReported < trades.size(); ++tradesReported)
+        {
+            const Trade& trade = trades[tradesReported];
+            tradeLog->log("FILL seq={} buy={} sell={} qty={} px={}",
+                trade.sequence,
+                trade.buyOrderId,
+                trade.sellOrderId,
+                trade.quantity,
+                trade.price);
+        }
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::attachTradeLog(AsyncLogger* logger) noexcept
+    {
+        // Only fills from here on
+        tradeLog = logger;
+        tradesReported = orderBook.getTrades().size();
+    }
+
+    template <OrderBookLike Book>
+    OrderIdAllocator& BasicMatchingEngine<Book>::getIdAllocator() noexcept
+    {
+        return idAllocator;
+    }
+
+    template <OrderBookLike Book>
+    uint64_t BasicMatchingEngine<Book>::getSequence() const noexcept
+    {
+        return sequence;
+    }
+
+    template <OrderBookLike Book>
+    bool BasicMatchingEngine<Book>::cancelOrder(uint64_t orderId)
+    {
+        MetricsUpdateScope metricsScope(metrics);
+        const EventTimeScope eventTime(*this);
+
+        if (!orderBook.cancelOrder(orderId))
+            return false;
+
+        ++sequence;
+        metrics.increment(Metric::OrdersCancelled);
+
+        replicate({ .orderId = orderId, .action = ReplicatedAction::Cancel }, eventTime.time());
+        return true;
+    }
+
+    template <OrderBookLike Book>
+    MassCancelResult BasicMatchingEngine<Book>::cancelSide(Side side) requires MassCancelBookLike<Book>
+    {
+        MetricsUpdateScope metricsScope(metrics);
+        const EventTimeScope eventTime(*this);
+        return recordMassCancel(orderBook.cancelSide(side),
+            { .action = ReplicatedAction::CancelSide, .side = side }, eventTime.time());
+    }
+
+    template <OrderBookLike Book>
+    MassCancelResult BasicMatchingEngine<Book>::cancelPriceRange(Side side,
+        double low,
+        double high) requires MassCancelBookLike<Book>
+    {
+        MetricsUpdateScope metricsScope(metrics);
+        const EventTimeScope eventTime(*this);
+        return recordMassCancel(orderBook.cancelPriceRange(side, low, high),
+            { .price = low, .high = high, .action = ReplicatedAction::CancelPriceRange, .side = side }, eventTime.time());
+    }
+
+    template <OrderBookLike Book>
+    MassCancelResult BasicMatchingEngine<Book>::cancelOwner(uint32_t owner) requires MassCancelBookLike<Book>
+    {
+        MetricsUpdateScope metricsScope(metrics);
+        const EventTimeScope eventTime(*this);
+        return recordMassCancel(orderBook.cancelOwner(owner),
+            { .owner = owner, .action = ReplicatedAction::CancelOwner }, eventTime.time());
+    }
+
+    template <OrderBookLike Book>
+    MassCancelResult BasicMatchingEngine<Book>::recordMassCancel(MassCancelResult result,
+        const ReplicationRecord& event,
+        Timestamp time)
+    {
+        if (result.orders > 0)
+        {
+            ++sequence;
+            metrics.increment(Metric::OrdersCancelled, result.orders);
+            replicate(event, time);
+        }
+
+        return result;
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::setTradingMode(TradingMode mode) requires AuctionBookLike<Book>
+    {
+        // Leaving an auction uncrosses, which fills orders
+        MetricsUpdateScope metricsScope(metrics);
+        const EventTimeScope eventTime(*this);
+        orderBook.setEventSequence(++sequence);
+        orderBook.setTradingMode(mode);
+        reportTrades();
+
+        replicate({ .action = ReplicatedAction::SetTradingMode, .mode = static_cast<uint8_t>(mode) }, eventTime.time());
+    }
+
+    template <OrderBookLike Book>
+    AuctionResult BasicMatchingEngine<Book>::uncross(double referencePrice) requires AuctionBookLike<Book>
+    {
+        MetricsUpdateScope metricsScope(metrics);
+        const EventTimeScope eventTime(*this);
+        orderBook.setEventSequence(++sequence);
+
+        const AuctionResult result = orderBook.uncross(referencePrice);
+        reportTrades();
+
+        replicate({ .price = referencePrice, .action = ReplicatedAction::Uncross }, eventTime.time());
+        return result;
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::enableDepthIndex(double tickSize)
+        requires requires(Book& book) { book.enableDepthIndex(tickSize); }
+    {
+        orderBook.enableDepthIndex(tickSize);
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::attachShadowFills(ShadowFillSimulator* simulator)
+        requires requires(Book& book) { book.attachShadowFills(simulator); }
+    {
+        orderBook.attachShadowFills(simulator);
+    }
+
+    template <OrderBookLike Book>
+    MemoryStats BasicMatchingEngine<Book>::memoryStats() const
+        requires requires(const Book& book) { book.memoryStats(); }
+    {
+        return orderBook.memoryStats();
+    }
+
+    template <OrderBookLike Book>
+    CompactionResult BasicMatchingEngine<Book>::compact(std::chrono::microseconds budget)
+        requires requires(Book& book) { book.compact(budget); }
+    {
+        return orderBook.compact(budget);
+    }
+
+    template <OrderBookLike Book>
+    RejectReason BasicMatchingEngine<Book>::getLastRejectReason() const noexcept
+    {
+        return lastRejectReason;
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::setRiskLimits(RiskLimits limits) noexcept
+    {
+        riskLimits = limits;
+    }
+
+    template <OrderBookLike Book>
+    const RiskLimits& BasicMatchingEngine<Book>::getRiskLimits() const noexcept
+    {
+        return riskLimits;
+    }
+
+    template <OrderBookLike Book>
+    RejectReason BasicMatchingEngine<Book>::validateSubmission(OrderType type,
+        double price,
+        uint64_t quantity) const noexcept
+    {
+        if (quantity == 0 || quantity > riskLimits.maxQuantity)
+            return RejectReason::InvalidQuantity;
+
+        if (type == OrderType::Market)
+        {
+            return riskLimits.allowMarketOrders
+                ? RejectReason::None
+                : RejectReason::MarketOrdersDisabled;
+        }
+
+        if (!validateOrder(price,
+            quantity,
+            riskLimits.maxPrice,
+            riskLimits.maxQuantity))
+            return RejectReason::InvalidPrice;
+
+        return RejectReason::None;
+    }
+
+    template <OrderBookLike Book>
+    const std::vector<Trade>& BasicMatchingEngine<Book>::getTrades() const
+    {
+        return orderBook.getTrades();
+    }
+
+  
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::printTopOfBook() const
+    {
+        orderBook.printTopOfBook();
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::printFullDepth() const
+    {
+        orderBook.printFullDepth();
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::logTopOfBook(AsyncLogger& logger) const
+    {
+        const double bid = orderBook.getBestBid();
+        const double ask = orderBook.getBestAsk();
+        const bool twoSided = bid != 0.0 && ask != 0.0;
+
+        logger.log("TOP bid={} ask={} spread={} mid={}",
+            bid,
+            ask,
+            twoSided ? ask - bid : 0.0,
+            twoSided ? (bid + ask) / 2.0 : 0.0);
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::logFullDepth(AsyncLogger& logger) const
+    {
+        for (const Side side : { Side::Sell, Side::Buy })
+        {
+            const char* label = (side == Side::Sell) ? "ASK" : "BID";
+
+            for (const DepthLevel& level : orderBook.getDepth(side))
+                logger.log("DEPTH {} px={} qty={} orders={}", label, level.price, level.volume, level.orderCount);
+        }
+    }
+
+    template <OrderBookLike Book>
+    const Book& BasicMatchingEngine<Book>::getOrderBook() const noexcept
+    {
+        return orderBook;
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::setSimulatedTime(Timestamp time) noexcept
+    {
+        simulatedClock = true;
+        orderBook.setSimulatedTime(time);
+    }
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::useWallClock() noexcept
+    {
+        simulatedClock = false;
+        orderBook.useWallClock();
+    }
+
+    template <OrderBookLike Book>
+    const MetricsRegistry& BasicMatchingEngine<Book>::getMetrics() const noexcept
+    {
+        return metrics;
+    }
+
+
+    template <OrderBookLike Book>
+    void BasicMatchingEngine<Book>::reset()
+    {
+        /*
+            Clears:
+                - Order book
+                - Trade history
+                - Resets order IDs and the event sequence
+                - Resets hot-path counters and the last reject reason
+
+            Useful for:
+                - Backtesting
+                - Simulation runs
+        */
+
+        orderBook.clear();
+        tradesReported = 0;
+        idAllocator.reset();
+        engineIds.reset();
+        sequence = 0;
+        highestReplicatedId = 0;
+        lastRejectReason = RejectReason::None;
+        metrics.reset();
+    }
+
+    // The default engine is compiled once in MatchingEngine.cpp
+    extern template class BasicMatchingEngine<OrderBook>;
+
 } // namespace hft
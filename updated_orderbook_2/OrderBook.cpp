@@ -1,5 +1,11 @@
 #include "OrderBook.hpp"
+#include "DepthIndex.hpp"
+#include "EngineMetrics.hpp"
+#include "ShadowFillSimulator.hpp"
 #include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
 
 
 //Implemented a price-time priority matching engine in modern C++ supporting depth aggregation, partial //fills, and VWAP tracking with exchange-realistic trade execution logic.
@@ -7,138 +13,1677 @@
 namespace hft
 {
 
+    namespace
+    {
+        // The feed is trusted to stay uncrossed, not to be well formed
+        bool validFeedPrice(double price) noexcept
+        {
+            return std::isfinite(price) && price > 0.0;
+        }
+
+        // Red-black tree node: three links and a colour word ahead of the value
+        template <typename Map>
+        size_t mapBytes(const Map& map) noexcept
+        {
+            return map.size() * (sizeof(typename Map::value_type) + 4 * sizeof(void*));
+        }
+
+        // Bucket array plus one singly linked node per element
+        template <typename Table>
+        size_t tableBytes(const Table& table) noexcept
+        {
+            return table.bucket_count() * sizeof(void*)
+                + table.size() * (sizeof(typename Table::value_type) + sizeof(void*));
+        }
+
+        template <typename Table>
+        size_t neededBuckets(const Table& table) noexcept
+        {
+            return static_cast<size_t>(std::ceil(static_cast<float>(table.size()) / table.max_load_factor()));
+        }
+
+        template <typename Table>
+        size_t tableSlackBytes(const Table& table) noexcept
+        {
+            const size_t needed = neededBuckets(table);
+            return table.bucket_count() > needed ? (table.bucket_count() - needed) * sizeof(void*) : 0;
+        }
+
+        // Shrinks a table left oversized by an earlier peak
+        template <typename Table>
+        size_t shrinkTable(Table& table)
+        {
+            const size_t before = table.bucket_count();
+
+            if (before > neededBuckets(table) * 2 + 8)
+                table.rehash(0);
+
+            return before > table.bucket_count() ? (before - table.bucket_count()) * sizeof(void*) : 0;
+        }
+    }
+
+    // Out of line so DepthIndex can stay incomplete in the header
+    OrderBook::OrderBook() = default;
+    OrderBook::~OrderBook() = default;
+    OrderBook::OrderBook(OrderBook&&) noexcept = default;
+    OrderBook& OrderBook::operator=(OrderBook&&) noexcept = default;
+
     void OrderBook::addOrder(Order order)
     {
-        if (order.type == OrderType::Market)
+        // Side is resolved once; everything below is side-specialized
+        if (order.side == Side::Buy)
+            addOrder<Side::Buy>(order, 0);
+        else
+            addOrder<Side::Sell>(order, 0);
+
+        // A new lit best can give resting mid pegs the reference they lacked
+        matchMidPegs();
+    }
+
+    void OrderBook::addIceberg(Order order, uint64_t displayQty)
+    {
+        if (order.type != OrderType::Limit || displayQty >= order.quantity)
+            displayQty = 0;
+
+        if (order.side == Side::Buy)
+            addOrder<Side::Buy>(order, displayQty);
+        else
+            addOrder<Side::Sell>(order, displayQty);
+
+        matchMidPegs();
+    }
+
+    template <Side S>
+    void OrderBook::addOrder(Order& order, uint64_t displayQty)
+    {
+        if (tradingMode == TradingMode::Auction)
+        {
+            // Call period: collect only, the book may cross
+            if (order.type == OrderType::Market)
+                restMarket<S>(order);
+            else
+                rest<S>(order, displayQty);
+
+            return;
+        }
+
+        if (order.type == OrderType::Market)
+        {
+            // Unfilled market quantity is discarded
+            sweep<S, OrderType::Market>(order);
+            return;
+        }
+
+        // Fast path: most limit orders do not cross on arrival
+        constexpr Side P = SideTraits<S>::opposite;
+        const auto& passive = book<P>();
+        if ((!passive.empty() && SideTraits<S>::crosses(order.price, passive.begin()->first))
+            || crossesPegs<P>(order.price))
+        {
+            sweep<S, OrderType::Limit>(order);
+
+            if (order.quantity == 0)
+                return;
+        }
+
+        if (shadows)
+            shadows->onRest(S, order.price, order.quantity);
+
+        rest<S>(order, displayQty);
+    }
+
+    // ============================================================
+    // SWEEP (CORE ENGINE LOGIC)
+    // ============================================================
+
+    template <Side S, OrderType T>
+    void OrderBook::sweep(Order& aggressor)
+    {
+        /*
+            Matching logic:
+
+            While the aggressor has quantity and crosses
+            the best opposite level:
+                - fill FIFO within the level
+                - drop the level once empty
+
+            Trades print at the ask (see SideTraits::tradePrice).
+            The book is never crossed at rest, so matching an
+            incoming order before resting it is equivalent to
+            resting it first and then uncrossing.
+
+            Pegged levels join through nextPassive(), priced from
+            references read once here, before anything trades.
+        */
+
+        using Traits = SideTraits<S>;
+
+        auto& passive = book<Traits::opposite>();
+        const PegQuotes quotes = pegQuotes<Traits::opposite>();
+        Timestamp time{};
+        uint64_t levelsTouched = 0;
+
+        while (aggressor.quantity > 0)
+        {
+            const PassiveLevel next = nextPassive<Traits::opposite>(quotes);
+            if (!next.level)
+                break;
+
+            const double passivePrice = next.price;
+            const bool lit = next.group == nullptr;
+
+            if constexpr (T == OrderType::Limit)
+            {
+                if (!Traits::crosses(aggressor.price, passivePrice))
+                    break;
+            }
+
+            const double tradePrice =
+                Traits::template tradePrice<T>(aggressor.price, passivePrice);
+
+            // All fills of one aggressor share one timestamp,
+            // read only once something actually trades
+            if (levelsTouched++ == 0)
+                time = currentTime();
+
+            PriceLevel& level = *next.level;
+            uint64_t levelFilled = 0;
+
+            while (aggressor.quantity > 0 && !level.empty())
+            {
+                const RestingOrder& resting = level.front();
+                const uint64_t tradeQty = std::min(aggressor.quantity, resting.quantity);
+
+                recordTrade(Traits::makeTrade(aggressor.id,
+                    resting.id,
+                    tradePrice,
+                    tradeQty,
+                    time,
+                    eventSequence));
+
+                if (shadows && lit)
+                    shadows->onFill(Traits::opposite, passivePrice, level.base + level.head, tradeQty);
+
+                aggressor.quantity -= tradeQty;
+                levelFilled += tradeQty;
+                onFrontReduced(level, tradeQty);
+            }
+
+            // One index update per level, not per fill (refills add their own)
+            if (depthIndex && lit)
+                depthIndex->remove(Traits::opposite, passivePrice, levelFilled);
+
+            if (level.empty())
+            {
+                if (lit)
+                {
+                    onLevelErased(Traits::opposite, passivePrice, level);
+                    passive.erase(passive.begin());
+                }
+                else
+                {
+                    next.group->erase(next.group->begin());
+                }
+            }
+        }
+
+        if (levelsTouched > 0)
+            onSweepFinished(levelsTouched);
+    }
+
+    template <Side S>
+    void OrderBook::rest(const Order& order, uint64_t displayQty)
+    {
+        auto [it, created] = book<S>().try_emplace(order.price);
+        PriceLevel& level = it->second;
+
+        if (created)
+            onLevelCreated(level);
+
+        // An iceberg shows its first tranche; what is left of it may be smaller
+        const uint64_t shown = (displayQty > 0) ? std::min(displayQty, order.quantity) : order.quantity;
+        const uint64_t hidden = order.quantity - shown;
+
+        const OrderHandle handle = store.allocate({
+            order.originalQty,
+            order.price,
+            order.timestamp,
+            0,
+            order.owner,
+            order.side,
+            order.type,
+            PegType::None,
+            NO_ORDER_HANDLE,
+            NO_ORDER_HANDLE,
+            hidden > 0 ? displayQty : 0,
+            hidden
+            });
+
+        store[handle].queueSlot = level.addOrder({ order.id, shown, handle, order.owner });
+        level.hiddenVolume += hidden;
+        orderIndex.emplace(order.id, handle);
+
+        if (order.owner != 0)
+            linkOwner(handle, order.owner);
+
+        if (depthIndex)
+            depthIndex->add(S, order.price, shown);
+
+        if (metrics)
+        {
+            metrics->setMax(Metric::MaxQueueLength, level.size());
+            metrics->set(Metric::OrderPoolOccupancy, store.size());
+        }
+    }
+
+    template <Side S>
+    void OrderBook::restMarket(const Order& order)
+    {
+        PriceLevel& queue = marketQueue<S>();
+
+        const OrderHandle handle = store.allocate({
+            order.originalQty,
+            order.price,
+            order.timestamp,
+            0,
+            order.owner,
+            order.side,
+            order.type
+            });
+
+        store[handle].queueSlot = queue.addOrder({ order.id, order.quantity, handle, order.owner });
+        orderIndex.emplace(order.id, handle);
+
+        if (order.owner != 0)
+            linkOwner(handle, order.owner);
+
+        if (metrics)
+            metrics->set(Metric::OrderPoolOccupancy, store.size());
+    }
+
+    // ============================================================
+    // CANCEL
+    // ============================================================
+
+    bool OrderBook::cancelOrder(uint64_t orderId)
+    {
+        const auto it = orderIndex.find(orderId);
+        if (it == orderIndex.end())
+            return false;
+
+        const OrderHandle handle = it->second;
+        orderIndex.erase(it);
+
+        if (store[handle].side == Side::Buy)
+            return cancelResting<Side::Buy>(handle);
+
+        return cancelResting<Side::Sell>(handle);
+    }
+
+    template <Side S>
+    bool OrderBook::cancelResting(OrderHandle handle)
+    {
+        const OrderDetails& details = store[handle];
+
+        // Only call-period market orders rest with type Market
+        if (details.type == OrderType::Market)
+        {
+            marketQueue<S>().cancel(details.queueSlot);
+            releaseOrder(handle, details.owner);
+
+            if (metrics)
+                metrics->set(Metric::OrderPoolOccupancy, store.size());
+
+            return true;
+        }
+
+        if (details.peg != PegType::None)
+        {
+            // Undisplayed: no depth index, shadow or L2 side effects
+            PegGroup& group = pegGroup<S>(details.peg);
+            const auto levelIt = group.find(details.price);
+
+            levelIt->second.cancel(details.queueSlot);
+            releaseOrder(handle, details.owner);
+
+            if (levelIt->second.empty())
+                group.erase(levelIt);
+
+            if (metrics)
+                metrics->set(Metric::OrderPoolOccupancy, store.size());
+
+            return true;
+        }
+
+        auto& side = book<S>();
+
+        // A displayed order's level lives until its last order leaves
+        const auto levelIt = side.find(details.price);
+        assert(levelIt != side.end());
+
+        PriceLevel& level = levelIt->second;
+        const uint64_t remaining = level.cancel(details.queueSlot);
+        level.hiddenVolume -= details.hiddenQty;
+
+        if (depthIndex)
+            depthIndex->remove(S, details.price, remaining);
+
+        if (shadows)
+            shadows->onCancel(S, details.price, details.queueSlot, remaining);
+
+        releaseOrder(handle, details.owner);
+
+        if (level.empty())
+        {
+            onLevelErased(S, levelIt->first, level);
+            side.erase(levelIt);
+        }
+
+        if (metrics)
+            metrics->set(Metric::OrderPoolOccupancy, store.size());
+
+        return true;
+    }
+
+    // ============================================================
+    // FEED MIRROR
+    // ============================================================
+
+    bool OrderBook::restOrder(const Order& order)
+    {
+        if (order.type != OrderType::Limit || order.quantity == 0 || !validFeedPrice(order.price)
+            || orderIndex.contains(order.id))
+            return false;
+
+        if (shadows)
+            shadows->onRest(order.side, order.price, order.quantity);
+
+        if (order.side == Side::Buy)
+            rest<Side::Buy>(order, 0);
+        else
+            rest<Side::Sell>(order, 0);
+
+        return true;
+    }
+
+    bool OrderBook::executeOrder(uint64_t orderId, uint64_t quantity)
+    {
+        const OrderHandle handle = findMirrored(orderId);
+        if (handle == NO_ORDER_HANDLE || quantity == 0)
+            return false;
+
+        if (store[handle].side == Side::Buy)
+            reduceResting<Side::Buy>(handle, quantity, true);
+        else
+            reduceResting<Side::Sell>(handle, quantity, true);
+
+        return true;
+    }
+
+    bool OrderBook::modifyOrder(uint64_t orderId, double price, uint64_t quantity)
+    {
+        const OrderHandle handle = findMirrored(orderId);
+        if (handle == NO_ORDER_HANDLE)
+            return false;
+
+        if (quantity == 0)
+            return cancelOrder(orderId);
+
+        if (!validFeedPrice(price))
+            return false;
+
+        if (store[handle].side == Side::Buy)
+            modifyResting<Side::Buy>(handle, price, quantity);
+        else
+            modifyResting<Side::Sell>(handle, price, quantity);
+
+        return true;
+    }
+
+    OrderHandle OrderBook::findMirrored(uint64_t orderId) const noexcept
+    {
+        const auto it = orderIndex.find(orderId);
+        if (it == orderIndex.end())
+            return NO_ORDER_HANDLE;
+
+        const OrderDetails& details = store[it->second];
+
+        const bool plain = details.type == OrderType::Limit
+            && details.peg == PegType::None
+            && details.hiddenQty == 0;
+
+        return plain ? it->second : NO_ORDER_HANDLE;
+    }
+
+    template <Side S>
+    void OrderBook::reduceResting(OrderHandle handle, uint64_t quantity, bool executed)
+    {
+        const OrderDetails& details = store[handle];
+        const double price = details.price;
+        const uint64_t slot = details.queueSlot;
+
+        auto& side = book<S>();
+        const auto levelIt = side.find(price);
+        PriceLevel& level = levelIt->second;
+
+        const RestingOrder order = level.at(slot);
+        const uint64_t reduced = std::min(quantity, order.quantity);
+
+        if (depthIndex)
+            depthIndex->remove(S, price, reduced);
+
+        // Fills advance shadow queues; reductions behind them do not
+        if (shadows)
+        {
+            if (executed)
+                shadows->onFill(S, price, slot, reduced);
+            else
+                shadows->onCancel(S, price, slot, reduced);
+        }
+
+        if (reduced < order.quantity)
+        {
+            level.reduce(slot, reduced);
+            return;
+        }
+
+        level.cancel(slot);
+        orderIndex.erase(order.id);
+        releaseOrder(handle, order.owner);
+
+        if (level.empty())
+        {
+            onLevelErased(S, price, level);
+            side.erase(levelIt);
+        }
+
+        if (metrics)
+            metrics->set(Metric::OrderPoolOccupancy, store.size());
+    }
+
+    template <Side S>
+    void OrderBook::modifyResting(OrderHandle handle, double price, uint64_t quantity)
+    {
+        const OrderDetails& details = store[handle];
+        const RestingOrder current = book<S>().find(details.price)->second.at(details.queueSlot);
+
+        if (price == details.price && quantity <= current.quantity)
+        {
+            if (quantity < current.quantity)
+                reduceResting<S>(handle, current.quantity - quantity, false);
+
+            return;
+        }
+
+        // Priority is lost: out, then back in at the tail of the new level
+        Order order(current.id, S, OrderType::Limit, price, quantity, currentTime());
+        order.owner = current.owner;
+
+        orderIndex.erase(current.id);
+        (void)cancelResting<S>(handle);
+        (void)restOrder(order);
+    }
+
+    // ============================================================
+    // MASS CANCEL
+    // ============================================================
+
+    MassCancelResult OrderBook::cancelSide(Side side)
+    {
+        MassCancelResult result;
+
+        if (side == Side::Buy)
+        {
+            cancelLevels<Side::Buy>(bids.begin(), bids.end(), result);
+            cancelMarketQueue<Side::Buy>(result);
+            cancelPegGroups<Side::Buy>(result);
+        }
+        else
+        {
+            cancelLevels<Side::Sell>(asks.begin(), asks.end(), result);
+            cancelMarketQueue<Side::Sell>(result);
+            cancelPegGroups<Side::Sell>(result);
+        }
+
+        if (metrics)
+            metrics->set(Metric::OrderPoolOccupancy, store.size());
+
+        return result;
+    }
+
+    MassCancelResult OrderBook::cancelPriceRange(Side side, double low, double high)
+    {
+        MassCancelResult result;
+
+        if (!(low <= high))
+            return result;
+
+        if (side == Side::Buy)
+            cancelPriceRange<Side::Buy>(low, high, result);
+        else
+            cancelPriceRange<Side::Sell>(low, high, result);
+
+        if (metrics)
+            metrics->set(Metric::OrderPoolOccupancy, store.size());
+
+        return result;
+    }
+
+    template <Side S>
+    void OrderBook::cancelPriceRange(double low, double high, MassCancelResult& result)
+    {
+        // Iteration order is best first: high..low for bids, low..high for asks
+        auto& side = book<S>();
+        const typename SideTraits<S>::Compare before;
+
+        const double nearEnd = before(low, high) ? low : high;
+        const double farEnd = before(low, high) ? high : low;
+
+        cancelLevels<S>(side.lower_bound(nearEnd), side.upper_bound(farEnd), result);
+    }
+
+    template <Side S>
+    void OrderBook::cancelLevels(typename BookSide<S>::iterator first,
+        typename BookSide<S>::iterator last,
+        MassCancelResult& result)
+    {
+        // Whole levels go at once: no per-order queue maintenance
+        for (auto it = first; it != last; ++it)
+        {
+            PriceLevel& level = it->second;
+
+            for (size_t i = level.head; i < level.orders.size(); ++i)
+            {
+                const RestingOrder& order = level.orders[i];
+                if (order.quantity == 0)
+                    continue;
+
+                orderIndex.erase(order.id);
+                releaseOrder(order.handle, order.owner);
+            }
+
+            result.orders += level.liveOrders;
+            result.quantity += level.totalVolume + level.hiddenVolume;
+            result.levels.push_back({ S, it->first, 0, 0 });
+
+            if (depthIndex)
+                depthIndex->remove(S, it->first, level.totalVolume);
+
+            onLevelErased(S, it->first, level);
+        }
+
+        book<S>().erase(first, last);
+    }
+
+    template <Side S>
+    void OrderBook::cancelMarketQueue(MassCancelResult& result)
+    {
+        const PriceLevel& queue = marketQueue<S>();
+
+        result.orders += queue.liveOrders;
+        result.quantity += queue.totalVolume;
+
+        discardMarketQueue<S>();
+    }
+
+    MassCancelResult OrderBook::cancelOwner(uint32_t owner)
+    {
+        /*
+            The owner's list is detached whole, then walked once.
+            Each order leaves its level individually (other owners
+            may share it), but emptied levels are erased and the L2
+            update is emitted once per touched level at the end.
+        */
+
+        MassCancelResult result;
+
+        const auto listIt = owners.find(owner);
+        if (listIt == owners.end())
+            return result;
+
+        OrderHandle handle = listIt->second.head;
+        owners.erase(listIt);
+
+        // Prices of levels touched; an owner's consecutive orders
+        // often share a level, so repeats are dropped on the way in
+        std::vector<double> touchedBids;
+        std::vector<double> touchedAsks;
+
+        while (handle != NO_ORDER_HANDLE)
+        {
+            const OrderDetails& details = store[handle];
+            const OrderHandle next = details.ownerNext;
+            const double price = details.price;
+            const bool resting = details.type == OrderType::Limit && details.peg == PegType::None;
+            const Side side = details.side;
+            const uint64_t hidden = details.hiddenQty;
+
+            const uint64_t remaining = (side == Side::Buy)
+                ? cancelOwned<Side::Buy>(handle)
+                : cancelOwned<Side::Sell>(handle);
+
+            ++result.orders;
+            result.quantity += remaining + hidden;
+            handle = next;
+
+            if (!resting)
+                continue;
+
+            if (depthIndex)
+                depthIndex->remove(side, price, remaining);
+
+            std::vector<double>& touched = (side == Side::Buy) ? touchedBids : touchedAsks;
+            if (touched.empty() || touched.back() != price)
+                touched.push_back(price);
+        }
+
+        settleLevels<Side::Buy>(touchedBids, result);
+        settleLevels<Side::Sell>(touchedAsks, result);
+
+        if (metrics)
+            metrics->set(Metric::OrderPoolOccupancy, store.size());
+
+        return result;
+    }
+
+    template <Side S>
+    uint64_t OrderBook::cancelOwned(OrderHandle handle)
+    {
+        // Already unlinked from its owner list by cancelOwner()
+        const OrderDetails& details = store[handle];
+
+        if (details.peg != PegType::None)
+        {
+            // Peg levels are settled here: they have no L2 update
+            PegGroup& group = pegGroup<S>(details.peg);
+            const auto levelIt = group.find(details.price);
+
+            orderIndex.erase(levelIt->second.at(details.queueSlot).id);
+            const uint64_t remaining = levelIt->second.cancel(details.queueSlot);
+
+            if (levelIt->second.empty())
+                group.erase(levelIt);
+
+            store.release(handle);
+            return remaining;
+        }
+
+        PriceLevel& queue = (details.type == OrderType::Market)
+            ? marketQueue<S>()
+            : book<S>().find(details.price)->second;
+
+        orderIndex.erase(queue.at(details.queueSlot).id);
+        const uint64_t remaining = queue.cancel(details.queueSlot);
+        queue.hiddenVolume -= details.hiddenQty;
+
+        if (shadows && details.type == OrderType::Limit)
+            shadows->onCancel(S, details.price, details.queueSlot, remaining);
+
+        store.release(handle);
+        return remaining;
+    }
+
+    template <Side S>
+    void OrderBook::settleLevels(std::vector<double>& touched, MassCancelResult& result)
+    {
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+        auto& side = book<S>();
+
+        for (const double price : touched)
+        {
+            const auto levelIt = side.find(price);
+            PriceLevel& level = levelIt->second;
+
+            result.levels.push_back({ S, price, level.totalVolume, level.size() });
+
+            if (level.empty())
+            {
+                onLevelErased(S, price, level);
+                side.erase(levelIt);
+            }
+        }
+    }
+
+    // ============================================================
+    // OWNER LISTS
+    // ============================================================
+
+    void OrderBook::linkOwner(OrderHandle handle, uint32_t owner)
+    {
+        // Appended, so cancelOwner() walks the store in allocation order
+        const auto [it, first] = owners.try_emplace(owner, OwnerList{ handle, handle });
+
+        if (first)
+            return;
+
+        store[handle].ownerPrev = it->second.tail;
+        store[it->second.tail].ownerNext = handle;
+        it->second.tail = handle;
+    }
+
+    void OrderBook::releaseOrder(OrderHandle handle, uint32_t owner)
+    {
+        if (owner != 0)
+        {
+            const OrderDetails& details = store[handle];
+            const OrderHandle prev = details.ownerPrev;
+            const OrderHandle next = details.ownerNext;
+
+            if (prev != NO_ORDER_HANDLE && next != NO_ORDER_HANDLE)
+            {
+                // Interior: the list entry is untouched
+                store[prev].ownerNext = next;
+                store[next].ownerPrev = prev;
+            }
+            else
+            {
+                const auto it = owners.find(owner);
+
+                if (prev == NO_ORDER_HANDLE && next == NO_ORDER_HANDLE)
+                {
+                    owners.erase(it);
+                }
+                else if (prev == NO_ORDER_HANDLE)
+                {
+                    store[next].ownerPrev = NO_ORDER_HANDLE;
+                    it->second.head = next;
+                }
+                else
+                {
+                    store[prev].ownerNext = NO_ORDER_HANDLE;
+                    it->second.tail = prev;
+                }
+            }
+        }
+
+        store.release(handle);
+    }
+
+    // ============================================================
+    // CALL AUCTION
+    // ============================================================
+
+    void OrderBook::setTradingMode(TradingMode mode)
+    {
+        if (mode == tradingMode)
+            return;
+
+        if (mode == TradingMode::Continuous)
+            (void)uncross();
+
+        tradingMode = mode;
+
+        // Mid pegs that met during the call period trade on reopening
+        matchMidPegs();
+    }
+
+    TradingMode OrderBook::getTradingMode() const noexcept
+    {
+        return tradingMode;
+    }
+
+    AuctionResult OrderBook::indicativeUncross(double referencePrice) const
+    {
+        /*
+            Equilibrium price selection:
+
+            One ascending pass over the union of bid and ask prices
+            keeps two running sums:
+                supply(p) = market sells + asks priced <= p
+                demand(p) = market buys  + bids priced >= p
+            so every candidate is scored in O(1) and the whole
+            search is O(levels), independent of order count.
+
+            Among candidates, in order:
+                1. maximum executable volume min(demand, supply)
+                2. minimum surplus |demand - supply|
+                3. market pressure: all surplus on the buy side
+                   picks the highest price, all on the sell side
+                   the lowest
+                4. closest to the reference price (last trade when
+                   none is given, else the middle of the tied range)
+        */
+
+        struct Candidate
+        {
+            double price;
+            uint64_t demand;
+            uint64_t supply;
+        };
+
+        const uint64_t marketDemand = buyMarketQueue.totalVolume;
+        uint64_t totalDemand = marketDemand;
+        // Iceberg reserve executes in an uncross, so it counts here
+        for (const auto& [price, level] : bids)
+            totalDemand += level.totalVolume + level.hiddenVolume;
+
+        uint64_t supply = sellMarketQueue.totalVolume;
+        uint64_t demandBelow = 0;
+
+        uint64_t bestVolume = 0;
+        uint64_t bestSurplus = 0;
+        std::vector<Candidate> tied;
+
+        auto askIt = asks.begin();
+        auto bidIt = bids.rbegin();
+
+        while (askIt != asks.end() || bidIt != bids.rend())
+        {
+            double price;
+            if (askIt == asks.end())
+                price = bidIt->first;
+            else if (bidIt == bids.rend())
+                price = askIt->first;
+            else
+                price = std::min(askIt->first, bidIt->first);
+
+            for (; askIt != asks.end() && askIt->first <= price; ++askIt)
+                supply += askIt->second.totalVolume + askIt->second.hiddenVolume;
+
+            const uint64_t demand = totalDemand - demandBelow;
+            const uint64_t volume = std::min(demand, supply);
+            const uint64_t surplus = (demand > supply) ? demand - supply : supply - demand;
+
+            if (volume > 0)
+            {
+                if (volume > bestVolume || (volume == bestVolume && surplus < bestSurplus))
+                {
+                    bestVolume = volume;
+                    bestSurplus = surplus;
+                    tied.clear();
+                }
+
+                if (volume == bestVolume && surplus == bestSurplus)
+                    tied.push_back({ price, demand, supply });
+            }
+
+            for (; bidIt != bids.rend() && bidIt->first <= price; ++bidIt)
+                demandBelow += bidIt->second.totalVolume + bidIt->second.hiddenVolume;
+        }
+
+        if (tied.empty())
+            return {};
+
+        const bool allBuySurplus = std::all_of(tied.begin(), tied.end(),
+            [](const Candidate& c) { return c.demand > c.supply; });
+        const bool allSellSurplus = std::all_of(tied.begin(), tied.end(),
+            [](const Candidate& c) { return c.supply > c.demand; });
+
+        // Candidates are in ascending price order
+        const Candidate* chosen = nullptr;
+
+        if (allBuySurplus)
+        {
+            chosen = &tied.back();
+        }
+        else if (allSellSurplus)
+        {
+            chosen = &tied.front();
+        }
+        else
+        {
+            double reference = referencePrice;
+            if (reference <= 0.0)
+            {
+                reference = trades.empty()
+                    ? (tied.front().price + tied.back().price) / 2.0
+                    : trades.back().price;
+            }
+
+            // Nearest to the reference; the lower price wins exact ties
+            for (const Candidate& candidate : tied)
+            {
+                if (!chosen
+                    || std::abs(candidate.price - reference) < std::abs(chosen->price - reference))
+                    chosen = &candidate;
+            }
+        }
+
+        AuctionResult result;
+        result.price = chosen->price;
+        result.volume = bestVolume;
+        result.buySurplus = chosen->demand - bestVolume;
+        result.sellSurplus = chosen->supply - bestVolume;
+        return result;
+    }
+
+    AuctionResult OrderBook::uncross(double referencePrice)
+    {
+        const AuctionResult result = indicativeUncross(referencePrice);
+
+        if (result.volume > 0)
+            executeUncross(result);
+
+        // Market orders never outlive the auction they joined
+        discardMarketQueue<Side::Buy>();
+        discardMarketQueue<Side::Sell>();
+
+        return result;
+    }
+
+    void OrderBook::executeUncross(const AuctionResult& result)
+    {
+        /*
+            Both sides are consumed in priority order: market
+            orders first, then levels from best towards the
+            auction price, FIFO within each. The volume bound
+            guarantees every level reached crosses the price,
+            and leaves the residual book uncrossed.
+        */
+
+        const Timestamp time = currentTime();
+        uint64_t remaining = result.volume;
+        uint64_t levelsTouched = 0;
+
+        while (remaining > 0)
+        {
+            const bool buyFromMarket = !buyMarketQueue.empty();
+            const bool sellFromMarket = !sellMarketQueue.empty();
+
+            PriceLevel& buyLevel = buyFromMarket ? buyMarketQueue : bids.begin()->second;
+            PriceLevel& sellLevel = sellFromMarket ? sellMarketQueue : asks.begin()->second;
+
+            const RestingOrder& buy = buyLevel.front();
+            const RestingOrder& sell = sellLevel.front();
+            const uint64_t qty = std::min({ remaining, buy.quantity, sell.quantity });
+
+            recordTrade({ buy.id, sell.id, result.price, qty, time, eventSequence });
+            remaining -= qty;
+
+            if (shadows)
+            {
+                if (!buyFromMarket)
+                    shadows->onFill(Side::Buy, bids.begin()->first, buyLevel.base + buyLevel.head, qty);
+                if (!sellFromMarket)
+                    shadows->onFill(Side::Sell, asks.begin()->first, sellLevel.base + sellLevel.head, qty);
+            }
+
+            onFrontReduced(buyLevel, qty);
+            onFrontReduced(sellLevel, qty);
+
+            if (depthIndex)
+            {
+                if (!buyFromMarket)
+                    depthIndex->remove(Side::Buy, bids.begin()->first, qty);
+                if (!sellFromMarket)
+                    depthIndex->remove(Side::Sell, asks.begin()->first, qty);
+            }
+
+            if (!buyFromMarket && buyLevel.empty())
+            {
+                onLevelErased(Side::Buy, bids.begin()->first, buyLevel);
+                bids.erase(bids.begin());
+                ++levelsTouched;
+            }
+
+            if (!sellFromMarket && sellLevel.empty())
+            {
+                onLevelErased(Side::Sell, asks.begin()->first, sellLevel);
+                asks.erase(asks.begin());
+                ++levelsTouched;
+            }
+        }
+
+        onSweepFinished(levelsTouched);
+    }
+
+    template <Side S>
+    void OrderBook::discardMarketQueue()
+    {
+        PriceLevel& queue = marketQueue<S>();
+
+        for (size_t i = queue.head; i < queue.orders.size(); ++i)
+        {
+            const RestingOrder& order = queue.orders[i];
+            if (order.quantity == 0)
+                continue;
+
+            orderIndex.erase(order.id);
+            releaseOrder(order.handle, order.owner);
+        }
+
+        queue.orders.clear();
+        queue.head = 0;
+        queue.base = 0;
+        queue.liveOrders = 0;
+        queue.totalVolume = 0;
+
+        if (metrics)
+            metrics->set(Metric::OrderPoolOccupancy, store.size());
+    }
+
+    // ============================================================
+    // PEGGED ORDERS
+    // ============================================================
+
+    void OrderBook::addPegged(Order order, PegType peg, double offset)
+    {
+        if (peg == PegType::None || order.type != OrderType::Limit)
+        {
+            addOrder(std::move(order));
+            return;
+        }
+
+        if (order.side == Side::Buy)
+            restPegged<Side::Buy>(order, peg, offset);
+        else
+            restPegged<Side::Sell>(order, peg, offset);
+
+        matchMidPegs();
+    }
+
+    template <Side S>
+    void OrderBook::restPegged(const Order& order, PegType peg, double offset)
+    {
+        /*
+            Never marketable on arrival: a peg rests at or behind
+            the lit touch of its own side, and the lit book is
+            uncrossed. The one exception, zero-offset mid pegs
+            meeting at the mid, is settled by matchMidPegs().
+        */
+
+        auto [it, created] = pegGroup<S>(peg).try_emplace(offset);
+        PriceLevel& level = it->second;
+
+        const OrderHandle handle = store.allocate({
+            order.originalQty,
+            offset,
+            order.timestamp,
+            0,
+            order.owner,
+            order.side,
+            order.type,
+            peg
+            });
+
+        store[handle].queueSlot = level.addOrder({ order.id, order.quantity, handle, order.owner });
+        orderIndex.emplace(order.id, handle);
+
+        if (order.owner != 0)
+            linkOwner(handle, order.owner);
+
+        if (metrics)
+            metrics->set(Metric::OrderPoolOccupancy, store.size());
+    }
+
+    template <Side S>
+    bool OrderBook::pegReference(PegType peg, double& reference) const noexcept
+    {
+        if (peg == PegType::Primary)
         {
-            executeMarketOrder(std::move(order));
+            if (book<S>().empty())
+                return false;
+
+            reference = book<S>().begin()->first;
+            return true;
+        }
+
+        if (bids.empty() || asks.empty())
+            return false;
+
+        reference = (bids.begin()->first + asks.begin()->first) / 2.0;
+        return true;
+    }
+
+    template <Side S>
+    OrderBook::PegQuotes OrderBook::pegQuotes() const noexcept
+    {
+        PegQuotes quotes;
+
+        if (!pegGroup<S>(PegType::Primary).empty())
+            quotes.primary = pegReference<S>(PegType::Primary, quotes.primaryReference);
+
+        if (!pegGroup<S>(PegType::Mid).empty())
+            quotes.mid = pegReference<S>(PegType::Mid, quotes.midReference);
+
+        return quotes;
+    }
+
+    template <Side S>
+    OrderBook::PassiveLevel OrderBook::nextPassive(const PegQuotes& quotes) noexcept
+    {
+        PassiveLevel next;
+
+        auto& lit = book<S>();
+        if (!lit.empty())
+            next = { &lit.begin()->second, lit.begin()->first, nullptr };
+
+        // Strictly better only: ties keep lit, then primary, then mid
+        const typename SideTraits<S>::Compare better;
+
+        auto consider = [&](PegGroup& group, bool active, double reference)
+            {
+                if (!active || group.empty())
+                    return;
+
+                const double price = pegPrice<S>(reference, group.begin()->first);
+
+                // Buy offsets past the reference would trade for nothing;
+                // farther offsets in the group only price lower
+                if (price <= 0.0)
+                    return;
+
+                if (!next.level || better(price, next.price))
+                    next = { &group.begin()->second, price, &group };
+            };
+
+        consider(pegGroup<S>(PegType::Primary), quotes.primary, quotes.primaryReference);
+        consider(pegGroup<S>(PegType::Mid), quotes.mid, quotes.midReference);
+
+        return next;
+    }
+
+    template <Side S>
+    bool OrderBook::crossesPegs(double price) noexcept
+    {
+        if (pegGroup<S>(PegType::Primary).empty() && pegGroup<S>(PegType::Mid).empty())
+            return false;
+
+        const PassiveLevel next = nextPassive<S>(pegQuotes<S>());
+
+        return next.group != nullptr
+            && SideTraits<SideTraits<S>::opposite>::crosses(price, next.price);
+    }
+
+    void OrderBook::matchMidPegs()
+    {
+        /*
+            Every other peg rests strictly behind the opposite lit
+            touch, so only zero-offset mid pegs on both sides can
+            meet. They trade at the mid, FIFO on both sides.
+        */
+
+        if (tradingMode != TradingMode::Continuous
+            || buyMidPegs.empty() || sellMidPegs.empty()
+            || buyMidPegs.begin()->first != 0.0 || sellMidPegs.begin()->first != 0.0)
+            return;
+
+        double mid = 0.0;
+        if (!pegReference<Side::Buy>(PegType::Mid, mid))
             return;
+
+        PriceLevel& buys = buyMidPegs.begin()->second;
+        PriceLevel& sells = sellMidPegs.begin()->second;
+        const Timestamp time = currentTime();
+
+        while (!buys.empty() && !sells.empty())
+        {
+            const RestingOrder& buy = buys.front();
+            const RestingOrder& sell = sells.front();
+            const uint64_t qty = std::min(buy.quantity, sell.quantity);
+
+            recordTrade({ buy.id, sell.id, mid, qty, time, eventSequence });
+
+            onFrontReduced(buys, qty);
+            onFrontReduced(sells, qty);
         }
 
-        if (order.side == Side::Buy)
+        if (buys.empty())
+            buyMidPegs.erase(buyMidPegs.begin());
+
+        if (sells.empty())
+            sellMidPegs.erase(sellMidPegs.begin());
+
+        onSweepFinished(1);
+    }
+
+    template <Side S>
+    void OrderBook::cancelPegGroups(MassCancelResult& result)
+    {
+        for (PegGroup* group : { &pegGroup<S>(PegType::Primary), &pegGroup<S>(PegType::Mid) })
         {
-            const double price = order.price;
-            bids[price].addOrder(std::move(order));
+            for (auto& [offset, level] : *group)
+            {
+                for (size_t i = level.head; i < level.orders.size(); ++i)
+                {
+                    const RestingOrder& order = level.orders[i];
+                    if (order.quantity == 0)
+                        continue;
+
+                    orderIndex.erase(order.id);
+                    releaseOrder(order.handle, order.owner);
+                }
+
+                result.orders += level.liveOrders;
+                result.quantity += level.totalVolume;
+            }
+
+            group->clear();
         }
+    }
+
+    std::vector<DepthLevel> OrderBook::getPegDepth(Side side, PegType peg) const
+    {
+        std::vector<DepthLevel> depth;
+
+        if (peg == PegType::None)
+            return depth;
+
+        if (side == Side::Buy)
+            appendPegDepth<Side::Buy>(depth, peg);
         else
+            appendPegDepth<Side::Sell>(depth, peg);
+
+        return depth;
+    }
+
+    template <Side S>
+    void OrderBook::appendPegDepth(std::vector<DepthLevel>& out, PegType peg) const
+    {
+        double reference = 0.0;
+        if (!pegReference<S>(peg, reference))
+            return;
+
+        const PegGroup& group = pegGroup<S>(peg);
+        out.reserve(group.size());
+
+        for (const auto& [offset, level] : group)
         {
-            const double price = order.price;
-            asks[price].addOrder(std::move(order));
+            const double price = pegPrice<S>(reference, offset);
+            if (price <= 0.0)
+                break;
+
+            out.push_back({ price, level.totalVolume, level.size() });
         }
+    }
+
+    // ============================================================
+    // DEPTH INDEX
+    // ============================================================
+
+    void OrderBook::enableDepthIndex(double tickSize)
+    {
+        depthIndex = std::make_unique<DepthIndex>(tickSize);
+
+        for (const auto& [price, level] : bids)
+            depthIndex->add(Side::Buy, price, level.totalVolume);
 
-        // Immediately attempt matching after insertion
-        matchOrders();
+        for (const auto& [price, level] : asks)
+            depthIndex->add(Side::Sell, price, level.totalVolume);
     }
 
-    void OrderBook::executeMarketOrder(Order order)
+    void OrderBook::disableDepthIndex() noexcept
     {
-        if (order.side == Side::Buy)
+        depthIndex.reset();
+    }
+
+    const DepthIndex* OrderBook::getDepthIndex() const noexcept
+    {
+        return depthIndex.get();
+    }
+
+    // ============================================================
+    // SHADOW ORDERS
+    // ============================================================
+
+    void OrderBook::attachShadowFills(ShadowFillSimulator* simulator) noexcept
+    {
+        shadows = simulator;
+    }
+
+    QueueTail OrderBook::queueTail(Side side, double price) const
+    {
+        if (side == Side::Buy)
+            return queueTail<Side::Buy>(price);
+
+        return queueTail<Side::Sell>(price);
+    }
+
+    template <Side S>
+    QueueTail OrderBook::queueTail(double price) const
+    {
+        const auto& side = book<S>();
+
+        // A missing level starts numbering from 0 when created
+        const auto it = side.find(price);
+        if (it == side.end())
+            return { 0, 0 };
+
+        const PriceLevel& level = it->second;
+        return { level.totalVolume, level.base + level.orders.size() };
+    }
+
+    // ============================================================
+    // MEMORY
+    // ============================================================
+
+    MemoryStats OrderBook::memoryStats() const
+    {
+        MemoryStats stats;
+
+        auto addQueue = [&stats](const PriceLevel& queue)
+            {
+                stats.levelBytes += queue.orders.capacity() * sizeof(RestingOrder);
+                stats.slackBytes += queue.slackBytes();
+            };
+
+        stats.levelBytes += mapBytes(bids) + mapBytes(asks);
+
+        for (const auto& [price, level] : bids)
+            addQueue(level);
+
+        for (const auto& [price, level] : asks)
+            addQueue(level);
+
+        addQueue(buyMarketQueue);
+        addQueue(sellMarketQueue);
+
+        for (const PegGroup* group : { &buyPrimaryPegs, &buyMidPegs, &sellPrimaryPegs, &sellMidPegs })
+        {
+            stats.levelBytes += mapBytes(*group);
+
+            for (const auto& [offset, level] : *group)
+                addQueue(level);
+        }
+
+        stats.levelBytes += spareQueues.capacity() * sizeof(spareQueues[0]);
+        for (const auto& spare : spareQueues)
+        {
+            stats.levelBytes += spare.capacity() * sizeof(RestingOrder);
+            stats.slackBytes += spare.capacity() * sizeof(RestingOrder);
+        }
+
+        stats.orderBytes = store.memoryBytes();
+        stats.slackBytes += store.slackBytes();
+
+        stats.tradeBytes = trades.capacity() * sizeof(Trade);
+        stats.slackBytes += (trades.capacity() - trades.size()) * sizeof(Trade);
+
+        stats.indexBytes = tableBytes(orderIndex) + tableBytes(owners);
+        stats.slackBytes += tableSlackBytes(orderIndex) + tableSlackBytes(owners);
+
+        if (depthIndex)
+            stats.indexBytes += depthIndex->memoryBytes();
+
+        return stats;
+    }
+
+    /*
+        Wall-clock budget of one compact() call. A step's cost is
+        estimated from the records it touches, at rates measured
+        for each kind of step (with headroom): moving queue records,
+        freeing buffers, rebuilding the store free list, rehashing.
+    */
+    class OrderBook::CompactionClock
+    {
+    public:
+
+        static constexpr int64_t QUEUE_NS = 10;
+        static constexpr int64_t BUFFER_NS = 100;
+        static constexpr int64_t STORE_NS = 20;
+        static constexpr int64_t TABLE_NS = 60;
+
+        explicit CompactionClock(std::chrono::microseconds budget)
+            : start(std::chrono::steady_clock::now()),
+            budgetNs(std::chrono::duration_cast<std::chrono::nanoseconds>(budget).count())
+        {
+        }
+
+        [[nodiscard]] bool fits(size_t elements, int64_t nsPerElement) const
+        {
+            const int64_t elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+            return elapsedNs + cost(elements, nsPerElement) <= budgetNs;
+        }
+
+        // Would not fit even an untouched budget
+        [[nodiscard]] bool exceedsBudget(size_t elements, int64_t nsPerElement) const noexcept
+        {
+            return cost(elements, nsPerElement) > budgetNs;
+        }
+
+    private:
+
+        static constexpr int64_t NS_PER_STEP = 500;
+
+        std::chrono::steady_clock::time_point start;
+        int64_t budgetNs;
+
+        [[nodiscard]] static int64_t cost(size_t elements, int64_t nsPerElement) noexcept
         {
-            while (order.quantity > 0 && !asks.empty())
+            return NS_PER_STEP + static_cast<int64_t>(elements) * nsPerElement;
+        }
+    };
+
+    CompactionResult OrderBook::compact(std::chrono::microseconds budget)
+    {
+        CompactionClock clock(budget);
+        CompactionResult result;
+
+        if (compactionPhase == CompactionPhase::Done)
+            compactionPhase = CompactionPhase::Bids;
+
+        // Runs one step if it fits; false means stop here and resume later
+        auto step = [&](size_t elements, int64_t nsPerElement, auto&& work)
             {
-                auto askIt = asks.begin();
-                PriceLevel& askLevel = askIt->second;
-                Order& sellOrder = askLevel.orders.front();
+                if (clock.fits(elements, nsPerElement))
+                    result.bytesReleased += work();
+                else if (clock.exceedsBudget(elements, nsPerElement))
+                    ++result.deferredSteps;
+                else
+                    return false;
 
-                const uint64_t tradeQty = std::min(order.quantity, sellOrder.quantity);
+                return true;
+            };
 
-                trades.push_back({
-                    order.id,
-                    sellOrder.id,
-                    askIt->first,
-                    tradeQty,
-                    std::chrono::steady_clock::now()
-                    });
+        while (compactionPhase != CompactionPhase::Done)
+        {
+            switch (compactionPhase)
+            {
+            case CompactionPhase::Bids:
+                if (!compactLevels<Side::Buy>(clock, result))
+                    return result;
+                compactionPhase = CompactionPhase::Asks;
+                break;
 
-                order.quantity -= tradeQty;
-                askLevel.reduceFront(tradeQty);
+            case CompactionPhase::Asks:
+                if (!compactLevels<Side::Sell>(clock, result))
+                    return result;
+                compactionPhase = CompactionPhase::MarketQueues;
+                break;
 
-                if (askLevel.empty())
-                    asks.erase(askIt);
+            case CompactionPhase::MarketQueues:
+                if (!step(buyMarketQueue.orders.size() + sellMarketQueue.orders.size(), CompactionClock::QUEUE_NS,
+                    [this] { return buyMarketQueue.compact() + sellMarketQueue.compact(); }))
+                    return result;
+                compactionPhase = CompactionPhase::PegGroups;
+                break;
+
+            case CompactionPhase::PegGroups:
+            {
+                const std::array<PegGroup*, 4> groups{ &buyPrimaryPegs, &buyMidPegs, &sellPrimaryPegs, &sellMidPegs };
+
+                size_t elements = 0;
+                for (const PegGroup* group : groups)
+                {
+                    for (const auto& [offset, level] : *group)
+                        elements += level.orders.size();
+                }
+
+                if (!step(elements, CompactionClock::QUEUE_NS, [&groups]
+                    {
+                        size_t bytes = 0;
+                        for (PegGroup* group : groups)
+                        {
+                            for (auto& [offset, level] : *group)
+                                bytes += level.compact();
+                        }
+                        return bytes;
+                    }))
+                    return result;
+                compactionPhase = CompactionPhase::SpareQueues;
+                break;
             }
 
-            return;
+            case CompactionPhase::SpareQueues:
+                if (!step(spareQueues.size(), CompactionClock::BUFFER_NS, [this]
+                    {
+                        size_t bytes = spareQueues.capacity() * sizeof(spareQueues[0]);
+                        for (const auto& spare : spareQueues)
+                            bytes += spare.capacity() * sizeof(RestingOrder);
+
+                        std::vector<std::vector<RestingOrder>>().swap(spareQueues);
+                        return bytes;
+                    }))
+                    return result;
+                compactionPhase = CompactionPhase::OrderStore;
+                break;
+
+            case CompactionPhase::OrderStore:
+                // The bitmap pass also walks every handle ever handed out
+                if (!step(store.freeCount() + store.size() / 64, CompactionClock::STORE_NS, [this] { return store.trim(); }))
+                    return result;
+                compactionPhase = CompactionPhase::OrderIndex;
+                break;
+
+            case CompactionPhase::OrderIndex:
+                if (!step(orderIndex.size(), CompactionClock::TABLE_NS, [this] { return shrinkTable(orderIndex); }))
+                    return result;
+                compactionPhase = CompactionPhase::OwnerIndex;
+                break;
+
+            case CompactionPhase::OwnerIndex:
+                if (!step(owners.size(), CompactionClock::TABLE_NS, [this] { return shrinkTable(owners); }))
+                    return result;
+                compactionPhase = CompactionPhase::Done;
+                break;
+
+            case CompactionPhase::Done:
+                break;
+            }
         }
 
-        while (order.quantity > 0 && !bids.empty())
-        {
-            auto bidIt = bids.begin();
-            PriceLevel& bidLevel = bidIt->second;
-            Order& buyOrder = bidLevel.orders.front();
+        result.passComplete = true;
+        return result;
+    }
+
+    template <Side S>
+    bool OrderBook::compactLevels(CompactionClock& clock, CompactionResult& result)
+    {
+        auto& side = book<S>();
+        auto it = compactionResume ? side.lower_bound(compactionPrice) : side.begin();
+        compactionResume = false;
 
-            const uint64_t tradeQty = std::min(order.quantity, buyOrder.quantity);
+        for (; it != side.end(); ++it)
+        {
+            PriceLevel& level = it->second;
 
-            trades.push_back({
-                buyOrder.id,
-                order.id,
-                bidIt->first,
-                tradeQty,
-                std::chrono::steady_clock::now()
-                });
+            // Nothing to release: skip without reading the clock
+            if (level.head == 0 && level.orders.capacity() <= level.orders.size() * 2)
+                continue;
 
-            order.quantity -= tradeQty;
-            bidLevel.reduceFront(tradeQty);
+            const size_t elements = level.orders.size() - level.head;
 
-            if (bidLevel.empty())
-                bids.erase(bidIt);
+            if (clock.fits(elements, CompactionClock::QUEUE_NS))
+            {
+                result.bytesReleased += level.compact();
+            }
+            else if (clock.exceedsBudget(elements, CompactionClock::QUEUE_NS))
+            {
+                ++result.deferredSteps;
+            }
+            else
+            {
+                compactionPrice = it->first;
+                compactionResume = true;
+                return false;
+            }
         }
+
+        return true;
     }
 
     // ============================================================
-    // MATCH ORDERS (CORE ENGINE LOGIC)
+    // METRICS HOOKS
     // ============================================================
 
-    void OrderBook::matchOrders()
+    void OrderBook::recordTrade(const Trade& trade)
     {
-        /*
-            Matching logic:
+        trades.push_back(trade);
 
-            While:
-                bestBid >= bestAsk
+        if (metrics)
+        {
+            metrics->increment(Metric::Fills);
+            metrics->increment(Metric::FilledQuantity, trade.quantity);
+        }
+    }
 
-            Trade occurs at ask price (standard exchange model)
+    void OrderBook::onFrontReduced(PriceLevel& level, uint64_t qty)
+    {
+        const RestingOrder front = level.front();
 
-            Price-time priority:
-                - First price level
-                - FIFO within level
-        */
+        if (!level.reduceFront(qty))
+            return;
 
-        while (!bids.empty() && !asks.empty())
-        {
-            auto bestBidIt = bids.begin();
-            auto bestAskIt = asks.begin();
+        // Only levels holding iceberg reserve read the cold record
+        if (level.hiddenVolume > 0 && replenish(level, front))
+            return;
+
+        orderIndex.erase(front.id);
+        releaseOrder(front.handle, front.owner);
+    }
 
-            double bestBid = bestBidIt->first;
-            double bestAsk = bestAskIt->first;
+    bool OrderBook::replenish(PriceLevel& level, const RestingOrder& filled)
+    {
+        OrderDetails& details = store[filled.handle];
+        if (details.hiddenQty == 0)
+            return false;
 
-            if (bestBid < bestAsk)
-                break;  // No crossing market
+        // Same record, same id index entry and owner link: only the
+        // queue slot changes, to the back of this level
+        const uint64_t tranche = std::min(details.displayQty, details.hiddenQty);
+        details.hiddenQty -= tranche;
+        level.hiddenVolume -= tranche;
+        details.queueSlot = level.addOrder({ filled.id, tranche, filled.handle, filled.owner });
 
-            PriceLevel& bidLevel = bestBidIt->second;
-            PriceLevel& askLevel = bestAskIt->second;
+        if (depthIndex)
+            depthIndex->add(details.side, details.price, tranche);
 
-            Order& buyOrder = bidLevel.orders.front();
-            Order& sellOrder = askLevel.orders.front();
+        if (metrics)
+            metrics->increment(Metric::IcebergRefills);
 
-            uint64_t tradeQty = std::min(buyOrder.quantity, sellOrder.quantity);
+        return true;
+    }
 
-            trades.push_back({
-                buyOrder.id,
-                sellOrder.id,
-                bestAsk,   // trade at ask price
-                tradeQty,
-                std::chrono::steady_clock::now()
-                });
+    void OrderBook::onLevelCreated(PriceLevel& level)
+    {
+        // Reuse a queue buffer from a dead level instead of regrowing one
+        if (!spareQueues.empty())
+        {
+            level.orders = std::move(spareQueues.back());
+            spareQueues.pop_back();
+        }
 
-            bidLevel.reduceFront(tradeQty);
-            askLevel.reduceFront(tradeQty);
+        if (metrics)
+            metrics->increment(Metric::LevelsCreated);
+    }
 
-            if (bidLevel.empty())
-                bids.erase(bestBidIt);
+    void OrderBook::onLevelErased(Side side, double price, PriceLevel& level)
+    {
+        if (shadows)
+            shadows->onLevelErased(side, price);
 
-            if (askLevel.empty())
-                asks.erase(bestAskIt);
+        if (spareQueues.size() < MAX_SPARE_QUEUES && level.orders.capacity() > 0)
+        {
+            level.orders.clear();
+            spareQueues.push_back(std::move(level.orders));
         }
+
+        if (metrics)
+            metrics->increment(Metric::LevelsDestroyed);
+    }
+
+    void OrderBook::onSweepFinished(uint64_t levelsTouched)
+    {
+        if (!metrics)
+            return;
+
+        metrics->set(Metric::LastSweepDepth, levelsTouched);
+        metrics->set(Metric::OrderPoolOccupancy, store.size());
+        metrics->setMax(Metric::MaxSweepDepth, levelsTouched);
     }
 
     // ============================================================
@@ -187,6 +1732,9 @@ namespace hft
 
     uint64_t OrderBook::getTotalBidVolume() const
     {
+        if (depthIndex)
+            return depthIndex->totalQuantity(Side::Buy);
+
         uint64_t total = 0;
         for (const auto& [price, level] : bids)
             total += level.totalVolume;
@@ -196,6 +1744,9 @@ namespace hft
 
     uint64_t OrderBook::getTotalAskVolume() const
     {
+        if (depthIndex)
+            return depthIndex->totalQuantity(Side::Sell);
+
         uint64_t total = 0;
         for (const auto& [price, level] : asks)
             total += level.totalVolume;
@@ -203,6 +1754,55 @@ namespace hft
         return total;
     }
 
+    BookSummary OrderBook::getSummary() const
+    {
+        BookSummary summary;
+
+        if (!bids.empty())
+        {
+            summary.bidPrice = bids.begin()->first;
+            summary.bidTop = bids.begin()->second.totalVolume;
+            summary.bidVolume = getTotalBidVolume();
+        }
+
+        if (!asks.empty())
+        {
+            summary.askPrice = asks.begin()->first;
+            summary.askTop = asks.begin()->second.totalVolume;
+            summary.askVolume = getTotalAskVolume();
+        }
+
+        return summary;
+    }
+
+    std::vector<DepthLevel> OrderBook::getDepth(Side side, size_t maxLevels) const
+    {
+        std::vector<DepthLevel> depth;
+
+        if (side == Side::Buy)
+            appendDepth<Side::Buy>(depth, maxLevels);
+        else
+            appendDepth<Side::Sell>(depth, maxLevels);
+
+        return depth;
+    }
+
+    template <Side S>
+    void OrderBook::appendDepth(std::vector<DepthLevel>& out, size_t maxLevels) const
+    {
+        const auto& side = book<S>();
+        const size_t count = (maxLevels == 0) ? side.size() : std::min(maxLevels, side.size());
+        out.reserve(count);
+
+        for (const auto& [price, level] : side)
+        {
+            if (out.size() == count)
+                break;
+
+            out.push_back({ price, level.totalVolume, level.size() });
+        }
+    }
+
     double OrderBook::calculateVWAP() const
     {
         double totalValue = 0.0;
@@ -249,7 +1849,20 @@ namespace hft
 
     bool OrderBook::empty() const
     {
-        return bids.empty() && asks.empty();
+        return bids.empty() && asks.empty()
+            && buyMarketQueue.empty() && sellMarketQueue.empty()
+            && buyPrimaryPegs.empty() && buyMidPegs.empty()
+            && sellPrimaryPegs.empty() && sellMidPegs.empty();
+    }
+
+    bool OrderBook::contains(uint64_t orderId) const noexcept
+    {
+        return orderIndex.contains(orderId);
+    }
+
+    size_t OrderBook::restingOrderCount() const noexcept
+    {
+        return store.size();
     }
 
     void OrderBook::clear()
@@ -257,6 +1870,49 @@ namespace hft
         bids.clear();
         asks.clear();
         trades.clear();
+        store.clear();
+        orderIndex.clear();
+        owners.clear();
+        spareQueues.clear();
+        buyMarketQueue = {};
+        sellMarketQueue = {};
+        buyPrimaryPegs.clear();
+        buyMidPegs.clear();
+        sellPrimaryPegs.clear();
+        sellMidPegs.clear();
+
+        if (depthIndex)
+            depthIndex->clear();
+
+        if (shadows)
+            shadows->onBookCleared();
+
+        compactionPhase = CompactionPhase::Bids;
+        compactionResume = false;
+
+        if (metrics)
+            metrics->set(Metric::OrderPoolOccupancy, 0);
+    }
+
+    void OrderBook::attachMetrics(MetricsRegistry* registry) noexcept
+    {
+        metrics = registry;
+    }
+
+    void OrderBook::setSimulatedTime(Timestamp time) noexcept
+    {
+        simulatedClock = true;
+        simulatedTime = time;
+    }
+
+    void OrderBook::useWallClock() noexcept
+    {
+        simulatedClock = false;
+    }
+
+    void OrderBook::setEventSequence(uint64_t sequence) noexcept
+    {
+        eventSequence = sequence;
     }
 
 } // namespace hft
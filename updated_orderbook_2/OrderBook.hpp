@@ -1,7 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
 #include <map>
-#include <deque>
+#include <unordered_map>
+#include <memory>
 #include <vector>
 #include <cstdint>
 #include <chrono>
@@ -33,22 +36,44 @@
 namespace hft
 {
 
+    class MetricsRegistry;
+    class DepthIndex;
+    class ShadowFillSimulator;
+
     // ============================================================
     // ENUMS
     // ============================================================
 
-    enum class Side
+    enum class Side : uint8_t
     {
         Buy,
         Sell
     };
 
-    enum class OrderType
+    enum class OrderType : uint8_t
     {
         Market,
         Limit
     };
 
+    // Continuous matches on arrival; Auction collects orders for a batch uncross
+    enum class TradingMode : uint8_t
+    {
+        Continuous,
+        Auction
+    };
+
+    // What a pegged order tracks: the lit best on its own side
+    // (Primary) or the lit midpoint (Mid)
+    enum class PegType : uint8_t
+    {
+        None,
+        Primary,
+        Mid
+    };
+
+    using Timestamp = std::chrono::steady_clock::time_point;
+
      // ORDER STRUCT
  
     struct Order
@@ -59,24 +84,129 @@ namespace hft
         double price;
         uint64_t quantity;
         uint64_t originalQty;
-        std::chrono::steady_clock::time_point timestamp;
+        Timestamp timestamp;
+        uint32_t owner = 0;
 
         Order(uint64_t id_,
             Side side_,
             OrderType type_,
             double price_,
             uint64_t qty_)
+            : Order(id_, side_, type_, price_, qty_, std::chrono::steady_clock::now())
+        {
+        }
+
+        Order(uint64_t id_,
+            Side side_,
+            OrderType type_,
+            double price_,
+            uint64_t qty_,
+            Timestamp timestamp_)
             : id(id_),
             side(side_),
             type(type_),
             price(price_),
             quantity(qty_),
             originalQty(qty_),
-            timestamp(std::chrono::steady_clock::now())
+            timestamp(timestamp_)
+        {
+        }
+    };
+
+     // DEPTH SNAPSHOT
+
+    struct DepthLevel
+    {
+        double price;
+        uint64_t volume;
+        size_t orderCount;
+
+        bool operator==(const DepthLevel&) const = default;
+    };
+
+     // TOP OF BOOK AND SIDE TOTALS
+
+    struct BookSummary
+    {
+        double bidPrice = 0.0;     // 0 on an empty side
+        double askPrice = 0.0;
+        uint64_t bidTop = 0;       // displayed volume at the best level
+        uint64_t askTop = 0;
+        uint64_t bidVolume = 0;    // as getTotalBidVolume()
+        uint64_t askVolume = 0;
+    };
+
+     // AUCTION OUTCOME
+
+    struct AuctionResult
+    {
+        double price = 0.0;        // 0 when the book does not cross
+        uint64_t volume = 0;
+        uint64_t buySurplus = 0;   // unexecuted demand at price
+        uint64_t sellSurplus = 0;  // unexecuted supply at price
+    };
+
+     // LEVEL UPDATE
+
+    // Aggregated state of one level after a change; volume 0 means removed
+    struct LevelUpdate
+    {
+        Side side;
+        double price;
+        uint64_t volume;
+        size_t orderCount;
+    };
+
+     // MASS CANCEL OUTCOME
+
+    struct MassCancelResult
+    {
+        size_t orders = 0;
+        uint64_t quantity = 0;
+        std::vector<LevelUpdate> levels;   // one per affected price level
+    };
+
+     // QUEUE TAIL
+
+    // What an order joining a level now would queue behind
+    struct QueueTail
+    {
+        uint64_t volume;     // resting at the level
+        uint64_t nextSlot;   // queue slot the next arrival takes
+    };
+
+     // MEMORY FOOTPRINT
+
+    /*
+        Approximate heap bytes by owner: container payloads plus
+        node links and bucket arrays, without allocator headers.
+        Slack is allocated but holds nothing live (consumed queue
+        prefixes, spare capacity, free store slots, oversized
+        hash tables, unused trade capacity).
+    */
+    struct MemoryStats
+    {
+        size_t levelBytes = 0;    // level map nodes and queue buffers
+        size_t orderBytes = 0;    // cold order store and its free list
+        size_t tradeBytes = 0;    // trade history
+        size_t indexBytes = 0;    // id and owner tables, depth index
+        size_t slackBytes = 0;    // included in the above
+
+        [[nodiscard]] size_t total() const noexcept
         {
+            return levelBytes + orderBytes + tradeBytes + indexBytes;
         }
     };
 
+     // COMPACTION SLICE OUTCOME
+
+    struct CompactionResult
+    {
+        size_t bytesReleased = 0;
+        size_t deferredSteps = 0;   // too large for the budget on their own
+        bool passComplete = false;  // the next call starts a new pass
+    };
+
      // TRADE STRUCT
  
     struct Trade
@@ -85,52 +215,500 @@ namespace hft
         uint64_t sellOrderId;
         double price;
         uint64_t quantity;
-        std::chrono::steady_clock::time_point timestamp;
+        Timestamp timestamp;
+        uint64_t sequence = 0;   // engine sequence of the event that traded
+    };
+
+    // ============================================================
+    // RESTING ORDER STORAGE (HOT / COLD SPLIT)
+    // ============================================================
+
+    using OrderHandle = uint32_t;
+
+    inline constexpr OrderHandle NO_ORDER_HANDLE = UINT32_MAX;
+
+    /*
+        Hot record: the only fields the matching loop touches.
+        Stored contiguously per level, 24 bytes each, so a
+        cache line holds more than twice as many orders as a
+        full Order would. The owner sits in what would be
+        padding, so fills of ownerless orders never read the
+        cold record.
+    */
+    struct RestingOrder
+    {
+        uint64_t id;
+        uint64_t quantity;
+        OrderHandle handle;
+        uint32_t owner = 0;
+    };
+
+    static_assert(sizeof(RestingOrder) == 24);
+
+    // Cold record: read on entry, cancel and reporting only.
+    // The id lives in the hot record. Orders with an owner are
+    // also linked into that owner's list (see OrderBook::cancelOwner).
+    // Icebergs keep their reserve here; the hot record holds the
+    // displayed tranche. Pegged orders keep their offset in `price`.
+    struct OrderDetails
+    {
+        uint64_t originalQty = 0;
+        double price = 0.0;
+        Timestamp timestamp{};
+        uint64_t queueSlot = 0;
+        uint32_t owner = 0;
+        Side side = Side::Buy;
+        OrderType type = OrderType::Limit;
+        PegType peg = PegType::None;
+        OrderHandle ownerPrev = NO_ORDER_HANDLE;
+        OrderHandle ownerNext = NO_ORDER_HANDLE;
+        uint64_t displayQty = 0;   // tranche size, 0 for plain orders
+        uint64_t hiddenQty = 0;    // reserve not yet displayed
+    };
+
+    /*
+        Slab of cold records indexed by OrderHandle.
+
+        Records live in fixed-size chunks, so growth never
+        copies existing records. Released handles are recycled
+        LIFO so the hottest slots stay in cache.
+    */
+    class OrderStore
+    {
+    public:
+
+        static constexpr uint32_t CHUNK_SHIFT = 12;
+        static constexpr uint32_t CHUNK_SIZE = 1u << CHUNK_SHIFT;
+
+        [[nodiscard]] OrderHandle allocate(const OrderDetails& details)
+        {
+            ++live;
+
+            OrderHandle handle;
+            if (!freeHandles.empty())
+            {
+                handle = freeHandles.back();
+                freeHandles.pop_back();
+            }
+            else
+            {
+                if (nextUnused == chunks.size() * CHUNK_SIZE)
+                    chunks.push_back(std::make_unique<OrderDetails[]>(CHUNK_SIZE));
+
+                handle = nextUnused++;
+            }
+
+            (*this)[handle] = details;
+            return handle;
+        }
+
+        void release(OrderHandle handle)
+        {
+            --live;
+            freeHandles.push_back(handle);
+        }
+
+        [[nodiscard]] OrderDetails& operator[](OrderHandle handle) noexcept
+        {
+            return chunks[handle >> CHUNK_SHIFT][handle & (CHUNK_SIZE - 1)];
+        }
+
+        [[nodiscard]] const OrderDetails& operator[](OrderHandle handle) const noexcept
+        {
+            return chunks[handle >> CHUNK_SHIFT][handle & (CHUNK_SIZE - 1)];
+        }
+
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return live;
+        }
+
+        [[nodiscard]] size_t freeCount() const noexcept
+        {
+            return freeHandles.size();
+        }
+
+        [[nodiscard]] size_t memoryBytes() const noexcept
+        {
+            return chunks.size() * CHUNK_SIZE * sizeof(OrderDetails)
+                + chunks.capacity() * sizeof(chunks[0])
+                + freeHandles.capacity() * sizeof(OrderHandle);
+        }
+
+        [[nodiscard]] size_t slackBytes() const noexcept
+        {
+            return (chunks.size() * CHUNK_SIZE - live) * sizeof(OrderDetails)
+                + (freeHandles.capacity() - freeHandles.size()) * sizeof(OrderHandle);
+        }
+
+        /*
+            Releases trailing chunks with no live record, then rebuilds
+            the free list so the lowest handles are reused first:
+            records migrate towards the front and high chunks drain
+            for a later trim. One bitmap pass, O(free handles + chunk
+            words). Returns bytes freed.
+        */
+        size_t trim()
+        {
+            const size_t before = memoryBytes();
+
+            constexpr size_t WORDS_PER_CHUNK = CHUNK_SIZE / 64;
+            std::vector<uint64_t> isFree(chunks.size() * WORDS_PER_CHUNK, 0);
+
+            for (const OrderHandle handle : freeHandles)
+                isFree[handle >> 6] |= uint64_t{ 1 } << (handle & 63);
+
+            size_t keep = chunks.size();
+            while (keep > 0)
+            {
+                const size_t first = (keep - 1) * CHUNK_SIZE;
+                const size_t handedOut = (nextUnused > first)
+                    ? std::min<size_t>(nextUnused - first, CHUNK_SIZE)
+                    : 0;
+
+                size_t freeInChunk = 0;
+                for (size_t word = 0; word < WORDS_PER_CHUNK; ++word)
+                    freeInChunk += static_cast<size_t>(std::popcount(isFree[(keep - 1) * WORDS_PER_CHUNK + word]));
+
+                if (freeInChunk != handedOut)
+                    break;
+
+                --keep;
+            }
+
+            chunks.resize(keep);
+            nextUnused = std::min(nextUnused, static_cast<OrderHandle>(keep * CHUNK_SIZE));
+
+            // Popped from the back: descending order hands out the lowest first
+            freeHandles.clear();
+            for (size_t word = keep * WORDS_PER_CHUNK; word-- > 0;)
+            {
+                for (uint64_t bits = isFree[word]; bits != 0;)
+                {
+                    const int bit = 63 - std::countl_zero(bits);
+                    freeHandles.push_back(static_cast<OrderHandle>(word * 64 + static_cast<size_t>(bit)));
+                    bits &= ~(uint64_t{ 1 } << bit);
+                }
+            }
+
+            if (freeHandles.capacity() > freeHandles.size() * 2)
+                freeHandles.shrink_to_fit();
+
+            return before - memoryBytes();
+        }
+
+        void clear() noexcept
+        {
+            chunks.clear();
+            freeHandles.clear();
+            nextUnused = 0;
+            live = 0;
+        }
+
+    private:
+        std::vector<std::unique_ptr<OrderDetails[]>> chunks;
+        std::vector<OrderHandle> freeHandles;
+        OrderHandle nextUnused = 0;
+        size_t live = 0;
     };
 
      // PRICE LEVEL
  
+    /*
+        FIFO of hot records in one contiguous vector.
+
+        Filled orders advance `head` instead of shifting; the
+        consumed prefix is dropped on the next append once it
+        dominates, so draining a deep level never moves memory.
+
+        Every record gets a queue slot (absolute position since
+        the level was created). `base` is the slot of orders[0],
+        so a slot finds its record in O(1) for cancels. Cancelled
+        records become zero-quantity tombstones skipped at the
+        front; the front record is always live.
+
+        totalVolume is the displayed quantity. Iceberg reserve is
+        summed separately; while it is zero, fills never read a
+        cold record to look for a tranche to refill.
+    */
     struct PriceLevel
     {
-        std::deque<Order> orders;
+        std::vector<RestingOrder> orders;
+        size_t head = 0;
+        uint64_t base = 0;
+        size_t liveOrders = 0;
         uint64_t totalVolume = 0;
+        uint64_t hiddenVolume = 0;
 
-        void addOrder(Order order)
+        // Returns the queue slot of the appended record
+        uint64_t addOrder(const RestingOrder& order)
         {
+            if (head >= 64 && head * 2 >= orders.size())
+            {
+                orders.erase(orders.begin(), orders.begin() + static_cast<std::ptrdiff_t>(head));
+                base += head;
+                head = 0;
+            }
+
             totalVolume += order.quantity;
-            orders.push_back(std::move(order));
+            ++liveOrders;
+            orders.push_back(order);
+            return base + orders.size() - 1;
         }
 
-        void reduceFront(uint64_t qty)
+        [[nodiscard]] RestingOrder& front() noexcept
         {
-            if (orders.empty())
-                return;
+            return orders[head];
+        }
 
-            Order& front = orders.front();
-            front.quantity -= qty;
+        [[nodiscard]] RestingOrder& at(uint64_t slot) noexcept
+        {
+            return orders[static_cast<size_t>(slot - base)];
+        }
+
+        // Returns true when the front order was fully filled and removed
+        bool reduceFront(uint64_t qty)
+        {
+            if (empty())
+                return false;
+
+            RestingOrder& first = orders[head];
+            first.quantity -= qty;
             totalVolume -= qty;
 
-            if (front.quantity == 0)
-                orders.pop_front();
+            if (first.quantity != 0)
+                return false;
+
+            --liveOrders;
+            popFront();
+            return true;
+        }
+
+        // Takes qty, below the remaining quantity, off the record at `slot`
+        void reduce(uint64_t slot, uint64_t qty) noexcept
+        {
+            at(slot).quantity -= qty;
+            totalVolume -= qty;
+        }
+
+        // Removes the live record at `slot`; returns its remaining quantity
+        uint64_t cancel(uint64_t slot)
+        {
+            RestingOrder& order = at(slot);
+            const uint64_t remaining = order.quantity;
+
+            order.quantity = 0;
+            totalVolume -= remaining;
+            --liveOrders;
+
+            if (slot - base == head)
+                popFront();
+
+            return remaining;
+        }
+
+        void popFront() noexcept
+        {
+            ++head;
+
+            while (head < orders.size() && orders[head].quantity == 0)
+                ++head;
+
+            if (head == orders.size())
+            {
+                base += orders.size();
+                orders.clear();
+                head = 0;
+            }
+        }
+
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return liveOrders;
         }
 
         bool empty() const
         {
-            return orders.empty();
+            return liveOrders == 0;
+        }
+
+        // Drops the consumed prefix (slots are unchanged) and spare
+        // capacity once it exceeds the records kept; returns bytes freed
+        size_t compact()
+        {
+            const size_t before = orders.capacity();
+
+            if (head > 0)
+            {
+                orders.erase(orders.begin(), orders.begin() + static_cast<std::ptrdiff_t>(head));
+                base += head;
+                head = 0;
+            }
+
+            if (orders.capacity() > orders.size() * 2)
+                orders.shrink_to_fit();
+
+            return (before - orders.capacity()) * sizeof(RestingOrder);
+        }
+
+        // Buffer bytes not holding a live order
+        [[nodiscard]] size_t slackBytes() const noexcept
+        {
+            return (orders.capacity() - liveOrders) * sizeof(RestingOrder);
+        }
+    };
+
+     // SIDE TRAITS
+
+    /*
+        Everything that differs between buying and selling,
+        resolved at compile time. The matching loop is written
+        once against these traits and instantiated per side.
+    */
+    template <Side S>
+    struct SideTraits;
+
+    template <>
+    struct SideTraits<Side::Buy>
+    {
+        // Descending bids (highest first)
+        using Compare = std::greater<double>;
+
+        static constexpr Side opposite = Side::Sell;
+
+        [[nodiscard]] static constexpr bool crosses(double limit, double passive) noexcept
+        {
+            return limit >= passive;
+        }
+
+        // Buy aggressors print at the resting ask
+        template <OrderType T>
+        [[nodiscard]] static constexpr double tradePrice(double, double passive) noexcept
+        {
+            return passive;
+        }
+
+        [[nodiscard]] static Trade makeTrade(uint64_t aggressorId,
+            uint64_t passiveId,
+            double price,
+            uint64_t qty,
+            Timestamp time,
+            uint64_t sequence) noexcept
+        {
+            return { aggressorId, passiveId, price, qty, time, sequence };
+        }
+    };
+
+    template <>
+    struct SideTraits<Side::Sell>
+    {
+        // Ascending asks (lowest first)
+        using Compare = std::less<double>;
+
+        static constexpr Side opposite = Side::Buy;
+
+        [[nodiscard]] static constexpr bool crosses(double limit, double passive) noexcept
+        {
+            return limit <= passive;
+        }
+
+        // Sell limits print at their own (ask) price, market sells at the bid
+        template <OrderType T>
+        [[nodiscard]] static constexpr double tradePrice(double limit, double passive) noexcept
+        {
+            if constexpr (T == OrderType::Limit)
+                return limit;
+            else
+                return passive;
+        }
+
+        [[nodiscard]] static Trade makeTrade(uint64_t aggressorId,
+            uint64_t passiveId,
+            double price,
+            uint64_t qty,
+            Timestamp time,
+            uint64_t sequence) noexcept
+        {
+            return { passiveId, aggressorId, price, qty, time, sequence };
         }
     };
 
+    template <Side S>
+    using BookSide = std::map<double, PriceLevel, typename SideTraits<S>::Compare>;
+
      // ORDER BOOK
  
     class OrderBook
     {
     public:
 
-        OrderBook() = default;
+        OrderBook();
+        ~OrderBook();
+
+        OrderBook(OrderBook&&) noexcept;
+        OrderBook& operator=(OrderBook&&) noexcept;
 
         // Order entry
         void addOrder(Order order);
 
+        /*
+            Limit order showing at most displayQty at a time. Arriving
+            orders match against its full quantity; at rest, each
+            filled tranche is refilled from the reserve in place and
+            requeued at the back of its level, keeping its id,
+            handle and owner. Depth, level volume and L2 updates show
+            the displayed tranche only; an auction uncross counts the
+            reserve. displayQty of 0, or not below the quantity,
+            enters a plain order.
+        */
+        void addIceberg(Order order, uint64_t displayQty);
+
+        /*
+            Limit order resting `offset` (>= 0) behind its reference:
+            below it for buys, above it for sells. Peg groups store
+            offsets only, so a move of the lit best bid or offer
+            reprices a whole group with no work at all.
+
+            Pegs trade through a merged view of lit and pegged levels
+            (lit first at equal prices), priced as of the aggressor's
+            arrival. They are not displayed: depth, volumes, L2
+            updates and the best bid/ask are lit only. A group
+            without a reference (its lit side, or either side for
+            Mid, is empty) cannot trade, nor can a buy group priced
+            at or below zero. Pegs sit out call auctions; zero-offset
+            mid pegs on both sides match at the mid.
+        */
+        void addPegged(Order order, PegType peg, double offset);
+
+        // One peg group at its current prices; empty without a reference
+        [[nodiscard]] std::vector<DepthLevel> getPegDepth(Side side, PegType peg) const;
+
+        // Removes a resting order; false if unknown or already done
+        bool cancelOrder(uint64_t orderId);
+
+        /*
+            Feed mirror (see FeedHandler): applies another venue's
+            own order events as is. Nothing matches; the feed is
+            trusted to keep the book uncrossed. An execution or a
+            size reduction keeps queue priority; a modify that moves
+            the price or raises the size requeues the order at the
+            back of its new level, as venues do, and size 0 deletes.
+            Each returns false and changes nothing for a duplicate
+            add, an unknown id, a pegged or iceberg order, or a
+            non-finite or non-positive price.
+        */
+        bool restOrder(const Order& order);
+        bool executeOrder(uint64_t orderId, uint64_t quantity);
+        bool modifyOrder(uint64_t orderId, double price, uint64_t quantity);
+
+        // Bulk cancels. Whole levels are dropped at once and each
+        // affected level appears once in the result, whatever the
+        // number of orders removed from it. Call-period market
+        // orders go with their side or owner, not with a range.
+        MassCancelResult cancelSide(Side side);
+        MassCancelResult cancelPriceRange(Side side, double low, double high);   // inclusive
+        MassCancelResult cancelOwner(uint32_t owner);   // owner 0 is never tracked
+
         // Matching engine trigger
         [[nodiscard]] std::vector<Trade> match();
 
@@ -145,28 +723,305 @@ namespace hft
         [[nodiscard]] uint64_t getTotalBidVolume() const;
         [[nodiscard]] uint64_t getTotalAskVolume() const;
 
+        // Everything above in one call, for cross-sectional snapshots
+        [[nodiscard]] BookSummary getSummary() const;
+
+        // Best-first aggregated levels (maxLevels == 0 means all)
+        [[nodiscard]] std::vector<DepthLevel> getDepth(Side side, size_t maxLevels = 0) const;
+
         [[nodiscard]] double calculateVWAP() const;
 
         // Output
         void printTopOfBook() const;
         void printFullDepth() const;
 
+        // Call auction. In Auction mode orders rest without matching
+        // (market orders wait in their own queue) until uncross().
+        // Returning to Continuous uncrosses first, so continuous
+        // matching always starts from an uncrossed book.
+        void setTradingMode(TradingMode mode);
+        [[nodiscard]] TradingMode getTradingMode() const noexcept;
+
+        // Equilibrium price without executing. referencePrice <= 0
+        // falls back to the last trade price.
+        [[nodiscard]] AuctionResult indicativeUncross(double referencePrice = 0.0) const;
+
+        // Executes every fill at the equilibrium price in one batch;
+        // unfilled market orders are discarded
+        AuctionResult uncross(double referencePrice = 0.0);
+
+        // Optional cumulative-depth index kept in step with every
+        // level volume change (see DepthIndex). Off by default.
+        void enableDepthIndex(double tickSize);
+        void disableDepthIndex() noexcept;
+        [[nodiscard]] const DepthIndex* getDepthIndex() const noexcept;
+
+        // Optional shadow-order overlay fed every passive fill,
+        // cancel, rest and level removal (not owned, may be null)
+        void attachShadowFills(ShadowFillSimulator* simulator) noexcept;
+
+        [[nodiscard]] QueueTail queueTail(Side side, double price) const;
+
         // Utilities
         [[nodiscard]] bool empty() const;
+        [[nodiscard]] bool contains(uint64_t orderId) const noexcept;   // live on the book
+        [[nodiscard]] size_t restingOrderCount() const noexcept;
         void clear();
 
-    private:
+        // O(levels); see MemoryStats
+        [[nodiscard]] MemoryStats memoryStats() const;
 
-        // Descending bids (highest first)
-        std::map<double, PriceLevel, std::greater<double>> bids;
+        /*
+            One bounded slice of compaction, resumed by the next call.
+            Steps are one level queue, the market queues, the peg
+            groups, the spare buffers, the order store, or one hash
+            table; the clock is checked before each
+            and a step whose size alone exceeds the budget is skipped
+            for this pass. Matching state is unchanged: queue slots,
+            handles and priority survive. Trade history is kept.
+        */
+        CompactionResult compact(std::chrono::microseconds budget);
 
-        // Ascending asks (lowest first)
-        std::map<double, PriceLevel> asks;
+        // Optional hot-path counters (not owned, may be null)
+        void attachMetrics(MetricsRegistry* registry) noexcept;
+
+        // Clock used for trade timestamps. Simulated time makes
+        // replays deterministic; the wall clock is the default.
+        void setSimulatedTime(Timestamp time) noexcept;
+        void useWallClock() noexcept;
+
+        [[nodiscard]] Timestamp currentTime() const noexcept
+        {
+            return simulatedClock ? simulatedTime : std::chrono::steady_clock::now();
+        }
+
+        // Engine sequence stamped on trades from the next calls
+        void setEventSequence(uint64_t sequence) noexcept;
+
+    private:
+
+        BookSide<Side::Buy> bids;
+        BookSide<Side::Sell> asks;
 
         std::vector<Trade> trades;
 
-        void matchOrders();
-        void executeMarketOrder(Order order);
+        OrderStore store;
+        std::unordered_map<uint64_t, OrderHandle> orderIndex;
+
+        // Each owner's orders in arrival order, linked through
+        // OrderDetails::ownerPrev/ownerNext
+        struct OwnerList
+        {
+            OrderHandle head;
+            OrderHandle tail;
+        };
+
+        std::unordered_map<uint32_t, OwnerList> owners;
+
+        // Emptied level buffers kept for reuse (capacity retained)
+        static constexpr size_t MAX_SPARE_QUEUES = 256;
+        std::vector<std::vector<RestingOrder>> spareQueues;
+        MetricsRegistry* metrics = nullptr;
+
+        bool simulatedClock = false;
+        Timestamp simulatedTime{};
+        uint64_t eventSequence = 0;
+
+        TradingMode tradingMode = TradingMode::Continuous;
+
+        std::unique_ptr<DepthIndex> depthIndex;
+
+        // Where the current compaction pass stopped
+        enum class CompactionPhase : uint8_t
+        {
+            Bids,
+            Asks,
+            MarketQueues,
+            PegGroups,
+            SpareQueues,
+            OrderStore,
+            OrderIndex,
+            OwnerIndex,
+            Done
+        };
+
+        CompactionPhase compactionPhase = CompactionPhase::Bids;
+        bool compactionResume = false;
+        double compactionPrice = 0.0;   // next level to visit when resuming
+        ShadowFillSimulator* shadows = nullptr;
+
+        // Market orders collected during the call period
+        PriceLevel buyMarketQueue;
+        PriceLevel sellMarketQueue;
+
+        // Pegged orders by offset from their reference, nearest first
+        using PegGroup = std::map<double, PriceLevel>;
+
+        PegGroup buyPrimaryPegs;
+        PegGroup buyMidPegs;
+        PegGroup sellPrimaryPegs;
+        PegGroup sellMidPegs;
+
+        // References of one side's peg groups, read once per sweep
+        struct PegQuotes
+        {
+            bool primary = false;
+            double primaryReference = 0.0;
+            bool mid = false;
+            double midReference = 0.0;
+        };
+
+        // Best level of the merged lit/peg view; group is null for lit
+        struct PassiveLevel
+        {
+            PriceLevel* level = nullptr;
+            double price = 0.0;
+            PegGroup* group = nullptr;
+        };
+
+        template <Side S>
+        [[nodiscard]] PegGroup& pegGroup(PegType peg) noexcept
+        {
+            if constexpr (S == Side::Buy)
+                return (peg == PegType::Primary) ? buyPrimaryPegs : buyMidPegs;
+            else
+                return (peg == PegType::Primary) ? sellPrimaryPegs : sellMidPegs;
+        }
+
+        template <Side S>
+        [[nodiscard]] const PegGroup& pegGroup(PegType peg) const noexcept
+        {
+            if constexpr (S == Side::Buy)
+                return (peg == PegType::Primary) ? buyPrimaryPegs : buyMidPegs;
+            else
+                return (peg == PegType::Primary) ? sellPrimaryPegs : sellMidPegs;
+        }
+
+        template <Side S>
+        [[nodiscard]] static constexpr double pegPrice(double reference, double offset) noexcept
+        {
+            return (S == Side::Buy) ? reference - offset : reference + offset;
+        }
+
+        template <Side S>
+        [[nodiscard]] PriceLevel& marketQueue() noexcept
+        {
+            if constexpr (S == Side::Buy)
+                return buyMarketQueue;
+            else
+                return sellMarketQueue;
+        }
+
+        template <Side S>
+        [[nodiscard]] BookSide<S>& book() noexcept
+        {
+            if constexpr (S == Side::Buy)
+                return bids;
+            else
+                return asks;
+        }
+
+        template <Side S>
+        [[nodiscard]] const BookSide<S>& book() const noexcept
+        {
+            if constexpr (S == Side::Buy)
+                return bids;
+            else
+                return asks;
+        }
+
+        template <Side S>
+        void addOrder(Order& order, uint64_t displayQty);
+
+        template <Side S, OrderType T>
+        void sweep(Order& aggressor);
+
+        template <Side S>
+        void rest(const Order& order, uint64_t displayQty);
+
+        template <Side S>
+        void restMarket(const Order& order);
+
+        template <Side S>
+        void restPegged(const Order& order, PegType peg, double offset);
+
+        template <Side S>
+        [[nodiscard]] bool pegReference(PegType peg, double& reference) const noexcept;
+
+        template <Side S>
+        [[nodiscard]] PegQuotes pegQuotes() const noexcept;
+
+        template <Side S>
+        [[nodiscard]] PassiveLevel nextPassive(const PegQuotes& quotes) noexcept;
+
+        // Whether a limit at `price` would trade with side S's pegs
+        template <Side S>
+        [[nodiscard]] bool crossesPegs(double price) noexcept;
+
+        template <Side S>
+        void cancelPegGroups(MassCancelResult& result);
+
+        template <Side S>
+        void appendPegDepth(std::vector<DepthLevel>& out, PegType peg) const;
+
+        void matchMidPegs();
+
+        template <Side S>
+        bool cancelResting(OrderHandle handle);
+
+        // Feed mirror helpers; the handle is a plain lit limit order
+        [[nodiscard]] OrderHandle findMirrored(uint64_t orderId) const noexcept;
+
+        template <Side S>
+        void reduceResting(OrderHandle handle, uint64_t quantity, bool executed);
+
+        template <Side S>
+        void modifyResting(OrderHandle handle, double price, uint64_t quantity);
+
+        template <Side S>
+        void discardMarketQueue();
+
+        template <Side S>
+        void cancelLevels(typename BookSide<S>::iterator first,
+            typename BookSide<S>::iterator last,
+            MassCancelResult& result);
+
+        template <Side S>
+        void cancelMarketQueue(MassCancelResult& result);
+
+        template <Side S>
+        void cancelPriceRange(double low, double high, MassCancelResult& result);
+
+        template <Side S>
+        uint64_t cancelOwned(OrderHandle handle);
+
+        // One L2 update per distinct touched price; erases emptied levels
+        template <Side S>
+        void settleLevels(std::vector<double>& touched, MassCancelResult& result);
+
+        void linkOwner(OrderHandle handle, uint32_t owner);
+        void releaseOrder(OrderHandle handle, uint32_t owner);
+
+        void executeUncross(const AuctionResult& result);
+
+        template <Side S>
+        [[nodiscard]] QueueTail queueTail(double price) const;
+
+        class CompactionClock;
+
+        // False when the budget ran out before the side was done
+        template <Side S>
+        bool compactLevels(CompactionClock& clock, CompactionResult& result);
+
+        template <Side S>
+        void appendDepth(std::vector<DepthLevel>& out, size_t maxLevels) const;
+
+        void recordTrade(const Trade& trade);
+        void onFrontReduced(PriceLevel& level, uint64_t qty);
+        bool replenish(PriceLevel& level, const RestingOrder& filled);
+        void onLevelCreated(PriceLevel& level);
+        void onLevelErased(Side side, double price, PriceLevel& level);
+        void onSweepFinished(uint64_t levelsTouched);
     };
 
 } // namespace hft
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "OrderBook.hpp"
+
+#include <concepts>
+#include <cstdint>
+#include <vector>
+
+/*
+
+    What MatchingEngine needs from a book.
+
+    Any type satisfying OrderBookLike can back the engine:
+    price-time FIFO matching on addOrder, cancels by id,
+    trade history, top-of-book and aggregated depth, and the
+    clock/metrics/sequence hooks the engine threads through.
+
+    Backends must produce identical trades and depth for
+    identical input; the differential tests hold them to it.
+*/
+
+namespace hft
+{
+
+    template <typename Book>
+    concept OrderBookLike = std::default_initializable<Book>
+        && requires(Book book,
+            const Book& view,
+            Order order,
+            uint64_t orderId,
+            Side side,
+            size_t levels,
+            Timestamp time,
+            uint64_t sequence,
+            MetricsRegistry* metrics)
+    {
+        // Order entry
+        book.addOrder(std::move(order));
+        { book.cancelOrder(orderId) } -> std::same_as<bool>;
+
+        // Trades
+        { view.getTrades() } -> std::same_as<const std::vector<Trade>&>;
+
+        // Market data
+        { view.getBestBid() } -> std::convertible_to<double>;
+        { view.getBestAsk() } -> std::convertible_to<double>;
+        { view.getTotalBidVolume() } -> std::convertible_to<uint64_t>;
+        { view.getTotalAskVolume() } -> std::convertible_to<uint64_t>;
+        { view.getDepth(side, levels) } -> std::same_as<std::vector<DepthLevel>>;
+        view.printTopOfBook();
+        view.printFullDepth();
+
+        // Utilities
+        { view.empty() } -> std::convertible_to<bool>;
+        { view.contains(orderId) } -> std::same_as<bool>;
+        book.clear();
+
+        // Engine hooks
+        book.attachMetrics(metrics);
+        book.setSimulatedTime(time);
+        book.useWallClock();
+        { view.currentTime() } -> std::same_as<Timestamp>;
+        book.setEventSequence(sequence);
+    };
+
+    // Backends that also support call-auction trading
+    template <typename Book>
+    concept AuctionBookLike = OrderBookLike<Book>
+        && requires(Book book, const Book& view, TradingMode mode, double referencePrice)
+    {
+        book.setTradingMode(mode);
+        { view.getTradingMode() } -> std::same_as<TradingMode>;
+        { view.indicativeUncross(referencePrice) } -> std::same_as<AuctionResult>;
+        { book.uncross(referencePrice) } -> std::same_as<AuctionResult>;
+    };
+
+    // Backends that also support bulk cancels
+    template <typename Book>
+    concept MassCancelBookLike = OrderBookLike<Book>
+        && requires(Book book, Side side, double price, uint32_t owner)
+    {
+        { book.cancelSide(side) } -> std::same_as<MassCancelResult>;
+        { book.cancelPriceRange(side, price, price) } -> std::same_as<MassCancelResult>;
+        { book.cancelOwner(owner) } -> std::same_as<MassCancelResult>;
+    };
+
+    // Backends that also support iceberg (reserve) orders
+    template <typename Book>
+    concept IcebergBookLike = OrderBookLike<Book>
+        && requires(Book book, Order order, uint64_t displayQty)
+    {
+        book.addIceberg(std::move(order), displayQty);
+    };
+
+    // Backends that also support pegged orders
+    template <typename Book>
+    concept PeggedBookLike = OrderBookLike<Book>
+        && requires(Book book, Order order, PegType peg, double offset)
+    {
+        book.addPegged(std::move(order), peg, offset);
+    };
+
+    static_assert(OrderBookLike<OrderBook>);
+    static_assert(AuctionBookLike<OrderBook>);
+    static_assert(MassCancelBookLike<OrderBook>);
+    static_assert(IcebergBookLike<OrderBook>);
+    static_assert(PeggedBookLike<OrderBook>);
+
+} // namespace hft
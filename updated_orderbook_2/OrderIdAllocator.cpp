@@ -0,0 +1,44 @@
+#include "OrderIdAllocator.hpp"
+
+namespace hft
+{
+
+    OrderIdAllocator::OrderIdAllocator(uint64_t blockSize) noexcept
+        : size(blockSize == 0 ? 1 : blockSize)
+    {
+    }
+
+    OrderIdAllocator::Range OrderIdAllocator::claimBlock() noexcept
+    {
+        const uint64_t block = nextBlock.fetch_add(1, std::memory_order_relaxed);
+
+        // IDs start at 1; 0 stays the "rejected" sentinel
+        const uint64_t first = 1 + block * size;
+        return { first, first + size };
+    }
+
+    void OrderIdAllocator::reset() noexcept
+    {
+        nextBlock.store(0, std::memory_order_relaxed);
+    }
+
+    void OrderIdAllocator::skipPast(uint64_t id) noexcept
+    {
+        if (id == 0)
+            return;
+
+        // Block (id - 1) / size holds id
+        const uint64_t block = (id - 1) / size + 1;
+
+        if (nextBlock.load(std::memory_order_relaxed) < block)
+            nextBlock.store(block, std::memory_order_relaxed);
+    }
+
+    void OrderIdBlock::refill() noexcept
+    {
+        const OrderIdAllocator::Range range = allocator->claimBlock();
+        nextId = range.first;
+        endId = range.last;
+    }
+
+} // namespace hft
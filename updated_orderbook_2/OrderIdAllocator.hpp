@@ -0,0 +1,98 @@
+#pragma once
+
+#include "HFTUtils.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+/*
+
+    Block-based order-ID allocation.
+
+    A single shared counter hands out whole blocks of IDs;
+    each producer (gateway thread, strategy, the engine's own
+    submitOrder path) draws from its private OrderIdBlock with
+    a plain increment. The shared cache line is touched once
+    per block instead of once per order.
+
+    IDs are unique across all blocks of one allocator and
+    start at 1. Which block a producer receives depends on
+    claim order, so replays take IDs from the journal
+    (MatchingEngine::submitOrderWithId) rather than re-drawing
+    them.
+*/
+
+namespace hft
+{
+
+    class OrderIdAllocator
+    {
+    public:
+
+        static constexpr uint64_t DEFAULT_BLOCK_SIZE = 4096;
+
+        // [first, last)
+        struct Range
+        {
+            uint64_t first;
+            uint64_t last;
+        };
+
+        explicit OrderIdAllocator(uint64_t blockSize = DEFAULT_BLOCK_SIZE) noexcept;
+
+        // Thread-safe
+        [[nodiscard]] Range claimBlock() noexcept;
+
+        [[nodiscard]] uint64_t blockSize() const noexcept
+        {
+            return size;
+        }
+
+        // Only while no producer holds a block
+        void reset() noexcept;
+
+        // Later blocks start above `id` (a replica taking over
+        // from its primary); same restriction as reset()
+        void skipPast(uint64_t id) noexcept;
+
+    private:
+
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> nextBlock{ 0 };
+        uint64_t size;
+    };
+
+    // One per producer thread; never shared
+    class OrderIdBlock
+    {
+    public:
+
+        explicit OrderIdBlock(OrderIdAllocator& allocator_) noexcept
+            : allocator(&allocator_)
+        {
+        }
+
+        [[nodiscard]] uint64_t next() noexcept
+        {
+            if (nextId == endId)
+                refill();
+
+            return nextId++;
+        }
+
+        // Forget the current block (after the allocator was reset)
+        void reset() noexcept
+        {
+            nextId = 0;
+            endId = 0;
+        }
+
+    private:
+
+        OrderIdAllocator* allocator;
+        uint64_t nextId = 0;
+        uint64_t endId = 0;
+
+        void refill() noexcept;
+    };
+
+} // namespace hft
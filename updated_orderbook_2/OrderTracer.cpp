@@ -0,0 +1,216 @@
+#include "OrderTracer.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+
+namespace hft
+{
+
+    namespace
+    {
+        // Shortest calibration window for the tick rate
+        constexpr auto MIN_CALIBRATION = std::chrono::milliseconds(5);
+
+        void writeSpan(std::ostream& out,
+            bool& first,
+            const char* name,
+            const OrderTrace& trace,
+            uint64_t begin,
+            uint64_t end,
+            uint64_t origin,
+            double ticksPerMicrosecond)
+        {
+            if (begin == 0 || end < begin)
+                return;
+
+            out << (first ? "\n" : ",\n");
+            first = false;
+
+            out << "{\"name\":\"" << name << "\",\"cat\":\"order\",\"ph\":\"X\",\"pid\":1"
+                << ",\"tid\":" << trace.thread
+                << ",\"ts\":" << static_cast<double>(begin - origin) / ticksPerMicrosecond
+                << ",\"dur\":" << static_cast<double>(end - begin) / ticksPerMicrosecond
+                << ",\"args\":{\"orderId\":" << trace.orderId << "}}";
+        }
+    }
+
+    OrderTracer::Buffer::Buffer(size_t capacity_, uint32_t thread_)
+        : thread(thread_),
+        capacity(capacity_),
+        traces(std::make_unique<OrderTrace[]>(capacity_))
+    {
+    }
+
+    OrderTracer::OrderTracer(Options options_)
+        : options(options_),
+        tracerId(ThreadSlotRegistry<Buffer>::nextOwnerId()),
+        every(options_.sampleEvery),
+        originTicks(traceClock()),
+        originTime(std::chrono::steady_clock::now())
+    {
+        if (options.tracesPerThread == 0)
+            throw std::invalid_argument("OrderTracer: tracesPerThread must be positive");
+    }
+
+    OrderTracer::~OrderTracer()
+    {
+        ThreadSlotRegistry<Buffer>::release(tracerId);
+    }
+
+    void OrderTracer::registerCurrentThread()
+    {
+        (void)localBuffer();
+    }
+
+    void OrderTracer::setSampleEvery(uint32_t period) noexcept
+    {
+        every.store(period, std::memory_order_relaxed);
+    }
+
+    uint32_t OrderTracer::sampleEvery() const noexcept
+    {
+        return every.load(std::memory_order_relaxed);
+    }
+
+    void OrderTracer::record(const OrderTrace& trace) noexcept
+    {
+        // Set up by the sample() that started this trace
+        Buffer* found = ThreadSlotRegistry<Buffer>::find(tracerId);
+        if (found == nullptr)
+            return;
+
+        Buffer& buffer = *found;
+        const size_t index = buffer.count.load(std::memory_order_relaxed);
+        if (index == buffer.capacity)
+        {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        buffer.traces[index] = trace;
+        buffer.traces[index].thread = buffer.thread;
+        buffer.count.store(index + 1, std::memory_order_release);
+    }
+
+    OrderTracer::Buffer* OrderTracer::registerThread()
+    {
+        std::lock_guard lock(bufferMutex);
+        buffers.push_back(std::make_unique<Buffer>(options.tracesPerThread,
+            static_cast<uint32_t>(buffers.size())));
+        return buffers.back().get();
+    }
+
+    // ============================================================
+    // EXPORT
+    // ============================================================
+
+    std::vector<OrderTrace> OrderTracer::traces() const
+    {
+        std::lock_guard lock(bufferMutex);
+
+        std::vector<OrderTrace> all;
+        for (const auto& buffer : buffers)
+        {
+            const size_t count = buffer->count.load(std::memory_order_acquire);
+            all.insert(all.end(), buffer->traces.get(), buffer->traces.get() + count);
+        }
+
+        return all;
+    }
+
+    uint64_t OrderTracer::droppedCount() const noexcept
+    {
+        std::lock_guard lock(bufferMutex);
+
+        uint64_t total = 0;
+        for (const auto& buffer : buffers)
+            total += buffer->dropped.load(std::memory_order_relaxed);
+
+        return total;
+    }
+
+    void OrderTracer::clear() noexcept
+    {
+        std::lock_guard lock(bufferMutex);
+
+        for (const auto& buffer : buffers)
+        {
+            buffer->count.store(0, std::memory_order_relaxed);
+            buffer->dropped.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    double OrderTracer::ticksPerMicrosecond() const
+    {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        // Wait out a window long enough to give a stable rate
+        while (std::chrono::steady_clock::now() - originTime < MIN_CALIBRATION)
+            std::this_thread::yield();
+
+        const uint64_t ticks = traceClock() - originTicks;
+        const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - originTime);
+        return static_cast<double>(ticks) / elapsed.count();
+#else
+        return 1'000.0;
+#endif
+    }
+
+    void OrderTracer::writeChromeTrace(std::ostream& out) const
+    {
+        const double rate = ticksPerMicrosecond();
+        const std::vector<OrderTrace> all = traces();
+
+        const auto flags = out.flags();
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+        bool first = true;
+        uint32_t threads = 0;
+
+        for (const OrderTrace& trace : all)
+        {
+            const uint64_t received = trace.at(TracePoint::Received);
+            const uint64_t validated = trace.at(TracePoint::Validated);
+            const uint64_t booked = trace.at(TracePoint::Booked);
+            const uint64_t published = trace.at(TracePoint::Published);
+
+            const bool rejected = (trace.orderId == 0);
+            writeSpan(out, first, rejected ? "submitOrder (rejected)" : "submitOrder",
+                trace, received, rejected ? validated : published, originTicks, rate);
+            writeSpan(out, first, "validateSubmission", trace, received, validated, originTicks, rate);
+            writeSpan(out, first, trace.market ? "executeMarketOrder" : "matchOrder",
+                trace, validated, booked, originTicks, rate);
+            writeSpan(out, first, "publish", trace, booked, published, originTicks, rate);
+
+            threads = std::max(threads, trace.thread + 1);
+        }
+
+        for (uint32_t thread = 0; thread < threads; ++thread)
+        {
+            out << (first ? "\n" : ",\n");
+            first = false;
+
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread
+                << ",\"args\":{\"name\":\"engine thread " << thread << "\"}}";
+        }
+
+        out << "\n]}\n";
+        out.flags(flags);
+    }
+
+    void OrderTracer::writeChromeTrace(const std::string& path) const
+    {
+        std::ofstream out(path, std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("OrderTracer: cannot open " + path);
+
+        writeChromeTrace(out);
+
+        if (!out)
+            throw std::runtime_error("OrderTracer: write failed for " + path);
+    }
+
+} // namespace hft
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "HFTUtils.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#endif
+
+/*
+
+    Sampled per-order lifecycle tracing.
+
+    One submit in every N (setSampleEvery; 0 turns sampling off)
+    is stamped with the time-stamp counter as it passes each
+    point of its life in the engine:
+
+        received -> validated -> booked -> published
+
+    giving the spans submitOrder, validateSubmission, matchOrder
+    (the book's add, match or market sweep) and publish (trade
+    log and replication). A rejected order stops at validated.
+
+    The stamps of one order go into a preallocated buffer owned
+    by the calling thread: no lock, no allocation, no shared
+    cache line. A thread that has not called
+    registerCurrentThread() gets its buffer on its first
+    sample() instead; if that allocation fails, its orders go
+    untraced. A full buffer drops the trace and counts it.
+
+    writeChromeTrace() converts the buffers offline into Chrome
+    trace-event JSON, readable by chrome://tracing and Perfetto.
+    Ticks are turned into time by comparing the counter with
+    the steady clock over the tracer's lifetime.
+
+    With no tracer attached the engine pays one branch per
+    submit; with one attached and sampling off, one relaxed
+    load more.
+*/
+
+namespace hft
+{
+
+    // Time-stamp counter where there is one, steady-clock ns elsewhere
+    [[nodiscard]] inline uint64_t traceClock() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    enum class TracePoint : uint8_t
+    {
+        Received,
+        Validated,
+        Booked,
+        Published,
+        Count
+    };
+
+    struct OrderTrace
+    {
+        uint64_t orderId = 0;                                   // 0 if rejected
+        uint64_t ticks[static_cast<size_t>(TracePoint::Count)] = {};   // 0 where not reached
+        uint32_t thread = 0;                                    // tracer-assigned index
+        bool market = false;
+
+        void mark(TracePoint point) noexcept
+        {
+            ticks[static_cast<size_t>(point)] = traceClock();
+        }
+
+        [[nodiscard]] uint64_t at(TracePoint point) const noexcept
+        {
+            return ticks[static_cast<size_t>(point)];
+        }
+    };
+
+    struct OrderTracerOptions
+    {
+        size_t tracesPerThread = 1 << 16;
+        uint32_t sampleEvery = 0;   // 0: off
+    };
+
+    class OrderTracer
+    {
+    public:
+
+        using Options = OrderTracerOptions;
+
+        explicit OrderTracer(Options options = {});
+        ~OrderTracer();
+
+        OrderTracer(const OrderTracer&) = delete;
+        OrderTracer& operator=(const OrderTracer&) = delete;
+
+        // Any thread, at any time; 0 turns sampling off
+        void setSampleEvery(uint32_t period) noexcept;
+        [[nodiscard]] uint32_t sampleEvery() const noexcept;
+
+        // Allocates the calling thread's buffer up front, off the
+        // submit path; throws std::bad_alloc. Idempotent.
+        void registerCurrentThread();
+
+        // Producer side: whether to trace the calling thread's next
+        // order; false if the thread has no buffer and none can be made
+        [[nodiscard]] bool sample() noexcept;
+
+        // Stores a finished trace in the calling thread's buffer
+        void record(const OrderTrace& trace) noexcept;
+
+        // Offline side: copies of every stored trace, thread by thread
+        [[nodiscard]] std::vector<OrderTrace> traces() const;
+        [[nodiscard]] uint64_t droppedCount() const noexcept;
+
+        // Chrome trace-event JSON; the path overload throws
+        // std::runtime_error if the file cannot be written
+        void writeChromeTrace(std::ostream& out) const;
+        void writeChromeTrace(const std::string& path) const;
+
+        // Only while no thread is recording
+        void clear() noexcept;
+
+    private:
+
+        struct Buffer
+        {
+            Buffer(size_t capacity_, uint32_t thread_);
+
+            // Written by the owning thread, read by exporters
+            alignas(CACHE_LINE_SIZE) std::atomic<size_t> count{ 0 };
+            uint32_t sinceSample = 0;
+            uint32_t thread;
+
+            alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> dropped{ 0 };
+
+            size_t capacity;
+            std::unique_ptr<OrderTrace[]> traces;
+        };
+
+        Options options;
+        const uint64_t tracerId;
+        std::atomic<uint32_t> every;
+
+        // Counter and clock read together, for tick conversion
+        uint64_t originTicks;
+        std::chrono::steady_clock::time_point originTime;
+
+        mutable std::mutex bufferMutex;
+        std::vector<std::unique_ptr<Buffer>> buffers;
+
+        [[nodiscard]] Buffer& localBuffer();
+
+        // The calling thread's buffer, or null if it cannot be made
+        [[nodiscard]] Buffer* tryLocalBuffer() noexcept;
+
+        // A new buffer for the calling thread
+        [[nodiscard]] Buffer* registerThread();
+
+        [[nodiscard]] double ticksPerMicrosecond() const;
+    };
+
+    inline bool OrderTracer::sample() noexcept
+    {
+        const uint32_t period = every.load(std::memory_order_relaxed);
+        if (period == 0)
+            return false;
+
+        Buffer* buffer = tryLocalBuffer();
+        if (buffer == nullptr || ++buffer->sinceSample < period)
+            return false;
+
+        buffer->sinceSample = 0;
+        return true;
+    }
+
+    inline OrderTracer::Buffer& OrderTracer::localBuffer()
+    {
+        return ThreadSlotRegistry<Buffer>::local(tracerId, [this] { return registerThread(); });
+    }
+
+    inline OrderTracer::Buffer* OrderTracer::tryLocalBuffer() noexcept
+    {
+        if (Buffer* buffer = ThreadSlotRegistry<Buffer>::find(tracerId))
+            return buffer;
+
+        try
+        {
+            return &localBuffer();
+        }
+        catch (...)
+        {
+            return nullptr;
+        }
+    }
+
+} // namespace hft
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "MatchingEngine.hpp"
+#include "OrderBook.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+/*
+
+    Binary order-entry protocol.
+
+    Every message is a fixed-layout, packed, little-endian
+    struct starting with a 4-byte header. Receivers decode in
+    place: once `header.length` bytes are buffered, the bytes
+    are read through messageAt<T>() with no copy and no
+    allocation. Lengths are fixed per type, so a mismatch is a
+    protocol error and the connection is dropped.
+
+    Client -> gateway: NewOrder, CancelOrder, ReplaceOrder
+    Gateway -> client: OrderAck, OrderReject, Fill,
+                       CancelAck, CancelReject, ReplaceAck
+
+    clientOrderId is chosen by the client and echoed back;
+    orderId is the engine id from the ack.
+*/
+
+namespace hft::wire
+{
+
+    static_assert(std::endian::native == std::endian::little,
+        "wire structs are laid out little-endian");
+
+    enum class MessageType : uint8_t
+    {
+        NewOrder = 1,
+        CancelOrder = 2,
+        ReplaceOrder = 3,
+
+        OrderAck = 10,
+        OrderReject = 11,
+        Fill = 12,
+        CancelAck = 13,
+        CancelReject = 14,
+        ReplaceAck = 15
+    };
+
+#pragma pack(push, 1)
+
+    struct MessageHeader
+    {
+        uint16_t length;
+        MessageType type;
+        uint8_t reserved;
+    };
+
+    struct NewOrder
+    {
+        MessageHeader header;
+        uint64_t clientOrderId;
+        double price;
+        uint64_t quantity;
+        Side side;
+        OrderType orderType;
+        uint8_t reserved[6];
+    };
+
+    struct CancelOrder
+    {
+        MessageHeader header;
+        uint64_t clientOrderId;
+        uint64_t orderId;
+    };
+
+    // Cancel-replace: the replacement gets a new id and queue position
+    struct ReplaceOrder
+    {
+        MessageHeader header;
+        uint64_t clientOrderId;
+        uint64_t orderId;
+        double price;
+        uint64_t quantity;
+    };
+
+    struct OrderAck
+    {
+        MessageHeader header;
+        uint64_t clientOrderId;
+        uint64_t orderId;
+    };
+
+    struct OrderReject
+    {
+        MessageHeader header;
+        uint64_t clientOrderId;
+        RejectReason reason;
+        uint8_t reserved[7];
+    };
+
+    struct Fill
+    {
+        MessageHeader header;
+        uint64_t clientOrderId;
+        uint64_t orderId;
+        double price;
+        uint64_t quantity;
+    };
+
+    struct CancelAck
+    {
+        MessageHeader header;
+        uint64_t clientOrderId;
+        uint64_t orderId;
+    };
+
+    struct CancelReject
+    {
+        MessageHeader header;
+        uint64_t clientOrderId;
+        uint64_t orderId;
+    };
+
+    struct ReplaceAck
+    {
+        MessageHeader header;
+        uint64_t clientOrderId;
+        uint64_t oldOrderId;
+        uint64_t newOrderId;
+    };
+
+#pragma pack(pop)
+
+    static_assert(sizeof(MessageHeader) == 4);
+    static_assert(sizeof(NewOrder) == 36);
+    static_assert(sizeof(CancelOrder) == 20);
+    static_assert(sizeof(ReplaceOrder) == 36);
+    static_assert(sizeof(OrderAck) == 20);
+    static_assert(sizeof(OrderReject) == 20);
+    static_assert(sizeof(Fill) == 36);
+    static_assert(sizeof(ReplaceAck) == 28);
+
+    // Largest message either side can send
+    constexpr size_t MAX_MESSAGE_SIZE = 36;
+
+    // Wire size for a type; 0 for unknown types
+    [[nodiscard]] constexpr size_t messageSize(MessageType type) noexcept
+    {
+        switch (type)
+        {
+        case MessageType::NewOrder:     return sizeof(NewOrder);
+        case MessageType::CancelOrder:  return sizeof(CancelOrder);
+        case MessageType::ReplaceOrder: return sizeof(ReplaceOrder);
+        case MessageType::OrderAck:     return sizeof(OrderAck);
+        case MessageType::OrderReject:  return sizeof(OrderReject);
+        case MessageType::Fill:         return sizeof(Fill);
+        case MessageType::CancelAck:    return sizeof(CancelAck);
+        case MessageType::CancelReject: return sizeof(CancelReject);
+        case MessageType::ReplaceAck:   return sizeof(ReplaceAck);
+        }
+
+        return 0;
+    }
+
+    // Header pre-filled for message type T
+    template <typename T>
+    [[nodiscard]] constexpr MessageHeader headerFor(MessageType type) noexcept
+    {
+        return { static_cast<uint16_t>(sizeof(T)), type, 0 };
+    }
+
+    // In-place view of a buffered message (packed structs have alignment 1)
+    template <typename T>
+    [[nodiscard]] const T& messageAt(const std::byte* data) noexcept
+    {
+        static_assert(alignof(T) == 1);
+        return *reinterpret_cast<const T*>(data);
+    }
+
+} // namespace hft::wire
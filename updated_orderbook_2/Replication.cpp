@@ -0,0 +1,210 @@
+#include "Replication.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+namespace hft
+{
+
+    namespace
+    {
+        constexpr char CHANNEL_MAGIC[8] = { 'H', 'F', 'T', 'R', 'E', 'P', 'L', '1' };
+
+        // Records start on their own cache line after the header
+        constexpr size_t RING_OFFSET = (sizeof(ReplicationRingHeader) + CACHE_LINE_SIZE - 1)
+            / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+
+        int64_t steadyNowNs() noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+    }
+
+    // ============================================================
+    // PRIMARY
+    // ============================================================
+
+    ReplicationPublisher::ReplicationPublisher(const std::string& path,
+        size_t capacity,
+        std::chrono::nanoseconds stallTimeout_)
+        : stallTimeout(stallTimeout_)
+    {
+        if (capacity == 0 || !std::has_single_bit(capacity))
+            throw std::invalid_argument("ReplicationPublisher: capacity must be a power of two");
+
+        mapping.create(path, RING_OFFSET + capacity * sizeof(ReplicationRecord));
+
+        // The file starts zeroed; the atomics are constructed in place
+        header = new (mapping.data()) ReplicationRingHeader{};
+        header->capacity = capacity;
+        header->heartbeatNs.store(steadyNowNs(), std::memory_order_relaxed);
+
+        slots = reinterpret_cast<ReplicationRecord*>(mapping.data() + RING_OFFSET);
+        mask = capacity - 1;
+
+        // Magic last: a standby that sees it sees a complete header
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(header->magic, CHANNEL_MAGIC, sizeof(CHANNEL_MAGIC));
+    }
+
+    ReplicationPublisher::~ReplicationPublisher()
+    {
+        close();
+    }
+
+    void ReplicationPublisher::publish(const ReplicationRecord& record) noexcept
+    {
+        if (standbyDetached || (next - consumedCache > mask && !waitForSpace()))
+        {
+            ++dropped;
+            return;
+        }
+
+        slots[next & mask] = record;
+        header->published.store(++next, std::memory_order_release);
+    }
+
+    bool ReplicationPublisher::waitForSpace() noexcept
+    {
+        ++waits;
+        const int64_t deadline = steadyNowNs() + stallTimeout.count();
+
+        // Ring full: wait for the standby to free a slot
+        while (next - (consumedCache = header->consumed.load(std::memory_order_acquire)) > mask)
+        {
+            if (steadyNowNs() > deadline)
+            {
+                standbyDetached = true;
+                header->detached.store(1, std::memory_order_release);
+                return false;
+            }
+
+            std::this_thread::yield();
+        }
+
+        return true;
+    }
+
+    void ReplicationPublisher::heartbeat() noexcept
+    {
+        header->heartbeatNs.store(steadyNowNs(), std::memory_order_relaxed);
+    }
+
+    void ReplicationPublisher::close() noexcept
+    {
+        if (header)
+            header->closed.store(1, std::memory_order_release);
+    }
+
+    uint64_t ReplicationPublisher::acknowledgedSequence() const noexcept
+    {
+        return header->acknowledged.load(std::memory_order_acquire);
+    }
+
+    uint64_t ReplicationPublisher::publishedCount() const noexcept
+    {
+        return next;
+    }
+
+    uint64_t ReplicationPublisher::fullWaits() const noexcept
+    {
+        return waits;
+    }
+
+    bool ReplicationPublisher::detached() const noexcept
+    {
+        return standbyDetached;
+    }
+
+    uint64_t ReplicationPublisher::droppedCount() const noexcept
+    {
+        return dropped;
+    }
+
+    // ============================================================
+    // STANDBY
+    // ============================================================
+
+    ReplicationSubscriber::ReplicationSubscriber(const std::string& path)
+    {
+        mapping.open(path);
+
+        if (mapping.size() < RING_OFFSET)
+            throw std::runtime_error("ReplicationSubscriber: truncated header in " + path);
+
+        header = reinterpret_cast<ReplicationRingHeader*>(mapping.data());
+
+        if (std::memcmp(header->magic, CHANNEL_MAGIC, sizeof(CHANNEL_MAGIC)) != 0)
+            throw std::runtime_error("ReplicationSubscriber: bad magic in " + path);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        const uint64_t capacity = header->capacity;
+        if (capacity == 0 || !std::has_single_bit(capacity)
+            || mapping.size() != RING_OFFSET + capacity * sizeof(ReplicationRecord))
+            throw std::runtime_error("ReplicationSubscriber: size mismatch in " + path);
+
+        slots = reinterpret_cast<const ReplicationRecord*>(mapping.data() + RING_OFFSET);
+        mask = capacity - 1;
+        next = header->consumed.load(std::memory_order_acquire);
+
+        lastPublished = header->published.load(std::memory_order_acquire);
+        lastProgressNs = steadyNowNs();
+    }
+
+    size_t ReplicationSubscriber::poll(std::span<ReplicationRecord> out) noexcept
+    {
+        const uint64_t published = header->published.load(std::memory_order_acquire);
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(published - next, out.size()));
+
+        for (size_t i = 0; i < count; ++i)
+            out[i] = slots[(next + i) & mask];
+
+        // Slots are copied out, so the primary may reuse them now
+        next += count;
+        if (count > 0)
+            header->consumed.store(next, std::memory_order_release);
+
+        return count;
+    }
+
+    bool ReplicationSubscriber::pending() const noexcept
+    {
+        return header->published.load(std::memory_order_acquire) != next;
+    }
+
+    void ReplicationSubscriber::acknowledge(uint64_t sequence) noexcept
+    {
+        header->acknowledged.store(sequence, std::memory_order_release);
+    }
+
+    bool ReplicationSubscriber::detached() const noexcept
+    {
+        return header->detached.load(std::memory_order_acquire) != 0;
+    }
+
+    bool ReplicationSubscriber::primaryAlive(std::chrono::nanoseconds timeout) noexcept
+    {
+        if (header->closed.load(std::memory_order_acquire) != 0)
+            return false;
+
+        const int64_t now = steadyNowNs();
+
+        // New records count as a heartbeat, so a busy primary never stops to send one
+        const uint64_t published = header->published.load(std::memory_order_acquire);
+        if (published != lastPublished)
+        {
+            lastPublished = published;
+            lastProgressNs = now;
+        }
+
+        const int64_t lastSign = std::max(lastProgressNs, header->heartbeatNs.load(std::memory_order_relaxed));
+        return now - lastSign <= timeout.count();
+    }
+
+} // namespace hft
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "HFTUtils.hpp"
+#include "MappedFile.hpp"
+#include "OrderBook.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <type_traits>
+
+/*
+
+    Hot-standby replication channel.
+
+    The primary engine publishes every accepted, sequenced
+    input (submits with the ids it assigned, cancels, mass
+    cancels, mode changes, uncrosses) as one fixed 64-byte
+    record into a single-producer single-consumer ring held in
+    a shared file mapping. A standby process maps the same
+    file, applies the records to its own engine in order
+    (MatchingEngine::followReplication) and acknowledges the
+    sequence it reached.
+
+    Publishing is a slot write and a release store: the
+    primary never waits for the standby, only for ring space,
+    and not for longer than its stall timeout. A standby that
+    frees no slot in that time is detached: the flag is raised
+    in the header and every later record is dropped and
+    counted, so a dead or stuck standby cannot stop matching.
+    A detached replica is incomplete and must not take over.
+    Records carry the primary's ids and event timestamps, so
+    the standby's book, trades and sequence follow the
+    primary's event for event.
+
+    The standby counts new records as signs of life; an idle
+    primary calls heartbeat() instead. A standby that finds
+    the channel closed, or no sign of life within its timeout,
+    drains what is left and takes over (MatchingEngine::
+    takeOver). Heartbeats use the steady clock, which is
+    shared by processes on one machine.
+*/
+
+namespace hft
+{
+
+    // ============================================================
+    // RECORDS
+    // ============================================================
+
+    enum class ReplicatedAction : uint8_t
+    {
+        Submit,
+        Iceberg,
+        Pegged,
+        Cancel,
+        CancelSide,
+        CancelPriceRange,
+        CancelOwner,
+        SetTradingMode,
+        Uncross
+    };
+
+    struct ReplicationRecord
+    {
+        uint64_t sequence = 0;      // engine sequence the event took
+        int64_t timestampNs = 0;    // engine clock at the event
+        uint64_t orderId = 0;
+        double price = 0.0;         // limit price, peg offset, range low or reference price
+        double high = 0.0;          // range high
+        uint64_t quantity = 0;
+        uint64_t displayQty = 0;
+        uint32_t owner = 0;
+        ReplicatedAction action{};
+        Side side{};
+        OrderType type{};
+        uint8_t mode = 0;           // PegType or TradingMode
+    };
+
+    static_assert(sizeof(ReplicationRecord) == 64);
+    static_assert(std::is_trivially_copyable_v<ReplicationRecord>);
+
+    // Start of the shared mapping; the record ring follows it
+    struct ReplicationRingHeader
+    {
+        char magic[8];
+        uint64_t capacity;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> published;      // records written
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> consumed;       // records read
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> acknowledged;   // sequence applied by the standby
+        alignas(CACHE_LINE_SIZE) std::atomic<int64_t> heartbeatNs;
+        std::atomic<uint32_t> closed;
+        std::atomic<uint32_t> detached;   // the primary stopped publishing to this standby
+    };
+
+    // Shared between processes: the atomics must not hide a lock
+    static_assert(std::atomic<uint64_t>::is_always_lock_free);
+    static_assert(std::atomic<int64_t>::is_always_lock_free);
+    static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+    // ============================================================
+    // PRIMARY
+    // ============================================================
+
+    class ReplicationPublisher
+    {
+    public:
+
+        static constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+        static constexpr std::chrono::milliseconds DEFAULT_STALL_TIMEOUT{ 100 };
+
+        // Creates the channel file with room for `capacity` records.
+        // Throws std::invalid_argument unless capacity is a power
+        // of two, std::runtime_error if the file cannot be mapped.
+        explicit ReplicationPublisher(const std::string& path,
+            size_t capacity = DEFAULT_CAPACITY,
+            std::chrono::nanoseconds stallTimeout = DEFAULT_STALL_TIMEOUT);
+
+        // Closes the channel: a graceful stop looks like a failure
+        // to the standby, which then takes over at once
+        ~ReplicationPublisher();
+
+        ReplicationPublisher(const ReplicationPublisher&) = delete;
+        ReplicationPublisher& operator=(const ReplicationPublisher&) = delete;
+
+        // Spins only while the ring is full, for at most the stall
+        // timeout; then detaches the standby and drops the record
+        void publish(const ReplicationRecord& record) noexcept;
+
+        // Keeps an idle primary alive to the standby
+        void heartbeat() noexcept;
+
+        void close() noexcept;
+
+        [[nodiscard]] uint64_t acknowledgedSequence() const noexcept;
+        [[nodiscard]] uint64_t publishedCount() const noexcept;
+
+        // publish() calls that found the ring full
+        [[nodiscard]] uint64_t fullWaits() const noexcept;
+
+        // Whether the standby was cut loose, and the records not
+        // published since
+        [[nodiscard]] bool detached() const noexcept;
+        [[nodiscard]] uint64_t droppedCount() const noexcept;
+
+    private:
+
+        SharedMapping mapping;
+        ReplicationRingHeader* header = nullptr;
+        ReplicationRecord* slots = nullptr;
+        uint64_t mask = 0;
+
+        std::chrono::nanoseconds stallTimeout;
+
+        uint64_t next = 0;
+        uint64_t consumedCache = 0;   // refreshed only when the ring looks full
+        uint64_t waits = 0;
+
+        bool standbyDetached = false;
+        uint64_t dropped = 0;
+
+        // Waits for a free slot; false if the stall timeout ran out
+        bool waitForSpace() noexcept;
+    };
+
+    // ============================================================
+    // STANDBY
+    // ============================================================
+
+    class ReplicationSubscriber
+    {
+    public:
+
+        // Maps and validates an existing channel; throws std::runtime_error
+        explicit ReplicationSubscriber(const std::string& path);
+
+        // Copies up to out.size() waiting records; returns the count
+        [[nodiscard]] size_t poll(std::span<ReplicationRecord> out) noexcept;
+
+        [[nodiscard]] bool pending() const noexcept;
+
+        // Engine sequence the standby has applied
+        void acknowledge(uint64_t sequence) noexcept;
+
+        // False once the channel is closed, or when neither a record
+        // nor a heartbeat arrived within timeout
+        [[nodiscard]] bool primaryAlive(std::chrono::nanoseconds timeout) noexcept;
+
+        // True once the primary gave up waiting for this standby;
+        // records after the ones still pending were dropped
+        [[nodiscard]] bool detached() const noexcept;
+
+    private:
+
+        SharedMapping mapping;
+        ReplicationRingHeader* header = nullptr;
+        const ReplicationRecord* slots = nullptr;
+        uint64_t mask = 0;
+        uint64_t next = 0;
+
+        uint64_t lastPublished = 0;
+        int64_t lastProgressNs = 0;
+    };
+
+} // namespace hft
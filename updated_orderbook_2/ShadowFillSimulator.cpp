@@ -0,0 +1,298 @@
+#include "ShadowFillSimulator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hft
+{
+
+    ShadowFillSimulator::ShadowFillSimulator(const OrderBook& book_)
+        : book(book_)
+    {
+    }
+
+    // ============================================================
+    // SHADOW ORDERS
+    // ============================================================
+
+    uint64_t ShadowFillSimulator::place(Side side, double price, uint64_t quantity)
+    {
+        if (quantity == 0 || !(price > 0.0) || !std::isfinite(price))
+            return 0;
+
+        if (side == Side::Buy)
+            return place<Side::Buy>(price, quantity);
+
+        return place<Side::Sell>(price, quantity);
+    }
+
+    template <Side S>
+    uint64_t ShadowFillSimulator::place(double price, uint64_t quantity)
+    {
+        // Resting liquidity only: a marketable order would take
+        const double opposite = (S == Side::Buy) ? book.getBestAsk() : book.getBestBid();
+        if (opposite != 0.0 && SideTraits<S>::crosses(price, opposite))
+            return 0;
+
+        const QueueTail tail = book.queueTail(S, price);
+        const uint64_t id = nextId++;
+
+        shadows<S>()[price].push_back({ id, S, price, quantity, quantity, tail.volume, tail.nextSlot });
+        locations.emplace(id, Location{ S, price });
+
+        return id;
+    }
+
+    bool ShadowFillSimulator::cancel(uint64_t shadowId)
+    {
+        const auto it = locations.find(shadowId);
+        if (it == locations.end())
+            return false;
+
+        const Location location = it->second;
+        locations.erase(it);
+
+        if (location.side == Side::Buy)
+            return cancel<Side::Buy>(shadowId, location.price);
+
+        return cancel<Side::Sell>(shadowId, location.price);
+    }
+
+    template <Side S>
+    bool ShadowFillSimulator::cancel(uint64_t shadowId, double price)
+    {
+        auto& side = shadows<S>();
+        const auto levelIt = side.find(price);
+        ShadowQueue& queue = levelIt->second;
+
+        queue.erase(std::find_if(queue.begin(), queue.end(),
+            [shadowId](const ShadowOrder& order) { return order.id == shadowId; }));
+
+        if (queue.empty())
+            side.erase(levelIt);
+
+        return true;
+    }
+
+    const ShadowOrder* ShadowFillSimulator::find(uint64_t shadowId) const
+    {
+        const auto it = locations.find(shadowId);
+        if (it == locations.end())
+            return nullptr;
+
+        if (it->second.side == Side::Buy)
+            return find<Side::Buy>(shadowId, it->second.price);
+
+        return find<Side::Sell>(shadowId, it->second.price);
+    }
+
+    template <Side S>
+    const ShadowOrder* ShadowFillSimulator::find(uint64_t shadowId, double price) const
+    {
+        const ShadowQueue& queue = shadows<S>().find(price)->second;
+
+        for (const ShadowOrder& order : queue)
+        {
+            if (order.id == shadowId)
+                return &order;
+        }
+
+        return nullptr;
+    }
+
+    const std::vector<ShadowFill>& ShadowFillSimulator::getFills() const noexcept
+    {
+        return fills;
+    }
+
+    size_t ShadowFillSimulator::openOrders() const noexcept
+    {
+        return locations.size();
+    }
+
+    void ShadowFillSimulator::clear()
+    {
+        bids.clear();
+        asks.clear();
+        locations.clear();
+        fills.clear();
+    }
+
+    // ============================================================
+    // BOOK EVENTS
+    // ============================================================
+
+    void ShadowFillSimulator::onFill(Side side, double price, uint64_t slot, uint64_t quantity)
+    {
+        if (side == Side::Buy)
+            fillBehind<Side::Buy>(price, slot, quantity);
+        else
+            fillBehind<Side::Sell>(price, slot, quantity);
+    }
+
+    void ShadowFillSimulator::onCancel(Side side, double price, uint64_t slot, uint64_t quantity)
+    {
+        if (side == Side::Buy)
+            countDown<Side::Buy>(price, slot, quantity);
+        else
+            countDown<Side::Sell>(price, slot, quantity);
+    }
+
+    void ShadowFillSimulator::onRest(Side side, double price, uint64_t quantity)
+    {
+        // A resting sell can only have crossed shadow bids, and vice versa
+        if (side == Side::Buy)
+            fillCrossed<Side::Sell>(price, quantity);
+        else
+            fillCrossed<Side::Buy>(price, quantity);
+    }
+
+    void ShadowFillSimulator::onLevelErased(Side side, double price)
+    {
+        if (side == Side::Buy)
+            resetQueue<Side::Buy>(price);
+        else
+            resetQueue<Side::Sell>(price);
+    }
+
+    void ShadowFillSimulator::onBookCleared()
+    {
+        resetQueues<Side::Buy>();
+        resetQueues<Side::Sell>();
+    }
+
+    template <Side S>
+    void ShadowFillSimulator::fillBehind(double price, uint64_t slot, uint64_t quantity)
+    {
+        auto& side = shadows<S>();
+        if (side.empty())
+            return;
+
+        const typename SideTraits<S>::Compare better;
+        uint64_t available = quantity;
+
+        // Trade-through: shadow levels priced better were skipped over
+        auto it = side.begin();
+        while (it != side.end() && available > 0 && better(it->first, price))
+        {
+            available = allocate(it->second, it->second.size(), available);
+            it = it->second.empty() ? side.erase(it) : std::next(it);
+        }
+
+        it = side.find(price);
+        if (it == side.end())
+            return;
+
+        ShadowQueue& queue = it->second;
+
+        // Slots ascend through the queue: a prefix was ahead of the
+        // filled order, the rest was behind it and moves up
+        size_t ahead = 0;
+        while (ahead < queue.size() && queue[ahead].slot <= slot)
+            ++ahead;
+
+        for (size_t i = ahead; i < queue.size(); ++i)
+            queue[i].volumeAhead -= std::min(queue[i].volumeAhead, quantity);
+
+        if (ahead > 0 && available > 0)
+        {
+            (void)allocate(queue, ahead, available);
+
+            if (queue.empty())
+                side.erase(it);
+        }
+    }
+
+    template <Side S>
+    void ShadowFillSimulator::fillCrossed(double price, uint64_t quantity)
+    {
+        auto& side = shadows<S>();
+        uint64_t available = quantity;
+
+        // Best first: every shadow level the new order would have hit
+        auto it = side.begin();
+        while (it != side.end() && available > 0 && SideTraits<S>::crosses(it->first, price))
+        {
+            available = allocate(it->second, it->second.size(), available);
+            it = it->second.empty() ? side.erase(it) : std::next(it);
+        }
+    }
+
+    template <Side S>
+    void ShadowFillSimulator::countDown(double price, uint64_t slot, uint64_t quantity)
+    {
+        auto& side = shadows<S>();
+        if (side.empty())
+            return;
+
+        const auto it = side.find(price);
+        if (it == side.end())
+            return;
+
+        // Only orders queued behind the cancelled one move up
+        for (ShadowOrder& order : it->second)
+        {
+            if (order.slot > slot)
+                order.volumeAhead -= std::min(order.volumeAhead, quantity);
+        }
+    }
+
+    template <Side S>
+    void ShadowFillSimulator::resetQueue(double price)
+    {
+        auto& side = shadows<S>();
+        if (side.empty())
+            return;
+
+        const auto it = side.find(price);
+        if (it == side.end())
+            return;
+
+        // A recreated level numbers its slots from 0 again, all behind
+        for (ShadowOrder& order : it->second)
+        {
+            order.volumeAhead = 0;
+            order.slot = 0;
+        }
+    }
+
+    template <Side S>
+    void ShadowFillSimulator::resetQueues()
+    {
+        for (auto& [price, queue] : shadows<S>())
+        {
+            for (ShadowOrder& order : queue)
+            {
+                order.volumeAhead = 0;
+                order.slot = 0;
+            }
+        }
+    }
+
+    uint64_t ShadowFillSimulator::allocate(ShadowQueue& queue, size_t end, uint64_t available)
+    {
+        const Timestamp time = book.currentTime();
+        size_t filled = 0;
+
+        for (size_t i = 0; i < end && available > 0; ++i)
+        {
+            ShadowOrder& order = queue[i];
+            const uint64_t quantity = std::min(order.quantity, available);
+
+            fills.push_back({ order.id, order.side, order.price, quantity, time });
+            order.quantity -= quantity;
+            available -= quantity;
+
+            if (order.quantity == 0)
+            {
+                locations.erase(order.id);
+                ++filled;
+            }
+        }
+
+        // Priority order means the filled orders are a prefix
+        queue.erase(queue.begin(), queue.begin() + static_cast<std::ptrdiff_t>(filled));
+        return available;
+    }
+
+} // namespace hft
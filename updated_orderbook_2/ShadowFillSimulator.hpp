@@ -0,0 +1,171 @@
+#pragma once
+
+#include "OrderBook.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+/*
+
+    Queue-position fill simulation for backtests.
+
+    Shadow orders are passive limit orders that live beside a
+    replayed OrderBook instead of in it, so the recorded flow
+    plays out exactly as it happened. The book reports every
+    passive fill, cancel, new resting order and level removal
+    (attachShadowFills); the simulator turns those into a queue
+    position and fills for each shadow order.
+
+    A shadow order joins the back of its level: everything
+    resting there when it was placed is ahead of it, identified
+    by queue slot. Fills and cancels of those orders count its
+    queue down. Flow that reaches beyond it is what it would
+    have received:
+
+        - a fill of a real order queued behind it at its price
+        - a fill at a worse price on its side (trade-through)
+        - an opposite order resting at or through its price
+
+    Each such quantity goes to shadow orders in price-time
+    priority and is used up by them, so two shadow orders never
+    share the same unit of flow. Fills print at the shadow
+    order's own price.
+
+    The book is never changed, so shadow orders have no market
+    impact: real orders behind them still fill as recorded.
+    Orders that would cross on placement are rejected; this
+    models resting liquidity only.
+*/
+
+namespace hft
+{
+
+    struct ShadowOrder
+    {
+        uint64_t id = 0;
+        Side side = Side::Buy;
+        double price = 0.0;
+        uint64_t quantity = 0;      // still open
+        uint64_t originalQty = 0;
+        uint64_t volumeAhead = 0;   // real quantity still queued in front
+        uint64_t slot = 0;          // first queue slot behind it at its level
+    };
+
+    struct ShadowFill
+    {
+        uint64_t shadowId;
+        Side side;
+        double price;
+        uint64_t quantity;
+        Timestamp timestamp;
+    };
+
+    class ShadowFillSimulator
+    {
+    public:
+
+        // Queue positions are read from `book`; attach the simulator
+        // to the same book to receive its events
+        explicit ShadowFillSimulator(const OrderBook& book);
+
+        // Rests a shadow order at the back of its level. Returns its
+        // id, or 0 if the quantity is zero or the price would cross.
+        [[nodiscard]] uint64_t place(Side side, double price, uint64_t quantity);
+
+        // False if unknown or already filled
+        bool cancel(uint64_t shadowId);
+
+        // Null once filled or cancelled
+        [[nodiscard]] const ShadowOrder* find(uint64_t shadowId) const;
+
+        [[nodiscard]] const std::vector<ShadowFill>& getFills() const noexcept;
+        [[nodiscard]] size_t openOrders() const noexcept;
+
+        // Drops shadow orders and fills; the book is untouched
+        void clear();
+
+        // Book events (called by OrderBook)
+        void onFill(Side side, double price, uint64_t slot, uint64_t quantity);
+        void onCancel(Side side, double price, uint64_t slot, uint64_t quantity);
+        void onRest(Side side, double price, uint64_t quantity);
+        void onLevelErased(Side side, double price);
+        void onBookCleared();
+
+    private:
+
+        // Shadow orders at one price in placement order, which is
+        // also ascending slot order
+        using ShadowQueue = std::vector<ShadowOrder>;
+
+        template <Side S>
+        using ShadowSide = std::map<double, ShadowQueue, typename SideTraits<S>::Compare>;
+
+        const OrderBook& book;
+
+        ShadowSide<Side::Buy> bids;
+        ShadowSide<Side::Sell> asks;
+
+        struct Location
+        {
+            Side side;
+            double price;
+        };
+
+        std::unordered_map<uint64_t, Location> locations;
+
+        std::vector<ShadowFill> fills;
+        uint64_t nextId = 1;
+
+        template <Side S>
+        [[nodiscard]] ShadowSide<S>& shadows() noexcept
+        {
+            if constexpr (S == Side::Buy)
+                return bids;
+            else
+                return asks;
+        }
+
+        template <Side S>
+        [[nodiscard]] const ShadowSide<S>& shadows() const noexcept
+        {
+            if constexpr (S == Side::Buy)
+                return bids;
+            else
+                return asks;
+        }
+
+        template <Side S>
+        [[nodiscard]] uint64_t place(double price, uint64_t quantity);
+
+        // A real order on side S filled at `price`
+        template <Side S>
+        void fillBehind(double price, uint64_t slot, uint64_t quantity);
+
+        // A real order rested at `price` opposite shadow side S
+        template <Side S>
+        void fillCrossed(double price, uint64_t quantity);
+
+        template <Side S>
+        void countDown(double price, uint64_t slot, uint64_t quantity);
+
+        template <Side S>
+        void resetQueue(double price);
+
+        template <Side S>
+        void resetQueues();
+
+        // Gives up to `available` to queue[0, end) front to back and
+        // returns the rest; filled orders leave the queue
+        uint64_t allocate(ShadowQueue& queue, size_t end, uint64_t available);
+
+        template <Side S>
+        bool cancel(uint64_t shadowId, double price);
+
+        template <Side S>
+        [[nodiscard]] const ShadowOrder* find(uint64_t shadowId, double price) const;
+    };
+
+} // namespace hft
@@ -1,8 +1,42 @@
+#include "AgentSimulator.hpp"
+#include "AsyncLogger.hpp"
+#include "Backtest.hpp"
+#include "ConsolidatedBook.hpp"
+#include "CrossSectionalAnalytics.hpp"
+#include "DepthIndex.hpp"
+#include "EventArchive.hpp"
+#include "FeedHandler.hpp"
 #include "HFTAlgorithms.hpp"
+#include "HFTUtils.hpp"
 #include "MatchingEngine.hpp"
+#include "OrderTracer.hpp"
+#include "Replication.hpp"
+#include "VectorOrderBook.hpp"
 
+#ifdef __linux__
+#include "Gateway.hpp"
+#include "GatewayClient.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <limits>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 using namespace hft;
 
@@ -78,15 +112,3291 @@ namespace
             10) == 0);
         assert(engine.getOrderBook().empty());
     }
-}
 
-int main()
-{
-    limitOrdersMatchAtRestingAsk();
-    marketOrdersConsumeBestPriceFirst();
-    riskLimitsRejectInvalidOrders();
-    analyticsHandleZeroLookback();
-    riskLimitsRejectNonFinitePrices();
+    void metricsTrackAcceptsRejectsAndSweeps()
+    {
+        MatchingEngine engine;
+        engine.setRiskLimits({ 1'000.0, 1'000, false });
+
+        (void)engine.submitOrder(Side::Sell, OrderType::Limit, 100.0, 10);
+        (void)engine.submitOrder(Side::Sell, OrderType::Limit, 101.0, 10);
+        (void)engine.submitOrder(Side::Sell, OrderType::Limit, 101.0, 10);
+        (void)engine.submitOrder(Side::Buy, OrderType::Limit, 101.0, 15);
+        assert(engine.submitOrder(Side::Buy, OrderType::Limit, 2'000.0, 1) == 0);
+        assert(engine.submitOrder(Side::Buy, OrderType::Limit, 100.0, 0) == 0);
+        assert(engine.submitOrder(Side::Buy, OrderType::Market, 0.0, 1) == 0);
+
+        const MetricsSnapshot snap = engine.getMetrics().snapshot();
+        assert(snap[Metric::OrdersAccepted] == 4);
+        assert(snap[Metric::OrdersRejectedPrice] == 1);
+        assert(snap[Metric::OrdersRejectedQuantity] == 1);
+        assert(snap[Metric::OrdersRejectedMarketDisabled] == 1);
+        assert(snap[Metric::Fills] == 2);
+        assert(snap[Metric::FilledQuantity] == 15);
+        assert(snap[Metric::LevelsCreated] == 2);
+        assert(snap[Metric::LevelsDestroyed] == 1);
+        assert(snap[Metric::LastSweepDepth] == 2);
+        assert(snap[Metric::MaxQueueLength] == 2);
+        assert(snap[Metric::OrderPoolOccupancy] == 2);
+        assert(snap.sequence == 7);
+
+        std::ostringstream json;
+        snap.writeJson(json);
+        assert(json.str().find("\"fills\":2") != std::string::npos);
+    }
+
+    void metricsSnapshotsAreConsistentAcrossThreads()
+    {
+        MatchingEngine engine;
+        std::atomic<bool> stop{ false };
+
+        std::thread reader([&]()
+            {
+                while (!stop.load(std::memory_order_acquire))
+                {
+                    const MetricsSnapshot snap = engine.getMetrics().snapshot();
+                    // Every submission is accepted and rests, so the
+                    // pool gauge must always equal the accepted counter
+                    assert(snap[Metric::OrdersAccepted] == snap[Metric::OrderPoolOccupancy]);
+                }
+            });
+
+        for (int i = 0; i < 10'000; ++i)
+            (void)engine.submitOrder(Side::Buy, OrderType::Limit, 100.0 + (i % 50), 1);
+
+        stop.store(true, std::memory_order_release);
+        reader.join();
+
+        assert(engine.getMetrics().snapshot()[Metric::OrdersAccepted] == 10'000);
+    }
+
+    std::vector<ReplayEvent> makeReplayDay(uint64_t seed, size_t count)
+    {
+        std::vector<ReplayEvent> events;
+        events.reserve(count);
+
+        SimRandom random(seed);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint64_t r = random.next();
+
+            ReplayEvent event{};
+            event.timestampNs = i * 1'000;
+            event.side = (r & 1) ? Side::Buy : Side::Sell;
+            event.type = (r % 17 == 0) ? OrderType::Market : OrderType::Limit;
+            event.price = 100.0 + static_cast<double>((r >> 4) % 20) * 0.5;
+            event.quantity = 1 + (r >> 12) % 200;
+            event.action = ReplayAction::Submit;
+            events.push_back(event);
+        }
+
+        return events;
+    }
+
+    void backtestsAreDeterministicAcrossThreadCounts()
+    {
+        const auto dir = std::filesystem::temp_directory_path();
+        const std::string day0 = (dir / "hft_replay_day0.bin").string();
+        const std::string day1 = (dir / "hft_replay_day1.bin").string();
+
+        writeReplayFile(day0, makeReplayDay(7, 5'000));
+        writeReplayFile(day1, makeReplayDay(11, 5'000));
+
+        ReplayDataset dataset;
+        dataset.addDay(day0);
+        dataset.addDay(day1);
+
+        // Strategy: lean on the bid every 100 events
+        auto quoter = []() -> BacktestStrategy
+            {
+                return [n = 0](MatchingEngine& engine, const ReplayEvent&) mutable
+                    {
+                        if (++n % 100 == 0 && engine.getOrderBook().getBestBid() > 0.0)
+                            (void)engine.submitOrder(Side::Buy,
+                                OrderType::Limit,
+                                engine.getOrderBook().getBestBid(),
+                                10);
+                    };
+            };
+
+        // Same quotes as shadow orders: filled by queue position,
+        // never inserted into the replayed book
+        auto shadowQuoter = []() -> ShadowStrategy
+            {
+                return [n = 0](ShadowFillSimulator& shadows, const MatchingEngine& engine, const ReplayEvent&) mutable
+                    {
+                        if (++n % 100 == 0 && engine.getOrderBook().getBestBid() > 0.0)
+                            (void)shadows.place(Side::Buy, engine.getOrderBook().getBestBid(), 10);
+                    };
+            };
+
+        std::vector<BacktestConfig> configs{
+            { "baseline", {}, nullptr },
+            { "no-market", { 1'000'000.0, 1'000'000, false }, nullptr },
+            { "small-qty", { 1'000'000.0, 100, true }, quoter },
+            { "shadow-bid", {}, nullptr, shadowQuoter },
+        };
+
+        BacktestRunner runner(dataset, configs);
+
+        ThreadPool single(1);
+        ThreadPool many(4);
+        const auto serial = runner.run(single);
+        const auto parallel = runner.run(many);
+
+        assert(serial.size() == 8);
+        assert(serial == parallel);
+        assert(serial[0].tradeCount > 0);
+        assert(serial[2].ordersRejected > 0);
+        assert(serial[4].ordersRejected > 0);
+        assert(serial[0].tradeChecksum != serial[1].tradeChecksum);
+        assert(serial[6].tradeChecksum == serial[0].tradeChecksum);
+        assert(serial[6].shadowVolume > 0 && serial[0].shadowVolume == 0);
+
+        // A count that matches the file size only modulo 2^64 is refused
+        const std::string garbled = (dir / "hft_replay_garbled.bin").string();
+        std::filesystem::copy_file(day0, garbled, std::filesystem::copy_options::overwrite_existing);
+        {
+            std::fstream patch(garbled, std::ios::in | std::ios::out | std::ios::binary);
+            const uint64_t count = dataset.day(0).size() + (uint64_t{ 1 } << 59);
+            patch.seekp(static_cast<std::streamoff>(offsetof(ReplayFileHeader, eventCount)));
+            patch.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        }
+
+        bool threw = false;
+        try
+        {
+            ReplayDataset broken;
+            broken.addDay(garbled);
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        assert(threw);
+
+        std::filesystem::remove(day0);
+        std::filesystem::remove(day1);
+        std::filesystem::remove(garbled);
+    }
+
+    void cancelsRemoveRestingOrders()
+    {
+        MatchingEngine engine;
+
+        const auto first = engine.submitOrder(Side::Sell, OrderType::Limit, 101.0, 100);
+        const auto second = engine.submitOrder(Side::Sell, OrderType::Limit, 101.0, 200);
+        (void)engine.submitOrder(Side::Sell, OrderType::Limit, 102.0, 300);
+
+        assert(engine.cancelOrder(first));
+        assert(!engine.cancelOrder(first));
+        assert(!engine.cancelOrder(999));
+
+        const auto depth = engine.getOrderBook().getDepth(Side::Sell);
+        assert(depth.size() == 2);
+        assert((depth[0] == DepthLevel{ 101.0, 200, 1 }));
+
+        // The cancelled order no longer has queue priority
+        (void)engine.submitOrder(Side::Buy, OrderType::Market, 0.0, 50);
+        assert(engine.getTrades().back().sellOrderId == second);
+
+        assert(engine.cancelOrder(second));
+        assert(engine.getOrderBook().getBestAsk() == 102.0);
+        assert(engine.getMetrics().get(Metric::OrdersCancelled) == 2);
+    }
+
+    // Drives two engines with identical input and requires
+    // identical trades and full depth after every step
+    template <OrderBookLike Reference, OrderBookLike Candidate>
+    void runDifferentialFlow(uint64_t seed, size_t steps)
+    {
+        BasicMatchingEngine<Reference> reference;
+        BasicMatchingEngine<Candidate> candidate;
+
+        std::vector<uint64_t> live;
+        SimRandom random(seed);
+
+        for (size_t step = 0; step < steps; ++step)
+        {
+            const uint64_t r = random.next();
+
+            const Timestamp now{ std::chrono::nanoseconds(step * 1'000) };
+            reference.setSimulatedTime(now);
+            candidate.setSimulatedTime(now);
+
+            const uint64_t action = r % 10;
+
+            if (action < 3 && !live.empty())
+            {
+                const size_t pick = (r >> 8) % live.size();
+                const uint64_t id = live[pick];
+                live[pick] = live.back();
+                live.pop_back();
+
+                const bool referenceCancelled = reference.cancelOrder(id);
+                const bool candidateCancelled = candidate.cancelOrder(id);
+                assert(referenceCancelled == candidateCancelled);
+            }
+            else
+            {
+                const Side side = (r & 0x10) ? Side::Buy : Side::Sell;
+                const OrderType type = (action == 9) ? OrderType::Market : OrderType::Limit;
+                const double price = 100.0 + static_cast<double>((r >> 12) % 16) * 0.25;
+                const uint64_t quantity = 1 + (r >> 20) % 300;
+
+                const auto a = reference.submitOrder(side, type, price, quantity);
+                const auto b = candidate.submitOrder(side, type, price, quantity);
+                assert(a == b);
+
+                if (type == OrderType::Limit)
+                    live.push_back(a);
+            }
+
+            const auto& left = reference.getTrades();
+            const auto& right = candidate.getTrades();
+            assert(left.size() == right.size());
+
+            for (size_t i = 0; i < left.size(); ++i)
+            {
+                assert(left[i].buyOrderId == right[i].buyOrderId);
+                assert(left[i].sellOrderId == right[i].sellOrderId);
+                assert(left[i].price == right[i].price);
+                assert(left[i].quantity == right[i].quantity);
+                assert(left[i].timestamp == right[i].timestamp);
+            }
+
+            for (const Side side : { Side::Buy, Side::Sell })
+                assert(reference.getOrderBook().getDepth(side) == candidate.getOrderBook().getDepth(side));
+        }
+
+        assert(!reference.getTrades().empty());
+    }
+
+    void backendsProduceIdenticalTradesAndDepth()
+    {
+        for (const uint64_t seed : { 1ull, 42ull, 2024ull })
+            runDifferentialFlow<OrderBook, VectorOrderBook>(seed, 2'000);
+    }
+
+    void auctionUncrossesAtMaximumVolume()
+    {
+        MatchingEngine engine;
+        engine.setTradingMode(TradingMode::Auction);
+
+        const auto marketBuy = engine.submitOrder(Side::Buy, OrderType::Market, 0.0, 100);
+        const auto bid101 = engine.submitOrder(Side::Buy, OrderType::Limit, 101.0, 300);
+        const auto bid100 = engine.submitOrder(Side::Buy, OrderType::Limit, 100.0, 200);
+        const auto ask99 = engine.submitOrder(Side::Sell, OrderType::Limit, 99.0, 250);
+        const auto ask100 = engine.submitOrder(Side::Sell, OrderType::Limit, 100.0, 200);
+        (void)engine.submitOrder(Side::Sell, OrderType::Limit, 102.0, 300);
+
+        // Collected without matching, book crossed during the call
+        assert(engine.getTrades().empty());
+        assert(engine.getOrderBook().getBestBid() > engine.getOrderBook().getBestAsk());
+
+        const AuctionResult result = engine.uncross();
+        assert(result.price == 100.0);
+        assert(result.volume == 450);
+        assert(result.buySurplus == 150);
+        assert(result.sellSurplus == 0);
+
+        // Market orders first, then price priority, all at one price
+        const auto& trades = engine.getTrades();
+        assert(trades.size() == 4);
+        assert(trades[0].buyOrderId == marketBuy && trades[0].sellOrderId == ask99 && trades[0].quantity == 100);
+        assert(trades[1].buyOrderId == bid101 && trades[1].sellOrderId == ask99 && trades[1].quantity == 150);
+        assert(trades[2].buyOrderId == bid101 && trades[2].sellOrderId == ask100 && trades[2].quantity == 150);
+        assert(trades[3].buyOrderId == bid100 && trades[3].sellOrderId == ask100 && trades[3].quantity == 50);
+
+        for (const Trade& trade : trades)
+            assert(trade.price == 100.0);
+
+        assert((engine.getOrderBook().getDepth(Side::Buy) == std::vector<DepthLevel>{ { 100.0, 150, 1 } }));
+        assert((engine.getOrderBook().getDepth(Side::Sell) == std::vector<DepthLevel>{ { 102.0, 300, 1 } }));
+
+        // Back to continuous trading on the residual book
+        engine.setTradingMode(TradingMode::Continuous);
+        (void)engine.submitOrder(Side::Sell, OrderType::Limit, 100.0, 50);
+        assert(engine.getTrades().size() == 5);
+    }
+
+    void auctionTieBreakers()
+    {
+        // Equal volume and surplus at 100 and 101: reference decides
+        auto balanced = [](double reference)
+            {
+                OrderBook book;
+                book.setTradingMode(TradingMode::Auction);
+                book.addOrder(Order(1, Side::Buy, OrderType::Limit, 101.0, 100));
+                book.addOrder(Order(2, Side::Sell, OrderType::Limit, 100.0, 100));
+                return book.indicativeUncross(reference).price;
+            };
+
+        assert(balanced(100.4) == 100.0);
+        assert(balanced(105.0) == 101.0);
+        assert(balanced(0.0) == 100.0);
+
+        // Buy surplus at every tied price: highest price
+        OrderBook pressured;
+        pressured.setTradingMode(TradingMode::Auction);
+        pressured.addOrder(Order(1, Side::Buy, OrderType::Limit, 101.0, 200));
+        pressured.addOrder(Order(2, Side::Sell, OrderType::Limit, 100.0, 100));
+
+        const AuctionResult result = pressured.indicativeUncross(100.0);
+        assert(result.price == 101.0);
+        assert(result.volume == 100);
+        assert(result.buySurplus == 100);
+
+        // Nothing crosses: no auction price, nothing traded
+        OrderBook apart;
+        apart.setTradingMode(TradingMode::Auction);
+        apart.addOrder(Order(1, Side::Buy, OrderType::Limit, 99.0, 100));
+        apart.addOrder(Order(2, Side::Sell, OrderType::Limit, 100.0, 100));
+        assert(apart.uncross().volume == 0);
+        assert(apart.getTrades().empty());
+    }
+
+    void auctionMarketOrdersCancelAndExpire()
+    {
+        MatchingEngine engine;
+        engine.setTradingMode(TradingMode::Auction);
+
+        const auto cancelled = engine.submitOrder(Side::Buy, OrderType::Market, 0.0, 100);
+        (void)engine.submitOrder(Side::Buy, OrderType::Market, 0.0, 500);
+        (void)engine.submitOrder(Side::Sell, OrderType::Limit, 100.0, 200);
+
+        assert(engine.cancelOrder(cancelled));
+        assert(engine.getOrderBook().restingOrderCount() == 2);
+
+        const AuctionResult result = engine.uncross();
+        assert(result.volume == 200);
+        assert(result.buySurplus == 300);
+
+        // The unfilled market remainder does not survive the auction
+        assert(engine.getOrderBook().empty());
+        assert(engine.getOrderBook().restingOrderCount() == 0);
+    }
+
+    void auctionMatchesBruteForceVolume()
+    {
+        SimRandom random(99);
+
+        for (int book = 0; book < 50; ++book)
+        {
+            OrderBook auction;
+            auction.setTradingMode(TradingMode::Auction);
+
+            std::vector<Order> orders;
+            for (uint64_t id = 1; id <= 200; ++id)
+            {
+                const uint64_t r = random.next();
+
+                const Side side = (r & 1) ? Side::Buy : Side::Sell;
+                const OrderType type = (r % 23 == 0) ? OrderType::Market : OrderType::Limit;
+                const double price = 95.0 + static_cast<double>((r >> 4) % 40) * 0.25;
+
+                orders.emplace_back(id, side, type, price, 1 + (r >> 12) % 500);
+                auction.addOrder(orders.back());
+            }
+
+            // Executable volume at every limit price, the slow way
+            uint64_t bestVolume = 0;
+            for (const Order& candidate : orders)
+            {
+                if (candidate.type == OrderType::Market)
+                    continue;
+
+                uint64_t demand = 0;
+                uint64_t supply = 0;
+                for (const Order& order : orders)
+                {
+                    const bool market = order.type == OrderType::Market;
+                    if (order.side == Side::Buy && (market || order.price >= candidate.price))
+                        demand += order.quantity;
+                    if (order.side == Side::Sell && (market || order.price <= candidate.price))
+                        supply += order.quantity;
+                }
+
+                bestVolume = std::max(bestVolume, std::min(demand, supply));
+            }
+
+            const AuctionResult result = auction.uncross();
+            assert(result.volume == bestVolume);
+
+            uint64_t traded = 0;
+            for (const Trade& trade : auction.getTrades())
+            {
+                assert(trade.price == result.price);
+                traded += trade.quantity;
+            }
+
+            assert(traded == bestVolume);
+
+            // Residual book must be uncrossed
+            const double bid = auction.getBestBid();
+            const double ask = auction.getBestAsk();
+            assert(bid == 0.0 || ask == 0.0 || bid < ask);
+        }
+    }
+
+#ifdef __linux__
+    struct ReceivedMessage
+    {
+        wire::MessageType type;
+        std::vector<std::byte> bytes;
+
+        template <typename T>
+        [[nodiscard]] const T& as() const
+        {
+            assert(bytes.size() == sizeof(T));
+            return wire::messageAt<T>(bytes.data());
+        }
+    };
+
+    void flushRequests(GatewayClient& client)
+    {
+        const bool flushed = client.flush();
+        assert(flushed);
+    }
+
+    // With a gateway given, runs its loop on this thread between reads
+    std::vector<ReceivedMessage> receiveMessages(GatewayClient& client, size_t count, Gateway* gateway = nullptr)
+    {
+        std::vector<ReceivedMessage> messages;
+
+        for (int attempt = 0; attempt < 200 && messages.size() < count; ++attempt)
+        {
+            if (gateway)
+                (void)gateway->pollOnce(0);
+
+            const int handled = client.receive([&](const wire::MessageHeader& header, const std::byte* data)
+                {
+                    messages.push_back({ header.type, { data, data + header.length } });
+                }, 10);
+
+            if (handled < 0)
+                break;
+        }
+
+        return messages;
+    }
+
+    void gatewayRoundTripsOverLoopback()
+    {
+        MatchingEngine engine;
+        Gateway gateway(engine);
+        std::thread loop([&]() { gateway.run(); });
+
+        GatewayClient client;
+        client.connect("127.0.0.1", gateway.port());
+
+        // Two requests in one flush: acks first, then both fills
+        client.newOrder(1, Side::Sell, OrderType::Limit, 101.0, 100);
+        client.newOrder(2, Side::Buy, OrderType::Limit, 101.0, 40);
+        flushRequests(client);
+
+        auto messages = receiveMessages(client, 4);
+        assert(messages.size() == 4);
+        assert(messages[0].type == wire::MessageType::OrderAck);
+        assert(messages[1].type == wire::MessageType::OrderAck);
+        assert(messages[2].type == wire::MessageType::Fill);
+        assert(messages[3].type == wire::MessageType::Fill);
+
+        const uint64_t sellId = messages[0].as<wire::OrderAck>().orderId;
+        assert(messages[0].as<wire::OrderAck>().clientOrderId == 1);
+        assert(messages[2].as<wire::Fill>().clientOrderId == 2);
+        assert(messages[2].as<wire::Fill>().quantity == 40);
+        assert(messages[3].as<wire::Fill>().orderId == sellId);
+        assert(messages[3].as<wire::Fill>().price == 101.0);
+
+        // Risk rejects carry the engine's reason
+        client.newOrder(3, Side::Buy, OrderType::Limit, -1.0, 10);
+        flushRequests(client);
+        messages = receiveMessages(client, 1);
+        assert(messages.size() == 1 && messages[0].type == wire::MessageType::OrderReject);
+        assert(messages[0].as<wire::OrderReject>().reason == RejectReason::InvalidPrice);
+
+        // Replace, cancel, then cancel again
+        client.replaceOrder(4, sellId, 102.0, 50);
+        flushRequests(client);
+        messages = receiveMessages(client, 1);
+        assert(messages.size() == 1 && messages[0].type == wire::MessageType::ReplaceAck);
+        const uint64_t replacedId = messages[0].as<wire::ReplaceAck>().newOrderId;
+        assert(engine.getOrderBook().getBestAsk() == 102.0);
+
+        client.cancelOrder(5, replacedId);
+        client.cancelOrder(6, replacedId);
+        flushRequests(client);
+        messages = receiveMessages(client, 2);
+        assert(messages.size() == 2);
+        assert(messages[0].type == wire::MessageType::CancelAck);
+        assert(messages[1].type == wire::MessageType::CancelReject);
+
+        // A message split across two segments is reassembled
+        const wire::NewOrder split{
+            wire::headerFor<wire::NewOrder>(wire::MessageType::NewOrder),
+            7, 100.0, 10, Side::Buy, OrderType::Limit, {} };
+        const auto* raw = reinterpret_cast<const std::byte*>(&split);
+        client.sendRaw(raw, 10);
+        flushRequests(client);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        client.sendRaw(raw + 10, sizeof(split) - 10);
+        flushRequests(client);
+        messages = receiveMessages(client, 1);
+        assert(messages.size() == 1 && messages[0].as<wire::OrderAck>().clientOrderId == 7);
+
+        // Malformed framing drops the connection
+        const wire::MessageHeader bogus{ 3, wire::MessageType::NewOrder, 0 };
+        client.sendRaw(&bogus, sizeof(bogus));
+        flushRequests(client);
+        assert(receiveMessages(client, 1).empty());
+        assert(!client.isConnected());
+
+        gateway.stop();
+        loop.join();
+    }
+
+    void gatewayCancelsOrdersOnDisconnect()
+    {
+        MatchingEngine engine;
+        Gateway gateway(engine);
+
+        GatewayClient leaving;
+        GatewayClient staying;
+        leaving.connect("127.0.0.1", gateway.port());
+        staying.connect("127.0.0.1", gateway.port());
+
+        leaving.newOrder(1, Side::Sell, OrderType::Limit, 101.0, 10);
+        leaving.newOrder(2, Side::Buy, OrderType::Limit, 99.0, 10);
+        flushRequests(leaving);
+        assert(receiveMessages(leaving, 2, &gateway).size() == 2);
+
+        staying.newOrder(1, Side::Sell, OrderType::Limit, 102.0, 10);
+        flushRequests(staying);
+        auto messages = receiveMessages(staying, 1, &gateway);
+        assert(messages.size() == 1 && messages[0].type == wire::MessageType::OrderAck);
+        const uint64_t stayingId = messages[0].as<wire::OrderAck>().orderId;
+        assert(engine.getOrderBook().getTotalAskVolume() == 20);
+
+        // Nobody could cancel the leaving client's orders once it is gone
+        leaving.close();
+        for (int attempt = 0; attempt < 200 && gateway.connectionCount() > 1; ++attempt)
+            (void)gateway.pollOnce(10);
+
+        assert(gateway.connectionCount() == 1);
+        assert(engine.getOrderBook().getTotalBidVolume() == 0);
+        assert(engine.getOrderBook().getTotalAskVolume() == 10);
+        assert(engine.getOrderBook().getBestAsk() == 102.0);
+
+        staying.cancelOrder(2, stayingId);
+        flushRequests(staying);
+        messages = receiveMessages(staying, 1, &gateway);
+        assert(messages.size() == 1 && messages[0].type == wire::MessageType::CancelAck);
+        assert(engine.getOrderBook().empty());
+    }
+
+    void gatewayPausesClientsThatStopReading()
+    {
+        MatchingEngine engine;
+        Gateway gateway(engine);
+        std::thread loop([&]() { gateway.run(); });
+
+        GatewayClient client;
+        client.connect("127.0.0.1", gateway.port());
+
+        // Risk rejects: 20-byte replies, far more than the socket buffers hold
+        constexpr size_t requests = 1'000'000;
+        for (size_t i = 1; i <= requests; ++i)
+            client.newOrder(i, Side::Buy, OrderType::Limit, -1.0, 10);
+
+        bool flushed = false;
+        std::thread sender([&]() { flushed = client.flush(); });
+
+        // Replies go unread until the gateway stops reading requests
+        bool paused = false;
+        for (int attempt = 0; attempt < 1'000 && !paused; ++attempt)
+        {
+            paused = gateway.pausedConnections() == 1;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        size_t rejects = 0;
+        for (int idle = 0; rejects < requests && idle < 500;)
+        {
+            const int handled = client.receive([&](const wire::MessageHeader& header, const std::byte*)
+                {
+                    if (header.type == wire::MessageType::OrderReject)
+                        ++rejects;
+                }, 10);
+
+            if (handled < 0)
+                break;
+
+            idle = (handled == 0) ? idle + 1 : 0;
+        }
+
+        sender.join();
+        assert(paused && flushed);
+        assert(rejects == requests);
+        assert(gateway.pausedConnections() == 0);
+
+        gateway.stop();
+        loop.join();
+    }
+#endif
+
+    // Walks best-first depth the slow way
+    SweepCost walkSweep(const std::vector<DepthLevel>& depth, uint64_t quantity)
+    {
+        SweepCost cost;
+        for (const DepthLevel& level : depth)
+        {
+            if (cost.quantity == quantity)
+                break;
+
+            const uint64_t take = std::min(quantity - cost.quantity, level.volume);
+            cost.notional += take * level.price;
+            cost.quantity += take;
+            cost.worstPrice = level.price;
+        }
+
+        return cost;
+    }
+
+    // Prices step `stride` ticks around each side's centre
+    void checkDepthIndexAgainstLevels(double tickSize, double stride, double bidCenter, double askCenter)
+    {
+        MatchingEngine engine;
+        engine.enableDepthIndex(tickSize);
+
+        std::vector<uint64_t> live;
+        SimRandom random(5);
+
+        for (int step = 0; step < 3'000; ++step)
+        {
+            const uint64_t r = random.next();
+
+            if (r % 5 == 0 && !live.empty())
+            {
+                const size_t pick = (r >> 8) % live.size();
+                engine.cancelOrder(live[pick]);
+                live[pick] = live.back();
+                live.pop_back();
+            }
+            else
+            {
+                const Side side = (r & 0x10) ? Side::Buy : Side::Sell;
+                const OrderType type = (r % 31 == 0) ? OrderType::Market : OrderType::Limit;
+                const double center = (side == Side::Buy) ? bidCenter : askCenter;
+                const double price = center + (static_cast<double>((r >> 12) % 41) - 20.0) * stride * tickSize;
+                live.push_back(engine.submitOrder(side, type, price, 1 + (r >> 20) % 200));
+            }
+
+            if (step % 50 != 0)
+                continue;
+
+            const OrderBook& book = engine.getOrderBook();
+            const DepthIndex& index = *book.getDepthIndex();
+
+            for (const Side side : { Side::Buy, Side::Sell })
+            {
+                const auto depth = book.getDepth(side);
+                uint64_t total = 0;
+                for (const DepthLevel& level : depth)
+                    total += level.volume;
+
+                assert(index.totalQuantity(side) == total);
+                assert(index.bestPrice(side) == (depth.empty() ? 0.0 : depth.front().price));
+
+                for (const uint64_t quantity : { uint64_t{ 1 }, uint64_t{ 150 }, uint64_t{ 1'000 }, total, total + 1 })
+                {
+                    const SweepCost expected = walkSweep(depth, quantity);
+                    const SweepCost actual = index.sweepCost(side, quantity);
+
+                    assert(actual.quantity == expected.quantity);
+                    assert(std::abs(actual.notional - expected.notional) < 1e-6);
+                    assert(actual.worstPrice == expected.worstPrice);
+                    assert(index.priceForQty(side, quantity)
+                        == (expected.quantity == quantity ? expected.worstPrice : 0.0));
+                }
+
+                // Size within n ticks of mid, the slow way
+                const double bid = book.getBestBid();
+                const double ask = book.getBestAsk();
+                const double reference = (bid > 0.0 && ask > 0.0) ? (bid + ask) / 2.0
+                    : (side == Side::Buy ? bid : ask);
+
+                for (const uint64_t ticks : { 0, 1, 4, 30 })
+                {
+                    uint64_t within = 0;
+                    for (const DepthLevel& level : depth)
+                    {
+                        if (std::abs(level.price - reference) <= ticks * tickSize + 1e-9
+                            || (side == Side::Buy ? level.price > reference : level.price < reference))
+                            within += level.volume;
+                    }
+
+                    assert(index.depthWithin(side, ticks) == within);
+                }
+            }
+        }
+    }
+
+    void depthIndexMatchesLevelWalk()
+    {
+        checkDepthIndexAgainstLevels(0.25, 1.0, 99.0, 101.0);
+
+        // Levels far wider than the grid's band
+        checkDepthIndexAgainstLevels(0.25, 5'000.0, 60'000.0, 60'002.0);
+    }
+
+    void depthIndexGrowsItsGrid()
+    {
+        DepthIndex index(0.01);
+
+        index.add(Side::Sell, 100.00, 10);
+        index.add(Side::Sell, 5'000.00, 20);  // far above the initial grid
+        index.add(Side::Sell, 0.05, 5);       // far below it
+        index.add(Side::Buy, 0.01, 7);
+
+        assert(index.bestPrice(Side::Sell) == 0.05);
+        assert(index.sweepCost(Side::Sell, 15).quantity == 15);
+        assert(std::abs(index.sweepCost(Side::Sell, 15).notional - (5 * 0.05 + 10 * 100.0)) < 1e-6);
+        assert(index.priceForQty(Side::Sell, 35) == 5'000.0);
+        assert(index.priceForQty(Side::Sell, 36) == 0.0);
+
+        index.remove(Side::Sell, 0.05, 5);
+        assert(index.bestPrice(Side::Sell) == 100.0);
+        assert(index.bestPrice(Side::Buy) == 0.01);
+
+        // A stray far order does not stretch the grid across the gap
+        DepthIndex wide(0.01);
+        wide.add(Side::Buy, 100.00, 10);
+        wide.add(Side::Buy, 999'999.00, 1);
+        wide.add(Side::Sell, 999'999.01, 2);
+        assert(wide.memoryBytes() < (size_t{ 1 } << 20));
+        assert(wide.bestPrice(Side::Buy) == 999'999.00);
+        assert(wide.priceForQty(Side::Buy, 11) == 100.0);
+        assert(wide.depthWithin(Side::Buy, 1) == 1);
+
+        wide.remove(Side::Buy, 999'999.00, 1);
+        assert(wide.bestPrice(Side::Buy) == 100.0);
+        assert(wide.sweepCost(Side::Buy, 10).quantity == 10);
+    }
+
+    void idBlocksStayUniqueAcrossProducers()
+    {
+        constexpr size_t producers = 8;
+        constexpr size_t perProducer = 10'000;
+
+        OrderIdAllocator allocator(64);
+        std::vector<std::vector<uint64_t>> drawn(producers);
+        std::vector<std::thread> threads;
+
+        for (size_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&, p]()
+                {
+                    OrderIdBlock block(allocator);
+                    for (size_t i = 0; i < perProducer; ++i)
+                        drawn[p].push_back(block.next());
+                });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        std::vector<uint64_t> all;
+        for (const auto& ids : drawn)
+            all.insert(all.end(), ids.begin(), ids.end());
+
+        std::sort(all.begin(), all.end());
+        assert(all.front() >= 1);
+        assert(std::adjacent_find(all.begin(), all.end()) == all.end());
+        assert(all.size() == producers * perProducer);
+    }
+
+    void engineSequencesAcceptedEvents()
+    {
+        MatchingEngine engine;
+        assert(engine.getSequence() == 0);
+
+        const auto sellId = engine.submitOrder(Side::Sell, OrderType::Limit, 101.0, 100);
+        assert(engine.getSequence() == 1);
+
+        // Rejects and failed cancels are not events
+        assert(engine.submitOrder(Side::Buy, OrderType::Limit, -1.0, 10) == 0);
+        assert(!engine.cancelOrder(12'345));
+        assert(engine.getSequence() == 1);
+
+        // External producers draw from the engine's allocator
+        OrderIdBlock producer(engine.getIdAllocator());
+        const uint64_t buyId = producer.next();
+        assert(buyId != sellId);
+        assert(engine.submitOrderWithId(buyId, Side::Buy, OrderType::Limit, 101.0, 40) == buyId);
+        assert(engine.getSequence() == 2);
+        assert(engine.getTrades().back().sequence == 2);
+        assert(engine.getTrades().back().buyOrderId == buyId);
+
+        assert(engine.submitOrderWithId(0, Side::Buy, OrderType::Limit, 101.0, 1) == 0);
+        assert(engine.getLastRejectReason() == RejectReason::InvalidOrderId);
+
+        assert(engine.cancelOrder(sellId));
+        assert(engine.getSequence() == 3);
+
+        // Ids still live on the book are refused, as a zero id is
+        const uint64_t restingId = producer.next();
+        assert(engine.submitOrderWithId(restingId, Side::Buy, OrderType::Limit, 99.0, 5) == restingId);
+        assert(engine.submitOrderWithId(restingId, Side::Sell, OrderType::Limit, 105.0, 5) == 0);
+        assert(engine.getLastRejectReason() == RejectReason::InvalidOrderId);
+        assert(engine.getMetrics().snapshot()[Metric::OrdersRejectedOrderId] == 2);
+        assert(engine.getSequence() == 4);
+
+        engine.reset();
+        assert(engine.getSequence() == 0);
+        assert(engine.getLastRejectReason() == RejectReason::None);
+        assert(engine.submitOrder(Side::Buy, OrderType::Limit, 100.0, 1) == 1);
+    }
+
+    void journaledIdsReplayIdentically()
+    {
+        struct JournalEntry
+        {
+            uint64_t orderId;
+            Side side;
+            double price;
+            uint64_t quantity;
+        };
+
+        // Live run: two producers interleave blocks of IDs
+        MatchingEngine live;
+        live.setSimulatedTime(Timestamp{});
+        OrderIdBlock first(live.getIdAllocator());
+        OrderIdBlock second(live.getIdAllocator());
+
+        std::vector<JournalEntry> journal;
+        for (uint64_t i = 0; i < 2'000; ++i)
+        {
+            OrderIdBlock& producer = (i % 3 == 0) ? second : first;
+            const JournalEntry entry{ producer.next(),
+                (i & 1) ? Side::Buy : Side::Sell,
+                100.0 + static_cast<double>(i % 7) * 0.5,
+                1 + i % 50 };
+
+            if (live.submitOrderWithId(entry.orderId, entry.side, OrderType::Limit, entry.price, entry.quantity))
+                journal.push_back(entry);
+        }
+
+        // Replay from the journal reproduces IDs, sequences and trades
+        MatchingEngine replay;
+        replay.setSimulatedTime(Timestamp{});
+        for (const JournalEntry& entry : journal)
+        {
+            const uint64_t replayedId = replay.submitOrderWithId(entry.orderId, entry.side, OrderType::Limit, entry.price, entry.quantity);
+            assert(replayedId == entry.orderId);
+        }
+
+        const auto& expected = live.getTrades();
+        const auto& actual = replay.getTrades();
+        assert(!expected.empty());
+        assert(expected.size() == actual.size());
+
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            assert(expected[i].buyOrderId == actual[i].buyOrderId);
+            assert(expected[i].sellOrderId == actual[i].sellOrderId);
+            assert(expected[i].quantity == actual[i].quantity);
+            assert(expected[i].sequence == actual[i].sequence);
+        }
+
+        assert(live.getSequence() == replay.getSequence());
+    }
+
+    // Every update describes the level as it now is; each level appears once
+    void checkLevelUpdates(const OrderBook& book, const MassCancelResult& result)
+    {
+        for (size_t i = 0; i < result.levels.size(); ++i)
+        {
+            const LevelUpdate& update = result.levels[i];
+
+            for (size_t j = i + 1; j < result.levels.size(); ++j)
+                assert(result.levels[j].side != update.side || result.levels[j].price != update.price);
+
+            const auto depth = book.getDepth(update.side);
+            const auto it = std::find_if(depth.begin(), depth.end(), [&](const DepthLevel& level)
+                {
+                    return level.price == update.price;
+                });
+
+            if (update.volume == 0)
+            {
+                assert(it == depth.end());
+            }
+            else
+            {
+                assert(it != depth.end());
+                assert(it->volume == update.volume && it->orderCount == update.orderCount);
+            }
+        }
+    }
+
+    void massCancelsDropSidesAndRanges()
+    {
+        MatchingEngine engine;
+        engine.enableDepthIndex(0.5);
+
+        for (int i = 0; i < 6; ++i)
+        {
+            (void)engine.submitOrder(Side::Buy, OrderType::Limit, 99.0 - i, 10);
+            (void)engine.submitOrder(Side::Buy, OrderType::Limit, 99.0 - i, 5);
+            (void)engine.submitOrder(Side::Sell, OrderType::Limit, 101.0 + i, 20);
+        }
+
+        const uint64_t before = engine.getSequence();
+
+        // Bids 96..98 inclusive: three levels, six orders
+        const MassCancelResult range = engine.cancelPriceRange(Side::Buy, 96.0, 98.0);
+        assert(range.orders == 6 && range.quantity == 45);
+        assert(range.levels.size() == 3);
+        checkLevelUpdates(engine.getOrderBook(), range);
+        assert(engine.getSequence() == before + 1);
+
+        const auto bids = engine.getOrderBook().getDepth(Side::Buy);
+        assert(bids.size() == 3);
+        assert(bids[0].price == 99.0 && bids[1].price == 95.0 && bids[2].price == 94.0);
+        assert(engine.getOrderBook().getDepthIndex()->totalQuantity(Side::Buy) == 45);
+
+        // An empty or inverted range is not an event
+        assert(engine.cancelPriceRange(Side::Buy, 96.5, 97.5).orders == 0);
+        assert(engine.cancelPriceRange(Side::Sell, 110.0, 100.0).orders == 0);
+        assert(engine.getSequence() == before + 1);
+
+        const MassCancelResult asks = engine.cancelSide(Side::Sell);
+        assert(asks.orders == 6 && asks.quantity == 120 && asks.levels.size() == 6);
+        assert(engine.getOrderBook().getBestAsk() == 0.0);
+        assert(engine.getOrderBook().restingOrderCount() == 6);
+        assert(engine.getMetrics().get(Metric::OrdersCancelled) == 12);
+
+        // The book still matches normally afterwards
+        (void)engine.submitOrder(Side::Sell, OrderType::Limit, 99.0, 15);
+        assert(engine.getTrades().size() == 2);
+        assert(engine.getOrderBook().getBestBid() == 95.0);
+    }
+
+    void massCancelByOwnerFollowsFills()
+    {
+        MatchingEngine engine;
+        engine.enableDepthIndex(0.5);
+
+        // Owners 1 and 2 interleave within the same levels
+        const auto a = engine.submitOrder(Side::Sell, OrderType::Limit, 101.0, 10, 1);
+        const auto b = engine.submitOrder(Side::Sell, OrderType::Limit, 101.0, 10, 2);
+        const auto c = engine.submitOrder(Side::Sell, OrderType::Limit, 101.0, 10, 1);
+        const auto d = engine.submitOrder(Side::Sell, OrderType::Limit, 102.0, 10, 1);
+        const auto e = engine.submitOrder(Side::Buy, OrderType::Limit, 99.0, 10, 1);
+        const auto f = engine.submitOrder(Side::Buy, OrderType::Limit, 98.0, 10);
+
+        // a fills completely and leaves owner 1's list; b is partially filled
+        (void)engine.submitOrder(Side::Buy, OrderType::Market, 0.0, 14);
+        assert(!engine.cancelOrder(a));
+
+        const MassCancelResult result = engine.cancelOwner(1);
+        assert(result.orders == 3 && result.quantity == 30);
+        assert(result.levels.size() == 3);
+        checkLevelUpdates(engine.getOrderBook(), result);
+
+        for (const auto id : { c, d, e })
+            assert(!engine.cancelOrder(id));
+
+        // Owner 2's partly filled b and the unowned f survive
+        assert(engine.getOrderBook().contains(b) && engine.getOrderBook().contains(f));
+
+        const auto asks = engine.getOrderBook().getDepth(Side::Sell);
+        assert(asks.size() == 1);
+        assert((asks[0] == DepthLevel{ 101.0, 6, 1 }));
+        assert(engine.getOrderBook().getDepthIndex()->totalQuantity(Side::Sell) == 6);
+
+        assert(engine.cancelOwner(1).orders == 0);
+        assert(engine.cancelOwner(0).orders == 0);
+
+        // Call-period market orders are owned too
+        engine.setTradingMode(TradingMode::Auction);
+        (void)engine.submitOrder(Side::Buy, OrderType::Market, 0.0, 5, 2);
+        const MassCancelResult owned = engine.cancelOwner(2);
+        assert(owned.orders == 2 && owned.quantity == 11);
+        assert(owned.levels.size() == 1);
+
+        engine.setTradingMode(TradingMode::Continuous);
+        assert(engine.getTrades().size() == 2);
+        assert(engine.cancelOrder(f));
+        assert(engine.getOrderBook().empty());
+    }
+
+    void massCancelsKeepBookConsistent()
+    {
+        MatchingEngine engine;
+        engine.enableDepthIndex(0.25);
+
+        std::vector<std::pair<uint64_t, uint32_t>> submitted;
+        SimRandom random(11);
+
+        for (int step = 0; step < 4'000; ++step)
+        {
+            const uint64_t r = random.next();
+            const Side side = (r & 0x10) ? Side::Buy : Side::Sell;
+            const uint64_t action = r % 100;
+
+            if (action < 2)
+            {
+                const uint32_t owner = static_cast<uint32_t>(1 + (r >> 8) % 4);
+                checkLevelUpdates(engine.getOrderBook(), engine.cancelOwner(owner));
+
+                for (const auto& [id, orderOwner] : submitted)
+                {
+                    if (orderOwner != owner)
+                        continue;
+
+                    const bool stillResting = engine.cancelOrder(id);
+                    assert(!stillResting);
+                }
+            }
+            else if (action < 4)
+            {
+                const double low = 95.0 + static_cast<double>((r >> 8) % 20) * 0.25;
+                const double high = low + static_cast<double>((r >> 16) % 8) * 0.25;
+                checkLevelUpdates(engine.getOrderBook(), engine.cancelPriceRange(side, low, high));
+
+                for (const DepthLevel& level : engine.getOrderBook().getDepth(side))
+                    assert(level.price < low || level.price > high);
+            }
+            else if (action < 20 && !submitted.empty())
+            {
+                engine.cancelOrder(submitted[(r >> 8) % submitted.size()].first);
+            }
+            else
+            {
+                const double center = (side == Side::Buy) ? 99.0 : 101.0;
+                const double price = center + (static_cast<double>((r >> 12) % 25) - 12.0) * 0.25;
+                const uint32_t owner = static_cast<uint32_t>((r >> 24) % 5);
+                submitted.emplace_back(engine.submitOrder(side, OrderType::Limit, price, 1 + (r >> 20) % 100, owner), owner);
+            }
+
+            if (step % 100 != 0)
+                continue;
+
+            const OrderBook& book = engine.getOrderBook();
+            size_t orders = 0;
+
+            for (const Side s : { Side::Buy, Side::Sell })
+            {
+                uint64_t volume = 0;
+                for (const DepthLevel& level : book.getDepth(s))
+                {
+                    volume += level.volume;
+                    orders += level.orderCount;
+                }
+
+                assert(volume == book.getDepthIndex()->totalQuantity(s));
+            }
+
+            assert(orders == book.restingOrderCount());
+        }
+
+        // Owner 0 orders are only reachable by side or price
+        for (uint32_t owner = 1; owner <= 4; ++owner)
+            engine.cancelOwner(owner);
+        engine.cancelSide(Side::Buy);
+        engine.cancelSide(Side::Sell);
+        assert(engine.getOrderBook().empty());
+        assert(engine.getOrderBook().restingOrderCount() == 0);
+    }
+
+    std::vector<std::string> splitLines(const std::string& text)
+    {
+        std::vector<std::string> lines;
+        std::istringstream in(text);
+
+        for (std::string line; std::getline(in, line);)
+            lines.push_back(line);
+
+        return lines;
+    }
+
+    void asyncLoggerKeepsPerThreadOrder()
+    {
+        constexpr int producers = 4;
+        constexpr int perProducer = 5'000;
+
+        std::ostringstream sink;
+        AsyncLogger logger(sink, { 1 << 18, std::chrono::microseconds(100) });
+        logger.start();
+
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&logger, p]()
+                {
+                    for (int i = 0; i < perProducer; ++i)
+                        logger.log("T{} #{}", p, i);
+                });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        logger.flush();
+        logger.stop();
+        assert(logger.droppedCount() == 0);
+
+        std::vector<int> nextExpected(producers, 0);
+        for (const std::string& line : splitLines(sink.str()))
+        {
+            int producer = -1;
+            int index = -1;
+            const int parsed = std::sscanf(line.c_str(), "T%d #%d", &producer, &index);
+            assert(parsed == 2);
+            assert(index == nextExpected[producer]);
+            ++nextExpected[producer];
+        }
+
+        for (int p = 0; p < producers; ++p)
+            assert(nextExpected[p] == perProducer);
+    }
+
+    void asyncLoggerDropsInsteadOfBlocking()
+    {
+        // 48-byte records do not divide the 4 KiB ring, so wrapping pads
+        std::ostringstream sink;
+        AsyncLogger logger(sink, { 4096, std::chrono::microseconds(100) });
+
+        // No writer yet: the ring fills and further records are dropped
+        for (uint64_t i = 0; i < 1'000; ++i)
+            logger.log("r {} {} {}", i, i * 2, 0.5);
+
+        const uint64_t dropped = logger.droppedCount();
+        assert(dropped > 0 && dropped < 1'000);
+
+        logger.stop();
+        auto lines = splitLines(sink.str());
+        assert(lines.size() == 1'000 - dropped + 1);
+        assert(lines.back().find("records dropped") != std::string::npos);
+
+        // With the writer running and flushes in between, the ring wraps many times
+        std::ostringstream wrapped;
+        AsyncLogger writer(wrapped, { 4096, std::chrono::microseconds(100) });
+        writer.start();
+
+        for (uint64_t round = 0; round < 50; ++round)
+        {
+            for (uint64_t i = 0; i < 60; ++i)
+                writer.log("r {} {} {}", round, i, 0.5);
+
+            writer.flush();
+        }
+
+        writer.stop();
+        assert(writer.droppedCount() == 0);
+
+        lines = splitLines(wrapped.str());
+        assert(lines.size() == 50 * 60);
+        assert(lines.front() == "r 0 0 0.5");
+        assert(lines.back() == "r 49 59 0.5");
+    }
+
+    void asyncLoggerFormatsFillsAndValues()
+    {
+        std::ostringstream sink;
+        AsyncLogger logger(sink);
+        logger.start();
+
+        MatchingEngine engine;
+        engine.attachTradeLog(&logger);
+
+        const auto sell = engine.submitOrder(Side::Sell, OrderType::Limit, 101.25, 30);
+        const auto buy = engine.submitOrder(Side::Buy, OrderType::Limit, 101.5, 10);
+        engine.logTopOfBook(logger);
+
+        logger.log("values {} {} {} {} {}", -7, true, Side::Sell, "text", 1e-3);
+        logger.log("extra", 1, 2);
+        logger.flush();
+
+        const auto lines = splitLines(sink.str());
+        assert(lines.size() == 4);
+
+        std::ostringstream fill;
+        fill << "FILL seq=2 buy=" << buy << " sell=" << sell << " qty=10 px=101.25";
+        assert(lines[0] == fill.str());
+        assert(lines[1] == "TOP bid=0 ask=101.25 spread=0 mid=0");
+        assert(lines[2] == "values -7 true 1 text 0.001");
+        assert(lines[3] == "extra 1 2");
+
+        // Detached: later fills are not logged
+        engine.attachTradeLog(nullptr);
+        (void)engine.submitOrder(Side::Buy, OrderType::Market, 0.0, 5);
+        logger.stop();
+        assert(splitLines(sink.str()).size() == 4);
+    }
+
+    void shadowOrdersFillFromQueuePosition()
+    {
+        MatchingEngine engine;
+        MatchingEngine plain;
+        ShadowFillSimulator shadows(engine.getOrderBook());
+        engine.attachShadowFills(&shadows);
+
+        // Same flow into both engines; the overlay must not show
+        auto submit = [&](Side side, OrderType type, double price, uint64_t quantity)
+            {
+                const uint64_t id = engine.submitOrder(side, type, price, quantity);
+                const uint64_t plainId = plain.submitOrder(side, type, price, quantity);
+                assert(plainId == id);
+                return id;
+            };
+
+        (void)submit(Side::Buy, OrderType::Limit, 100.0, 10);
+        const uint64_t second = submit(Side::Buy, OrderType::Limit, 100.0, 20);
+
+        const uint64_t bid = shadows.place(Side::Buy, 100.0, 15);
+        assert(bid != 0);
+        assert(shadows.find(bid)->volumeAhead == 30);
+
+        // Joins behind the shadow order: not ahead of it
+        (void)submit(Side::Buy, OrderType::Limit, 100.0, 5);
+        assert(shadows.find(bid)->volumeAhead == 30);
+
+        const bool cancelled = engine.cancelOrder(second);
+        const bool plainCancelled = plain.cancelOrder(second);
+        assert(cancelled && plainCancelled);
+        assert(shadows.find(bid)->volumeAhead == 10);
+
+        (void)submit(Side::Sell, OrderType::Market, 0.0, 6);
+        assert(shadows.find(bid)->volumeAhead == 4);
+        assert(shadows.getFills().empty());
+
+        // 4 clears the queue ahead, 5 fills the real order behind
+        // (would have been ours), 1 rests through our price
+        (void)submit(Side::Sell, OrderType::Limit, 100.0, 10);
+        assert(shadows.getFills().size() == 2);
+        assert(shadows.getFills()[0].quantity == 5);
+        assert(shadows.getFills()[1].quantity == 1);
+        assert(shadows.getFills()[0].price == 100.0);
+        assert(shadows.find(bid)->quantity == 9);
+        assert(shadows.find(bid)->volumeAhead == 0);
+
+        // Marketable shadow orders are rejected
+        assert(shadows.place(Side::Buy, 100.5, 1) == 0);
+        assert(shadows.place(Side::Sell, 99.0, 0) == 0);
+
+        // A buy resting at 102 crosses the shadow ask at 101
+        const uint64_t ask = shadows.place(Side::Sell, 101.0, 5);
+        (void)submit(Side::Buy, OrderType::Limit, 102.0, 4);
+        assert(shadows.find(ask)->quantity == 2);
+
+        // Trade-through: buying at 104 passes both shadow asks
+        const uint64_t far = shadows.place(Side::Sell, 103.0, 2);
+        (void)submit(Side::Sell, OrderType::Limit, 104.0, 5);
+        (void)submit(Side::Buy, OrderType::Market, 0.0, 5);
+        assert(shadows.find(ask) == nullptr);
+        assert(shadows.find(far) == nullptr);
+        assert(shadows.openOrders() == 1);
+
+        const bool shadowCancelled = shadows.cancel(bid);
+        const bool cancelledTwice = shadows.cancel(bid);
+        assert(shadowCancelled && !cancelledTwice);
+        assert(shadows.openOrders() == 0);
+
+        const auto& left = engine.getTrades();
+        const auto& right = plain.getTrades();
+        assert(left.size() == right.size());
+        for (size_t i = 0; i < left.size(); ++i)
+        {
+            assert(left[i].buyOrderId == right[i].buyOrderId);
+            assert(left[i].sellOrderId == right[i].sellOrderId);
+            assert(left[i].quantity == right[i].quantity);
+        }
+    }
+
+    void shadowQueuePositionsMatchReference()
+    {
+        /*
+            Random flow with shadow orders on top. The reference
+            keeps each real order's remaining quantity from the
+            trade tape and, per shadow order, the real orders that
+            were resting at its price when it was placed; what is
+            left of those is its queue ahead. The replayed book
+            must match an engine without the overlay exactly.
+        */
+
+        struct Live
+        {
+            Side side;
+            double price;
+            uint64_t remaining;
+        };
+
+        struct Placed
+        {
+            uint64_t originalQty;
+            std::vector<uint64_t> ahead;
+            bool cancelled = false;
+        };
+
+        MatchingEngine engine;
+        MatchingEngine plain;
+        ShadowFillSimulator shadows(engine.getOrderBook());
+        engine.attachShadowFills(&shadows);
+
+        std::unordered_map<uint64_t, Live> live;
+        std::unordered_map<uint64_t, Placed> placed;
+        std::vector<uint64_t> openShadows;
+
+        SimRandom random(99);
+        size_t tradesSeen = 0;
+
+        for (size_t step = 0; step < 4'000; ++step)
+        {
+            const uint64_t r = random.next();
+            const uint64_t action = r % 20;
+
+            const Timestamp now{ std::chrono::nanoseconds(step * 1'000) };
+            engine.setSimulatedTime(now);
+            plain.setSimulatedTime(now);
+
+            if (action < 4 && !live.empty())
+            {
+                auto it = live.begin();
+                std::advance(it, static_cast<std::ptrdiff_t>((r >> 8) % std::min<size_t>(live.size(), 16)));
+                const uint64_t id = it->first;
+                live.erase(it);
+
+                const bool cancelled = engine.cancelOrder(id);
+                const bool plainCancelled = plain.cancelOrder(id);
+                assert(cancelled && plainCancelled);
+            }
+            else if (action == 4)
+            {
+                const double low = 100.0 + static_cast<double>((r >> 8) % 16) * 0.25;
+                const Side side = (r & 0x10) ? Side::Buy : Side::Sell;
+
+                (void)engine.cancelPriceRange(side, low, low + 0.25);
+                (void)plain.cancelPriceRange(side, low, low + 0.25);
+
+                std::erase_if(live, [&](const auto& entry)
+                    {
+                        return entry.second.side == side
+                            && entry.second.price >= low && entry.second.price <= low + 0.25;
+                    });
+            }
+            else if (action < 8)
+            {
+                const Side side = (r & 0x10) ? Side::Buy : Side::Sell;
+                const double price = 100.0 + static_cast<double>((r >> 12) % 16) * 0.25;
+                const uint64_t quantity = 1 + (r >> 20) % 100;
+
+                const uint64_t id = shadows.place(side, price, quantity);
+                if (id == 0)
+                    continue;
+
+                Placed record{ quantity, {} };
+                for (const auto& [orderId, order] : live)
+                {
+                    if (order.side == side && order.price == price)
+                        record.ahead.push_back(orderId);
+                }
+
+                placed.emplace(id, std::move(record));
+                openShadows.push_back(id);
+            }
+            else if (action == 8 && !openShadows.empty())
+            {
+                const size_t pick = (r >> 8) % openShadows.size();
+                const uint64_t id = openShadows[pick];
+                openShadows[pick] = openShadows.back();
+                openShadows.pop_back();
+
+                if (shadows.cancel(id))
+                    placed[id].cancelled = true;
+            }
+            else
+            {
+                const Side side = (r & 0x10) ? Side::Buy : Side::Sell;
+                const OrderType type = (action == 19) ? OrderType::Market : OrderType::Limit;
+                const double price = 100.0 + static_cast<double>((r >> 12) % 16) * 0.25;
+                const uint64_t quantity = 1 + (r >> 20) % 300;
+
+                const uint64_t id = engine.submitOrder(side, type, price, quantity);
+                const uint64_t plainId = plain.submitOrder(side, type, price, quantity);
+                assert(plainId == id);
+
+                uint64_t remaining = quantity;
+                const auto& trades = engine.getTrades();
+
+                for (; tradesSeen < trades.size(); ++tradesSeen)
+                {
+                    const Trade& trade = trades[tradesSeen];
+                    remaining -= trade.quantity;
+
+                    const uint64_t passive = (side == Side::Buy) ? trade.sellOrderId : trade.buyOrderId;
+                    auto it = live.find(passive);
+                    it->second.remaining -= trade.quantity;
+                    if (it->second.remaining == 0)
+                        live.erase(it);
+                }
+
+                if (type == OrderType::Limit && remaining > 0)
+                    live.emplace(id, Live{ side, price, remaining });
+            }
+
+            // Queue ahead of every open shadow order, from the reference
+            for (const uint64_t id : openShadows)
+            {
+                const ShadowOrder* order = shadows.find(id);
+                if (order == nullptr)
+                    continue;
+
+                uint64_t ahead = 0;
+                for (const uint64_t orderId : placed[id].ahead)
+                {
+                    const auto it = live.find(orderId);
+                    if (it != live.end())
+                        ahead += it->second.remaining;
+                }
+
+                assert(order->volumeAhead == ahead);
+            }
+
+            assert(engine.getTrades().size() == plain.getTrades().size());
+            for (const Side side : { Side::Buy, Side::Sell })
+                assert(engine.getOrderBook().getDepth(side) == plain.getOrderBook().getDepth(side));
+        }
+
+        // Every shadow order is filled, open, or cancelled, never overfilled
+        std::unordered_map<uint64_t, uint64_t> filled;
+        for (const ShadowFill& fill : shadows.getFills())
+            filled[fill.shadowId] += fill.quantity;
+
+        for (const auto& [id, record] : placed)
+        {
+            const ShadowOrder* order = shadows.find(id);
+            const uint64_t open = order ? order->quantity : 0;
+
+            assert(filled[id] + open <= record.originalQty);
+            if (!record.cancelled)
+                assert(filled[id] + open == record.originalQty);
+        }
+
+        assert(!shadows.getFills().empty());
+        assert(shadows.openOrders() > 0);
+    }
+
+    void consolidatedBookMergesVenues()
+    {
+        ConsolidatedBook book(3);
+
+        assert(book.apply(0, { Side::Buy, 100.0, 50, 2 }));
+        assert(book.apply(1, { Side::Buy, 100.5, 30, 1 }));
+        assert(book.apply(2, { Side::Buy, 100.0, 20, 1 }));
+        assert(book.apply(0, { Side::Sell, 101.0, 40, 1 }));
+        assert(book.apply(2, { Side::Sell, 101.0, 10, 3 }));
+        assert(!book.apply(3, { Side::Sell, 101.0, 10, 3 }));
+
+        // Non-finite and non-positive prices never become levels
+        assert(!book.apply(0, { Side::Buy, std::numeric_limits<double>::quiet_NaN(), 10, 1 }));
+        assert(!book.apply(1, { Side::Sell, std::numeric_limits<double>::infinity(), 10, 1 }));
+        assert(!book.apply(2, { Side::Buy, 0.0, 10, 1 }));
+        assert(!book.apply(2, { Side::Buy, -1.0, 10, 1 }));
+        assert(!book.apply(0, { Side::Sell, std::numeric_limits<double>::quiet_NaN(), 0, 0 }));
+
+        assert((book.nbbo() == Nbbo{ 100.5, 30, 1, 101.0, 50, 0 }));
+        assert(book.getVenueDepth(0, Side::Buy).size() == 1);
+
+        const auto bidDepth = book.getDepth(Side::Buy);
+        assert(bidDepth.size() == 2);
+        assert(bidDepth[1].price == 100.0 && bidDepth[1].volume == 70 && bidDepth[1].orderCount == 3);
+        assert((bidDepth[1].venues == std::vector<VenueQuote>{ { 0, 50, 2 }, { 2, 20, 1 } }));
+
+        // Best venue pulls its quote: the next one takes over
+        assert(book.apply(1, { Side::Buy, 100.5, 0, 0 }));
+        assert((book.nbbo() == Nbbo{ 100.0, 70, 0, 101.0, 50, 0 }));
+
+        // Size change at the top, and a tie won by the lower index
+        assert(book.apply(2, { Side::Sell, 101.0, 25, 3 }));
+        assert(book.nbbo().askSize == 65 && book.nbbo().askVenue == 0);
+
+        // Removing a level the venue never quoted changes nothing
+        assert(book.apply(1, { Side::Sell, 99.0, 0, 0 }));
+        assert(book.nbbo().ask == 101.0);
+
+        book.clearVenue(0);
+        assert((book.nbbo() == Nbbo{ 100.0, 20, 2, 101.0, 25, 2 }));
+        assert(book.getVenueDepth(0, Side::Buy).empty());
+
+        book.clear();
+        assert((book.nbbo() == Nbbo{}));
+        assert(book.getDepth(Side::Sell).empty());
+    }
+
+    void consolidatedBookMatchesVenueScan()
+    {
+        constexpr size_t venueCount = 7;
+
+        ConsolidatedBook book(venueCount);
+        SimRandom random(314);
+
+        for (size_t step = 0; step < 20'000; ++step)
+        {
+            const uint64_t r = random.next();
+
+            const VenueId venue = static_cast<VenueId>(r % venueCount);
+
+            if ((r >> 4) % 500 == 0)
+            {
+                book.clearVenue(venue);
+            }
+            else
+            {
+                const Side side = (r & 0x100) ? Side::Buy : Side::Sell;
+                const double offset = static_cast<double>((r >> 9) % 12) * 0.5;
+                const double price = (side == Side::Buy) ? 100.0 - offset : 100.0 + offset;
+                const uint64_t volume = ((r >> 14) % 3 == 0) ? 0 : 1 + (r >> 16) % 500;
+
+                (void)book.apply(venue, { side, price, volume, volume == 0 ? 0 : 1 + (r >> 26) % 5 });
+            }
+
+            // Brute force: best venue by scan, merged levels by summing
+            for (const Side side : { Side::Buy, Side::Sell })
+            {
+                double bestPrice = 0.0;
+                VenueId bestVenue = NO_VENUE;
+                std::map<double, ConsolidatedLevel> merged;
+
+                for (VenueId v = 0; v < venueCount; ++v)
+                {
+                    const auto depth = book.getVenueDepth(v, side);
+
+                    if (!depth.empty())
+                    {
+                        const bool improves = (side == Side::Buy)
+                            ? depth.front().price > bestPrice
+                            : depth.front().price < bestPrice;
+
+                        if (bestVenue == NO_VENUE || improves)
+                        {
+                            bestPrice = depth.front().price;
+                            bestVenue = v;
+                        }
+                    }
+
+                    for (const DepthLevel& level : depth)
+                    {
+                        ConsolidatedLevel& total = merged[level.price];
+                        total.price = level.price;
+                        total.volume += level.volume;
+                        total.orderCount += level.orderCount;
+                    }
+                }
+
+                const Nbbo& nbbo = book.nbbo();
+                const auto depth = book.getDepth(side);
+                assert(depth.size() == merged.size());
+
+                if (side == Side::Buy)
+                {
+                    assert(nbbo.bidVenue == bestVenue && nbbo.bid == bestPrice);
+                    assert(nbbo.bidSize == (depth.empty() ? 0 : depth.front().volume));
+                }
+                else
+                {
+                    assert(nbbo.askVenue == bestVenue && nbbo.ask == bestPrice);
+                    assert(nbbo.askSize == (depth.empty() ? 0 : depth.front().volume));
+                }
+
+                for (const ConsolidatedLevel& level : depth)
+                {
+                    const ConsolidatedLevel& expected = merged.at(level.price);
+                    assert(level.volume == expected.volume && level.orderCount == expected.orderCount);
+
+                    uint64_t attributed = 0;
+                    for (const VenueQuote& quote : level.venues)
+                        attributed += quote.volume;
+                    assert(attributed == level.volume);
+                }
+            }
+        }
+    }
+
+    void memoryStatsCoverBookStorage()
+    {
+        MatchingEngine engine;
+        const MemoryStats empty = engine.memoryStats();
+
+        for (uint64_t i = 0; i < 5'000; ++i)
+            (void)engine.submitOrder(Side::Buy, OrderType::Limit, 90.0 + static_cast<double>(i % 50) * 0.1, 10);
+
+        (void)engine.submitOrder(Side::Sell, OrderType::Market, 0.0, 1'000);
+
+        const MemoryStats stats = engine.memoryStats();
+        assert(stats.levelBytes >= 4'900 * sizeof(RestingOrder));
+        assert(stats.orderBytes >= 4'900 * sizeof(OrderDetails));
+        assert(stats.tradeBytes >= 100 * sizeof(Trade));
+        assert(stats.indexBytes >= 4'900 * sizeof(uint64_t));
+        assert(stats.total() > empty.total());
+        assert(stats.slackBytes < stats.total());
+    }
+
+    void compactionReleasesMemoryWithoutChangingMatching()
+    {
+        /*
+            Two engines see the same flow; one is compacted in tiny
+            slices along the way. Bursts of resting orders that are
+            then swept or cancelled leave drained queue prefixes,
+            spare buffers, free store chunks and grown hash tables.
+        */
+
+        MatchingEngine compacted;
+        MatchingEngine plain;
+
+        std::vector<uint64_t> live;
+        SimRandom random(77);
+        size_t slices = 0;
+
+        for (size_t step = 0; step < 30'000; ++step)
+        {
+            const uint64_t r = random.next();
+            const uint64_t action = r % 10;
+
+            const Timestamp now{ std::chrono::nanoseconds(step * 1'000) };
+            compacted.setSimulatedTime(now);
+            plain.setSimulatedTime(now);
+
+            if (action < 3 && !live.empty())
+            {
+                const size_t pick = (r >> 8) % live.size();
+                const uint64_t id = live[pick];
+                live[pick] = live.back();
+                live.pop_back();
+
+                const bool compactedCancelled = compacted.cancelOrder(id);
+                const bool plainCancelled = plain.cancelOrder(id);
+                assert(compactedCancelled == plainCancelled);
+            }
+            else
+            {
+                // Bursts alternate sides so queues build and drain
+                const bool burstBuys = (step / 2'000) % 2 == 0;
+                const Side side = (action == 9) ? (burstBuys ? Side::Sell : Side::Buy)
+                    : (burstBuys ? Side::Buy : Side::Sell);
+                const OrderType type = (action == 9) ? OrderType::Market : OrderType::Limit;
+                const double price = 100.0 + static_cast<double>((r >> 12) % 8) * 0.5;
+
+                const uint64_t id = compacted.submitOrder(side, type, price, 1 + (r >> 20) % 50);
+                const uint64_t plainId = plain.submitOrder(side, type, price, 1 + (r >> 20) % 50);
+                assert(plainId == id);
+
+                if (type == OrderType::Limit)
+                    live.push_back(id);
+            }
+
+            if (step % 97 == 0)
+            {
+                (void)compacted.compact(std::chrono::microseconds(2));
+                ++slices;
+            }
+
+            assert(compacted.getTrades().size() == plain.getTrades().size());
+            for (const Side side : { Side::Buy, Side::Sell })
+                assert(compacted.getOrderBook().getDepth(side) == plain.getOrderBook().getDepth(side));
+        }
+
+        const auto& left = compacted.getTrades();
+        const auto& right = plain.getTrades();
+        for (size_t i = 0; i < left.size(); ++i)
+        {
+            assert(left[i].buyOrderId == right[i].buyOrderId);
+            assert(left[i].sellOrderId == right[i].sellOrderId);
+            assert(left[i].quantity == right[i].quantity);
+        }
+
+        // Finish the pass the last slice may have left in flight
+        const CompactionResult finish = compacted.compact(std::chrono::seconds(10));
+        assert(finish.passComplete);
+
+        // Drop the book to a handful of orders, then run one whole
+        // pass over it: the budget fits every step, so what it
+        // releases does not depend on the clock
+        for (size_t i = 16; i < live.size(); ++i)
+        {
+            const bool compactedCancelled = compacted.cancelOrder(live[i]);
+            const bool plainCancelled = plain.cancelOrder(live[i]);
+            assert(compactedCancelled == plainCancelled);
+        }
+
+        const MemoryStats before = compacted.memoryStats();
+        const CompactionResult pass = compacted.compact(std::chrono::seconds(10));
+        const MemoryStats after = compacted.memoryStats();
+
+        assert(pass.passComplete && pass.deferredSteps == 0);
+        assert(slices > 0);
+        assert(pass.bytesReleased > 0);
+        assert(after.total() < before.total());
+        assert(after.slackBytes < before.slackBytes);
+        assert(after.total() < plain.memoryStats().total());
+
+        // Survivors still cancel and match by their old slots
+        for (size_t i = 0; i < std::min<size_t>(live.size(), 8); ++i)
+        {
+            const bool compactedCancelled = compacted.cancelOrder(live[i]);
+            const bool plainCancelled = plain.cancelOrder(live[i]);
+            assert(compactedCancelled == plainCancelled);
+        }
+
+        (void)compacted.submitOrder(Side::Buy, OrderType::Market, 0.0, 1'000);
+        (void)plain.submitOrder(Side::Buy, OrderType::Market, 0.0, 1'000);
+        (void)compacted.submitOrder(Side::Sell, OrderType::Market, 0.0, 1'000);
+        (void)plain.submitOrder(Side::Sell, OrderType::Market, 0.0, 1'000);
+
+        assert(compacted.getTrades().size() == plain.getTrades().size());
+        assert(compacted.getOrderBook().empty() == plain.getOrderBook().empty());
+
+        // A zero budget fits no step: everything is deferred, nothing done
+        MatchingEngine idle;
+        (void)idle.submitOrder(Side::Buy, OrderType::Limit, 100.0, 10);
+        (void)idle.cancelOrder(1);
+        const CompactionResult none = idle.compact(std::chrono::microseconds(0));
+        assert(none.bytesReleased == 0 && none.deferredSteps > 0 && none.passComplete);
+    }
+
+    void archiveRoundTripsTradesAndBookEvents()
+    {
+        const auto path = (std::filesystem::temp_directory_path() / "hft_archive_roundtrip.bin").string();
+
+        MatchingEngine engine;
+        SimRandom random(5);
+        for (size_t i = 0; i < 20'000; ++i)
+        {
+            const uint64_t r = random.next();
+
+            engine.setSimulatedTime(Timestamp{} + std::chrono::nanoseconds(i * 750 + r % 300));
+            (void)engine.submitOrder((r & 1) ? Side::Buy : Side::Sell,
+                (r % 13 == 0) ? OrderType::Market : OrderType::Limit,
+                100.0 + static_cast<double>((r >> 3) % 40) * 0.05,
+                1 + (r >> 10) % 100);
+        }
+
+        const std::vector<Trade>& trades = engine.getTrades();
+        assert(trades.size() > 1'000);
+
+        std::vector<BookEvent> events;
+        for (size_t i = 0; i < 5'000; ++i)
+        {
+            BookEvent event;
+            event.timestamp = Timestamp{} + std::chrono::nanoseconds(i * 3'000);
+            event.sequence = i;
+            event.level = { (i % 3 == 0) ? Side::Sell : Side::Buy, 99.5 + static_cast<double>(i % 25) * 0.01, (i * 37) % 5'000, i % 11 };
+            events.push_back(event);
+        }
+
+        // Off the tick grid: stored raw, still exact
+        events[17].level.price = 100.003;
+        events[18].level.price = 1e300;
+
+        {
+            ArchiveWriter writer(path, { 0.01, 512 });
+            writer.append(trades);
+            for (const BookEvent& event : events)
+                writer.append(event);
+            writer.close();
+
+            assert(writer.recordCount() == trades.size() + events.size());
+            assert(writer.bytesWritten() * 5 < (trades.size() + events.size()) * sizeof(Trade));
+        }
+
+        ArchiveReader reader(path);
+        assert(reader.tickSize() == 0.01);
+        assert(reader.blockCount() == (trades.size() + events.size() + 511) / 512);
+
+        ThreadPool pool(4);
+        const std::vector<ArchiveBlock> blocks = reader.decodeBlocks(0, reader.blockCount(), pool);
+
+        std::vector<Trade> decodedTrades;
+        std::vector<BookEvent> decodedEvents;
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            const ArchiveBlock serial = reader.decodeBlock(i);
+            assert(serial.trades.size() == blocks[i].trades.size());
+            assert(serial.bookEvents.size() == blocks[i].bookEvents.size());
+
+            decodedTrades.insert(decodedTrades.end(), blocks[i].trades.begin(), blocks[i].trades.end());
+            decodedEvents.insert(decodedEvents.end(), blocks[i].bookEvents.begin(), blocks[i].bookEvents.end());
+        }
+
+        assert(decodedTrades.size() == trades.size());
+        for (size_t i = 0; i < trades.size(); ++i)
+        {
+            assert(decodedTrades[i].buyOrderId == trades[i].buyOrderId);
+            assert(decodedTrades[i].sellOrderId == trades[i].sellOrderId);
+            assert(decodedTrades[i].price == trades[i].price);
+            assert(decodedTrades[i].quantity == trades[i].quantity);
+            assert(decodedTrades[i].timestamp == trades[i].timestamp);
+            assert(decodedTrades[i].sequence == trades[i].sequence);
+        }
+
+        assert(decodedEvents.size() == events.size());
+        for (size_t i = 0; i < events.size(); ++i)
+        {
+            assert(decodedEvents[i].timestamp == events[i].timestamp);
+            assert(decodedEvents[i].sequence == events[i].sequence);
+            assert(decodedEvents[i].level.side == events[i].level.side);
+            assert(decodedEvents[i].level.price == events[i].level.price);
+            assert(decodedEvents[i].level.volume == events[i].level.volume);
+            assert(decodedEvents[i].level.orderCount == events[i].level.orderCount);
+        }
+
+        std::filesystem::remove(path);
+    }
+
+    void archiveRoundTripsEmptyArchive()
+    {
+        const auto path = (std::filesystem::temp_directory_path() / "hft_archive_empty.bin").string();
+
+        {
+            ArchiveWriter writer(path, { 0.25, 64 });
+            writer.close();
+
+            assert(writer.recordCount() == 0);
+        }
+
+        ArchiveReader reader(path);
+        assert(reader.tickSize() == 0.25);
+        assert(reader.blockCount() == 0);
+        assert(reader.findBlockByTime(Timestamp{}) == 0);
+        assert(reader.findBlockBySequence(1) == 0);
+
+        ThreadPool pool(2);
+        assert(reader.decodeBlocks(0, reader.blockCount(), pool).empty());
+
+        std::filesystem::remove(path);
+    }
+
+    void archiveSeeksByTimeAndSequence()
+    {
+        const auto dir = std::filesystem::temp_directory_path();
+        const auto path = (dir / "hft_archive_seek.bin").string();
+
+        {
+            ArchiveWriter writer(path, { 0.5, 100 });
+            for (uint64_t i = 0; i < 1'000; ++i)
+            {
+                Trade trade{ i + 1, i + 2, 100.0 + static_cast<double>(i % 7) * 0.5, 10, Timestamp{} + std::chrono::microseconds(i * 10), i * 2 };
+                writer.append(trade);
+            }
+        }
+
+        ArchiveReader reader(path);
+        assert(reader.blockCount() == 10);
+
+        // Record i sits in block i / 100
+        const size_t byTime = reader.findBlockByTime(Timestamp{} + std::chrono::microseconds(4'505));
+        assert(byTime == 4);
+        assert(reader.findBlockBySequence(1'000) == 5);
+        assert(reader.findBlockBySequence(1'999) == reader.blockCount());
+        assert(reader.findBlockByTime(Timestamp{}) == 0);
+
+        ThreadPool pool(2);
+        const auto tail = reader.decodeBlocks(byTime, reader.blockCount(), pool);
+        assert(tail.size() == 6);
+        assert(tail.front().trades.front().buyOrderId == 401);
+        assert(tail.back().trades.back().sequence == 1'998);
+        assert(reader.decodeBlocks(7, 3, pool).empty());
+
+        // A truncated file, then a garbled block, must be rejected
+        const auto bad = (dir / "hft_archive_bad.bin").string();
+        std::filesystem::copy_file(path, bad, std::filesystem::copy_options::overwrite_existing);
+        std::filesystem::resize_file(bad, std::filesystem::file_size(bad) - 1);
+
+        bool threw = false;
+        try
+        {
+            ArchiveReader broken(bad);
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        assert(threw);
+
+        {
+            ArchiveWriter writer(bad, { 0.5, 100 });
+            writer.append(Trade{ 1, 2, 100.0, 10, Timestamp{}, 1 });
+            writer.append(Trade{ 3, 4, 100.5, 10, Timestamp{}, 2 });
+        }
+
+        uint32_t blockBytes = 0;
+        uint64_t blockOffset = 0;
+        {
+            ArchiveReader intact(bad);
+            blockBytes = intact.blockInfo(0).bytes;
+            blockOffset = intact.blockInfo(0).offset;
+        }
+
+        // Continuation bits everywhere: no varint ends inside the block
+        {
+            std::fstream patch(bad, std::ios::in | std::ios::out | std::ios::binary);
+            patch.seekp(static_cast<std::streamoff>(16));
+            const std::string garbage(blockBytes, '\xff');
+            patch.write(garbage.data(), static_cast<std::streamsize>(garbage.size()));
+        }
+
+        {
+            ArchiveReader corrupt(bad);
+            threw = false;
+            try
+            {
+                (void)corrupt.decodeBlock(0);
+            }
+            catch (const std::runtime_error&)
+            {
+                threw = true;
+            }
+            assert(threw);
+        }
+
+        // Garbled index entries are refused on open, before any decode
+        const auto patchIndex = [&](size_t field, const auto value)
+            {
+                const auto entry = std::filesystem::file_size(bad) - 24 - sizeof(ArchiveBlockInfo);
+                std::fstream patch(bad, std::ios::in | std::ios::out | std::ios::binary);
+                patch.seekp(static_cast<std::streamoff>(entry + field));
+                patch.write(reinterpret_cast<const char*>(&value), sizeof(value));
+            };
+
+        const auto opens = [&]()
+            {
+                try
+                {
+                    ArchiveReader reader(bad);
+                    return true;
+                }
+                catch (const std::runtime_error&)
+                {
+                    return false;
+                }
+            };
+
+        // An offset that wraps past the index when the size is added
+        patchIndex(offsetof(ArchiveBlockInfo, offset), ~uint64_t{ 0 } - 8);
+        assert(!opens());
+        patchIndex(offsetof(ArchiveBlockInfo, offset), blockOffset);
+        assert(opens());
+
+        // More records than the block's bytes can hold
+        patchIndex(offsetof(ArchiveBlockInfo, records), ~uint32_t{ 0 });
+        assert(!opens());
+
+        // A block count whose index size wraps to the empty index
+        {
+            ArchiveWriter writer(bad, { 0.5, 100 });
+        }
+        assert(opens());
+        {
+            const uint64_t count = uint64_t{ 1 } << 60;
+            std::fstream patch(bad, std::ios::in | std::ios::out | std::ios::binary);
+            patch.seekp(static_cast<std::streamoff>(std::filesystem::file_size(bad) - 16));
+            patch.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        }
+        assert(!opens());
+
+        std::filesystem::remove(path);
+        std::filesystem::remove(bad);
+    }
+
+    void icebergsRefillAtBackOfLevel()
+    {
+        MatchingEngine engine;
+        engine.enableDepthIndex(0.01);
+
+        const uint64_t iceberg = engine.submitIceberg(Side::Buy, 100.0, 50, 10);
+        const uint64_t plain = engine.submitOrder(Side::Buy, OrderType::Limit, 100.0, 5);
+        assert(iceberg != 0 && plain != 0);
+
+        // Only the displayed tranche is visible
+        const OrderBook& book = engine.getOrderBook();
+        assert(book.getTotalBidVolume() == 15);
+        assert(book.getDepth(Side::Buy) == (std::vector<DepthLevel>{ { 100.0, 15, 2 } }));
+        assert(book.getDepthIndex()->totalQuantity(Side::Buy) == 15);
+
+        // The tranche fills, is refilled and queues behind the plain order
+        (void)engine.submitOrder(Side::Sell, OrderType::Market, 0.0, 10);
+        assert(book.getDepth(Side::Buy) == (std::vector<DepthLevel>{ { 100.0, 15, 2 } }));
+
+        (void)engine.submitOrder(Side::Sell, OrderType::Market, 0.0, 5);
+        assert(engine.getTrades().back().buyOrderId == plain);
+
+        // One aggressor runs through a tranche and into its refill
+        (void)engine.submitOrder(Side::Sell, OrderType::Limit, 100.0, 12);
+        const auto& trades = engine.getTrades();
+        assert(trades.size() == 4);
+        assert(trades[2].buyOrderId == iceberg && trades[2].quantity == 10);
+        assert(trades[3].buyOrderId == iceberg && trades[3].quantity == 2);
+        assert(book.getDepth(Side::Buy) == (std::vector<DepthLevel>{ { 100.0, 8, 1 } }));
+        assert(book.getDepthIndex()->totalQuantity(Side::Buy) == 8);
+        assert(engine.getMetrics().get(Metric::IcebergRefills) == 2);
+
+        // 50 - 22 traded: 8 shown, 20 in reserve; cancel drops both
+        const MassCancelResult cancelled = engine.cancelSide(Side::Buy);
+        assert(cancelled.orders == 1 && cancelled.quantity == 28);
+        assert(book.empty());
+
+        // A crossing iceberg takes with its full quantity, then shows a tranche
+        (void)engine.submitOrder(Side::Sell, OrderType::Limit, 101.0, 30);
+        const uint64_t taker = engine.submitIceberg(Side::Buy, 101.0, 100, 25);
+        assert(engine.getTrades().back().buyOrderId == taker && engine.getTrades().back().quantity == 30);
+        assert(book.getDepth(Side::Buy) == (std::vector<DepthLevel>{ { 101.0, 25, 1 } }));
+        assert(engine.cancelOrder(taker));
+        assert(book.empty() && book.getDepthIndex()->totalQuantity(Side::Buy) == 0);
+
+        // The reserve counts in an uncross
+        engine.setTradingMode(TradingMode::Auction);
+        (void)engine.submitIceberg(Side::Buy, 100.0, 40, 5);
+        (void)engine.submitOrder(Side::Sell, OrderType::Limit, 99.0, 40);
+        assert(book.indicativeUncross().volume == 40);
+        engine.setTradingMode(TradingMode::Continuous);
+        assert(book.empty());
+
+        assert(engine.submitIceberg(Side::Buy, 100.0, 10, 0) == 0);
+        assert(engine.getLastRejectReason() == RejectReason::InvalidQuantity);
+    }
+
+    void icebergReserveFullyExecutes()
+    {
+        MatchingEngine engine;
+        engine.enableDepthIndex(0.01);
+
+        std::unordered_map<uint64_t, uint64_t> icebergs;   // id -> total quantity
+        SimRandom random(29);
+
+        for (int step = 0; step < 20'000; ++step)
+        {
+            const uint64_t r = random.next();
+
+            const Side side = (r & 1) ? Side::Buy : Side::Sell;
+            const double price = 100.0 + static_cast<double>((r >> 2) % 10) * 0.01 * ((side == Side::Buy) ? -1.0 : 1.0);
+            const uint64_t quantity = 1 + (r >> 8) % 200;
+
+            if (r % 5 == 0)
+            {
+                const uint64_t id = engine.submitIceberg(side, price, quantity, 1 + (r >> 16) % 20);
+                icebergs.emplace(id, quantity);
+            }
+            else
+            {
+                (void)engine.submitOrder(side, (r % 9 == 0) ? OrderType::Market : OrderType::Limit,
+                    (r % 9 == 0) ? 0.0 : price + ((side == Side::Buy) ? 0.05 : -0.05), quantity);
+            }
+
+            const OrderBook& book = engine.getOrderBook();
+            uint64_t shown = 0;
+            for (const DepthLevel& level : book.getDepth(Side::Buy))
+                shown += level.volume;
+
+            assert(shown == book.getTotalBidVolume());
+            assert(shown == book.getDepthIndex()->totalQuantity(Side::Buy));
+        }
+
+        // Sweep both sides dry: every reserve must have traded
+        while (!engine.getOrderBook().empty())
+        {
+            (void)engine.submitOrder(Side::Buy, OrderType::Market, 0.0, 1'000'000);
+            (void)engine.submitOrder(Side::Sell, OrderType::Market, 0.0, 1'000'000);
+        }
+
+        std::unordered_map<uint64_t, uint64_t> traded;
+        for (const Trade& trade : engine.getTrades())
+        {
+            traded[trade.buyOrderId] += trade.quantity;
+            traded[trade.sellOrderId] += trade.quantity;
+        }
+
+        assert(icebergs.size() > 1'000);
+        for (const auto& [id, quantity] : icebergs)
+            assert(traded[id] == quantity);
+    }
+
+    void peggedOrdersTrackTheLitQuote()
+    {
+        MatchingEngine engine;
+        engine.enableDepthIndex(0.25);
+        const OrderBook& book = engine.getOrderBook();
+
+        // No reference yet: the peg rests but cannot trade
+        const uint64_t primary = engine.submitPegged(Side::Buy, PegType::Primary, 0.5, 20, 7);
+        assert(primary != 0 && book.getPegDepth(Side::Buy, PegType::Primary).empty());
+        (void)engine.submitOrder(Side::Sell, OrderType::Limit, 101.0, 10);
+        assert(engine.getTrades().empty());
+
+        (void)engine.submitOrder(Side::Buy, OrderType::Limit, 100.0, 10);
+        assert(book.getPegDepth(Side::Buy, PegType::Primary) == (std::vector<DepthLevel>{ { 99.5, 20, 1 } }));
+
+        // Repriced with the bid, never displayed
+        (void)engine.submitOrder(Side::Buy, OrderType::Limit, 100.25, 10);
+        assert(book.getPegDepth(Side::Buy, PegType::Primary) == (std::vector<DepthLevel>{ { 99.75, 20, 1 } }));
+        assert(book.getTotalBidVolume() == 20 && book.getDepthIndex()->totalQuantity(Side::Buy) == 20);
+
+        // Mid 100.625: a sell at 100.5 misses the lit bid but takes the mid peg
+        const uint64_t mid = engine.submitPegged(Side::Buy, PegType::Mid, 0.0, 10, 7);
+        (void)engine.submitOrder(Side::Sell, OrderType::Limit, 100.5, 4);
+        assert(engine.getTrades().size() == 1);
+        assert(engine.getTrades().back().buyOrderId == mid && engine.getTrades().back().quantity == 4);
+        assert(book.getBestAsk() == 101.0);
+
+        // One sweep walks the merged view in price order
+        (void)engine.submitOrder(Side::Sell, OrderType::Market, 0.0, 20);
+        const auto& trades = engine.getTrades();
+        assert(trades.size() == 4);
+        assert(trades[1].buyOrderId == mid && trades[1].price == 100.625 && trades[1].quantity == 6);
+        assert(trades[2].price == 100.25 && trades[2].quantity == 10);
+        assert(trades[3].price == 100.0 && trades[3].quantity == 4);
+
+        // Pegs are priced as of the aggressor's arrival (bid 100.0)
+        (void)engine.submitOrder(Side::Sell, OrderType::Market, 0.0, 26);
+        assert(trades.size() == 6);
+        assert(trades[5].buyOrderId == primary && trades[5].price == 99.5 && trades[5].quantity == 20);
+        assert(book.getDepthIndex()->totalQuantity(Side::Buy) == 0);
+
+        // At equal prices lit orders fill first
+        const uint64_t lit = engine.submitOrder(Side::Buy, OrderType::Limit, 100.0, 5);
+        (void)engine.submitPegged(Side::Buy, PegType::Primary, 0.0, 5);
+        (void)engine.submitOrder(Side::Sell, OrderType::Market, 0.0, 5);
+        assert(trades.back().buyOrderId == lit);
+
+        // The remaining peg lost its reference with the lit bid
+        assert(book.getPegDepth(Side::Buy, PegType::Primary).empty());
+        assert(engine.cancelSide(Side::Buy).quantity == 5);
+    }
+
+    void peggedOrdersCancelAndReject()
+    {
+        MatchingEngine engine;
+        const OrderBook& book = engine.getOrderBook();
+
+        (void)engine.submitOrder(Side::Buy, OrderType::Limit, 100.0, 10);
+        (void)engine.submitOrder(Side::Sell, OrderType::Limit, 101.0, 10);
+
+        // Zero-offset mid pegs meet at the mid, FIFO
+        const uint64_t buy = engine.submitPegged(Side::Buy, PegType::Mid, 0.0, 10, 3);
+        const uint64_t sell = engine.submitPegged(Side::Sell, PegType::Mid, 0.0, 4);
+        assert(engine.getTrades().size() == 1);
+        assert(engine.getTrades().back().buyOrderId == buy && engine.getTrades().back().sellOrderId == sell);
+        assert(engine.getTrades().back().price == 100.5 && engine.getTrades().back().quantity == 4);
+        assert(book.getPegDepth(Side::Buy, PegType::Mid) == (std::vector<DepthLevel>{ { 100.5, 6, 1 } }));
+
+        // Mid pegs that meet during an auction trade on reopening
+        engine.setTradingMode(TradingMode::Auction);
+        const uint64_t late = engine.submitPegged(Side::Sell, PegType::Mid, 0.0, 2);
+        assert(engine.getTrades().size() == 1 && book.indicativeUncross().volume == 0);
+        engine.setTradingMode(TradingMode::Continuous);
+        assert(engine.getTrades().back().sellOrderId == late && engine.getTrades().back().quantity == 2);
+
+        const uint64_t away = engine.submitPegged(Side::Sell, PegType::Primary, 0.25, 8, 3);
+        assert(engine.cancelOrder(away) && !engine.cancelOrder(away));
+        assert(book.getPegDepth(Side::Sell, PegType::Primary).empty());
+
+        (void)engine.submitPegged(Side::Buy, PegType::Primary, 1.0, 5, 3);
+        (void)engine.submitPegged(Side::Buy, PegType::Primary, 2.0, 5);
+        const MassCancelResult owned = engine.cancelOwner(3);
+        assert(owned.orders == 2 && owned.quantity == 9 && owned.levels.empty());
+        assert(book.getPegDepth(Side::Buy, PegType::Primary) == (std::vector<DepthLevel>{ { 98.0, 5, 1 } }));
+
+        const MassCancelResult side = engine.cancelSide(Side::Buy);
+        assert(side.orders == 2 && side.quantity == 15);
+        assert(book.getPegDepth(Side::Buy, PegType::Primary).empty());
+
+        assert(engine.submitPegged(Side::Buy, PegType::Mid, -0.25, 10) == 0);
+        assert(engine.getLastRejectReason() == RejectReason::InvalidPrice);
+        assert(engine.submitPegged(Side::Buy, PegType::Mid, std::numeric_limits<double>::quiet_NaN(), 10) == 0);
+        assert(engine.submitPegged(Side::Buy, PegType::None, 0.0, 10) == 0);
+        assert(engine.getLastRejectReason() == RejectReason::InvalidPrice);
+        assert(engine.submitPegged(Side::Buy, PegType::Mid, 0.0, 0) == 0);
+        assert(engine.getLastRejectReason() == RejectReason::InvalidQuantity);
+        assert(engine.submitPegged(Side::Sell, PegType::Primary, 1'000'000.0, 10) == 0);
+        assert(engine.getLastRejectReason() == RejectReason::InvalidPrice);
+
+        // Buy pegs never price at or below zero: refused on entry,
+        // and left out of matching and depth if the reference falls
+        const uint64_t low = engine.submitOrder(Side::Buy, OrderType::Limit, 1.0, 5);
+        assert(engine.submitPegged(Side::Buy, PegType::Primary, 1.0, 10) == 0);
+        assert(engine.getLastRejectReason() == RejectReason::InvalidPrice);
+
+        const uint64_t deep = engine.submitPegged(Side::Buy, PegType::Primary, 0.75, 10);
+        assert(deep != 0);
+        (void)engine.submitOrder(Side::Buy, OrderType::Limit, 0.5, 5);
+        assert(engine.cancelOrder(low));
+        assert(book.getPegDepth(Side::Buy, PegType::Primary).empty());
+
+        const size_t trades = engine.getTrades().size();
+        (void)engine.submitOrder(Side::Sell, OrderType::Market, 0.0, 20);
+        assert(engine.getTrades().size() == trades + 1 && engine.getTrades().back().price == 0.5);
+        assert(engine.cancelOrder(deep));
+
+        // Compaction reclaims drained peg queues like lit ones
+        (void)engine.compact(std::chrono::seconds(1));
+
+        std::vector<uint64_t> churn;
+        for (int i = 0; i < 64; ++i)
+            churn.push_back(engine.submitPegged(Side::Sell, PegType::Mid, 0.5, 1));
+        for (size_t i = 0; i + 1 < churn.size(); ++i)
+            assert(engine.cancelOrder(churn[i]));
+
+        const size_t slack = book.memoryStats().slackBytes;
+        assert(engine.compact(std::chrono::seconds(1)).passComplete);
+        assert(slack - book.memoryStats().slackBytes >= 32 * sizeof(RestingOrder));
+    }
+
+    void peggedBookNeverCrosses()
+    {
+        MatchingEngine engine;
+        const OrderBook& book = engine.getOrderBook();
+        std::vector<uint64_t> ids;
+        SimRandom random(41);
+        size_t pegged = 0;
+
+        // Best price a buyer (or seller) would meet across lit and pegs
+        auto best = [&](Side side)
+            {
+                std::vector<DepthLevel> levels = book.getDepth(side, 1);
+                for (const PegType peg : { PegType::Primary, PegType::Mid })
+                {
+                    const std::vector<DepthLevel> pegs = book.getPegDepth(side, peg);
+                    if (!pegs.empty())
+                        levels.push_back(pegs.front());
+                }
+
+                std::optional<double> price;
+                for (const DepthLevel& level : levels)
+                {
+                    if (!price || ((side == Side::Buy) ? level.price > *price : level.price < *price))
+                        price = level.price;
+                }
+
+                return price;
+            };
+
+        for (int step = 0; step < 20'000; ++step)
+        {
+            const uint64_t r = random.next();
+
+            const Side side = (r & 1) ? Side::Buy : Side::Sell;
+            const double price = 100.0 + static_cast<double>((r >> 2) % 16) * 0.25 - 2.0;
+            const uint64_t quantity = 1 + (r >> 8) % 100;
+            const uint32_t owner = 1 + static_cast<uint32_t>((r >> 20) % 4);
+
+            switch (r % 7)
+            {
+            case 0:
+            case 1:
+                ids.push_back(engine.submitPegged(side, ((r >> 24) & 1) ? PegType::Mid : PegType::Primary,
+                    static_cast<double>((r >> 26) % 3) * 0.25, quantity, owner));
+                ++pegged;
+                break;
+            case 2:
+                if (!ids.empty())
+                    (void)engine.cancelOrder(ids[(r >> 12) % ids.size()]);
+                break;
+            default:
+                ids.push_back(engine.submitOrder(side, OrderType::Limit, price, quantity, owner));
+                break;
+            }
+
+            const std::optional<double> bid = best(Side::Buy);
+            const std::optional<double> ask = best(Side::Sell);
+            assert(!bid || !ask || *bid < *ask);
+        }
+
+        assert(pegged > 5'000);
+
+        for (uint32_t owner = 1; owner <= 4; ++owner)
+            (void)engine.cancelOwner(owner);
+
+        assert(book.empty());
+    }
+    FeedMessage feedMessage(uint32_t symbol, uint64_t sequence, FeedAction action, uint64_t orderId,
+        Side side = Side::Buy, double price = 0.0, uint64_t quantity = 0)
+    {
+        FeedMessage message{};
+        message.timestampNs = sequence * 1'000;
+        message.sequence = sequence;
+        message.orderId = orderId;
+        message.price = price;
+        message.quantity = quantity;
+        message.symbol = symbol;
+        message.action = action;
+        message.side = side;
+        return message;
+    }
+
+    void feedHandlerMirrorsOrderEvents()
+    {
+        FeedHandler handler;
+
+        handler.apply(feedMessage(7, 1, FeedAction::Add, 10, Side::Buy, 100.0, 50));
+        handler.apply(feedMessage(7, 2, FeedAction::Add, 11, Side::Buy, 100.0, 30));
+        handler.apply(feedMessage(7, 3, FeedAction::Add, 20, Side::Sell, 101.0, 40));
+
+        // A crossing add rests as sent: the mirror never matches
+        handler.apply(feedMessage(7, 4, FeedAction::Add, 21, Side::Sell, 99.0, 5));
+        const OrderBook* book = handler.book(7);
+        assert(book != nullptr && book->getTrades().empty());
+        assert(book->getBestAsk() == 99.0);
+        handler.apply(feedMessage(7, 5, FeedAction::Delete, 21));
+
+        // A size cut keeps the queue slot; an increase takes a new one
+        handler.apply(feedMessage(7, 6, FeedAction::Modify, 10, Side::Buy, 100.0, 45));
+        assert(book->queueTail(Side::Buy, 100.0).volume == 75 && book->queueTail(Side::Buy, 100.0).nextSlot == 2);
+
+        handler.apply(feedMessage(7, 7, FeedAction::Modify, 10, Side::Buy, 100.0, 60));
+        assert(book->queueTail(Side::Buy, 100.0).volume == 90 && book->queueTail(Side::Buy, 100.0).nextSlot == 3);
+        handler.apply(feedMessage(7, 8, FeedAction::Execute, 11, Side::Buy, 0.0, 30));
+        assert(book->getDepth(Side::Buy) == (std::vector<DepthLevel>{ { 100.0, 60, 1 } }));
+
+        // Partial then full execution; the level goes with the last lot
+        handler.apply(feedMessage(7, 9, FeedAction::Execute, 20, Side::Sell, 0.0, 15));
+        assert(book->getDepth(Side::Sell) == (std::vector<DepthLevel>{ { 101.0, 25, 1 } }));
+        handler.apply(feedMessage(7, 10, FeedAction::Execute, 20, Side::Sell, 0.0, 25));
+        assert(book->getDepth(Side::Sell).empty());
+
+        // Price change moves the order
+        handler.apply(feedMessage(7, 11, FeedAction::Modify, 10, Side::Buy, 100.5, 60));
+        assert(book->getDepth(Side::Buy) == (std::vector<DepthLevel>{ { 100.5, 60, 1 } }));
+
+        // Unknown ids, duplicate adds and bad prices are counted, not applied
+        handler.apply(feedMessage(7, 12, FeedAction::Delete, 99));
+        handler.apply(feedMessage(7, 13, FeedAction::Add, 10, Side::Sell, 102.0, 1));
+        handler.apply(feedMessage(7, 14, FeedAction::Add, 30, Side::Sell, std::numeric_limits<double>::quiet_NaN(), 1));
+        handler.apply(feedMessage(7, 15, FeedAction::Add, 31, Side::Buy, 0.0, 1));
+        handler.apply(feedMessage(7, 16, FeedAction::Modify, 10, Side::Buy, -100.5, 60));
+        assert(book->getDepth(Side::Buy) == (std::vector<DepthLevel>{ { 100.5, 60, 1 } }));
+        handler.apply(feedMessage(7, 17, FeedAction::Modify, 10, Side::Buy, 100.5, 0));
+        assert(book->empty());
+
+        const FeedStats stats = handler.stats();
+        assert(stats.messages == 17 && stats.applied == 12 && stats.rejected == 5);
+        assert(stats.gaps == 0 && stats.dropped == 0);
+        assert(handler.book(8) == nullptr && handler.symbolCount() == 1);
+    }
+
+    void feedHandlerRecoversFromGaps()
+    {
+        FeedHandler handler;
+        std::vector<FeedGap> gaps;
+        handler.setGapHandler([&](const FeedGap& gap) { gaps.push_back(gap); });
+
+        handler.apply(feedMessage(1, 1, FeedAction::Add, 1, Side::Buy, 100.0, 10));
+        handler.apply(feedMessage(1, 2, FeedAction::Add, 2, Side::Sell, 101.0, 10));
+        handler.apply(feedMessage(1, 2, FeedAction::Add, 2, Side::Sell, 101.0, 10));   // duplicate
+
+        // Message 3 is lost: the book is dropped and 4 and 5 are held
+        handler.apply(feedMessage(1, 4, FeedAction::Add, 4, Side::Buy, 99.0, 5));
+        handler.apply(feedMessage(1, 5, FeedAction::Delete, 1));
+        assert(gaps.size() == 1 && gaps[0].symbol == 1 && gaps[0].expected == 3 && gaps[0].received == 4);
+        assert(handler.recovering(1) && handler.book(1)->empty());
+
+        // Snapshot as of 4, in the stream: 4 is already in it, 5 replays
+        handler.apply(feedMessage(1, 4, FeedAction::SnapshotBegin, 0));
+        handler.apply(feedMessage(1, 4, FeedAction::SnapshotOrder, 1, Side::Buy, 100.0, 10));
+        handler.apply(feedMessage(1, 4, FeedAction::SnapshotOrder, 3, Side::Buy, 100.0, 7));
+        handler.apply(feedMessage(1, 4, FeedAction::SnapshotOrder, 4, Side::Buy, 99.0, 5));
+        handler.apply(feedMessage(1, 4, FeedAction::SnapshotOrder, 2, Side::Sell, 101.0, 10));
+        handler.apply(feedMessage(1, 4, FeedAction::SnapshotEnd, 0));
+
+        const OrderBook& book = *handler.book(1);
+        assert(!handler.recovering(1));
+        assert(book.getDepth(Side::Buy) == (std::vector<DepthLevel>{ { 100.0, 7, 1 }, { 99.0, 5, 1 } }));
+        assert(book.getDepth(Side::Sell) == (std::vector<DepthLevel>{ { 101.0, 10, 1 } }));
+
+        // Live books ignore snapshots
+        handler.apply(feedMessage(1, 6, FeedAction::Add, 6, Side::Sell, 102.0, 1));
+        handler.apply(feedMessage(1, 6, FeedAction::SnapshotBegin, 0));
+        handler.apply(feedMessage(1, 6, FeedAction::SnapshotEnd, 0));
+        assert(book.getDepth(Side::Sell).size() == 2);
+
+        FeedStats stats = handler.stats();
+        assert(stats.gaps == 1 && stats.snapshots == 1);
+        assert(stats.dropped == 4);   // duplicate 2, held 4, ignored snapshot
+
+        // Joining mid-session: the first message gaps; an out-of-band
+        // snapshot answers the request
+        handler.apply(feedMessage(2, 500, FeedAction::Add, 50, Side::Sell, 20.0, 3));
+        handler.apply(feedMessage(2, 501, FeedAction::Add, 51, Side::Sell, 20.0, 4));
+        assert(gaps.size() == 2 && gaps[1].expected == 1 && gaps[1].received == 500);
+
+        const std::vector<FeedMessage> snapshot{ feedMessage(2, 500, FeedAction::SnapshotOrder, 40, Side::Buy, 19.5, 9) };
+        handler.applySnapshot(2, 499, snapshot);
+        assert(handler.book(2)->getDepth(Side::Buy) == (std::vector<DepthLevel>{ { 19.5, 9, 1 } }));
+        assert(handler.book(2)->getDepth(Side::Sell) == (std::vector<DepthLevel>{ { 20.0, 7, 2 } }));
+
+        stats = handler.stats();
+        assert(stats.gaps == 2 && stats.snapshots == 2);
+    }
+
+    void feedHandlerShardsMatchSequentialApply()
+    {
+        // Random L3 flow over 40 symbols, with a few gaps and in-stream snapshots
+        struct Live { uint64_t id; Side side; double price; uint64_t quantity; };
+
+        std::vector<FeedMessage> messages;
+        std::vector<std::vector<Live>> books(40);
+        std::vector<uint64_t> sequences(40, 0);
+        std::vector<bool> lost(40, false);
+        uint64_t nextId = 1;
+        SimRandom random(17);
+
+        for (size_t i = 0; i < 200'000; ++i)
+        {
+            const uint64_t r = random.next();
+
+            const uint32_t symbol = static_cast<uint32_t>(r % 40);
+            std::vector<Live>& live = books[symbol];
+            uint64_t& sequence = sequences[symbol];
+
+            if (r % 5'000 == 1)
+            {
+                // Lose a message; the snapshot follows the next one
+                ++sequence;
+                lost[symbol] = true;
+                continue;
+            }
+
+            const size_t pick = live.empty() ? 0 : (r >> 8) % live.size();
+
+            if (live.empty() || (r >> 6) % 4 == 0)
+            {
+                const Side side = (r >> 20) & 1 ? Side::Buy : Side::Sell;
+                const double price = 100.0 + ((side == Side::Buy) ? -1.0 : 1.0) * static_cast<double>(1 + (r >> 21) % 20) * 0.05;
+                live.push_back({ nextId++, side, price, 1 + (r >> 12) % 100 });
+                messages.push_back(feedMessage(symbol, ++sequence, FeedAction::Add,
+                    live.back().id, side, price, live.back().quantity));
+            }
+            else if ((r >> 6) % 4 == 1)
+            {
+                Live& order = live[pick];
+                order.quantity = 1 + (r >> 12) % 100;
+                messages.push_back(feedMessage(symbol, ++sequence, FeedAction::Modify,
+                    order.id, order.side, order.price, order.quantity));
+            }
+            else
+            {
+                Live& order = live[pick];
+                const uint64_t filled = ((r >> 6) % 4 == 2) ? order.quantity : 1 + (r >> 12) % order.quantity;
+                messages.push_back(feedMessage(symbol, ++sequence, ((r >> 6) % 4 == 2) ? FeedAction::Delete : FeedAction::Execute,
+                    order.id, order.side, 0.0, filled));
+
+                order.quantity -= filled;
+                if (order.quantity == 0)
+                    live.erase(live.begin() + static_cast<std::ptrdiff_t>(pick));
+            }
+
+            if (lost[symbol])
+            {
+                lost[symbol] = false;
+                messages.push_back(feedMessage(symbol, sequence, FeedAction::SnapshotBegin, 0));
+                for (const Live& order : live)
+                    messages.push_back(feedMessage(symbol, sequence, FeedAction::SnapshotOrder,
+                        order.id, order.side, order.price, order.quantity));
+                messages.push_back(feedMessage(symbol, sequence, FeedAction::SnapshotEnd, 0));
+            }
+        }
+
+        const auto path = (std::filesystem::temp_directory_path() / "hft_feed_capture.bin").string();
+        writeFeedCapture(path, messages);
+
+        {
+            const FeedCapture capture(path);
+            assert(capture.messages().size() == messages.size());
+
+            FeedHandler sequential;
+            size_t gaps = 0;
+            sequential.setGapHandler([&](const FeedGap&) { ++gaps; });
+            sequential.process(capture.messages());
+
+            FeedHandlerOptions options;
+            options.shards = 7;
+            options.batchMessages = 50'000;
+            options.sliceMessages = 3'000;
+
+            FeedHandler sharded(options);
+            size_t shardedGaps = 0;
+            sharded.setGapHandler([&](const FeedGap&) { ++shardedGaps; });
+
+            ThreadPool pool(4);
+            sharded.process(capture.messages(), pool);
+
+            assert(gaps > 10 && gaps == shardedGaps);
+            assert(sequential.stats() == sharded.stats());
+            assert(sequential.stats().snapshots == gaps && sequential.stats().rejected == 0);
+
+            for (uint32_t symbol = 0; symbol < 40; ++symbol)
+            {
+                const OrderBook& mirror = *sequential.book(symbol);
+                assert(!sequential.recovering(symbol));
+                assert(mirror.getDepth(Side::Buy) == sharded.book(symbol)->getDepth(Side::Buy));
+                assert(mirror.getDepth(Side::Sell) == sharded.book(symbol)->getDepth(Side::Sell));
+                assert(mirror.restingOrderCount() == books[symbol].size());
+            }
+        }
+
+        // A count that matches the file size only modulo 2^64 is refused
+        {
+            std::fstream patch(path, std::ios::in | std::ios::out | std::ios::binary);
+            const uint64_t garbled = messages.size() + (uint64_t{ 1 } << 60);
+            patch.seekp(static_cast<std::streamoff>(offsetof(FeedCaptureHeader, messageCount)));
+            patch.write(reinterpret_cast<const char*>(&garbled), sizeof(garbled));
+        }
+
+        bool threw = false;
+        try
+        {
+            const FeedCapture capture(path);
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        assert(threw);
+
+        std::filesystem::remove(path);
+    }
+
+    // Every replicated action, driven by a fixed seed; returns the ids it saw
+    // A simulated clock makes the trade timestamps repeatable across runs
+    std::vector<uint64_t> runReplicatedFlow(MatchingEngine& engine, uint64_t seed, size_t events, bool simulatedClock = false)
+    {
+        SimRandom random(seed);
+        std::vector<uint64_t> live;
+        std::vector<uint64_t> seen;
+
+        for (size_t i = 0; i < events; ++i)
+        {
+            const uint64_t r = random.next();
+
+            if (simulatedClock)
+                engine.setSimulatedTime(Timestamp{} + std::chrono::microseconds(i));
+
+            const Side side = (r & 0x10) ? Side::Buy : Side::Sell;
+            const double price = 100.0 + static_cast<double>((r >> 12) % 16) * 0.25;
+            const uint64_t quantity = 1 + (r >> 20) % 300;
+            const uint32_t owner = 1 + static_cast<uint32_t>((r >> 40) % 4);
+
+            uint64_t id = 0;
+
+            switch (r % 64)
+            {
+            case 0:
+                (void)engine.cancelOwner(owner);
+                break;
+            case 1:
+                (void)engine.cancelPriceRange(side, price - 0.5, price);
+                break;
+            case 2:
+                (void)engine.cancelSide(side);
+                break;
+            case 3:
+                engine.setTradingMode(TradingMode::Auction);
+                break;
+            case 4:
+                engine.setTradingMode(TradingMode::Continuous);
+                break;
+            case 5:
+                (void)engine.uncross(101.5);
+                break;
+            case 6:
+            case 7:
+                id = engine.submitIceberg(side, price, quantity * 4, quantity, owner);
+                break;
+            case 8:
+            case 9:
+                id = engine.submitPegged(side, (r & 0x20) ? PegType::Mid : PegType::Primary, -0.25, quantity, owner);
+                break;
+            case 10:
+                id = engine.submitOrder(side, OrderType::Market, 0.0, quantity, owner);
+                break;
+            default:
+                if (r % 3 == 0 && !live.empty())
+                {
+                    const size_t pick = (r >> 8) % live.size();
+                    (void)engine.cancelOrder(live[pick]);
+                    live[pick] = live.back();
+                    live.pop_back();
+                }
+                else
+                {
+                    id = engine.submitOrder(side, OrderType::Limit, price, quantity, owner);
+                }
+                break;
+            }
+
+            if (id != 0)
+            {
+                live.push_back(id);
+                seen.push_back(id);
+            }
+        }
+
+        return seen;
+    }
+
+    void assertReplicaMatches(const MatchingEngine& primary, const MatchingEngine& standby)
+    {
+        assert(primary.getSequence() == standby.getSequence());
+
+        const auto& left = primary.getTrades();
+        const auto& right = standby.getTrades();
+        assert(left.size() == right.size());
+
+        for (size_t i = 0; i < left.size(); ++i)
+        {
+            assert(left[i].buyOrderId == right[i].buyOrderId);
+            assert(left[i].sellOrderId == right[i].sellOrderId);
+            assert(left[i].price == right[i].price);
+            assert(left[i].quantity == right[i].quantity);
+            assert(left[i].timestamp == right[i].timestamp);
+            assert(left[i].sequence == right[i].sequence);
+        }
+
+        for (const Side side : { Side::Buy, Side::Sell })
+            assert(primary.getOrderBook().getDepth(side) == standby.getOrderBook().getDepth(side));
+    }
+
+    void replicaAppliesEventsInOrder()
+    {
+        const auto path = (std::filesystem::temp_directory_path() / "hft_replication_inproc.bin").string();
+
+        MatchingEngine primary;
+        MatchingEngine standby;
+
+        {
+            // A small ring forces the primary to wait for the standby
+            ReplicationPublisher publisher(path, 64, std::chrono::seconds(5));
+            ReplicationSubscriber subscriber(path);
+            primary.attachReplication(&publisher);
+
+            std::thread follower([&]()
+                {
+                    while (subscriber.primaryAlive(std::chrono::seconds(5)) || subscriber.pending())
+                    {
+                        if (standby.followReplication(subscriber) == 0)
+                            std::this_thread::yield();
+                    }
+                });
+
+            const auto ids = runReplicatedFlow(primary, 7, 4000);
+            publisher.close();
+            follower.join();
+
+            assert(!ids.empty());
+            assert(publisher.publishedCount() == primary.getSequence());
+            assert(publisher.acknowledgedSequence() == primary.getSequence());
+            primary.attachReplication(nullptr);
+        }
+
+        assertReplicaMatches(primary, standby);
+
+        // Out-of-order records are refused rather than applied
+        ReplicationRecord skipped{};
+        skipped.sequence = standby.getSequence() + 2;
+        skipped.action = ReplicatedAction::Cancel;
+
+        bool threw = false;
+        try
+        {
+            standby.applyReplicated(skipped);
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        assert(threw);
+
+        // So are records that do not reproduce the primary's sequence
+        ReplicationRecord unknown{};
+        unknown.sequence = standby.getSequence() + 1;
+        unknown.action = ReplicatedAction::Cancel;
+        unknown.orderId = 1ull << 60;
+
+        threw = false;
+        try
+        {
+            standby.applyReplicated(unknown);
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        assert(threw);
+
+        std::filesystem::remove(path);
+    }
+
+    void stalledStandbyIsDetached()
+    {
+        const auto path = (std::filesystem::temp_directory_path() / "hft_replication_stalled.bin").string();
+
+        MatchingEngine primary;
+        ReplicationPublisher publisher(path, 8, std::chrono::milliseconds(1));
+        primary.attachReplication(&publisher);
+
+        // Nobody consumes: once the ring fills, matching goes on
+        // without the standby
+        for (int i = 0; i < 20; ++i)
+            (void)primary.submitOrder(Side::Buy, OrderType::Limit, 90.0 + i * 0.25, 10);
+
+        assert(primary.getOrderBook().restingOrderCount() == 20);
+        assert(publisher.detached());
+        assert(publisher.publishedCount() == 8);
+        assert(publisher.droppedCount() == 12);
+        assert(publisher.fullWaits() == 1);
+
+        // The late standby applies what was published, then refuses
+        // to carry on with an incomplete replica
+        ReplicationSubscriber subscriber(path);
+        assert(subscriber.detached());
+
+        MatchingEngine standby;
+        const size_t applied = standby.followReplication(subscriber);
+        assert(applied == 8);
+
+        bool threw = false;
+        try
+        {
+            (void)standby.followReplication(subscriber);
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        assert(threw);
+
+        primary.attachReplication(nullptr);
+        std::filesystem::remove(path);
+    }
+
+    void tracerSamplesOrderLifecycles()
+    {
+        MatchingEngine engine;
+        OrderTracer tracer;
+        engine.attachTracer(&tracer);
+
+        // Off by default: nothing is stamped
+        for (int i = 0; i < 10; ++i)
+            (void)engine.submitOrder(Side::Buy, OrderType::Limit, 99.0, 10);
+        assert(tracer.traces().empty());
+
+        tracer.setSampleEvery(1);
+        const uint64_t resting = engine.submitOrder(Side::Sell, OrderType::Limit, 101.0, 50);
+        const uint64_t crossing = engine.submitOrder(Side::Buy, OrderType::Market, 0.0, 20);
+        assert(engine.submitOrder(Side::Buy, OrderType::Limit, -1.0, 10) == 0);
+
+        const auto traces = tracer.traces();
+        assert(traces.size() == 3);
+        assert(traces[0].orderId == resting && !traces[0].market);
+        assert(traces[1].orderId == crossing && traces[1].market);
+
+        for (size_t i = 0; i < 2; ++i)
+        {
+            const OrderTrace& trace = traces[i];
+            assert(trace.at(TracePoint::Received) != 0);
+            assert(trace.at(TracePoint::Received) <= trace.at(TracePoint::Validated));
+            assert(trace.at(TracePoint::Validated) <= trace.at(TracePoint::Booked));
+            assert(trace.at(TracePoint::Booked) <= trace.at(TracePoint::Published));
+        }
+
+        // The reject stops at validation
+        assert(traces[2].orderId == 0);
+        assert(traces[2].at(TracePoint::Validated) != 0);
+        assert(traces[2].at(TracePoint::Booked) == 0);
+
+        std::ostringstream json;
+        tracer.writeChromeTrace(json);
+        const std::string text = json.str();
+
+        const auto count = [&text](const std::string& needle)
+            {
+                size_t found = 0;
+                for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1))
+                    ++found;
+                return found;
+            };
+
+        assert(text.starts_with("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+        assert(count("\"ph\":\"X\"") == 4 + 4 + 2);
+        assert(count("\"name\":\"submitOrder\"") == 2);
+        assert(count("\"name\":\"submitOrder (rejected)\"") == 1);
+        assert(count("\"name\":\"matchOrder\"") == 1);
+        assert(count("\"name\":\"executeMarketOrder\"") == 1);
+        assert(count("\"name\":\"thread_name\"") == 1);
+    }
+
+    void tracerSamplingAndBuffersArePerThread()
+    {
+        OrderTracer tracer({ .tracesPerThread = 8, .sampleEvery = 4 });
+
+        // Two engines on two threads, one tracer
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 2; ++t)
+        {
+            threads.emplace_back([&tracer]()
+                {
+                    MatchingEngine engine;
+                    engine.attachTracer(&tracer);
+
+                    for (int i = 0; i < 40; ++i)
+                        (void)engine.submitOrder(Side::Buy, OrderType::Limit, 90.0 + (i % 5), 10);
+                });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        // 10 sampled per thread; 8 kept, 2 dropped
+        const auto traces = tracer.traces();
+        assert(traces.size() == 16);
+        assert(tracer.droppedCount() == 4);
+        assert(std::count_if(traces.begin(), traces.end(), [](const OrderTrace& trace) { return trace.thread == 1; }) == 8);
+
+        tracer.clear();
+        assert(tracer.traces().empty());
+        assert(tracer.droppedCount() == 0);
+    }
+
+    void tracerBuffersArePreregistered()
+    {
+        OrderTracer tracer({ .tracesPerThread = 8, .sampleEvery = 1 });
+        tracer.registerCurrentThread();
+        tracer.registerCurrentThread();
+
+        MatchingEngine engine;
+        engine.attachTracer(&tracer);
+        (void)engine.submitOrder(Side::Buy, OrderType::Limit, 100.0, 10);
+
+        const auto traces = tracer.traces();
+        assert(traces.size() == 1);
+        assert(traces.front().thread == 0);
+    }
+
+    void threadSlotsAreReleasedWithTheirOwner()
+    {
+        using Registry = ThreadSlotRegistry<int>;
+        const size_t bound = Registry::boundCount();
+
+        // Short-lived owners leave no binding behind on any thread
+        for (int i = 0; i < 100; ++i)
+        {
+            const uint64_t owner = Registry::nextOwnerId();
+            int here = 1;
+            int there = 2;
+
+            std::thread worker([owner, &there]()
+                {
+                    const int& slot = Registry::local(owner, [&there] { return &there; });
+                    assert(&slot == &there);
+                });
+            worker.join();
+
+            assert(Registry::find(owner) == nullptr);
+            const int& slot = Registry::local(owner, [&here] { return &here; });
+            assert(&slot == &here && Registry::find(owner) == &here);
+            assert(Registry::boundCount() == bound + 1);
+
+            Registry::release(owner);
+            assert(Registry::boundCount() == bound);
+        }
+    }
+
+    // Random books: some empty, some one-sided, some missing
+    std::vector<OrderBook> makeUniverse(size_t symbols, uint64_t seed)
+    {
+        std::vector<OrderBook> books(symbols);
+        SimRandom random(seed);
+        uint64_t nextId = 1;
+
+        for (OrderBook& book : books)
+        {
+            const uint64_t r = random.next();
+
+            const double base = 10.0 + static_cast<double>(r % 500);
+            const size_t bids = (r >> 12) % 6;
+            const size_t asks = (r >> 20) % 6;
+
+            for (size_t i = 0; i < bids; ++i)
+            {
+                const double ticks = static_cast<double>(1 + (r >> (i + 28)) % 5);
+                book.addOrder(Order(nextId++, Side::Buy, OrderType::Limit, base - 0.01 * ticks, 1 + (r >> (i * 3)) % 900));
+            }
+
+            for (size_t i = 0; i < asks; ++i)
+            {
+                const double ticks = static_cast<double>(1 + (r >> (i + 36)) % 5);
+                book.addOrder(Order(nextId++, Side::Sell, OrderType::Limit, base + 0.01 * ticks, 1 + (r >> (i * 5)) % 700));
+            }
+        }
+
+        return books;
+    }
+
+    void crossSectionMatchesPerBookAnalytics()
+    {
+        const auto books = makeUniverse(1500, 11);
+
+        std::vector<const OrderBook*> universe;
+        for (const OrderBook& book : books)
+            universe.push_back(&book);
+        universe[7] = nullptr;
+
+        // Chunks that do not divide the universe
+        CrossSectionalAnalytics serial({ .chunkSymbols = 96 });
+        serial.refresh(universe);
+        assert(serial.size() == universe.size());
+
+        const OrderBook empty;
+        for (size_t i = 0; i < universe.size(); ++i)
+        {
+            const OrderBook& book = universe[i] ? *universe[i] : empty;
+
+            assert(serial.imbalances()[i] == HFTAlgorithms::computeOrderImbalance(book));
+            assert(serial.spreadPercentages()[i] == HFTAlgorithms::computeSpreadPercentage(book));
+            assert(serial.microprices()[i] == HFTAlgorithms::computeMicroprice(book));
+            assert(serial.bidPrices()[i] == book.getBestBid());
+            assert(serial.askVolumes()[i] == static_cast<double>(book.getTotalAskVolume()));
+        }
+
+        // The ranking is a permutation, best imbalance first
+        const auto ranked = serial.rankedByImbalance();
+        std::vector<uint32_t> sorted(ranked.begin(), ranked.end());
+        std::sort(sorted.begin(), sorted.end());
+        for (size_t i = 0; i < sorted.size(); ++i)
+            assert(sorted[i] == i);
+
+        for (size_t i = 1; i < ranked.size(); ++i)
+        {
+            const double previous = serial.imbalances()[ranked[i - 1]];
+            const double current = serial.imbalances()[ranked[i]];
+            assert(previous > current || (previous == current && ranked[i - 1] < ranked[i]));
+        }
+
+        // Same answer from the pool, and after a book changes
+        ThreadPool pool(4);
+        CrossSectionalAnalytics parallel({ .chunkSymbols = 96 });
+        parallel.refresh(universe, pool);
+
+        assert(std::ranges::equal(serial.imbalances(), parallel.imbalances()));
+        assert(std::ranges::equal(serial.microprices(), parallel.microprices()));
+        assert(std::ranges::equal(serial.rankedByImbalance(), parallel.rankedByImbalance()));
+
+        OrderBook skewed;
+        skewed.addOrder(Order(1, Side::Buy, OrderType::Limit, 50.0, 1000));
+        universe[42] = &skewed;
+
+        parallel.refresh(universe, pool);
+        assert(parallel.imbalances()[42] == 1.0);
+        assert(parallel.spreadPercentages()[42] == 0.0);
+        assert(parallel.microprices()[42] == 0.0);
+        assert(parallel.rankedByImbalance().front() <= 42);
+    }
+
+    using WakeLog = std::vector<std::pair<SimTime, uint32_t>>;
+
+    SimTask sleeper(AgentContext ctx, WakeLog* log, SimTime period, uint64_t jitter, int wakes)
+    {
+        for (int i = 0; i < wakes; ++i)
+        {
+            co_await ctx.sleep(period + ctx.random().below(jitter + 1));
+            log->emplace_back(ctx.now(), ctx.id());
+        }
+    }
+
+    WakeLog runSleepers(uint64_t seed, uint64_t jitter)
+    {
+        MatchingEngine engine;
+        AgentSimulator simulator(engine, { .seed = seed });
+
+        WakeLog log;
+        for (int agent = 0; agent < 50; ++agent)
+            simulator.spawn([&log, jitter](AgentContext ctx) { return sleeper(ctx, &log, 10, jitter, 20); });
+
+        const uint64_t processed = simulator.run();
+        assert(processed == 50 * 21);
+        assert(simulator.runningAgents() == 0);
+        assert(simulator.pendingEvents() == 0);
+        return log;
+    }
+
+    void simulatorRunsAgentsInTimeOrder()
+    {
+        // The wheel pops by (time, ticket) across levels
+        SimEventQueue queue;
+        const std::vector<ScheduledEvent> events = {
+            { 70'000, 1 }, { 300, 2 }, { 5, 3 }, { 70'000, 4 }, { 300, 5 }, { 1ull << 40, 6 }, { 5, 7 }
+        };
+        for (const ScheduledEvent& event : events)
+            queue.push(event);
+
+        assert(queue.size() == events.size() && queue.nextTime() == 5);
+        std::vector<uint64_t> popped;
+        while (!queue.empty())
+        {
+            popped.push_back(queue.pop().ticket);
+            if (popped.size() == 3)
+            {
+                // Same time as the last pop: still in ticket order
+                queue.push({ 300, 8 });
+                assert(queue.nextTime() == 300);
+            }
+        }
+        assert((popped == std::vector<uint64_t>{ 3, 7, 2, 5, 8, 1, 4, 6 }));
+
+        bool rejected = false;
+        try
+        {
+            queue.push({ 1, 9 });
+        }
+        catch (const std::invalid_argument&)
+        {
+            rejected = true;
+        }
+        assert(rejected);
+
+        const WakeLog log = runSleepers(7, 5);
+        assert(log.size() == 50 * 20);
+        assert(std::is_sorted(log.begin(), log.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; }));
+
+        // Seeded: the same run twice, a different one otherwise
+        assert(runSleepers(7, 5) == log);
+        assert(runSleepers(8, 5) != log);
+
+        // Equal times run in scheduling order
+        const WakeLog ties = runSleepers(7, 0);
+        for (size_t i = 0; i < ties.size(); ++i)
+            assert(ties[i] == std::make_pair(SimTime{ 10 * (i / 50 + 1) }, static_cast<uint32_t>(i % 50)));
+
+        // Stepping in time
+        MatchingEngine engine;
+        AgentSimulator simulator(engine);
+        WakeLog stepped;
+        simulator.spawn([&stepped](AgentContext ctx) { return sleeper(ctx, &stepped, 10, 0, 5); });
+
+        const uint64_t untilStep = simulator.runUntil(25);
+        assert(untilStep == 3);
+        assert(simulator.now() == 25 && stepped.size() == 2);
+        const uint64_t rest = simulator.run();
+        assert(rest == 3);
+        assert(simulator.now() == 50);
+    }
+
+    struct MakerLog
+    {
+        uint64_t orderId = 0;
+        SimTime ackTime = 0;
+        SimFill fill;
+        SimTime fillTime = 0;
+        bool timedOut = false;
+        SimTime timeoutTime = 0;
+        bool cancelled = false;
+        bool cancelledAgain = true;
+        SimTime doneTime = 0;
+    };
+
+    SimTask restingMaker(AgentContext ctx, MakerLog* log)
+    {
+        log->orderId = co_await ctx.submit(Side::Sell, OrderType::Limit, 100.0, 10);
+        log->ackTime = ctx.now();
+
+        log->fill = co_await ctx.nextFill();
+        log->fillTime = ctx.now();
+
+        log->timedOut = !(co_await ctx.nextFill(3'000)).has_value();
+        log->timeoutTime = ctx.now();
+
+        log->cancelled = co_await ctx.cancel(log->orderId);
+        log->cancelledAgain = co_await ctx.cancel(log->orderId);
+        log->doneTime = ctx.now();
+    }
+
+    SimTask marketTaker(AgentContext ctx, uint64_t quantity, SimFill* fill)
+    {
+        co_await ctx.sleep(5'000);
+        const uint64_t id = co_await ctx.submit(Side::Buy, OrderType::Market, 0.0, quantity);
+        assert(id != 0);
+
+        *fill = co_await ctx.nextFill();
+    }
+
+    SimTask failingAgent(AgentContext ctx)
+    {
+        co_await ctx.sleep(1);
+        throw std::runtime_error("agent failed");
+    }
+
+    void simulatedAgentsTradeThroughLatency()
+    {
+        MatchingEngine engine;
+        AgentSimulator simulator(engine, { .latency = { .baseNs = 1'000 } });
+
+        MakerLog maker;
+        SimFill taken;
+        simulator.spawn([&maker](AgentContext ctx) { return restingMaker(ctx, &maker); });
+        simulator.spawn([&taken](AgentContext ctx) { return marketTaker(ctx, 4, &taken); });
+        simulator.run();
+
+        // Every message takes 1us each way
+        assert(maker.orderId != 0 && maker.ackTime == 2'000);
+
+        assert(maker.fill.orderId == maker.orderId);
+        assert(maker.fill.side == Side::Sell && maker.fill.price == 100.0);
+        assert(maker.fill.quantity == 4 && maker.fill.remaining == 6);
+        assert(maker.fill.tradeTime == 6'000 && maker.fillTime == 7'000);
+
+        assert(taken.side == Side::Buy && taken.quantity == 4 && taken.remaining == 0);
+
+        assert(maker.timedOut && maker.timeoutTime == 10'000);
+        assert(maker.cancelled && !maker.cancelledAgain);
+        assert(maker.doneTime == 14'000);
+
+        // The engine ran on simulated time
+        assert(engine.getTrades().size() == 1);
+        assert(engine.getTrades()[0].timestamp == Timestamp{} + std::chrono::nanoseconds(6'000));
+        assert(engine.getOrderBook().getBestAsk() == 0.0);
+
+        // Agent exceptions surface from run()
+        simulator.spawn(failingAgent);
+        bool threw = false;
+        try
+        {
+            simulator.run();
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        assert(threw && simulator.runningAgents() == 0);
+    }
+
+#ifdef __linux__
+    void standbyTakesOverFromCrashedPrimary()
+    {
+        const auto path = (std::filesystem::temp_directory_path() / "hft_replication_failover.bin").string();
+        constexpr uint64_t seed = 99;
+        constexpr size_t events = 20000;
+
+        // The child inherits the mapping; a small ring keeps it in lockstep
+        ReplicationPublisher channel(path, 1024, std::chrono::seconds(5));
+
+        const pid_t child = ::fork();
+        assert(child >= 0);
+
+        if (child == 0)
+        {
+            MatchingEngine primary;
+            primary.attachReplication(&channel);
+            (void)runReplicatedFlow(primary, seed, events, true);
+
+            // Crash: no close(), no destructors
+            ::_exit(0);
+        }
+
+        ReplicationSubscriber subscriber(path);
+        MatchingEngine standby;
+
+        for (;;)
+        {
+            const bool alive = subscriber.primaryAlive(std::chrono::milliseconds(500));
+            const size_t applied = standby.followReplication(subscriber);
+
+            if (!alive && applied == 0 && !subscriber.pending())
+                break;
+
+            if (applied == 0)
+                std::this_thread::yield();
+        }
+
+        int status = 0;
+        const pid_t reaped = ::waitpid(child, &status, 0);
+        assert(reaped == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+        MatchingEngine reference;
+        const auto ids = runReplicatedFlow(reference, seed, events, true);
+        assertReplicaMatches(reference, standby);
+
+        // After takeover, new ids never collide with the primary's
+        standby.takeOver();
+        const uint64_t next = standby.submitOrder(Side::Buy, OrderType::Limit, 90.0, 10);
+        assert(next > *std::max_element(ids.begin(), ids.end()));
+        assert(standby.getSequence() == reference.getSequence() + 1);
+
+        std::filesystem::remove(path);
+    }
+#endif
+}
+
+int main()
+{
+    limitOrdersMatchAtRestingAsk();
+    marketOrdersConsumeBestPriceFirst();
+    riskLimitsRejectInvalidOrders();
+    analyticsHandleZeroLookback();
+    riskLimitsRejectNonFinitePrices();
+    metricsTrackAcceptsRejectsAndSweeps();
+    metricsSnapshotsAreConsistentAcrossThreads();
+    backtestsAreDeterministicAcrossThreadCounts();
+    cancelsRemoveRestingOrders();
+    backendsProduceIdenticalTradesAndDepth();
+    auctionUncrossesAtMaximumVolume();
+    auctionTieBreakers();
+    auctionMarketOrdersCancelAndExpire();
+    auctionMatchesBruteForceVolume();
+    depthIndexMatchesLevelWalk();
+    depthIndexGrowsItsGrid();
+    idBlocksStayUniqueAcrossProducers();
+    engineSequencesAcceptedEvents();
+    journaledIdsReplayIdentically();
+    massCancelsDropSidesAndRanges();
+    massCancelByOwnerFollowsFills();
+    massCancelsKeepBookConsistent();
+    asyncLoggerKeepsPerThreadOrder();
+    asyncLoggerDropsInsteadOfBlocking();
+    asyncLoggerFormatsFillsAndValues();
+    shadowOrdersFillFromQueuePosition();
+    shadowQueuePositionsMatchReference();
+    consolidatedBookMergesVenues();
+    consolidatedBookMatchesVenueScan();
+    memoryStatsCoverBookStorage();
+    compactionReleasesMemoryWithoutChangingMatching();
+    archiveRoundTripsTradesAndBookEvents();
+    archiveRoundTripsEmptyArchive();
+    archiveSeeksByTimeAndSequence();
+    icebergsRefillAtBackOfLevel();
+    icebergReserveFullyExecutes();
+    peggedOrdersTrackTheLitQuote();
+    peggedOrdersCancelAndReject();
+    peggedBookNeverCrosses();
+    feedHandlerMirrorsOrderEvents();
+    feedHandlerRecoversFromGaps();
+    feedHandlerShardsMatchSequentialApply();
+    replicaAppliesEventsInOrder();
+    stalledStandbyIsDetached();
+    tracerSamplesOrderLifecycles();
+    tracerSamplingAndBuffersArePerThread();
+    tracerBuffersArePreregistered();
+    threadSlotsAreReleasedWithTheirOwner();
+    crossSectionMatchesPerBookAnalytics();
+    simulatorRunsAgentsInTimeOrder();
+    simulatedAgentsTradeThroughLatency();
+
+#ifdef __linux__
+    gatewayRoundTripsOverLoopback();
+    gatewayCancelsOrdersOnDisconnect();
+    gatewayPausesClientsThatStopReading();
+    standbyTakesOverFromCrashedPrimary();
+#endif
 
     return 0;
 }
@@ -0,0 +1,185 @@
+#include "ThreadPool.hpp"
+
+namespace hft
+{
+
+    ThreadPool::ThreadPool(size_t threads)
+    {
+        if (threads == 0)
+            threads = 1;
+
+        queues.reserve(threads);
+        for (size_t i = 0; i < threads; ++i)
+            queues.push_back(std::make_unique<WorkQueue>());
+
+        workers.reserve(threads);
+        for (size_t i = 0; i < threads; ++i)
+            workers.emplace_back([this, i]() { workerLoop(i); });
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard lock(stateMutex);
+            stopping = true;
+        }
+
+        workAvailable.notify_all();
+        workers.clear();   // jthread joins
+    }
+
+    size_t ThreadPool::size() const noexcept
+    {
+        return queues.size();
+    }
+
+    // ============================================================
+    // BATCH SUBMISSION
+    // ============================================================
+
+    void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn)
+    {
+        if (count == 0)
+            return;
+
+        std::lock_guard batchLock(batchMutex);
+
+        job = &fn;
+        firstError = nullptr;
+        remaining.store(count, std::memory_order_relaxed);
+
+        // Contiguous run per worker keeps neighbouring jobs on one core
+        const size_t workerCount = queues.size();
+        for (size_t w = 0; w < workerCount; ++w)
+        {
+            const size_t begin = count * w / workerCount;
+            const size_t end = count * (w + 1) / workerCount;
+
+            std::lock_guard queueLock(queues[w]->mutex);
+            for (size_t i = begin; i < end; ++i)
+                queues[w]->items.push_back(i);
+        }
+
+        {
+            std::lock_guard lock(stateMutex);
+            ++generation;
+        }
+        workAvailable.notify_all();
+
+        // Caller helps as a thief
+        size_t index = 0;
+        while (steal(workerCount, index))
+            execute(index);
+
+        {
+            std::unique_lock lock(stateMutex);
+            batchDone.wait(lock, [this]()
+                {
+                    return remaining.load(std::memory_order_acquire) == 0;
+                });
+        }
+
+        job = nullptr;
+
+        if (firstError)
+            std::rethrow_exception(firstError);
+    }
+
+    // ============================================================
+    // WORKERS
+    // ============================================================
+
+    void ThreadPool::workerLoop(size_t self)
+    {
+        uint64_t seenGeneration = 0;
+
+        for (;;)
+        {
+            {
+                std::unique_lock lock(stateMutex);
+                workAvailable.wait(lock, [&]()
+                    {
+                        return stopping || generation != seenGeneration;
+                    });
+
+                if (stopping)
+                    return;
+
+                seenGeneration = generation;
+            }
+
+            while (runOne(self))
+            {
+            }
+        }
+    }
+
+    bool ThreadPool::runOne(size_t self)
+    {
+        size_t index = 0;
+
+        if (!popLocal(self, index) && !steal(self, index))
+            return false;
+
+        execute(index);
+        return true;
+    }
+
+    bool ThreadPool::popLocal(size_t self, size_t& index)
+    {
+        WorkQueue& queue = *queues[self];
+        std::lock_guard lock(queue.mutex);
+
+        if (queue.items.empty())
+            return false;
+
+        index = queue.items.back();
+        queue.items.pop_back();
+        return true;
+    }
+
+    bool ThreadPool::steal(size_t self, size_t& index)
+    {
+        const size_t workerCount = queues.size();
+
+        for (size_t offset = 1; offset <= workerCount; ++offset)
+        {
+            const size_t victim = (self + offset) % workerCount;
+            if (victim == self)
+                continue;
+
+            WorkQueue& queue = *queues[victim];
+            std::lock_guard lock(queue.mutex);
+
+            if (queue.items.empty())
+                continue;
+
+            index = queue.items.front();
+            queue.items.pop_front();
+            return true;
+        }
+
+        return false;
+    }
+
+    void ThreadPool::execute(size_t index)
+    {
+        try
+        {
+            (*job)(index);
+        }
+        catch (...)
+        {
+            std::lock_guard lock(errorMutex);
+            if (!firstError)
+                firstError = std::current_exception();
+        }
+
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            std::lock_guard lock(stateMutex);
+            batchDone.notify_all();
+        }
+    }
+
+} // namespace hft
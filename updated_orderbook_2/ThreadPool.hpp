@@ -0,0 +1,83 @@
+#pragma once
+
+#include "HFTUtils.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+
+    Work-stealing thread pool for batch jobs
+    (backtests, parallel decode, cross-sectional analytics).
+
+    parallelFor() splits [0, count) into one contiguous run per
+    worker. Each worker drains its own queue from the back and,
+    once empty, steals from the front of the others, so uneven
+    job costs still keep every core busy.
+
+    The calling thread helps by stealing until the batch is done.
+    Indices are handed to exactly one thread each; callers write
+    results into slot [index] to stay deterministic regardless of
+    which thread ran what.
+*/
+
+namespace hft
+{
+
+    class ThreadPool
+    {
+    public:
+
+        explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        [[nodiscard]] size_t size() const noexcept;
+
+        // Runs fn(i) for every i in [0, count) and blocks until all finish.
+        // The first exception thrown by fn is rethrown here.
+        void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+    private:
+
+        struct alignas(CACHE_LINE_SIZE) WorkQueue
+        {
+            std::mutex mutex;
+            std::deque<size_t> items;
+        };
+
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        std::vector<std::jthread> workers;
+
+        // One batch at a time
+        std::mutex batchMutex;
+
+        std::mutex stateMutex;
+        std::condition_variable workAvailable;
+        std::condition_variable batchDone;
+        uint64_t generation = 0;
+        bool stopping = false;
+
+        const std::function<void(size_t)>* job = nullptr;
+        std::atomic<size_t> remaining{ 0 };
+        std::exception_ptr firstError;
+        std::mutex errorMutex;
+
+        void workerLoop(size_t self);
+        bool runOne(size_t self);
+        bool popLocal(size_t self, size_t& index);
+        bool steal(size_t self, size_t& index);
+        void execute(size_t index);
+    };
+
+} // namespace hft
@@ -0,0 +1,323 @@
+#include "VectorOrderBook.hpp"
+#include "EngineMetrics.hpp"
+#include "OrderBookLike.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace hft
+{
+
+    static_assert(OrderBookLike<VectorOrderBook>);
+
+    void VectorOrderBook::addOrder(Order order)
+    {
+        if (order.side == Side::Buy)
+            addOrder<Side::Buy>(order);
+        else
+            addOrder<Side::Sell>(order);
+    }
+
+    template <Side S>
+    void VectorOrderBook::addOrder(Order& order)
+    {
+        if (order.type == OrderType::Market)
+        {
+            sweep<S, OrderType::Market>(order);
+            return;
+        }
+
+        sweep<S, OrderType::Limit>(order);
+
+        if (order.quantity > 0)
+            rest<S>(order);
+    }
+
+    // ============================================================
+    // SWEEP
+    // ============================================================
+
+    template <Side S, OrderType T>
+    void VectorOrderBook::sweep(Order& aggressor)
+    {
+        using Traits = SideTraits<S>;
+
+        auto& passive = levels<Traits::opposite>();
+        Timestamp time{};
+        uint64_t levelsTouched = 0;
+
+        while (aggressor.quantity > 0 && !passive.empty())
+        {
+            Level& best = passive.back();
+
+            if constexpr (T == OrderType::Limit)
+            {
+                if (!Traits::crosses(aggressor.price, best.price))
+                    break;
+            }
+
+            const double tradePrice = Traits::template tradePrice<T>(aggressor.price, best.price);
+
+            if (levelsTouched++ == 0)
+                time = currentTime();
+
+            PriceLevel& queue = best.queue;
+
+            while (aggressor.quantity > 0 && !queue.empty())
+            {
+                const RestingOrder& resting = queue.front();
+                const uint64_t restingId = resting.id;
+                const uint64_t tradeQty = std::min(aggressor.quantity, resting.quantity);
+
+                trades.push_back(Traits::makeTrade(aggressor.id,
+                    restingId,
+                    tradePrice,
+                    tradeQty,
+                    time,
+                    eventSequence));
+
+                if (metrics)
+                {
+                    metrics->increment(Metric::Fills);
+                    metrics->increment(Metric::FilledQuantity, tradeQty);
+                }
+
+                aggressor.quantity -= tradeQty;
+
+                if (queue.reduceFront(tradeQty))
+                    locations.erase(restingId);
+            }
+
+            if (queue.empty())
+            {
+                passive.pop_back();
+
+                if (metrics)
+                    metrics->increment(Metric::LevelsDestroyed);
+            }
+        }
+
+        if (levelsTouched > 0 && metrics)
+        {
+            metrics->set(Metric::LastSweepDepth, levelsTouched);
+            metrics->set(Metric::OrderPoolOccupancy, locations.size());
+            metrics->setMax(Metric::MaxSweepDepth, levelsTouched);
+        }
+    }
+
+    // ============================================================
+    // RESTING AND CANCEL
+    // ============================================================
+
+    template <Side S>
+    typename std::vector<VectorOrderBook::Level>::iterator VectorOrderBook::findLevel(double price)
+    {
+        using Better = typename SideTraits<S>::Compare;
+
+        // Levels before the result are strictly worse than `price`
+        auto& side = levels<S>();
+        return std::lower_bound(side.begin(), side.end(), price,
+            [](const Level& level, double value)
+            {
+                return Better{}(value, level.price);
+            });
+    }
+
+    template <Side S>
+    void VectorOrderBook::rest(const Order& order)
+    {
+        auto& side = levels<S>();
+        auto it = findLevel<S>(order.price);
+
+        if (it == side.end() || it->price != order.price)
+        {
+            it = side.insert(it, Level{ order.price, {} });
+
+            if (metrics)
+                metrics->increment(Metric::LevelsCreated);
+        }
+
+        const uint64_t slot = it->queue.addOrder({ order.id, order.quantity, 0 });
+        locations.emplace(order.id, Location{ S, order.price, slot });
+
+        if (metrics)
+        {
+            metrics->setMax(Metric::MaxQueueLength, it->queue.size());
+            metrics->set(Metric::OrderPoolOccupancy, locations.size());
+        }
+    }
+
+    bool VectorOrderBook::cancelOrder(uint64_t orderId)
+    {
+        const auto it = locations.find(orderId);
+        if (it == locations.end())
+            return false;
+
+        const Location location = it->second;
+        locations.erase(it);
+
+        if (location.side == Side::Buy)
+            return cancelAt<Side::Buy>(location);
+
+        return cancelAt<Side::Sell>(location);
+    }
+
+    template <Side S>
+    bool VectorOrderBook::cancelAt(const Location& location)
+    {
+        auto& side = levels<S>();
+        const auto it = findLevel<S>(location.price);
+
+        if (it == side.end() || it->price != location.price)
+            return false;
+
+        it->queue.cancel(location.slot);
+
+        if (it->queue.empty())
+        {
+            side.erase(it);
+
+            if (metrics)
+                metrics->increment(Metric::LevelsDestroyed);
+        }
+
+        return true;
+    }
+
+    // ============================================================
+    // MARKET DATA
+    // ============================================================
+
+    const std::vector<Trade>& VectorOrderBook::getTrades() const noexcept
+    {
+        return trades;
+    }
+
+    double VectorOrderBook::getBestBid() const
+    {
+        return bidLevels.empty() ? 0.0 : bidLevels.back().price;
+    }
+
+    double VectorOrderBook::getBestAsk() const
+    {
+        return askLevels.empty() ? 0.0 : askLevels.back().price;
+    }
+
+    uint64_t VectorOrderBook::getTotalBidVolume() const
+    {
+        uint64_t total = 0;
+        for (const Level& level : bidLevels)
+            total += level.queue.totalVolume;
+
+        return total;
+    }
+
+    uint64_t VectorOrderBook::getTotalAskVolume() const
+    {
+        uint64_t total = 0;
+        for (const Level& level : askLevels)
+            total += level.queue.totalVolume;
+
+        return total;
+    }
+
+    std::vector<DepthLevel> VectorOrderBook::getDepth(Side side, size_t maxLevels) const
+    {
+        std::vector<DepthLevel> depth;
+
+        if (side == Side::Buy)
+            appendDepth<Side::Buy>(depth, maxLevels);
+        else
+            appendDepth<Side::Sell>(depth, maxLevels);
+
+        return depth;
+    }
+
+    template <Side S>
+    void VectorOrderBook::appendDepth(std::vector<DepthLevel>& out, size_t maxLevels) const
+    {
+        const auto& side = levels<S>();
+        const size_t count = (maxLevels == 0) ? side.size() : std::min(maxLevels, side.size());
+        out.reserve(count);
+
+        for (auto it = side.rbegin(); it != side.rend() && out.size() < count; ++it)
+            out.push_back({ it->price, it->queue.totalVolume, it->queue.size() });
+    }
+
+    // ============================================================
+    // OUTPUT
+    // ============================================================
+
+    void VectorOrderBook::printTopOfBook() const
+    {
+        const double bid = getBestBid();
+        const double ask = getBestAsk();
+        const bool twoSided = !bidLevels.empty() && !askLevels.empty();
+
+        std::cout << "\n--- TOP OF BOOK ---\n";
+        std::cout << "Best Bid: " << bid << "\n";
+        std::cout << "Best Ask: " << ask << "\n";
+        std::cout << "Spread:   " << (twoSided ? ask - bid : 0.0) << "\n";
+        std::cout << "MidPrice: " << (twoSided ? (ask + bid) / 2.0 : 0.0) << "\n";
+    }
+
+    void VectorOrderBook::printFullDepth() const
+    {
+        std::cout << "\n===== ORDER BOOK DEPTH =====\n";
+
+        std::cout << "\nASKS:\n";
+        for (auto it = askLevels.rbegin(); it != askLevels.rend(); ++it)
+            std::cout << it->price << " | " << it->queue.totalVolume << "\n";
+
+        std::cout << "\nBIDS:\n";
+        for (auto it = bidLevels.rbegin(); it != bidLevels.rend(); ++it)
+            std::cout << it->price << " | " << it->queue.totalVolume << "\n";
+    }
+
+    // ============================================================
+    // UTILITIES
+    // ============================================================
+
+    bool VectorOrderBook::empty() const
+    {
+        return bidLevels.empty() && askLevels.empty();
+    }
+
+    bool VectorOrderBook::contains(uint64_t orderId) const noexcept
+    {
+        return locations.contains(orderId);
+    }
+
+    void VectorOrderBook::clear()
+    {
+        bidLevels.clear();
+        askLevels.clear();
+        locations.clear();
+        trades.clear();
+
+        if (metrics)
+            metrics->set(Metric::OrderPoolOccupancy, 0);
+    }
+
+    void VectorOrderBook::attachMetrics(MetricsRegistry* registry) noexcept
+    {
+        metrics = registry;
+    }
+
+    void VectorOrderBook::setSimulatedTime(Timestamp time) noexcept
+    {
+        simulatedClock = true;
+        simulatedTime = time;
+    }
+
+    void VectorOrderBook::useWallClock() noexcept
+    {
+        simulatedClock = false;
+    }
+
+    void VectorOrderBook::setEventSequence(uint64_t sequence) noexcept
+    {
+        eventSequence = sequence;
+    }
+
+} // namespace hft
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "OrderBook.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*
+
+    Alternative OrderBookLike backend: sorted price vectors.
+
+    Each side keeps its levels in one std::vector ordered from
+    worst to best, so the best level is at the back. Sweeps
+    pop from the back, and near-touch inserts shift only the few
+    levels behind them. This suits the shallow, top-heavy books
+    most instruments have, and gives the differential tests an
+    independent implementation to compare OrderBook against.
+
+    Matching semantics (SideTraits trade price, FIFO, market
+    remainder discarded) are identical to OrderBook.
+*/
+
+namespace hft
+{
+
+    class MetricsRegistry;
+
+    class VectorOrderBook
+    {
+    public:
+
+        VectorOrderBook() = default;
+
+        // Order entry
+        void addOrder(Order order);
+        bool cancelOrder(uint64_t orderId);
+
+        [[nodiscard]] const std::vector<Trade>& getTrades() const noexcept;
+
+        // Market data
+        [[nodiscard]] double getBestBid() const;
+        [[nodiscard]] double getBestAsk() const;
+        [[nodiscard]] uint64_t getTotalBidVolume() const;
+        [[nodiscard]] uint64_t getTotalAskVolume() const;
+        [[nodiscard]] std::vector<DepthLevel> getDepth(Side side, size_t maxLevels = 0) const;
+
+        // Output
+        void printTopOfBook() const;
+        void printFullDepth() const;
+
+        // Utilities
+        [[nodiscard]] bool empty() const;
+        [[nodiscard]] bool contains(uint64_t orderId) const noexcept;   // live on the book
+        void clear();
+
+        // Engine hooks
+        void attachMetrics(MetricsRegistry* registry) noexcept;
+        void setSimulatedTime(Timestamp time) noexcept;
+        void useWallClock() noexcept;
+
+        [[nodiscard]] Timestamp currentTime() const noexcept
+        {
+            return simulatedClock ? simulatedTime : std::chrono::steady_clock::now();
+        }
+
+        void setEventSequence(uint64_t sequence) noexcept;
+
+    private:
+
+        struct Level
+        {
+            double price;
+            PriceLevel queue;
+        };
+
+        struct Location
+        {
+            Side side;
+            double price;
+            uint64_t slot;
+        };
+
+        // Worst to best; best level at back()
+        std::vector<Level> bidLevels;
+        std::vector<Level> askLevels;
+
+        std::unordered_map<uint64_t, Location> locations;
+        std::vector<Trade> trades;
+
+        MetricsRegistry* metrics = nullptr;
+        bool simulatedClock = false;
+        Timestamp simulatedTime{};
+        uint64_t eventSequence = 0;
+
+        template <Side S>
+        [[nodiscard]] std::vector<Level>& levels() noexcept
+        {
+            if constexpr (S == Side::Buy)
+                return bidLevels;
+            else
+                return askLevels;
+        }
+
+        template <Side S>
+        [[nodiscard]] const std::vector<Level>& levels() const noexcept
+        {
+            if constexpr (S == Side::Buy)
+                return bidLevels;
+            else
+                return askLevels;
+        }
+
+        template <Side S>
+        void addOrder(Order& order);
+
+        template <Side S, OrderType T>
+        void sweep(Order& aggressor);
+
+        template <Side S>
+        void rest(const Order& order);
+
+        template <Side S>
+        [[nodiscard]] typename std::vector<Level>::iterator findLevel(double price);
+
+        template <Side S>
+        bool cancelAt(const Location& location);
+
+        template <Side S>
+        void appendDepth(std::vector<DepthLevel>& out, size_t maxLevels) const;
+    };
+
+} // namespace hft
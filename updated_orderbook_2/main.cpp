@@ -1,4 +1,5 @@
-﻿#include "MatchingEngine.hpp"
+﻿#include "AsyncLogger.hpp"
+#include "MatchingEngine.hpp"
 #include "HFTAlgorithms.hpp"
 #include "HFTUtils.hpp"
 
@@ -31,6 +32,11 @@ int main()
     MatchingEngine engine;
     engine.setRiskLimits({ 10'000.0, 10'000, true });
 
+    // Fills, depth and analytics are formatted off this thread
+    AsyncLogger logger(std::cout);
+    logger.start();
+    engine.attachTradeLog(&logger);
+
     LatencyTimer timer;
 
     // Start latency measurement
@@ -53,24 +59,12 @@ int main()
     timer.stop();
 
 
-    engine.printFullDepth();
-    engine.printTopOfBook();
-
-    const auto& trades = engine.getTrades();
-
-    std::cout << "\n====== TRADES EXECUTED ======\n";
-    for (const auto& t : trades)
-    {
-        std::cout << "BuyID: " << t.buyOrderId
-            << " | SellID: " << t.sellOrderId
-            << " | Price: " << t.price
-            << " | Qty: " << t.quantity
-            << "\n";
-    }
-
+    engine.logFullDepth(logger);
+    engine.logTopOfBook(logger);
+    HFTAlgorithms::logAnalytics(logger, engine.getOrderBook(), engine.getTrades());
 
-    std::cout << "\n";
-    HFTAlgorithms::printAnalytics(engine.getOrderBook(), trades);
+    // Drain before writing to std::cout from this thread again
+    logger.stop();
 
 
     std::cout << "\n====== PERFORMANCE ======\n";